@@ -4,9 +4,13 @@
 // ERR_WRITE_CYCLES cycles
 
 #include "bp.h"
+#include "lib_profile.h"
 #include <glib.h>
 #include <time.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 
 #define LEARNING_RATE 0.001
 #define ERROR_FUNCTION CROSS_ENTROPY
@@ -15,72 +19,237 @@
 #define MAX_CYCLES           20000
 #define ERR_WRITE_CYCLES      1000
 
+// Threads for UPDATE_BY_EPOCH training (0 = one per available processor):
+#define TRAIN_THREADS            0
+
 // extern int usertime(); /* Return total milliseconds of user time */
 // extern int systime();  /* Return total milliseconds of system time */
 
-void action_log_initialise() { }
-void action_log_record(ActionType act, int cycle, char *arg1, char *arg2) { }
+void action_log_initialise(ActionLog *log) { }
+void action_log_free(ActionLog *log) { }
+void action_log_record(ActionLog *log, ActionType act, int cycle, ObjectType arg1, ObjectType arg2) { }
 
 static void save_weights(Network *net, char *weight_prefix, int i)
 {
-    char filename[64];
+    char filename[256], tmpname[260];
     FILE *fp;
 
-    g_snprintf(filename, 64, "%s_%d.weights", weight_prefix, i);
+    /* Write to a temporary file and rename it when complete, so that an */
+    /* interrupted run never leaves a truncated weight file behind:       */
 
-    if ((fp = fopen(filename, "w")) == NULL) {
-        fprintf(stderr, "ERROR: Cannot write to %s\n", filename);
+    g_snprintf(filename, 256, "%s_%d.weights", weight_prefix, i);
+    g_snprintf(tmpname, 260, "%s.tmp", filename);
+
+    if ((fp = fopen(tmpname, "w")) == NULL) {
+        fprintf(stderr, "ERROR: Cannot write to %s\n", tmpname);
     }
     else if (!network_dump_weights(fp, net)) {
         fprintf(stderr, "ERROR: Problem dumping weights ... weights not saved\n");
         fclose(fp);
-        remove(filename);
+        remove(tmpname);
+    }
+    else if ((fclose(fp) != 0) || (rename(tmpname, filename) != 0)) {
+        fprintf(stderr, "ERROR: Cannot write to %s\n", filename);
+        remove(tmpname);
     }
     else {
         fprintf(stderr, "Weights successfully saved to %s\n", filename);
-        fclose(fp);
     }
 }
 
-static void run_and_save(int j, char *training_set, char *weight_prefix)
+static Boolean run_and_save(int j, char *training_set, char *weight_prefix, int threads, FILE *log)
 {
     Network *net;
+    NetworkTrainer *trainer = NULL;
     TrainingDataList *tdl;
     double rms, cross_entropy, sme;
     TaskType task = {TASK_COFFEE, DAMAGE_NONE, {TRUE, FALSE, FALSE, FALSE, FALSE}};
     int i;
 
     world_initialise(&task);
-    tdl = training_set_read(training_set, IN_WIDTH, OUT_WIDTH);
+    if ((tdl = training_set_read(training_set, IN_WIDTH, OUT_WIDTH)) == NULL) {
+        return(FALSE);
+    }
     if ((net = network_create(IN_WIDTH, HIDDEN_WIDTH, OUT_WIDTH)) != NULL) {
+        network_reserve_bptt_workspace(net, sequence_list_max_length(tdl));
+        if (UPDATE_TIME == UPDATE_BY_EPOCH) {
+            trainer = network_trainer_create(net, tdl, threads);
+        }
         for (i = 0; i < MAX_CYCLES; i++) {
             if (i == (ERR_WRITE_CYCLES * (i / ERR_WRITE_CYCLES))) {
                 rms = sqrt(network_test(net, tdl, SUM_SQUARE_ERROR));
                 cross_entropy = network_test(net, tdl, CROSS_ENTROPY);
                 sme = network_test(net, tdl, SOFT_MAX_ERROR);
-                fprintf(stdout, "%3d: RMS Error: %7.5f; Cross Entropy: %7.5f; SoftMax Error: %7.5f\n", i, rms, cross_entropy, sme);
+                fprintf(log, "%3d: RMS Error: %7.5f; Cross Entropy: %7.5f; SoftMax Error: %7.5f\n", i, rms, cross_entropy, sme);
+                fflush(log);
+            }
+            if (trainer != NULL) {
+                network_trainer_epoch(trainer, LEARNING_RATE, ERROR_FUNCTION, FALSE);
+            }
+            else {
+                network_train(net, tdl, LEARNING_RATE, ERROR_FUNCTION, UPDATE_TIME, FALSE);
             }
-            network_train(net, tdl, LEARNING_RATE, ERROR_FUNCTION, UPDATE_TIME, FALSE);
         }
         save_weights(net, weight_prefix, j);
+        network_trainer_destroy(trainer);
         network_tell_destroy(net);
     }
     training_set_free(tdl);
+    return(net != NULL);
+}
+
+/******************************************************************************/
+/* The training farm: Train one network per seed, each in its own process    */
+/* (so each has its own rand() stream, seeded with the seed), running up to  */
+/* jobs at a time. Seeds whose weight file already exists are skipped, so an */
+/* interrupted farm can simply be rerun to complete it.                      */
+
+static void train_seed(int seed, char *weight_prefix, int threads)
+{
+    char filename[256];
+    FILE *log;
+    Boolean ok;
+
+    g_snprintf(filename, 256, "%s_%d.log", weight_prefix, seed);
+    if ((log = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "ERROR: Cannot write to %s\n", filename);
+        _exit(1);
+    }
+    srand(seed);
+#ifdef PROFILE
+    profile_reset();
+#endif
+    fprintf(log, "Seed %d; Training set %s; %d epochs\n", seed, TRAINING_SET, MAX_CYCLES);
+    ok = run_and_save(seed, TRAINING_SET, weight_prefix, threads, log);
+    fprintf(log, "User time: %f; System time: %f\n", usertime()*0.001, systime()*0.001);
+    fclose(log);
+#ifdef PROFILE
+    /* _exit skips the atexit report, so each job writes its own: */
+    g_snprintf(filename, 256, "%s_%d_profile.dat", weight_prefix, seed);
+    if ((log = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "WARNING: Cannot write profile to %s\n", filename);
+    }
+    else {
+        profile_write_report(log);
+        fclose(log);
+    }
+#endif
+    _exit(ok ? 0 : 1);
+}
+
+static void train_farm(int seed0, int seed1, int jobs, char *weight_prefix)
+{
+    char filename[256];
+    struct stat st;
+    int threads, running = 0, failed = 0, status, seed;
+    pid_t pid;
+
+    /* Share the processors between the concurrent jobs: */
+    threads = MAX(1, (int) sysconf(_SC_NPROCESSORS_ONLN) / jobs);
+
+    for (seed = seed0; seed <= seed1; seed++) {
+        g_snprintf(filename, 256, "%s_%d.weights", weight_prefix, seed);
+        if (stat(filename, &st) == 0) {
+            fprintf(stdout, "Seed %d: %s exists ... skipping\n", seed, filename);
+            continue;
+        }
+        if (running == jobs) {
+            if ((wait(&status) > 0) && !(WIFEXITED(status) && (WEXITSTATUS(status) == 0))) {
+                failed++;
+            }
+            running--;
+        }
+        fprintf(stdout, "Seed %d: training\n", seed);
+        fflush(stdout);
+        fflush(stderr);
+        if ((pid = fork()) == 0) {
+            train_seed(seed, weight_prefix, threads);
+        }
+        else if (pid < 0) {
+            fprintf(stderr, "ERROR: Cannot start a job for seed %d\n", seed);
+            failed++;
+        }
+        else {
+            running++;
+        }
+    }
+    while (running > 0) {
+        if ((wait(&status) > 0) && !(WIFEXITED(status) && (WEXITSTATUS(status) == 0))) {
+            failed++;
+        }
+        running--;
+    }
+    if (failed > 0) {
+        fprintf(stderr, "WARNING: %d seed(s) failed; rerun to retry them\n", failed);
+    }
+}
+
+static Boolean parse_seeds(char *arg, int *seed0, int *seed1)
+{
+    /* Either a single seed ("7") or an inclusive range ("1..50"): */
+
+    if (sscanf(arg, "%d..%d", seed0, seed1) == 2) {
+        return(*seed0 <= *seed1);
+    }
+    else if (sscanf(arg, "%d", seed0) == 1) {
+        *seed1 = *seed0;
+        return(TRUE);
+    }
+    return(FALSE);
+}
+
+static void print_usage(FILE *fp)
+{
+    fprintf(fp, "Usage: bp\n");
+    fprintf(fp, "       bp --train --seeds s0..s1 [--jobs N] [--prefix prefix]\n");
 }
 
 int main(int argc, char **argv)
 {
-    int i;
+    char *weight_prefix = "weights_bp";
+    int seed0 = 1, seed1 = 1, jobs = 0;
+    Boolean farm = FALSE;
     long t0 = (long) time(NULL);
+    int i;
 
-    srand((int) t0);
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--train") == 0) {
+            farm = TRUE;
+        }
+        else if ((strcmp(argv[i], "--seeds") == 0) && (i+1 < argc)) {
+            if (!parse_seeds(argv[++i], &seed0, &seed1)) {
+                fprintf(stderr, "ERROR: Invalid seed range %s\n", argv[i]);
+                exit(1);
+            }
+        }
+        else if ((strcmp(argv[i], "--jobs") == 0) && (i+1 < argc)) {
+            jobs = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--prefix") == 0) && (i+1 < argc)) {
+            weight_prefix = argv[++i];
+        }
+        else {
+            print_usage(stderr);
+            exit(1);
+        }
+    }
+
+    PROFILE_REPORT_AT_EXIT("bp_profile.dat");
     fprintf(stdout, "BEFORE: User time: %f; System time: %f\n", usertime()*0.001, systime()*0.001);
-    for (i = 0; i < 1; i++) {
-        run_and_save(i, TRAINING_SET, "weights_bp_marc");
+    if (farm) {
+        if (jobs < 1) {
+            jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        train_farm(seed0, seed1, MAX(1, jobs), weight_prefix);
+    }
+    else {
+        int threads = (TRAIN_THREADS > 0) ? TRAIN_THREADS : (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+        srand((int) t0);
+        run_and_save(0, TRAINING_SET, "weights_bp_marc", threads, stdout);
     }
     fprintf(stdout, "AFTER:  User time: %f; System time: %f\n", usertime()*0.001, systime()*0.001);
     exit(0);
 }
 
 /******************************************************************************/
-
@@ -62,6 +62,28 @@ typedef struct acs2 {
     int accomplished;
 } ACS2;
 
+/* Defined in error_analysis.c: ***********************************************/
+
+/* The record of actions performed during an episode. Each world context has  */
+/* its own log. Programs without the analyses (bp, bp_sweep) stub these out.  */
+/* Actions name their arguments by type (OBJECT_NONE if absent), and their    */
+/* records are kept in an arena that is reset, not freed, between episodes.   */
+
+typedef enum object_type {OBJECT_CUP, OBJECT_TEABAG, OBJECT_COFFEE_PACKET, OBJECT_SUGAR_PACKET, OBJECT_SPOON, OBJECT_CARTON, OBJECT_SUGAR_BOWL, OBJECT_SUGAR_BOWL_LID, OBJECT_NONE} ObjectType;
+
+typedef struct action_log {
+    struct action_list *first;
+    struct action_list *last;
+    Boolean             task_complete;
+    struct action_list *arena;         // Records, in the order performed
+    int                 length;        // Records in use
+    int                 capacity;      // Records allocated
+} ActionLog;
+
+extern void action_log_initialise(ActionLog *log);
+extern void action_log_free(ActionLog *log);
+extern void action_log_record(ActionLog *log, ActionType act, int cycle, ObjectType arg1, ObjectType arg2);
+
 /* Defined in lib_network.c: **************************************************/
 
 #include "lib_network.h"
@@ -76,6 +98,20 @@ extern double systime();  /* Return total milliseconds of system time */
 #define WES_LENGTH 128
 extern char world_error_string[WES_LENGTH];
 
+typedef struct world_context WorldContext;
+
+extern WorldContext *world_context_create();
+extern void world_context_free(WorldContext *wc);
+extern WorldContext *world_context_default();
+extern ActionLog *world_context_action_log(WorldContext *wc);
+extern char *world_context_error_string(WorldContext *wc);
+extern void world_context_initialise(WorldContext *wc, TaskType *task);
+extern void world_context_set_network_input_vector(WorldContext *wc, double *vector);
+extern void world_context_print_state(WorldContext *wc, FILE *fp);
+extern Boolean world_context_perform_action(WorldContext *wc, ActionType action);
+
+/* The original interface, which operates on the default context: */
+
 extern void world_initialise(TaskType *task);
 extern void world_set_network_input_vector(double *vector);
 extern void world_print_state(FILE *fp);
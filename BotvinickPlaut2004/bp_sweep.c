@@ -0,0 +1,1088 @@
+/******************************************************************************/
+
+// Headless damage sweep: For a given type of damage, run a fixed number of
+// episodes of each task for each weight file at each level of damage, and
+// write the survival (first error) and subtask error category tables to
+// tab-delimited files. Episodes are distributed over a pool of threads.
+//
+// Usage:
+//   bp_sweep [-d damage] [-l l1,l2,...] [-n episodes] [-j threads]
+//            [-B batch] [-t coffee|tea|both] [-b] [-N] [-a width] [-s seed]
+//            [-o prefix] weight_file ...
+//
+// If no weight files are given, Weights/srn_20000_01.wgt ... _12.wgt are
+// used (as in the survival viewer and subtask chart of xbp).
+//
+// Every episode draws its random numbers from its own stream, identified by
+// the seed and (network, level, task, episode), so for a given seed the
+// results do not depend on the number of threads or the batch size.
+//
+// With -N, connection lesions are nested: the streams no longer depend on
+// the level, and each episode's connections are ranked once and severed in
+// rank order, so that an episode's lesion at one level contains its lesion
+// at every lower level.
+//
+// With -a, the number of episodes is adaptive: each cell (network, level and
+// task) is run in rounds of ADAPTIVE_ROUND episodes until the 95% confidence
+// interval on its proportion of error-free episodes is narrower than +/- the
+// given width, or -n episodes have been run. Idle threads take the unsettled
+// cell with the widest interval. Cells near 0% or 100% settle quickly, and a
+// cell's stopping point depends only on its own episodes, so the results are
+// still independent of the number of threads and the batch size.
+
+#include "bp.h"
+#include "lib_profile.h"
+#include "utils_maths.h"
+#include "xcs_sequences.h"
+#include <glib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// Consider at most 40 steps when computing survival:
+#define SV_STEPS 40
+// Allow at most 100 steps in any episode:
+#define MAX_STEPS 100
+#define ERROR_CATEGORIES 5
+#define MAX_LEVELS 32
+#define MAX_NETS 64
+#define MAX_THREADS 256
+#define MAX_BATCH 256
+#define ADAPTIVE_ROUND 32
+
+void action_log_initialise(ActionLog *log) { }
+void action_log_free(ActionLog *log) { }
+void action_log_record(ActionLog *log, ActionType act, int cycle, ObjectType arg1, ObjectType arg2) { }
+
+#include TARGET_SEQUENCES
+
+typedef struct damage_details {
+    char *name;
+    char *label;
+    int num_levels;
+    double level[MAX_LEVELS];
+} DamageDetails;
+
+/* The default levels are those of the subtask chart (xcs_sim2_subtask_chart.c): */
+
+static DamageDetails sweep_dd[8] = {
+    {"none",              "No Damage",                           1, {0.000}},
+    {"activation_noise",  "Activation Noise (s.d.)",            10, {0.000, 0.010, 0.020, 0.030, 0.040, 0.050, 0.100, 0.200, 0.300, 0.400}},
+    {"ch_weight_noise",   "CH Weight Noise (s.d.)",             10, {0.000, 0.001, 0.002, 0.005, 0.010, 0.030, 0.050, 0.100, 0.200, 0.400}},
+    {"ch_weight_lesion",  "CH Connections Severed (proportion)", 10, {0.000, 0.001, 0.003, 0.006, 0.009, 0.015, 0.050, 0.100, 0.200, 0.400}},
+    {"ih_weight_noise",   "IH Weight Noise (s.d.)",             10, {0.000, 0.001, 0.002, 0.005, 0.010, 0.030, 0.050, 0.100, 0.200, 0.400}},
+    {"ih_weight_lesion",  "IH Connections Severed (proportion)", 10, {0.000, 0.001, 0.003, 0.006, 0.009, 0.015, 0.050, 0.100, 0.200, 0.400}},
+    {"context_ablate",    "Context Units Removed (proportion)", 10, {0.000, 0.001, 0.003, 0.006, 0.009, 0.015, 0.050, 0.100, 0.200, 0.400}},
+    {"weight_scale",      "Weight Scaling Factor (proportion)", 10, {1.000, 0.900, 0.800, 0.700, 0.600, 0.500, 0.400, 0.300, 0.200, 0.100}}
+};
+
+/* One job is all episodes of one task for one network at one damage level:   */
+
+typedef struct sweep_job {
+    int          net;
+    int          level;
+    BaseTaskType task;
+    int          survival[SV_STEPS];
+    int          subtasks[ERROR_CATEGORIES];
+    int          episodes;     // Episodes run so far
+    int          correct;      // ... of which error free
+    Boolean      busy;         // Adaptive mode: a round is being run
+    Boolean      settled;      // Adaptive mode: no more rounds needed
+} SweepJob;
+
+typedef struct sweep_spec {
+    DamageType       damage;
+    int              num_levels;
+    double           level[MAX_LEVELS];
+    int              episodes;     // Per cell (at most, if adaptive)
+    double           half_width;   // Target CI half-width, or 0 for fixed
+    int              batch_size;
+    uint64_t         seed;
+    Boolean          nested;
+    StateType        initial_state;
+    int              num_nets;
+    char            *file[MAX_NETS];
+    Network         *net[MAX_NETS];
+    int              num_jobs;
+    SweepJob        *job;
+    int              next_job;
+    int              unsettled;
+    pthread_mutex_t  lock;
+    pthread_cond_t   job_done;
+} SweepSpec;
+
+/******************************************************************************/
+/* Survival scoring (as in xcs_sim2_survival_viewer.c) ************************/
+
+static int get_first_difference(ActionType *this, ActionType *target, int max)
+{
+    int i = 0;
+
+    while (i < max) {
+        if (this[i] == target[i]) {
+            i++;
+        }
+        else {
+            return(i+1);
+        }
+    }
+    return(i+1);
+}
+
+static int get_first_error(ActionType *this, BaseTaskType base)
+{
+    int i1, i2, i3, i4, i5, i6;
+
+    if (base == TASK_COFFEE) {
+        i1 = get_first_difference(this, sequence_coffee1, 37);
+        i2 = get_first_difference(this, sequence_coffee2, 37);
+        i3 = get_first_difference(this, sequence_coffee3, 37);
+        i4 = get_first_difference(this, sequence_coffee4, 37);
+        i5 = get_first_difference(this, sequence_coffee5, 31);
+        i6 = get_first_difference(this, sequence_coffee6, 31);
+        return(MAX(i1, MAX(i2, MAX(i3, MAX(i4, MAX(i5, i6))))));
+    }
+    else {
+        i1 = get_first_difference(this, sequence_tea1, 20);
+        i2 = get_first_difference(this, sequence_tea2, 20);
+        i3 = get_first_difference(this, sequence_tea3, 14);
+        return(MAX(i1, MAX(i2, i3)));
+    }
+}
+
+// An episode is error free if it matches a target sequence through to its end:
+
+#define MATCHES(this, target) (get_first_difference(this, target, sizeof(target)/sizeof(ActionType)) > sizeof(target)/sizeof(ActionType))
+
+static Boolean get_error_free(ActionType *this, BaseTaskType base)
+{
+    if (base == TASK_COFFEE) {
+        return(MATCHES(this, sequence_coffee1) || MATCHES(this, sequence_coffee2) || MATCHES(this, sequence_coffee3) || MATCHES(this, sequence_coffee4) || MATCHES(this, sequence_coffee5) || MATCHES(this, sequence_coffee6));
+    }
+    else {
+        return(MATCHES(this, sequence_tea1) || MATCHES(this, sequence_tea2) || MATCHES(this, sequence_tea3));
+    }
+}
+
+#undef MATCHES
+
+/******************************************************************************/
+/* Subtask scoring (as in xcs_sim2_subtask_chart.c) ***************************/
+
+typedef enum subtask_type {
+    ST_ERROR, STEEP_TEA, ADD_COFFEE, ADD_CREAM, ADD_SUGAR_FROM_BOWL, ADD_SUGAR_FROM_PACK, DRINK_BEVERAGE
+} SubtaskType;
+
+typedef struct subtask_list {
+    int                  t0;
+    int                  t1;
+    SubtaskType          task;
+    struct subtask_list *next;
+} SubtaskList;
+
+static ActionType ACTIONS_STEEP_TEA[4] = {ACTION_FIXATE_TEABAG, ACTION_PICK_UP, ACTION_FIXATE_CUP, ACTION_DIP};
+static ActionType ACTIONS_ADD_COFFEE[10] = {ACTION_FIXATE_COFFEE_PACKET, ACTION_PICK_UP, ACTION_PULL_OPEN, ACTION_FIXATE_CUP, ACTION_POUR, ACTION_FIXATE_SPOON, ACTION_PUT_DOWN, ACTION_PICK_UP, ACTION_FIXATE_CUP, ACTION_STIR};
+static ActionType ACTIONS_ADD_CREAM[11] = {ACTION_FIXATE_CARTON, ACTION_PUT_DOWN, ACTION_PICK_UP, ACTION_PEEL_OPEN, ACTION_FIXATE_CUP, ACTION_POUR, ACTION_FIXATE_SPOON, ACTION_PUT_DOWN, ACTION_PICK_UP, ACTION_FIXATE_CUP, ACTION_STIR};
+static ActionType ACTIONS_ADD_SUGAR_FROM_BOWL[11] = {ACTION_FIXATE_SUGAR_PACKET, ACTION_PUT_DOWN, ACTION_PULL_OFF, ACTION_FIXATE_SPOON, ACTION_PUT_DOWN, ACTION_PICK_UP, ACTION_FIXATE_SUGAR_BOWL, ACTION_SCOOP, ACTION_FIXATE_CUP, ACTION_POUR, ACTION_STIR};
+static ActionType ACTIONS_ADD_SUGAR_FROM_PACK[11] = {ACTION_FIXATE_SUGAR_PACKET, ACTION_PUT_DOWN, ACTION_PICK_UP, ACTION_TEAR_OPEN, ACTION_FIXATE_CUP, ACTION_POUR, ACTION_FIXATE_SPOON, ACTION_PUT_DOWN, ACTION_PICK_UP, ACTION_FIXATE_CUP, ACTION_STIR};
+static ActionType ACTIONS_DRINK_BEVERAGE[4] = {ACTION_PUT_DOWN, ACTION_PICK_UP, ACTION_SIP, ACTION_SIP};
+
+static char *category_name[ERROR_CATEGORIES] = {
+    "Intrusion", "Omission", "Perseveration", "Displacement", "Error"
+};
+
+static void stl_free(SubtaskList *subtasks)
+{
+    SubtaskList *next;
+
+    while (subtasks != NULL) {
+        next = subtasks->next;
+        free(subtasks);
+        subtasks = next;
+    }
+}
+
+static int stl_length(SubtaskList *subtasks)
+{
+    int n = 0;
+
+    while (subtasks != NULL) {
+        subtasks = subtasks->next;
+        n++;
+    }
+    return(n);
+}
+
+static SubtaskType stl_get_nth(SubtaskList *subtasks, int n)
+{
+    while ((--n > 0) && (subtasks != NULL)) {
+        subtasks = subtasks->next;
+    }
+    if (subtasks != NULL) {
+        return(subtasks->task);
+    }
+    else {
+        return(ST_ERROR);
+    }
+}
+
+static Boolean stl_contains_subtask(SubtaskList *subtasks, SubtaskType task)
+{
+    while (subtasks != NULL) {
+        if (subtasks->task == task) {
+            return(TRUE);
+        }
+        subtasks = subtasks->next;
+    }
+    return(FALSE);
+}
+
+static Boolean stl_contains_subtask_perseveration(SubtaskList *subtasks)
+{
+    if (subtasks == NULL) {
+        return(FALSE);
+    }
+    else if (stl_contains_subtask(subtasks->next, subtasks->task)) {
+        return(TRUE);
+    }
+    else if ((subtasks->task == ADD_SUGAR_FROM_PACK) &&  stl_contains_subtask(subtasks->next, ADD_SUGAR_FROM_BOWL)) {
+        return(TRUE);
+    }
+    else if ((subtasks->task == ADD_SUGAR_FROM_BOWL) &&  stl_contains_subtask(subtasks->next, ADD_SUGAR_FROM_PACK)) {
+        return(TRUE);
+    }
+    else {
+        return(stl_contains_subtask_perseveration(subtasks->next));
+    }
+}
+
+static Boolean stl_contains_subtask_omission(SubtaskList *subtasks, BaseTaskType base)
+{
+    if (base == TASK_TEA) {
+        if (!stl_contains_subtask(subtasks, STEEP_TEA)) {
+            return(TRUE);
+        }
+        else if (!stl_contains_subtask(subtasks, ADD_SUGAR_FROM_BOWL) && !stl_contains_subtask(subtasks, ADD_SUGAR_FROM_PACK)) {
+            return(TRUE);
+        }
+        else if (!stl_contains_subtask(subtasks, DRINK_BEVERAGE)) {
+            return(TRUE);
+        }
+        else {
+            return(FALSE);
+        }
+    }
+    else if (base == TASK_COFFEE) {
+        if (!stl_contains_subtask(subtasks, ADD_COFFEE)) {
+            return(TRUE);
+        }
+        else if (!stl_contains_subtask(subtasks, ADD_SUGAR_FROM_BOWL) && !stl_contains_subtask(subtasks, ADD_SUGAR_FROM_PACK)) {
+            return(TRUE);
+        }
+        else if (!stl_contains_subtask(subtasks, ADD_CREAM)) {
+            return(TRUE);
+        }
+        else if (!stl_contains_subtask(subtasks, DRINK_BEVERAGE)) {
+            return(TRUE);
+        }
+        else {
+            return(FALSE);
+        }
+    }
+    else {
+        return(FALSE);
+    }
+}
+
+static Boolean stl_contains_subtask_intrusion(SubtaskList *subtasks, BaseTaskType base)
+{
+    if (base == TASK_TEA) {
+        if (stl_contains_subtask(subtasks, ADD_CREAM)) {
+            return(TRUE);
+        }
+    }
+    return(FALSE);
+}
+
+static Boolean stl_contains_subtask_displacement(SubtaskList *subtasks, BaseTaskType base)
+{
+    if (base == TASK_TEA) {
+        if (stl_length(subtasks) != 3) {
+            return(TRUE);
+        }
+        else if (stl_get_nth(subtasks, 1) != STEEP_TEA) {
+            return(TRUE);
+        }
+        else if (stl_get_nth(subtasks, 3) != DRINK_BEVERAGE) {
+            return(TRUE);
+        }
+        else if (stl_get_nth(subtasks, 2) == ADD_SUGAR_FROM_BOWL) {
+            return(FALSE);
+        }
+        else if (stl_get_nth(subtasks, 2) == ADD_SUGAR_FROM_PACK) {
+            return(FALSE);
+        }
+        else {
+            return(TRUE);
+        }
+    }
+    else if (base == TASK_COFFEE) {
+        if (stl_length(subtasks) != 4) {
+            return(TRUE);
+        }
+        else if (stl_get_nth(subtasks, 1) != ADD_COFFEE) {
+            return(TRUE);
+        }
+        else if (stl_get_nth(subtasks, 4) != DRINK_BEVERAGE) {
+            return(TRUE);
+        }
+        else if ((stl_get_nth(subtasks, 2) == ADD_SUGAR_FROM_BOWL) && (stl_get_nth(subtasks, 3) == ADD_CREAM)) {
+            return(FALSE);
+        }
+        else if ((stl_get_nth(subtasks, 2) == ADD_SUGAR_FROM_PACK) && (stl_get_nth(subtasks, 3) == ADD_CREAM)) {
+            return(FALSE);
+        }
+        else if ((stl_get_nth(subtasks, 3) == ADD_SUGAR_FROM_BOWL) && (stl_get_nth(subtasks, 2) == ADD_CREAM)) {
+            return(FALSE);
+        }
+        else if ((stl_get_nth(subtasks, 3) == ADD_SUGAR_FROM_PACK) && (stl_get_nth(subtasks, 2) == ADD_CREAM)) {
+            return(FALSE);
+        }
+        else {
+            return(TRUE);
+        }
+    }
+    else {
+        return(FALSE);
+    }
+}
+
+static Boolean action_sequence_compare(ActionType *sequence, int t0, ActionType *list, int l)
+{
+    if (t0 + l > MAX_STEPS) {
+        return(FALSE);
+    }
+    while (l-- > 0) {
+        if (sequence[t0+l] != list[l]) {
+            return(FALSE);
+        }
+    }
+    return(TRUE);
+}
+
+static SubtaskList *get_subtask(ActionType *this, int t0)
+{
+    SubtaskList *new;
+
+    if ((new = (SubtaskList *)malloc(sizeof(SubtaskList))) == NULL) {
+        fprintf(stderr, "WARNING: Memory allocation failure in get_subtask()\n");
+    }
+    else if (action_sequence_compare(this, t0, ACTIONS_STEEP_TEA, 4)) {
+        new->t0 = t0;
+        new->task = STEEP_TEA;
+        new->t1 = t0 + 3;
+    }
+    else if (action_sequence_compare(this, t0, ACTIONS_ADD_COFFEE, 10)) {
+        new->t0 = t0;
+        new->task = ADD_COFFEE;
+        new->t1 = t0 + 9;
+    }
+    else if (action_sequence_compare(this, t0, ACTIONS_ADD_CREAM, 11)) {
+        new->t0 = t0;
+        new->task = ADD_CREAM;
+        new->t1 = t0 + 10;
+    }
+    else if (action_sequence_compare(this, t0, ACTIONS_ADD_SUGAR_FROM_BOWL, 11)) {
+        new->t0 = t0;
+        new->task = ADD_SUGAR_FROM_BOWL;
+        new->t1 = t0 + 10;
+    }
+    else if (action_sequence_compare(this, t0, ACTIONS_ADD_SUGAR_FROM_PACK, 11)) {
+        new->t0 = t0;
+        new->task = ADD_SUGAR_FROM_PACK;
+        new->t1 = t0 + 10;
+    }
+    else if (action_sequence_compare(this, t0, ACTIONS_DRINK_BEVERAGE, 4)) {
+        new->t0 = t0;
+        new->task = DRINK_BEVERAGE;
+        new->t1 = t0 + 3;
+    }
+    else {
+        free(new);
+        new = NULL;
+    }
+    return(new);
+}
+
+static SubtaskList *st_error(int t0)
+{
+    SubtaskList *new;
+
+    if ((new = (SubtaskList *)malloc(sizeof(SubtaskList))) == NULL) {
+        fprintf(stderr, "WARNING: Memory allocation failure in st_error()\n");
+    }
+    else {
+        new->task = ST_ERROR;
+        new->t0 = t0;
+        new->t1 = t0;
+        new->next = NULL;
+    }
+    return(new);
+}
+
+static SubtaskList *parse_subtasks(ActionType *this, int t0)
+{
+    SubtaskList *st, *new;
+
+    if (t0 >= MAX_STEPS) {
+        return(st_error(t0));
+    }
+    else if (this[t0] == ACTION_SAY_DONE) {
+        return(NULL);
+    }
+    else if ((st = get_subtask(this, t0)) != NULL) {
+        st->next = parse_subtasks(this, st->t1 + 1);
+        return(st);
+    }
+    else if ((new = st_error(t0)) != NULL) {
+        while ((new->t1 < MAX_STEPS) && ((st = get_subtask(this, new->t1 + 1)) == NULL)) {
+            new->t1++;
+        }
+        new->next = st;
+        if (st != NULL) {
+            st->next = parse_subtasks(this, st->t1 + 1);
+        }
+        return(new);
+    }
+    else {
+        return(NULL);
+    }
+}
+
+static void action_list_score(ActionType *this, BaseTaskType base, int *subtasks_data)
+{
+    SubtaskList *subtasks;
+
+    subtasks = parse_subtasks(this, 0);
+
+    if (stl_contains_subtask(subtasks, ST_ERROR)) {
+        subtasks_data[4]++;
+    }
+    else if (stl_contains_subtask_perseveration(subtasks)) {
+        subtasks_data[2]++;
+    }
+    else if (stl_contains_subtask_omission(subtasks, base)) {
+        subtasks_data[1]++;
+    }
+    else if (stl_contains_subtask_intrusion(subtasks, base)) {
+        subtasks_data[0]++;
+    }
+    else if (stl_contains_subtask_displacement(subtasks, base)) {
+        subtasks_data[3]++;
+    }
+
+    stl_free(subtasks);
+}
+
+/******************************************************************************/
+/* Running episodes ***********************************************************/
+
+static void apply_weight_damage(DamageOverlay *overlay, DamageType damage, double level, Boolean nested)
+{
+    damage_overlay_clear(overlay);
+
+    if (nested && (damage == DAMAGE_CH_WEIGHT_LESION)) {
+        damage_overlay_rank_weights(overlay);
+        damage_overlay_lesion_nested_ch(overlay, level);
+        return;
+    }
+    else if (nested && (damage == DAMAGE_IH_WEIGHT_LESION)) {
+        damage_overlay_rank_weights(overlay);
+        damage_overlay_lesion_nested_ih(overlay, level);
+        return;
+    }
+
+    switch (damage) {
+        case DAMAGE_CH_WEIGHT_NOISE: {
+            damage_overlay_perturb_weights_ch(overlay, level);
+            break;
+        }
+        case DAMAGE_CH_WEIGHT_LESION: {
+            damage_overlay_lesion_weights_ch(overlay, level);
+            break;
+        }
+        case DAMAGE_IH_WEIGHT_NOISE: {
+            damage_overlay_perturb_weights_ih(overlay, level);
+            break;
+        }
+        case DAMAGE_IH_WEIGHT_LESION: {
+            damage_overlay_lesion_weights_ih(overlay, level);
+            break;
+        }
+        case DAMAGE_CONTEXT_ABLATE: {
+            damage_overlay_ablate_context(overlay, level);
+            break;
+        }
+        case DAMAGE_WEIGHT_SCALE: {
+            damage_overlay_scale_weights(overlay, level);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+/* Episodes of a job are run in batches: Each row of the batch has its own   */
+/* world and hidden state, and all rows are advanced in lock-step, so that   */
+/* rows sharing weights are propagated together as one matrix product.       */
+/* Weight damage is held in a per-row overlay on the shared weights.         */
+
+typedef struct sweep_worker {
+    NetworkBatch  *batch;
+    WorldContext  *wc[MAX_BATCH];
+    DamageOverlay *damage[MAX_BATCH];
+    RandomStream   rng[MAX_BATCH];
+    Network       *nets[MAX_BATCH];
+    ActionType    this[MAX_BATCH][MAX_STEPS];
+} SweepWorker;
+
+static void run_batch(SweepWorker *sw, TaskType *task, double level, int n)
+{
+    NetworkBatch *batch = sw->batch;
+    double vector_in[IN_WIDTH];
+    double vector_out[OUT_WIDTH];
+    int count[MAX_BATCH];
+    int b, remaining = n;
+
+    for (b = 0; b < batch->size; b++) {
+        batch->active[b] = (b < n);
+    }
+    for (b = 0; b < n; b++) {
+        random_stream_select(&sw->rng[b]);
+        world_context_initialise(sw->wc[b], task);
+        network_batch_randomise_hidden_units(batch, b);
+        count[b] = 0;
+    }
+
+    while (remaining > 0) {
+        for (b = 0; b < n; b++) {
+            if (batch->active[b]) {
+                world_context_set_network_input_vector(sw->wc[b], vector_in);
+                network_batch_tell_input(batch, b, vector_in);
+            }
+        }
+        network_batch_propagate2(batch, sw->nets, sw->damage);
+        for (b = 0; b < n; b++) {
+            if (batch->active[b]) {
+                ActionType act;
+
+                random_stream_select(&sw->rng[b]);
+                network_batch_ask_output(batch, b, vector_out);
+                act = world_get_network_output_action(NULL, vector_out);
+                sw->this[b][count[b]] = act;
+                world_context_perform_action(sw->wc[b], act);
+                if (task->damage == DAMAGE_ACTIVATION_NOISE) {
+                    network_batch_inject_noise(batch, b, level*level);
+                }
+                if ((act == ACTION_SAY_DONE) || (++count[b] >= MAX_STEPS)) {
+                    /* Mask out the finished episode, and pad out the remainder */
+                    /* of its action list (unused steps are never a match):     */
+                    batch->active[b] = FALSE;
+                    remaining--;
+                    while (++count[b] < MAX_STEPS) {
+                        sw->this[b][count[b]] = ACTION_NONE;
+                    }
+                }
+            }
+        }
+    }
+    random_stream_select(NULL);
+}
+
+static void run_job(SweepSpec *spec, SweepJob *job, SweepWorker *sw, int e0, int episodes)
+{
+    /* Run episodes e0 ... e0+episodes-1 of the job: */
+
+    TaskType task;
+    double level = spec->level[job->level];
+    Network *pristine = spec->net[job->net];
+    Boolean weight_damage;
+    int count, e, b, n;
+
+    task.base = job->task;
+    task.damage = spec->damage;
+    task.initial_state = spec->initial_state;
+
+    weight_damage = (spec->damage != DAMAGE_NONE) && (spec->damage != DAMAGE_ACTIVATION_NOISE);
+
+    for (e = e0; e < e0 + episodes; e += n) {
+        n = MIN(spec->batch_size, e0 + episodes - e);
+        for (b = 0; b < n; b++) {
+            /* All rows share the pristine weights. Weight damage is fresh */
+            /* for each episode:                                           */
+            random_stream_initialise(&sw->rng[b], spec->seed, job->net, spec->nested ? 0 : job->level, job->task, e + b);
+            sw->nets[b] = pristine;
+            if (weight_damage) {
+                random_stream_select(&sw->rng[b]);
+                apply_weight_damage(sw->damage[b], spec->damage, level, spec->nested);
+            }
+        }
+        random_stream_select(NULL);
+        run_batch(sw, &task, level, n);
+
+        PROFILE_ENTER(PROFILE_CLASSIFY);
+        for (b = 0; b < n; b++) {
+            count = MIN(get_first_error(sw->this[b], job->task), SV_STEPS);
+            while (count-- > 0) {
+                job->survival[count]++;
+            }
+            action_list_score(sw->this[b], job->task, job->subtasks);
+            if (get_error_free(sw->this[b], job->task)) {
+                job->correct++;
+            }
+        }
+        PROFILE_EXIT(PROFILE_CLASSIFY);
+        job->episodes += n;
+    }
+}
+
+static double job_half_width(SweepJob *job)
+{
+    /* Half-width of the 95% (Agresti-Coull) interval on the proportion of */
+    /* error-free episodes. Unlike the Wald interval it does not collapse  */
+    /* to zero when no episode (or every episode) has been error free:     */
+
+    double n = job->episodes + 4.0;
+    double p = (job->correct + 2.0) / n;
+
+    return(1.96 * sqrt(p * (1.0 - p) / n));
+}
+
+static int next_adaptive_job(SweepSpec *spec)
+{
+    /* The idle unsettled job with the widest interval, or -1 if none: */
+
+    double w, widest = -1.0;
+    int j, best = -1;
+
+    for (j = 0; j < spec->num_jobs; j++) {
+        if (!spec->job[j].busy && !spec->job[j].settled) {
+            if ((w = job_half_width(&spec->job[j])) > widest) {
+                widest = w;
+                best = j;
+            }
+        }
+    }
+    return(best);
+}
+
+static void sweep_worker_free(SweepWorker *sw)
+{
+    int b;
+
+    for (b = 0; b < MAX_BATCH; b++) {
+        world_context_free(sw->wc[b]);
+        damage_overlay_destroy(sw->damage[b]);
+    }
+    network_batch_destroy(sw->batch);
+    free(sw);
+}
+
+static SweepWorker *sweep_worker_create(SweepSpec *spec)
+{
+    SweepWorker *sw;
+    Boolean weight_damage;
+    int b;
+
+    weight_damage = (spec->damage != DAMAGE_NONE) && (spec->damage != DAMAGE_ACTIVATION_NOISE);
+
+    if ((sw = (SweepWorker *)calloc(1, sizeof(SweepWorker))) == NULL) {
+        return(NULL);
+    }
+    else if ((sw->batch = network_batch_create(spec->batch_size, IN_WIDTH, HIDDEN_WIDTH, OUT_WIDTH)) == NULL) {
+        sweep_worker_free(sw);
+        return(NULL);
+    }
+    for (b = 0; b < spec->batch_size; b++) {
+        if ((sw->wc[b] = world_context_create()) == NULL) {
+            sweep_worker_free(sw);
+            return(NULL);
+        }
+        else if (weight_damage && ((sw->damage[b] = damage_overlay_create(spec->net[0])) == NULL)) {
+            sweep_worker_free(sw);
+            return(NULL);
+        }
+    }
+    return(sw);
+}
+
+static void *sweep_thread(void *arg)
+{
+    SweepSpec *spec = (SweepSpec *)arg;
+    SweepWorker *sw;
+    int j;
+
+    if ((sw = sweep_worker_create(spec)) == NULL) {
+        fprintf(stderr, "ERROR: Cannot allocate batch for worker thread\n");
+        return(NULL);
+    }
+
+    if (spec->half_width > 0.0) {
+        /* Adaptive: run a round of the neediest job, then decide whether */
+        /* it needs more. Wait if every unsettled job is busy:            */
+        pthread_mutex_lock(&spec->lock);
+        while (spec->unsettled > 0) {
+            if ((j = next_adaptive_job(spec)) < 0) {
+                pthread_cond_wait(&spec->job_done, &spec->lock);
+            }
+            else {
+                SweepJob *job = &spec->job[j];
+
+                job->busy = TRUE;
+                pthread_mutex_unlock(&spec->lock);
+                run_job(spec, job, sw, job->episodes, MIN(ADAPTIVE_ROUND, spec->episodes - job->episodes));
+                pthread_mutex_lock(&spec->lock);
+                job->busy = FALSE;
+                if ((job->episodes >= spec->episodes) || (job_half_width(job) < spec->half_width)) {
+                    job->settled = TRUE;
+                    spec->unsettled--;
+                }
+                pthread_cond_broadcast(&spec->job_done);
+            }
+        }
+        pthread_mutex_unlock(&spec->lock);
+    }
+    else {
+        do {
+            pthread_mutex_lock(&spec->lock);
+            j = spec->next_job++;
+            pthread_mutex_unlock(&spec->lock);
+            if (j < spec->num_jobs) {
+                run_job(spec, &spec->job[j], sw, 0, spec->episodes);
+            }
+        } while (j < spec->num_jobs);
+    }
+
+    sweep_worker_free(sw);
+    return(NULL);
+}
+
+/******************************************************************************/
+/* Input and output ***********************************************************/
+
+static Network *load_network(char *file)
+{
+    Network *net;
+    int j;
+
+    if ((net = network_create(IN_WIDTH, HIDDEN_WIDTH, OUT_WIDTH)) == NULL) {
+        fprintf(stderr, "ERROR: Cannot allocate network for %s\n", file);
+        return(NULL);
+    }
+    else if ((j = network_restore_weights_from_file(file, net)) < 0) {
+        fprintf(stderr, "ERROR: Cannot read %s ... weights not restored\n", file);
+        network_tell_destroy(net);
+        return(NULL);
+    }
+    else if (j > 0) {
+        fprintf(stderr, "ERROR: Weight file format error %d in %s ... weights not restored\n", j, file);
+        network_tell_destroy(net);
+        return(NULL);
+    }
+    else {
+        return(net);
+    }
+}
+
+static void write_header(FILE *fp, SweepSpec *spec)
+{
+    int n;
+
+    if (spec->half_width > 0.0) {
+        fprintf(fp, "# Damage: %s; Episodes per cell: Until 95%% CI within +/-%5.3f (at most %d); Seed: %llu%s\n", sweep_dd[spec->damage].label, spec->half_width, spec->episodes, (unsigned long long) spec->seed, spec->nested ? "; Nested" : "");
+    }
+    else {
+        fprintf(fp, "# Damage: %s; Episodes per cell: %d; Seed: %llu%s\n", sweep_dd[spec->damage].label, spec->episodes, (unsigned long long) spec->seed, spec->nested ? "; Nested" : "");
+    }
+    for (n = 0; n < spec->num_nets; n++) {
+        fprintf(fp, "# Network %d: %s\n", n, spec->file[n]);
+    }
+}
+
+static Boolean write_survival_table(char *filename, SweepSpec *spec)
+{
+    FILE *fp;
+    int j, i;
+
+    if ((fp = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "ERROR: Cannot write to %s\n", filename);
+        return(FALSE);
+    }
+    write_header(fp, spec);
+    fprintf(fp, "Level\tTask\tNetwork%s", (spec->half_width > 0.0) ? "\tEpisodes" : "");
+    for (i = 0; i < SV_STEPS; i++) {
+        fprintf(fp, "\tStep %d", i+1);
+    }
+    fprintf(fp, "\n");
+    for (j = 0; j < spec->num_jobs; j++) {
+        SweepJob *job = &spec->job[j];
+        fprintf(fp, "%5.3f\t%s\t%d", spec->level[job->level], task_name[job->task], job->net);
+        if (spec->half_width > 0.0) {
+            fprintf(fp, "\t%d", job->episodes);
+        }
+        for (i = 0; i < SV_STEPS; i++) {
+            fprintf(fp, "\t%d", job->survival[i]);
+        }
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+    return(TRUE);
+}
+
+static Boolean write_subtask_table(char *filename, SweepSpec *spec)
+{
+    FILE *fp;
+    int j, i;
+
+    if ((fp = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "ERROR: Cannot write to %s\n", filename);
+        return(FALSE);
+    }
+    write_header(fp, spec);
+    fprintf(fp, "Level\tTask\tNetwork%s", (spec->half_width > 0.0) ? "\tEpisodes" : "");
+    for (i = 0; i < ERROR_CATEGORIES; i++) {
+        fprintf(fp, "\t%s", category_name[i]);
+    }
+    fprintf(fp, "\n");
+    for (j = 0; j < spec->num_jobs; j++) {
+        SweepJob *job = &spec->job[j];
+        fprintf(fp, "%5.3f\t%s\t%d", spec->level[job->level], task_name[job->task], job->net);
+        if (spec->half_width > 0.0) {
+            fprintf(fp, "\t%d", job->episodes);
+        }
+        for (i = 0; i < ERROR_CATEGORIES; i++) {
+            fprintf(fp, "\t%d", job->subtasks[i]);
+        }
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+    return(TRUE);
+}
+
+/******************************************************************************/
+
+static DamageType parse_damage(char *arg)
+{
+    int d;
+
+    for (d = 0; d < 8; d++) {
+        if (strcmp(arg, sweep_dd[d].name) == 0) {
+            return((DamageType) d);
+        }
+    }
+    d = atoi(arg);
+    if ((d > 0) && (d < 8)) {
+        return((DamageType) d);
+    }
+    fprintf(stderr, "WARNING: Unknown damage type %s; using activation_noise\n", arg);
+    return(DAMAGE_ACTIVATION_NOISE);
+}
+
+static int parse_levels(char *arg, double *level)
+{
+    char *p = arg;
+    int n = 0;
+
+    while ((n < MAX_LEVELS) && (*p != '\0')) {
+        level[n++] = strtod(p, &p);
+        if (*p == ',') {
+            p++;
+        }
+        else {
+            break;
+        }
+    }
+    return(n);
+}
+
+static void print_usage(FILE *fp)
+{
+    int d;
+
+    fprintf(fp, "Usage: bp_sweep [-d damage] [-l l1,l2,...] [-n episodes] [-j threads]\n");
+    fprintf(fp, "                [-B batch] [-t coffee|tea|both] [-b] [-N] [-a width] [-s seed]\n");
+    fprintf(fp, "                [-o prefix] weight_file ...\n");
+    fprintf(fp, "With -a, run each cell until the 95%% CI on its proportion of error-free\n");
+    fprintf(fp, "episodes is within +/-width, or for at most -n episodes\n");
+    fprintf(fp, "Damage types:\n");
+    for (d = 1; d < 8; d++) {
+        fprintf(fp, "  %d: %-18s %s\n", d, sweep_dd[d].name, sweep_dd[d].label);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    SweepSpec spec;
+    pthread_t thread[MAX_THREADS];
+    char filename[256];
+    char *prefix = "sweep";
+    char *level_arg = NULL;
+    BaseTaskType t0 = TASK_COFFEE, t1 = TASK_TEA;
+    int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int i, j, k, n, t;
+
+    memset(&spec, 0, sizeof(SweepSpec));
+    spec.damage = DAMAGE_ACTIVATION_NOISE;
+    spec.episodes = 100;
+    spec.batch_size = 64;
+    spec.seed = (uint64_t) time(NULL);
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-d") == 0) && (i+1 < argc)) {
+            spec.damage = parse_damage(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-l") == 0) && (i+1 < argc)) {
+            level_arg = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-n") == 0) && (i+1 < argc)) {
+            spec.episodes = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-B") == 0) && (i+1 < argc)) {
+            spec.batch_size = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-j") == 0) && (i+1 < argc)) {
+            threads = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-t") == 0) && (i+1 < argc)) {
+            i++;
+            if (strcmp(argv[i], "coffee") == 0) {
+                t0 = t1 = TASK_COFFEE;
+            }
+            else if (strcmp(argv[i], "tea") == 0) {
+                t0 = t1 = TASK_TEA;
+            }
+        }
+        else if (strcmp(argv[i], "-b") == 0) {
+            spec.initial_state.bowl_closed = TRUE;
+        }
+        else if (strcmp(argv[i], "-N") == 0) {
+            spec.nested = TRUE;
+        }
+        else if ((strcmp(argv[i], "-a") == 0) && (i+1 < argc)) {
+            spec.half_width = atof(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-s") == 0) && (i+1 < argc)) {
+            spec.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if ((strcmp(argv[i], "-o") == 0) && (i+1 < argc)) {
+            prefix = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-h") == 0) || (argv[i][0] == '-')) {
+            print_usage(stderr);
+            exit(1);
+        }
+        else if (spec.num_nets < MAX_NETS) {
+            spec.file[spec.num_nets++] = argv[i];
+        }
+    }
+
+    if (level_arg != NULL) {
+        spec.num_levels = parse_levels(level_arg, spec.level);
+    }
+    else {
+        spec.num_levels = sweep_dd[spec.damage].num_levels;
+        for (k = 0; k < spec.num_levels; k++) {
+            spec.level[k] = sweep_dd[spec.damage].level[k];
+        }
+    }
+    if (spec.nested && (spec.damage != DAMAGE_CH_WEIGHT_LESION) && (spec.damage != DAMAGE_IH_WEIGHT_LESION)) {
+        fprintf(stderr, "WARNING: Nested damage (-N) applies only to connection lesions; ignored\n");
+        spec.nested = FALSE;
+    }
+#ifdef PROFILE
+    g_snprintf(filename, 256, "%s_profile.dat", prefix);
+    profile_report_at_exit(filename);
+#endif
+    threads = MAX(1, MIN(threads, MAX_THREADS));
+    spec.batch_size = MAX(1, MIN(spec.batch_size, MAX_BATCH));
+
+    /* Load the weights (defaulting to those used by the xbp viewers): */
+
+    if (spec.num_nets == 0) {
+        static char default_file[12][64];
+        for (n = 0; n < 12; n++) {
+            g_snprintf(default_file[n], 64, "Weights/srn_20000_%02d.wgt", n+1);
+            if (access(default_file[n], R_OK) == 0) {
+                spec.file[spec.num_nets++] = default_file[n];
+            }
+        }
+    }
+    for (n = 0; n < spec.num_nets; n++) {
+        if ((spec.net[n] = load_network(spec.file[n])) == NULL) {
+            exit(1);
+        }
+    }
+    if (spec.num_nets == 0) {
+        fprintf(stderr, "ERROR: No weight files\n");
+        print_usage(stderr);
+        exit(1);
+    }
+
+    /* Build the job list (all initialised to zero counts): */
+
+    spec.num_jobs = spec.num_levels * spec.num_nets * (t1 - t0 + 1);
+    if ((spec.job = (SweepJob *)calloc(spec.num_jobs, sizeof(SweepJob))) == NULL) {
+        fprintf(stderr, "ERROR: Cannot allocate %d jobs\n", spec.num_jobs);
+        exit(1);
+    }
+    j = 0;
+    for (k = 0; k < spec.num_levels; k++) {
+        for (t = t0; t <= t1; t++) {
+            for (n = 0; n < spec.num_nets; n++) {
+                spec.job[j].level = k;
+                spec.job[j].task = (BaseTaskType) t;
+                spec.job[j].net = n;
+                j++;
+            }
+        }
+    }
+
+    spec.unsettled = spec.num_jobs;
+    pthread_mutex_init(&spec.lock, NULL);
+    pthread_cond_init(&spec.job_done, NULL);
+
+    fprintf(stdout, "%s: %d levels x %d networks x %d tasks x %s%d episodes on %d threads\n", sweep_dd[spec.damage].label, spec.num_levels, spec.num_nets, t1 - t0 + 1, (spec.half_width > 0.0) ? "at most " : "", spec.episodes, threads);
+    fprintf(stdout, "BEFORE: User time: %f; System time: %f\n", usertime()*0.001, systime()*0.001);
+
+    for (i = 0; i < threads; i++) {
+        pthread_create(&thread[i], NULL, sweep_thread, &spec);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(thread[i], NULL);
+    }
+
+    fprintf(stdout, "AFTER:  User time: %f; System time: %f\n", usertime()*0.001, systime()*0.001);
+    if (spec.half_width > 0.0) {
+        for (j = 0, k = 0; j < spec.num_jobs; j++) {
+            k += spec.job[j].episodes;
+        }
+        fprintf(stdout, "Episodes run: %d of at most %d\n", k, spec.num_jobs * spec.episodes);
+    }
+
+    g_snprintf(filename, 256, "%s_survival.dat", prefix);
+    write_survival_table(filename, &spec);
+    g_snprintf(filename, 256, "%s_subtasks.dat", prefix);
+    write_subtask_table(filename, &spec);
+
+    pthread_cond_destroy(&spec.job_done);
+    pthread_mutex_destroy(&spec.lock);
+    for (n = 0; n < spec.num_nets; n++) {
+        network_tell_destroy(spec.net[n]);
+    }
+    free(spec.job);
+    exit(0);
+}
+
+/******************************************************************************/
@@ -5,14 +5,19 @@ Contents:
 Created:
     Richard Cooper, Sat Aug 15 15:54:44 1998
 Public procedures:
-    void action_log_initialise();
-    void action_log_record(ActionType act, int cycle, char *arg1, char *arg2)
+    void action_log_initialise(ActionLog *log);
+    void action_log_free(ActionLog *log);
+    void action_log_record(ActionLog *log, ActionType act, int cycle, ObjectType arg1, ObjectType arg2)
     void action_log_print();
+    void analyse_context_with_acs1(WorldContext *wc, TaskType *task, ACS1 *results)
+    GList *analyse_context_with_acs2(WorldContext *wc, TaskType *task, ACS2 *results)
+    void analyse_context_count_with_acs2(WorldContext *wc, TaskType *task, ACS2 *results)
     void ActAnalyseList(FILE *fp)
 
 *******************************************************************************/
 
 #include "bp.h"
+#include "lib_profile.h"
 #include <glib.h>
 #include <string.h>
 #include "lib_string.h"
@@ -22,11 +27,14 @@ Public procedures:
 typedef enum a3_label {ANOMOLOUS_A3, PREPARE_COFFEE, PREPARE_TEA} A3Label;
 typedef enum a2_label {ANOMOLOUS_A2, ADD_COFFEE, STEEP_TEA, ADD_SUGAR, ADD_MILK, STIR_DRINK, DRINK_BEVERAGE, A2_BREAK, A2_DOUBLE_BREAK} A2Label;
 
+#define ACTION_LOG_BLOCK 64
+
 typedef struct action_list {
     ActionType          act;
     int                 cycle;
-    char               *arg1;
-    char               *arg2;
+    ObjectType          arg1;
+    ObjectType          arg2;
+    ObjectType          spoon;          // What the spoon holds before the action
     A2Label             subtask;
     A3Label             task;
     Boolean             a2_open;
@@ -36,42 +44,90 @@ typedef struct action_list {
     Boolean             crux;
     Boolean             independent;
     Boolean             correct;
+    Boolean             pour_ahead;     // Something is poured into the mug later
+    Boolean             lid_to_mug;     // The lid is next poured into the mug
+    Boolean             stir_ahead;     // The mug is stirred later
+    int                 pours_ahead;    // Pours into the mug (up to 2) before then
     struct action_list *next;
     struct action_list *prev;
 } ActionList;
 
-static ActionList *first_action = NULL;
-static ActionList *last_action  = NULL;
+/* The names of the objects, as in world.c: */
 
-extern void action_log_report(char *string);
+static char *object_name[OBJECT_NONE+1] = {"mug", "teabag", "coffee packet", "sugar packet", "spoon", "cream carton", "sugar bowl", "lid", "nothing"};
 
-static Boolean task_complete;
+extern void action_log_report(char *string);
 
 /******************************************************************************/
 /********* Constructing the action/event list: ********************************/
 
-void action_log_initialise()
+/* The records live in the log's arena, which keeps its memory from one     */
+/* episode to the next. Records are only ever added at the end, so the list  */
+/* is the arena in order and can be relinked if the arena has to move.      */
+
+void action_log_initialise(ActionLog *log)
+{
+    log->length = 0;
+    log->first = NULL;
+    log->last = NULL;
+}
+
+void action_log_free(ActionLog *log)
+{
+    free(log->arena);
+    log->arena = NULL;
+    log->capacity = 0;
+    action_log_initialise(log);
+}
+
+static Boolean action_log_grow(ActionLog *log)
 {
-    while (first_action != NULL) {
-        ActionList *tmp = first_action;
-        first_action = first_action->next;
-        free(tmp);
+    ActionList *arena;
+    int capacity = log->capacity + ACTION_LOG_BLOCK;
+    int i;
+
+    if ((arena = (ActionList *)realloc(log->arena, capacity * sizeof(ActionList))) == NULL) {
+        return(FALSE);
+    }
+    for (i = 0; i < log->length; i++) {
+        arena[i].prev = (i > 0) ? &arena[i-1] : NULL;
+        arena[i].next = (i < log->length - 1) ? &arena[i+1] : NULL;
     }
-    last_action = NULL;
+    log->arena = arena;
+    log->capacity = capacity;
+    if (log->length > 0) {
+        log->first = &arena[0];
+        log->last = &arena[log->length - 1];
+    }
+    return(TRUE);
 }
 
-void action_log_record(ActionType act, int cycle, char *arg1, char *arg2)
+void action_log_record(ActionLog *log, ActionType act, int cycle, ObjectType arg1, ObjectType arg2)
 {
-    ActionList *new;
+    ActionList *new, *prev = log->last;
 
-    if ((new = (ActionList *)malloc(sizeof(ActionList))) == NULL) {
+    if ((log->length == log->capacity) && !action_log_grow(log)) {
         fprintf(stderr, "WARNING: Memory allocation failed in action_log_record()\n");
     }
     else {
+        new = &log->arena[log->length++];
         new->act = act;
         new->cycle = cycle;
         new->arg1 = arg1;
         new->arg2 = arg2;
+        /* Track the spoon's contents as the actions arrive: */
+        if (prev == NULL) {
+            new->spoon = OBJECT_NONE;
+        }
+        else if ((prev->act == ACTION_SCOOP) && (prev->arg2 == OBJECT_SPOON)) {
+            new->spoon = prev->arg1;
+        }
+        else if ((prev->act == ACTION_POUR) && (prev->arg1 == OBJECT_SPOON)) {
+            new->spoon = OBJECT_NONE;
+        }
+        else {
+            new->spoon = prev->spoon;
+        }
         new->subtask = ANOMOLOUS_A2;
         new->task = ANOMOLOUS_A3;
         new->a2_open = FALSE;
@@ -82,15 +138,14 @@ void action_log_record(ActionType act, int cycle, char *arg1, char *arg2)
         new->independent = FALSE;
         new->correct = FALSE;
         new->next = NULL;
-        new->prev = last_action;
-    }
-    if (last_action == NULL) {
-        first_action = new;
-        last_action = new;
-    }
-    else {
-        last_action->next = new;
-        last_action = new;
+        new->prev = prev;
+        if (prev == NULL) {
+            log->first = new;
+        }
+        else {
+            prev->next = new;
+        }
+        log->last = new;
     }
 }
 
@@ -142,47 +197,47 @@ static void print_action(ActionList *action)
 
     switch (action->act) {
         case ACTION_PICK_UP: {
-            g_snprintf(buffer, 128, "pick_up(%s)", action->arg1);
+            g_snprintf(buffer, 128, "pick_up(%s)", object_name[action->arg1]);
             break;
         }
         case ACTION_PUT_DOWN: {
-            g_snprintf(buffer, 128, "put_down(%s)", action->arg1);
+            g_snprintf(buffer, 128, "put_down(%s)", object_name[action->arg1]);
             break;
         }
         case ACTION_POUR: {
-            g_snprintf(buffer, 128, "pour(%s, %s)", action->arg1, action->arg2);
+            g_snprintf(buffer, 128, "pour(%s, %s)", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_PEEL_OPEN: {
-            g_snprintf(buffer, 128, "peel_open(%s)", action->arg1);
+            g_snprintf(buffer, 128, "peel_open(%s)", object_name[action->arg1]);
             break;
         }
         case ACTION_TEAR_OPEN: {
-            g_snprintf(buffer, 128, "tear_open(%s)", action->arg1);
+            g_snprintf(buffer, 128, "tear_open(%s)", object_name[action->arg1]);
             break;
         }
         case ACTION_PULL_OPEN: {
-            g_snprintf(buffer, 128, "pull_open(%s)", action->arg1);
+            g_snprintf(buffer, 128, "pull_open(%s)", object_name[action->arg1]);
             break;
         }
         case ACTION_PULL_OFF: {
-            g_snprintf(buffer, 128, "pull_off(%s, %s)", action->arg1, action->arg2);
+            g_snprintf(buffer, 128, "pull_off(%s, %s)", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_SCOOP: {
-            g_snprintf(buffer, 128, "scoop(%s, %s)", action->arg1, action->arg2);
+            g_snprintf(buffer, 128, "scoop(%s, %s)", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_SIP: {
-            g_snprintf(buffer, 128, "sip(%s)", action->arg1);
+            g_snprintf(buffer, 128, "sip(%s)", object_name[action->arg1]);
             break;
         }
         case ACTION_STIR: {
-            g_snprintf(buffer, 128, "stir(%s, %s)", action->arg1, action->arg2);
+            g_snprintf(buffer, 128, "stir(%s, %s)", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_DIP: {
-            g_snprintf(buffer, 128, "dip(%s, %s)", action->arg1, action->arg2);
+            g_snprintf(buffer, 128, "dip(%s, %s)", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_SAY_DONE: {
@@ -190,7 +245,7 @@ static void print_action(ActionList *action)
             break;
         }
         default: {
-            g_snprintf(buffer, 128, "default(%d, %p, %p)", (int) action->act, action->arg1, action->arg2);
+            g_snprintf(buffer, 128, "default(%d, %s, %s)", (int) action->act, object_name[action->arg1], object_name[action->arg2]);
             break;
         }
     }
@@ -204,9 +259,10 @@ static void print_action(ActionList *action)
 
 void action_log_print()
 {
+    ActionLog *log = world_context_action_log(world_context_default());
     ActionList *tmp;
 
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
+    for (tmp = log->first; tmp != NULL; tmp = tmp->next) {
         print_action(tmp);
     }
 }
@@ -217,47 +273,47 @@ static void print_action_to_file(FILE *fp, ActionList *action)
 {
     switch (action->act) {
         case ACTION_PICK_UP: {
-            fprintf(fp, "pick_up(%s)\n", action->arg1);
+            fprintf(fp, "pick_up(%s)\n", object_name[action->arg1]);
             break;
         }
         case ACTION_PUT_DOWN: {
-            fprintf(fp, "put_down(%s)\n", action->arg1);
+            fprintf(fp, "put_down(%s)\n", object_name[action->arg1]);
             break;
         }
         case ACTION_POUR: {
-            fprintf(fp, "pour(%s, %s)\n", action->arg1, action->arg2);
+            fprintf(fp, "pour(%s, %s)\n", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_PEEL_OPEN: {
-            fprintf(fp, "peel_open(%s)\n", action->arg1);
+            fprintf(fp, "peel_open(%s)\n", object_name[action->arg1]);
             break;
         }
         case ACTION_TEAR_OPEN: {
-            fprintf(fp, "tear_open(%s)\n", action->arg1);
+            fprintf(fp, "tear_open(%s)\n", object_name[action->arg1]);
             break;
         }
         case ACTION_PULL_OPEN: {
-            fprintf(fp, "pull_open(%s)\n", action->arg1);
+            fprintf(fp, "pull_open(%s)\n", object_name[action->arg1]);
             break;
         }
         case ACTION_PULL_OFF: {
-            fprintf(fp, "pull_off(%s, %s)\n", action->arg1, action->arg2);
+            fprintf(fp, "pull_off(%s, %s)\n", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_SCOOP: {
-            fprintf(fp, "scoop(%s, %s)\n", action->arg1, action->arg2);
+            fprintf(fp, "scoop(%s, %s)\n", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_SIP: {
-            fprintf(fp, "sip(%s)\n", action->arg1);
+            fprintf(fp, "sip(%s)\n", object_name[action->arg1]);
             break;
         }
         case ACTION_STIR: {
-            fprintf(fp, "stir(%s, %s)\n", action->arg1, action->arg2);
+            fprintf(fp, "stir(%s, %s)\n", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_DIP: {
-            fprintf(fp, "dip(%s, %s)\n", action->arg1, action->arg2);
+            fprintf(fp, "dip(%s, %s)\n", object_name[action->arg1], object_name[action->arg2]);
             break;
         }
         case ACTION_SAY_DONE: {
@@ -265,111 +321,92 @@ static void print_action_to_file(FILE *fp, ActionList *action)
             break;
         }
         default: {
-            fprintf(fp, "default(%d, %p, %p)\n", (int) action->act, action->arg1, action->arg2);
+            fprintf(fp, "default(%d, %s, %s)\n", (int) action->act, object_name[action->arg1], object_name[action->arg2]);
             break;
         }
     }
 }
 
-void print_actions_to_file(FILE *fp)
+static void print_log_to_file(ActionLog *log, FILE *fp)
 {
     ActionList *tmp;
 
     fprintf(fp, "     ----------------------------------------------------------------------\n");
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
+    for (tmp = log->first; tmp != NULL; tmp = tmp->next) {
         print_action_to_file(fp, tmp);
     }
 }
 
-/******************************************************************************/
-/********* Analysing the action/event list: ***********************************/
-
-static Boolean is_sugar(char *string)
+void print_actions_to_file(FILE *fp)
 {
-    return((string != NULL) && strcmp(string, "sugar") == 0);
+    print_log_to_file(world_context_action_log(world_context_default()), fp);
 }
 
-static Boolean is_coffee(char *string)
-{
-    return((string != NULL) && strcmp(string, "coffee") == 0);
-}
+/******************************************************************************/
+/********* Analysing the action/event list: ***********************************/
 
-static Boolean is_cream(char *string)
-{
-    return((string != NULL) && strcmp(string, "cream") == 0);
-}
+/* What has been put in the spoon or the sugar bowl lid during analysis: */
+
+typedef enum ingredient {INGREDIENT_NONE, INGREDIENT_SUGAR, INGREDIENT_COFFEE, INGREDIENT_CREAM} Ingredient;
 
-static Boolean is_teabag(char *string)
+static Boolean is_teabag(ObjectType object)
 {
-    return((string != NULL) && strcmp(string, "teabag") == 0);
+    return(object == OBJECT_TEABAG);
 }
 
-static Boolean is_cream_carton(char *string)
+static Boolean is_cream_carton(ObjectType object)
 {
-    return((string != NULL) && strcmp(string, "cream carton") == 0);
+    return(object == OBJECT_CARTON);
 }
 
-static Boolean is_sugar_bowl(char *string)
+static Boolean is_sugar_bowl(ObjectType object)
 {
-    return((string != NULL) && strcmp(string, "sugar bowl") == 0);
+    return(object == OBJECT_SUGAR_BOWL);
 }
 
-static Boolean is_sugar_packet(char *string)
+static Boolean is_sugar_packet(ObjectType object)
 {
-    return((string != NULL) && strcmp(string, "sugar packet") == 0);
+    return(object == OBJECT_SUGAR_PACKET);
 }
 
-static Boolean is_coffee_packet(char *string)
+static Boolean is_coffee_packet(ObjectType object)
 {
-    return((string != NULL) && strcmp(string, "coffee packet") == 0);
+    return(object == OBJECT_COFFEE_PACKET);
 }
 
-static Boolean is_spoon(char *string)
+static Boolean is_spoon(ObjectType object)
 {
-    return((string != NULL) && strcmp(string, "spoon") == 0);
+    return(object == OBJECT_SPOON);
 }
 
-static Boolean is_mug(char *string)
+static Boolean is_mug(ObjectType object)
 {
-    return((string != NULL) && strcmp(string, "mug") == 0);
+    return(object == OBJECT_CUP);
 }
 
-static Boolean is_lid(char *string)
+static Boolean is_lid(ObjectType object)
 {
-    return((string != NULL) && strcmp(string, "lid") == 0);
+    return(object == OBJECT_SUGAR_BOWL_LID);
 }
 
-static A2Label guess_subtask_from_object(char *string)
+static A2Label guess_subtask_from_object(ObjectType object)
 {
-    if (string == NULL) {
-        return(ANOMOLOUS_A2);
-    }
-    else if (strcmp(string, "sugar") == 0) {
-        return(ADD_SUGAR);
-    }
-    else if (strcmp(string, "sugar bowl") == 0) {
-        return(ADD_SUGAR);
-    }
-    else if (strcmp(string, "sugar packet") == 0) {
-        return(ADD_SUGAR);
-    }
-    else if (strcmp(string, "coffee") == 0) {
-        return(ADD_COFFEE);
-    }
-    else if (strcmp(string, "coffee packet") == 0) {
-        return(ADD_COFFEE);
-    }
-    else if (strcmp(string, "teabag") == 0) {
-        return(STEEP_TEA);
-    }
-    else if (strcmp(string, "cream") == 0) {
-        return(ADD_MILK);
-    }
-    else if (strcmp(string, "cream carton") == 0) {
-        return(ADD_MILK);
-    }
-    else {
-        return(ANOMOLOUS_A2);
+    switch (object) {
+        case OBJECT_SUGAR_BOWL: case OBJECT_SUGAR_PACKET: {
+            return(ADD_SUGAR);
+        }
+        case OBJECT_COFFEE_PACKET: {
+            return(ADD_COFFEE);
+        }
+        case OBJECT_TEABAG: {
+            return(STEEP_TEA);
+        }
+        case OBJECT_CARTON: {
+            return(ADD_MILK);
+        }
+        default: {
+            return(ANOMOLOUS_A2);
+        }
     }
 }
 
@@ -380,10 +417,10 @@ static Boolean is_error(ActionList *action)
             return((action->subtask != ADD_MILK) && (action->subtask != ADD_SUGAR) && (action->subtask != ADD_COFFEE) && (action->subtask != STEEP_TEA) && (action->subtask != STIR_DRINK) && (action->subtask != DRINK_BEVERAGE));
         }
         case ACTION_POUR: {
-            return((strcmp(action->arg2, "mug") != 0) || ((action->subtask != ADD_MILK) && (action->subtask != ADD_SUGAR) && (action->subtask != ADD_COFFEE)));
+            return(!is_mug(action->arg2) || ((action->subtask != ADD_MILK) && (action->subtask != ADD_SUGAR) && (action->subtask != ADD_COFFEE)));
         }
         case ACTION_STIR: {
-            return((action->subtask != STIR_DRINK) && ((strcmp(action->arg2, "mug") != 0) || (strcmp(action->arg1, "spoon") != 0)));
+            return((action->subtask != STIR_DRINK) && (!is_mug(action->arg2) || !is_spoon(action->arg1)));
         }
         case ACTION_DIP: {
             return(action->subtask != STEEP_TEA);
@@ -406,24 +443,6 @@ static Boolean is_error(ActionList *action)
     }
 }
 
-static char *get_spoon_contents(ActionList *action)
-{
-    while (action->prev != NULL) {
-        action = action->prev;
-        if (action->act == ACTION_SCOOP) {
-            if (is_spoon(action->arg2)) {
-                return(action->arg1);
-            }
-        }
-        else if (action->act == ACTION_POUR) {
-            if (is_spoon(action->arg1)) {
-                return(NULL);
-            }
-        }
-    }
-    return(NULL);
-}
-
 static A2Label get_subtask(ActionList *action)
 {
     switch (action->act) {
@@ -489,8 +508,7 @@ static A2Label get_subtask(ActionList *action)
         }
         case ACTION_POUR: {
             if (is_spoon(action->arg1)) {
-                char *contents = get_spoon_contents(action);
-                return(guess_subtask_from_object(contents));
+                return(guess_subtask_from_object(action->spoon));
             }
             else {
                 return(guess_subtask_from_object(action->arg1));
@@ -517,65 +535,15 @@ Boolean is_crux(ActionType act)
     }
 }
 
-static int count_actions()
-{
-    ActionList *tmp;
-    int count = 0;
-
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
-        count++;
-    }
-    return(count);
-}
-
-static int count_independents()
-{
-    ActionList *tmp;
-    int count = 0;
-
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
-        if (tmp->independent) {
-            count++;
-        }
-    }
-    return(count);
-}
-
-static int count_crux_errors()
-{
-    ActionList *tmp;
-    int count = 0;
-
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
-        if ((tmp->crux) && (!tmp->correct)) {
-            count++;
-        }
-    }
-    return(count);
-}
-
-static int count_non_crux_errors()
-{
-    ActionList *tmp;
-    int count = 0;
-
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
-        if ((!tmp->crux) && (!tmp->correct)) {
-            count++;
-        }
-    }
-    return(count);
-}
-
 /*----------------------------------------------------------------------------*/
 
-static void categorise_a1s()
+static void categorise_a1s(ActionLog *log)
 {
     ActionList *tmp;
     Boolean prev_break;
 
     /* Initialise and score basic actions: */
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
+    for (tmp = log->first; tmp != NULL; tmp = tmp->next) {
         tmp->a2_open = FALSE;
         tmp->a2_close = FALSE;
         tmp->subtask = get_subtask(tmp);
@@ -584,21 +552,20 @@ static void categorise_a1s()
         tmp->correct = TRUE;
     }
     /* Ignore the last "say done", if it is present: */
-    if ((last_action != NULL) && (last_action->act == ACTION_SAY_DONE)) {
-        if (first_action == last_action) {
-            free(last_action);
-            first_action = NULL;
-            last_action = NULL;
+    if ((log->last != NULL) && (log->last->act == ACTION_SAY_DONE)) {
+        if (log->first == log->last) {
+            log->first = NULL;
+            log->last = NULL;
         }
         else {
-            last_action = last_action->prev;
-            free(last_action->next);
-            last_action->next = NULL;
+            log->last = log->last->prev;
+            log->last->next = NULL;
         }
-        task_complete = TRUE;
+        log->length--;
+        log->task_complete = TRUE;
     }
     /* Score double breaks: */
-    for (tmp = first_action, prev_break = FALSE; tmp != NULL; tmp = tmp->next) {
+    for (tmp = log->first, prev_break = FALSE; tmp != NULL; tmp = tmp->next) {
         if ((prev_break) && (tmp->subtask == A2_BREAK)) {
             tmp->prev->subtask = A2_DOUBLE_BREAK;
             tmp->subtask = A2_DOUBLE_BREAK;
@@ -624,7 +591,7 @@ static void extend_bracketing_minimally(ActionList *action)
     }
 }
 
-static void extend_bracketing_to_prior(ActionList *action)
+static void extend_bracketing_to_prior(ActionLog *log, ActionList *action)
 {
     /* Look to the left. Is there another action from the current subtask */
     /* before the beginning of the previous fully bracketed subtask?      */
@@ -661,12 +628,12 @@ static void extend_bracketing_to_prior(ActionList *action)
         tmp = tmp->prev;
     }
 
-    if ((tmp == NULL) && (first_action->subtask == action->subtask)) {
+    if ((tmp == NULL) && (log->first->subtask == action->subtask)) {
 
     /* The open bracket should be moved to the start of the sequence */
 
         action->a2_open = FALSE;
-        first_action->a2_open = TRUE;
+        log->first->a2_open = TRUE;
     }
     else if (tmp != NULL) {
 
@@ -675,11 +642,11 @@ static void extend_bracketing_to_prior(ActionList *action)
 
         action->a2_open = FALSE;
         tmp->next->a2_open = TRUE;
-        extend_bracketing_to_prior(tmp);
+        extend_bracketing_to_prior(log, tmp);
     }
 }
 
-static void extend_bracketing_to_post(ActionList *action)
+static void extend_bracketing_to_post(ActionLog *log, ActionList *action)
 {
     /* Look to the right. Is there another action from the current subtask */
     /* before the end of the following fully bracketed subtask?            */
@@ -716,12 +683,12 @@ static void extend_bracketing_to_post(ActionList *action)
         tmp = tmp->next;
     }
 
-    if ((tmp == NULL) && (last_action->subtask == action->subtask)) {
+    if ((tmp == NULL) && (log->last->subtask == action->subtask)) {
 
     /* The close bracket should be moved to the end of the sequence */
 
         action->a2_close = FALSE;
-        last_action->a2_close = TRUE;
+        log->last->a2_close = TRUE;
     }
     else if (tmp != NULL) {
 
@@ -730,18 +697,18 @@ static void extend_bracketing_to_post(ActionList *action)
 
         action->a2_close = FALSE;
         tmp->prev->a2_close = TRUE;
-        extend_bracketing_to_post(tmp);
+        extend_bracketing_to_post(log, tmp);
     }
 }
 
-static void bracket_a1s()
+static void bracket_a1s(ActionLog *log)
 {
     ActionList *tmp;
 
     /* First run through the list finding cruxes. Extend them to left/right   */
     /* so that the brackets extend over connected regions of one subtask.     */
 
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
+    for (tmp = log->first; tmp != NULL; tmp = tmp->next) {
         if ((tmp->crux) && (tmp->subtask != A2_BREAK)) {
             tmp->a2_open = TRUE;
             tmp->a2_close = TRUE;
@@ -749,22 +716,24 @@ static void bracket_a1s()
         }
     }
 
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
+    for (tmp = log->first; tmp != NULL; tmp = tmp->next) {
         if (tmp->a2_open) {
-            extend_bracketing_to_prior(tmp);
+            extend_bracketing_to_prior(log, tmp);
         }
         if (tmp->a2_close) {
-            extend_bracketing_to_post(tmp);
+            extend_bracketing_to_post(log, tmp);
         }
     }
 }
 
-static void categorise_indepedents()
+static void categorise_and_count_a1s(ActionLog *log, ACS1 *results)
 {
+    /* Mark the independent actions and the errors, and count them: */
+
     ActionList *tmp;
     int level = 0;
 
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
+    for (tmp = log->first; tmp != NULL; tmp = tmp->next) {
         if (tmp->a2_open) {
             level++;
         }
@@ -772,45 +741,56 @@ static void categorise_indepedents()
         if (tmp->a2_close) {
             level--;
         }
-    }
-}
-
-static void categorise_errors()
-{
-    ActionList *tmp;
-
-    for (tmp = first_action; tmp != NULL; tmp = tmp->next) {
         tmp->correct = !is_error(tmp);
+
+        results->actions++;
+        if (tmp->independent) {
+            results->independents++;
+        }
+        if (!tmp->correct) {
+            if (tmp->crux) {
+                results->errors_crux++;
+            }
+            else {
+                results->errors_non_crux++;
+            }
+        }
     }
 }
 
 /*----------------------------------------------------------------------------*/
 
 // NOTE: task_complete is recorded in a very unsatisfactory way! We use a
-// global variable to record whether SAY_DONE occurs using ACS1, but for other
-// reasons delete SAY_DONE if it does occur at the end of the list. ACS2 then
-// checks this global variable. Thus, ACS2 must be called after ACS1 on the same
+// flag in the action log to record whether SAY_DONE occurs using ACS1, but for
+// other reasons delete SAY_DONE if it does occur at the end of the list. ACS2
+// then checks this flag. Thus, ACS2 must be called after ACS1 on the same
 // actions if this is to be accurate
 
-static void analyse_actions_code_with_acs1()
+static void analyse_actions_code_with_acs1(ActionLog *log, ACS1 *results)
 {
-    task_complete = FALSE;
-    if (first_action != NULL) {
-        categorise_a1s();
-        bracket_a1s();
-        categorise_indepedents();
-        categorise_errors();
-    }
+    PROFILE_ENTER(PROFILE_CLASSIFY);
+    results->actions = 0;
+    results->independents = 0;
+    results->errors_crux = 0;
+    results->errors_non_crux = 0;
+
+    log->task_complete = FALSE;
+    if (log->first != NULL) {
+        categorise_a1s(log);
+        bracket_a1s(log);
+        categorise_and_count_a1s(log, results);
+    }
+    PROFILE_EXIT(PROFILE_CLASSIFY);
 }
 
-void analyse_actions_with_acs1(TaskType *task, ACS1 *results)
+void analyse_context_with_acs1(WorldContext *wc, TaskType *task, ACS1 *results)
 {
-    analyse_actions_code_with_acs1();
+    analyse_actions_code_with_acs1(world_context_action_log(wc), results);
+}
 
-    results->actions = count_actions();
-    results->independents = count_independents();
-    results->errors_crux = count_crux_errors();
-    results->errors_non_crux = count_non_crux_errors();
+void analyse_actions_with_acs1(TaskType *task, ACS1 *results)
+{
+    analyse_context_with_acs1(world_context_default(), task, results);
 }
 
 /******************************************************************************/
@@ -820,27 +800,33 @@ void analyse_actions_with_acs1(TaskType *task, ACS1 *results)
 /* from start to finish with errors recorded along the way or at the end.     */
 /* This isn't the real ACS2 of Schwartz et al., but it is more accurate.      */
 
-/* Global variables to record what has been done:                             */
+/* The state recording what has been done (local to each analysis, so that  */
+/* several action logs may be analysed concurrently):                         */
 
-static Boolean added_coffee, added_tea, added_cream, added_sugar, stirred_coffee, stirred_sugar, stirred_cream;
-static Boolean cream_carton_is_open, coffee_packet_is_open, sugar_bowl_is_open, sugar_packet_is_open;
-static int sip_count;
-static char *spoon_contents, *lid_contents;
+typedef struct acs2_state {
+    Boolean added_coffee, added_tea, added_cream, added_sugar, stirred_coffee, stirred_sugar, stirred_cream;
+    Boolean cream_carton_is_open, coffee_packet_is_open, sugar_bowl_is_open, sugar_packet_is_open;
+    int sip_count;
+    Ingredient spoon_contents, lid_contents;
+    Boolean report;            // Describe each error, or just count them
+} Acs2State;
 
 /*----------------------------------------------------------------------------*/
 
-static Boolean action_compare(ActionList *this, ActionType act, char *arg1, char *arg2)
+static Boolean action_compare(ActionList *this, ActionType act, ObjectType arg1, ObjectType arg2)
 {
+    /* OBJECT_NONE matches any argument */
+
     if (this == NULL) {
         return(FALSE);
     }
     else if (this->act != act) {
         return(FALSE);
     }
-    else if ((arg1 != NULL) && ((this->arg1 == NULL) || strcmp(this->arg1, arg1) != 0)) {
+    else if ((arg1 != OBJECT_NONE) && (this->arg1 != arg1)) {
         return(FALSE);
     }
-    else if ((arg2 != NULL) && ((this->arg2 == NULL) || strcmp(this->arg2, arg2) != 0)) {
+    else if ((arg2 != OBJECT_NONE) && (this->arg2 != arg2)) {
         return(FALSE);
     }
     else {
@@ -848,15 +834,15 @@ static Boolean action_compare(ActionList *this, ActionType act, char *arg1, char
     }
 }
 
-static Boolean all_ingredients_have_been_stirred_in()
+static Boolean all_ingredients_have_been_stirred_in(Acs2State *st)
 {
-    if (added_coffee && !stirred_coffee) {
+    if (st->added_coffee && !st->stirred_coffee) {
         return(FALSE);
     }
-    else if (added_sugar && !stirred_sugar) {
+    else if (st->added_sugar && !st->stirred_sugar) {
         return(FALSE);
     }
-    else if (added_cream && !stirred_cream) {
+    else if (st->added_cream && !st->stirred_cream) {
         return(FALSE);
     }
     else {
@@ -864,30 +850,50 @@ static Boolean all_ingredients_have_been_stirred_in()
     }
 }
 
-static Boolean all_ingredients_added(TaskType *task)
+static Boolean all_ingredients_added(Acs2State *st, TaskType *task)
 {
     if (task->base == TASK_COFFEE) {
-        return(added_coffee && added_sugar && added_cream);
+        return(st->added_coffee && st->added_sugar && st->added_cream);
     }
     else if (task->base == TASK_TEA) {
-        return(added_tea && added_sugar);
+        return(st->added_tea && st->added_sugar);
     }
     else {
         return(TRUE);
     }
 }
 
-static Boolean ingredients_added_after_current_action(ActionList *action)
+static void look_ahead(ActionLog *log)
 {
-    while (action != NULL) {
-        if (action_compare(action, ACTION_POUR, NULL, "mug")) {
-            return(TRUE);
+    /* One pass from the end of the log, recording at each action what is    */
+    /* still to come, for the tests below:                                    */
+
+    ActionList *action, *next = NULL;
+
+    for (action = log->last; action != NULL; next = action, action = action->prev) {
+        action->pour_ahead = (next != NULL) && next->pour_ahead;
+        action->lid_to_mug = (next != NULL) && next->lid_to_mug;
+        action->stir_ahead = (next != NULL) && next->stir_ahead;
+        action->pours_ahead = (next != NULL) ? next->pours_ahead : 0;
+
+        if (action_compare(action, ACTION_POUR, OBJECT_NONE, OBJECT_CUP)) {
+            action->pour_ahead = TRUE;
+            action->pours_ahead = MIN(action->pours_ahead + 1, 2);
+        }
+        else if (action_compare(action, ACTION_STIR, OBJECT_CUP, OBJECT_NONE)) {
+            action->stir_ahead = TRUE;
+            action->pours_ahead = 0;
+        }
+        if (action_compare(action, ACTION_POUR, OBJECT_SUGAR_BOWL_LID, OBJECT_NONE)) {
+            action->lid_to_mug = is_mug(action->arg2);
         }
-        action = action->next;
     }
-    return(FALSE);
 }
 
+static Boolean ingredients_added_after_current_action(ActionList *action)
+{
+    return((action != NULL) && action->pour_ahead);
+}
 
 static Boolean next_steps_add_but_dont_stir_ingredient(ActionList *action)
 {
@@ -897,56 +903,42 @@ static Boolean next_steps_add_but_dont_stir_ingredient(ActionList *action)
     // end, or more than one consecutive pour(X, mug) without an intervening
     // stir(mug, Y)
 
-    int pour_count = 0;
-
-    while (action != NULL) {
-        if (action_compare(action, ACTION_POUR, NULL, "mug")) {
-            pour_count++;
-        }
-        else if (action_compare(action, ACTION_STIR, "mug", NULL)) {
-            return(pour_count > 1);
-        }
-        action = action->next;
+    if (action == NULL) {
+        return(FALSE);
+    }
+    else if (action->stir_ahead) {
+        return(action->pours_ahead > 1);
+    }
+    else {
+        return(action->pours_ahead == 1);
     }
-    return(pour_count == 1);
 }
 
 static Boolean sugar_bowl_lid_is_poured_into_mug(ActionList *action)
 {
     // Return TRUE if the sugar bowl lid is eventually poured into the coffee 
 
-    while (action != NULL) {
-        if (action_compare(action, ACTION_POUR, "lid", "mug")) {
-            return(TRUE);
-        }
-        else if (action_compare(action, ACTION_POUR, "lid", NULL)) {
-            return(FALSE);
-        }
-        else {
-            action = action->next;
-        }
-    }
-    return(FALSE);
+    return((action != NULL) && action->lid_to_mug);
 }
 
 /*----------------------------------------------------------------------------*/
 
-static void initialise_state()
+static void initialise_state(Acs2State *st)
 {
-    added_coffee = FALSE;
-    added_tea = FALSE;
-    added_cream = FALSE;
-    added_sugar = FALSE;
-    stirred_coffee = FALSE;
-    stirred_sugar = FALSE;
-    stirred_cream = FALSE;
-    cream_carton_is_open = FALSE;
-    coffee_packet_is_open = FALSE;
-    sugar_bowl_is_open = FALSE;
-    sugar_packet_is_open = FALSE;
-    sip_count = 0;
-    spoon_contents = NULL;
-    lid_contents = NULL;
+    st->added_coffee = FALSE;
+    st->added_tea = FALSE;
+    st->added_cream = FALSE;
+    st->added_sugar = FALSE;
+    st->stirred_coffee = FALSE;
+    st->stirred_sugar = FALSE;
+    st->stirred_cream = FALSE;
+    st->cream_carton_is_open = FALSE;
+    st->coffee_packet_is_open = FALSE;
+    st->sugar_bowl_is_open = FALSE;
+    st->sugar_packet_is_open = FALSE;
+    st->sip_count = 0;
+    st->spoon_contents = INGREDIENT_NONE;
+    st->lid_contents = INGREDIENT_NONE;
 }
 
 static void initialise_counts(ACS2 *results)
@@ -964,18 +956,23 @@ static void initialise_counts(ACS2 *results)
     results->accomplished = 0;
 }
 
-static GList *append_error(GList *errors, char *content)
+static GList *append_error(Acs2State *st, GList *errors, char *content)
 {
-    return(g_list_append(errors, string_copy(content)));
+    /* Errors are prepended, and the list reversed once complete: */
+
+    if (st->report) {
+        errors = g_list_prepend(errors, string_copy(content));
+    }
+    return(errors);
 }
 
-static GList *process_all_actions(GList *errors, TaskType *task, ACS2 *results)
+static GList *process_all_actions(ActionLog *log, Acs2State *st, GList *errors, TaskType *task, ACS2 *results)
 {
     A2Label previous_subtask = ANOMOLOUS_A2;
     char buffer[128];
     ActionList *action;
 
-    for (action = first_action; action != NULL; action = action->next) {
+    for (action = log->first; action != NULL; action = action->next) {
         switch (action->act) {
             case ACTION_PICK_UP: {
                 break;
@@ -984,655 +981,645 @@ static GList *process_all_actions(GList *errors, TaskType *task, ACS2 *results)
                 break;
             }
             case ACTION_POUR: {
-                if ((action->arg1 == NULL) || (action->arg2 == NULL)) {
-                    errors = append_error(errors, "Bizarre: NULL object in pour!");
+                if ((action->arg1 == OBJECT_NONE) || (action->arg2 == OBJECT_NONE)) {
+                    errors = append_error(st, errors, "Bizarre: NULL object in pour!");
                     results->bizarre++;
 		}
-                else if (strcmp(action->arg1, action->arg2) == 0) {
-                    errors = append_error(errors, "Bizarre: Pouring into self!");
+                else if (action->arg1 == action->arg2) {
+                    errors = append_error(st, errors, "Bizarre: Pouring into self!");
                     results->bizarre++;
                 }
                 else if (is_spoon(action->arg2)) {
                     // Pour target is spoon
                     if (is_coffee_packet(action->arg1)) {
-                        if (!coffee_packet_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring coffee into spoon without opening packet");
+                        if (!st->coffee_packet_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring coffee into spoon without opening packet");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring coffee into spoon");
+                            errors = append_error(st, errors, "Object substitution: Pouring coffee into spoon");
                             results->object_sub++;
-                            spoon_contents = "coffee";
+                            st->spoon_contents = INGREDIENT_COFFEE;
                         }
                     }
                     else if (is_sugar_packet(action->arg1)) {
-                        if (!sugar_packet_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring sugar packet into spoon but sugar packet isn't open");
+                        if (!st->sugar_packet_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring sugar packet into spoon but sugar packet isn't open");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring sugar packet into spoon");
+                            errors = append_error(st, errors, "Object substitution: Pouring sugar packet into spoon");
                             results->object_sub++;
-                            spoon_contents = "sugar";
+                            st->spoon_contents = INGREDIENT_SUGAR;
                         }
                     }
                     else if (is_sugar_bowl(action->arg1)) {
-                        if (!sugar_bowl_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring sugar bowl into spoon but sugar bowl is not open");
+                        if (!st->sugar_bowl_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring sugar bowl into spoon but sugar bowl is not open");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring sugar bowl into spoon");
+                            errors = append_error(st, errors, "Object substitution: Pouring sugar bowl into spoon");
                             results->object_sub++;
-                            spoon_contents = "sugar";
+                            st->spoon_contents = INGREDIENT_SUGAR;
                         }
                     }
                     else if (is_lid(action->arg1)) {
-                        if (lid_contents == NULL) {
-                            errors = append_error(errors, "Anticipation: Pouring lid into spoon but lid is empty");
+                        if (st->lid_contents == INGREDIENT_NONE) {
+                            errors = append_error(st, errors, "Anticipation: Pouring lid into spoon but lid is empty");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Action addition: Pouring sugar bowl lid into spoon");
+                            errors = append_error(st, errors, "Action addition: Pouring sugar bowl lid into spoon");
                             results->action_addition++;
-                            spoon_contents = lid_contents;
-                            lid_contents = NULL;
+                            st->spoon_contents = st->lid_contents;
+                            st->lid_contents = INGREDIENT_NONE;
                         }
                     }
                     else if (is_cream_carton(action->arg1)) {
-                        if (!cream_carton_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring cream carton into spoon but cream carton is not open");
+                        if (!st->cream_carton_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring cream carton into spoon but cream carton is not open");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring cream carton into spoon");
+                            errors = append_error(st, errors, "Object substitution: Pouring cream carton into spoon");
                             results->object_sub++;
-                            spoon_contents = "cream";
+                            st->spoon_contents = INGREDIENT_CREAM;
                         }
                     }
                     else {
-                        g_snprintf(buffer, 128, "Gesture substitution: Pouring with %s (not a container)", action->arg1);
-                        errors = append_error(errors, buffer);
+                        g_snprintf(buffer, 128, "Gesture substitution: Pouring with %s (not a container)", object_name[action->arg1]);
+                        errors = append_error(st, errors, buffer);
                         results->gesture_sub++;
                     }
                 }
                 else if (is_sugar_bowl(action->arg2)) {
                     // Pour target is sugar bowl
                     if (is_coffee_packet(action->arg1)) {
-                        if (!coffee_packet_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring coffee packet into sugar bowl but coffee packet is closed");
+                        if (!st->coffee_packet_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring coffee packet into sugar bowl but coffee packet is closed");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring coffee into sugar bowl");
+                            errors = append_error(st, errors, "Object substitution: Pouring coffee into sugar bowl");
                             results->object_sub++;
                         }
                     }
                     else if (is_sugar_packet(action->arg1)) {
-                        if (!sugar_packet_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring sugar packet into sugar bowl but sugar packet is not open");
+                        if (!st->sugar_packet_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring sugar packet into sugar bowl but sugar packet is not open");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring sugar packet into sugar bowl");
+                            errors = append_error(st, errors, "Object substitution: Pouring sugar packet into sugar bowl");
                             results->object_sub++;
                         }
                     }
                     else if (is_spoon(action->arg1)) {
-                        if (spoon_contents == NULL) {
-                            errors = append_error(errors, "Bizarre: Pouring empty spoon into sugar bowl");
+                        if (st->spoon_contents == INGREDIENT_NONE) {
+                            errors = append_error(st, errors, "Bizarre: Pouring empty spoon into sugar bowl");
                             results->bizarre++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring full spoon into sugar bowl");
+                            errors = append_error(st, errors, "Object substitution: Pouring full spoon into sugar bowl");
                             results->object_sub++;
-                            spoon_contents = NULL;
+                            st->spoon_contents = INGREDIENT_NONE;
                         }
                     }
                     else if (is_lid(action->arg1)) {
-                        if (lid_contents == NULL) {
-                            errors = append_error(errors, "Anticipation: Pouring empty lid into sugar bowl");
+                        if (st->lid_contents == INGREDIENT_NONE) {
+                            errors = append_error(st, errors, "Anticipation: Pouring empty lid into sugar bowl");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Action addition: Pouring sugar bowl lid into sugar bowl");
+                            errors = append_error(st, errors, "Action addition: Pouring sugar bowl lid into sugar bowl");
                             results->action_addition++;
-                            lid_contents = NULL;
+                            st->lid_contents = INGREDIENT_NONE;
                         }
                     }
                     else if (is_cream_carton(action->arg1)) {
-                        if (!cream_carton_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring cream carton into sugar bowl but cream carton is not open");
+                        if (!st->cream_carton_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring cream carton into sugar bowl but cream carton is not open");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring cream carton into sugar bowl");
+                            errors = append_error(st, errors, "Object substitution: Pouring cream carton into sugar bowl");
                             results->object_sub++;
                         }
                     }
                     else {
-                        g_snprintf(buffer, 128, "Gesture substitution: Pouring with %s (not a container)", action->arg1);
-                        errors = append_error(errors, buffer);
+                        g_snprintf(buffer, 128, "Gesture substitution: Pouring with %s (not a container)", object_name[action->arg1]);
+                        errors = append_error(st, errors, buffer);
                         results->gesture_sub++;
                     }
                 }
                 else if (is_lid(action->arg2)) {
                     // Pour target is sugar bowl lid
                     if (is_coffee_packet(action->arg1)) {
-                        if (!coffee_packet_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring from closed coffee packet");
+                        if (!st->coffee_packet_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring from closed coffee packet");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring coffee into sugar bowl lid");
+                            errors = append_error(st, errors, "Object substitution: Pouring coffee into sugar bowl lid");
                             results->object_sub++;
-                            spoon_contents = "coffee";
+                            st->spoon_contents = INGREDIENT_COFFEE;
                         }
                     }
                     else if (is_sugar_packet(action->arg1)) {
-                        if (!sugar_packet_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring from closed sugar packet");
+                        if (!st->sugar_packet_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring from closed sugar packet");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring sugar packet into sugar bowl lid");
+                            errors = append_error(st, errors, "Object substitution: Pouring sugar packet into sugar bowl lid");
                             results->object_sub++;
-                            spoon_contents = "sugar";
+                            st->spoon_contents = INGREDIENT_SUGAR;
                         }
                     }
                     else if (is_spoon(action->arg1)) {
-                        errors = append_error(errors, "Action addition: Pouring spoon into sugar bowl lid");
+                        errors = append_error(st, errors, "Action addition: Pouring spoon into sugar bowl lid");
                         results->action_addition++;
-                        lid_contents = spoon_contents;
-                        spoon_contents = NULL;
+                        st->lid_contents = st->spoon_contents;
+                        st->spoon_contents = INGREDIENT_NONE;
                     }
                     else if (is_sugar_bowl(action->arg1)) {
-                        if (!sugar_bowl_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring unopened bowl into sugar bowl lid");
+                        if (!st->sugar_bowl_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring unopened bowl into sugar bowl lid");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring sugar bowl into sugar bowl lid");
+                            errors = append_error(st, errors, "Object substitution: Pouring sugar bowl into sugar bowl lid");
                             results->object_sub++;
-                            lid_contents = "sugar";
+                            st->lid_contents = INGREDIENT_SUGAR;
                         }
                     }
                     else if (is_cream_carton(action->arg1)) {
-                        if (!cream_carton_is_open) {
-                            errors = append_error(errors, "Anticipation: Pouring from closed cream carton");
+                        if (!st->cream_carton_is_open) {
+                            errors = append_error(st, errors, "Anticipation: Pouring from closed cream carton");
                             results->anticipations++;
                         }
                         else {
-                            errors = append_error(errors, "Object substitution: Pouring cream carton into sugar bowl lid");
+                            errors = append_error(st, errors, "Object substitution: Pouring cream carton into sugar bowl lid");
                             results->object_sub++;
                         }
                     }
                     else {
-                        errors = append_error(errors, "Gesture substitution: Pouring with non-container");
+                        errors = append_error(st, errors, "Gesture substitution: Pouring with non-container");
                         results->gesture_sub++;
                     }
                 }
                 else if (!is_mug(action->arg2)) {
                     // Pour target is not mug
-                    g_snprintf(buffer, 128, "Object substitution: Pouring into %s (not a container)", action->arg2);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution: Pouring into %s (not a container)", object_name[action->arg2]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
                 }
                 // Pour target is mug
                 else if (is_coffee_packet(action->arg1)) {
-                    if (!coffee_packet_is_open) {
-                        errors = append_error(errors, "Anticipation: Pouring from closed coffee packet");
+                    if (!st->coffee_packet_is_open) {
+                        errors = append_error(st, errors, "Anticipation: Pouring from closed coffee packet");
                         results->anticipations++;
                     }
-                    else if (added_coffee) {
+                    else if (st->added_coffee) {
                         if (previous_subtask == ADD_COFFEE) {
-                            errors = append_error(errors, "Quality: Continuous perseveration of pouring coffee");
+                            errors = append_error(st, errors, "Quality: Continuous perseveration of pouring coffee");
                             results->quality++;
                         }
                         else {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of coffee");
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of coffee");
                             results->perseverations++;
                         }
                     }
                     else {
-                        added_coffee = TRUE;
+                        st->added_coffee = TRUE;
                     }
                     previous_subtask = ADD_COFFEE;
                 }
                 else if (is_cream_carton(action->arg1)) {
-                    if (!cream_carton_is_open) {
-                        errors = append_error(errors, "Anticipation: Pouring from closed cream carton");
+                    if (!st->cream_carton_is_open) {
+                        errors = append_error(st, errors, "Anticipation: Pouring from closed cream carton");
                         results->anticipations++;
                     }
-                    else if (added_cream) {
+                    else if (st->added_cream) {
                         if (previous_subtask == ADD_MILK) {
-                            errors = append_error(errors, "Quality: Continuous perseveration of pouring of cream");
+                            errors = append_error(st, errors, "Quality: Continuous perseveration of pouring of cream");
                             results->quality++;
                         }
                         else {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of cream");
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of cream");
                             results->perseverations++;
                         }
                     }
                     else {
-                        added_cream = TRUE;
+                        st->added_cream = TRUE;
                     }
                     previous_subtask = ADD_MILK;
                 }
                 else if (is_sugar_packet(action->arg1)) {
-                    if (!sugar_packet_is_open) {
-                        errors = append_error(errors, "Anticipation: Pouring from closed sugar packet");
+                    if (!st->sugar_packet_is_open) {
+                        errors = append_error(st, errors, "Anticipation: Pouring from closed sugar packet");
                         results->anticipations++;
                     }
-                    else if (added_sugar) {
+                    else if (st->added_sugar) {
                         if (previous_subtask == ADD_SUGAR) {
-                            errors = append_error(errors, "Quality: Continuous perseveration of pouring sugar packet");
+                            errors = append_error(st, errors, "Quality: Continuous perseveration of pouring sugar packet");
                             results->quality++;
                         }
                         else {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of sugar");
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of sugar");
                             results->perseverations++;
                         }
                     }
                     else {
-                        added_sugar = TRUE;
+                        st->added_sugar = TRUE;
                     }
                     previous_subtask = ADD_SUGAR;
                 }
                 else if (is_spoon(action->arg1)) {
-                    if (spoon_contents == NULL) {
+                    if (st->spoon_contents == INGREDIENT_NONE) {
                         if ((previous_subtask == ADD_COFFEE) || (previous_subtask == ADD_SUGAR) || (previous_subtask == ADD_MILK)) {
-                            errors = append_error(errors, "Gesture subtitution: Pouring from empty spoon when we should be stirring");
+                            errors = append_error(st, errors, "Gesture subtitution: Pouring from empty spoon when we should be stirring");
                             results->gesture_sub++;
                         }
                         else {
-                            errors = append_error(errors, "Anticipation: Pouring from empty spoon");
+                            errors = append_error(st, errors, "Anticipation: Pouring from empty spoon");
                             results->anticipations++;
                         }
                     }
-                    else if (is_sugar(spoon_contents)) {
-                        if (added_sugar) {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of sugar");
+                    else if (st->spoon_contents == INGREDIENT_SUGAR) {
+                        if (st->added_sugar) {
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of sugar");
                             results->perseverations++;
                         }
                         else {
-                            added_sugar = TRUE;
+                            st->added_sugar = TRUE;
                         }
                         previous_subtask = ADD_SUGAR;
                     }
-                    else if (is_coffee(spoon_contents)) {
-                        if (added_coffee) {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of coffee");
+                    else if (st->spoon_contents == INGREDIENT_COFFEE) {
+                        if (st->added_coffee) {
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of coffee");
                             results->perseverations++;
                         }
                         else {
-                            added_coffee = TRUE;
+                            st->added_coffee = TRUE;
                         }
                         previous_subtask = ADD_COFFEE;
                     }
-                    else if (is_cream(spoon_contents)) {
-                        if (added_cream) {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of cream");
+                    else if (st->spoon_contents == INGREDIENT_CREAM) {
+                        if (st->added_cream) {
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of cream");
                             results->perseverations++;
                         }
                         else {
-                            added_cream = TRUE;
+                            st->added_cream = TRUE;
                         }
                         previous_subtask = ADD_MILK;
                     }
-                    else {
-                        g_snprintf(buffer, 128, "Object substitution: Spooning %s into mug", spoon_contents);
-                        errors = append_error(errors, buffer);
-                        results->object_sub++;
-                    }
-                    spoon_contents = NULL;
+                    st->spoon_contents = INGREDIENT_NONE;
                 }
                 else if (is_sugar_bowl(action->arg1)) {
-                    if (!sugar_bowl_is_open) {
-                        errors = append_error(errors, "Anticipation: Pouring from closed sugar bowl");
+                    if (!st->sugar_bowl_is_open) {
+                        errors = append_error(st, errors, "Anticipation: Pouring from closed sugar bowl");
                         results->anticipations++;
                     }
                     else {
-                        errors = append_error(errors, "Tool omission: Pouring open sugar bowl into mug");
+                        errors = append_error(st, errors, "Tool omission: Pouring open sugar bowl into mug");
                         results->tool_omission++;
-                        if (added_sugar) {
+                        if (st->added_sugar) {
                             if (previous_subtask == ADD_SUGAR) {
-                                errors = append_error(errors, "Quality: Continuous perseveration of pouring of sugar bowl");
+                                errors = append_error(st, errors, "Quality: Continuous perseveration of pouring of sugar bowl");
                                 results->quality++;
                             }
                             else {
-                                errors = append_error(errors, "Perseveration: Recurrent adding of sugar");
+                                errors = append_error(st, errors, "Perseveration: Recurrent adding of sugar");
                                 results->perseverations++;
                             }
                         }
                         else {
-                            added_sugar = TRUE;
+                            st->added_sugar = TRUE;
                         }
                     }
                     previous_subtask = ADD_SUGAR;
                 }
                 else if (is_lid(action->arg1)) {
-                    if (lid_contents == NULL) {
-                        errors = append_error(errors, "Anticipation: Pouring from empty lid");
+                    if (st->lid_contents == INGREDIENT_NONE) {
+                        errors = append_error(st, errors, "Anticipation: Pouring from empty lid");
                         results->anticipations++;
                     }
-                    else if (is_sugar(lid_contents)) {
-                        if (added_sugar) {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of sugar");
+                    else if (st->lid_contents == INGREDIENT_SUGAR) {
+                        if (st->added_sugar) {
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of sugar");
                             results->perseverations++;
                         }
                         else {
-                            added_sugar = TRUE;
+                            st->added_sugar = TRUE;
                         }
                         previous_subtask = ADD_SUGAR;
                     }
-                    else if (is_coffee(lid_contents)) {
-                        if (added_coffee) {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of coffee");
+                    else if (st->lid_contents == INGREDIENT_COFFEE) {
+                        if (st->added_coffee) {
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of coffee");
                             results->perseverations++;
                         }
                         else {
-                            added_coffee = TRUE;
+                            st->added_coffee = TRUE;
                         }
                         previous_subtask = ADD_COFFEE;
                     }
-                    else if (is_cream(lid_contents)) {
-                        if (added_cream) {
-                            errors = append_error(errors, "Perseveration: Recurrent adding of cream");
+                    else if (st->lid_contents == INGREDIENT_CREAM) {
+                        if (st->added_cream) {
+                            errors = append_error(st, errors, "Perseveration: Recurrent adding of cream");
                             results->perseverations++;
                         }
                         else {
-                            added_cream = TRUE;
+                            st->added_cream = TRUE;
                         }
                         previous_subtask = ADD_MILK;
                     }
-                    else {
-                        g_snprintf(buffer, 128, "Object substitution: Spooning %s with lid into mug", lid_contents);
-                        errors = append_error(errors, buffer);
-                        results->object_sub++;
-                    }
-                    lid_contents = NULL;
+                    st->lid_contents = INGREDIENT_NONE;
 		}
 		else {
-		    g_snprintf(buffer, 128, "Object substitution: Pouring %s into mug", action->arg1);
-                    errors = append_error(errors, buffer);
+		    g_snprintf(buffer, 128, "Object substitution: Pouring %s into mug", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
 		}
                 break;
             }
             case ACTION_PEEL_OPEN: {
-                if (action->arg1 == NULL) {
-                    errors = append_error(errors, "Bizarre: NULL object in peeling open!");
+                if (action->arg1 == OBJECT_NONE) {
+                    errors = append_error(st, errors, "Bizarre: NULL object in peeling open!");
                     results->bizarre++;
 		}
                 else if (!is_cream_carton(action->arg1)) {
-                    g_snprintf(buffer, 128, "Object substitution (%s) on peeling open", action->arg1);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution (%s) on peeling open", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
                 }
-                else if (!cream_carton_is_open) {
-                    cream_carton_is_open = TRUE;
+                else if (!st->cream_carton_is_open) {
+                    st->cream_carton_is_open = TRUE;
                 }
                 else if ((action->prev != NULL) && (action->prev->act == ACTION_PEEL_OPEN)) {
-                    errors = append_error(errors, "Quality: Continuous perseveration on opening of cream carton");
+                    errors = append_error(st, errors, "Quality: Continuous perseveration on opening of cream carton");
                     results->quality++;
                 }
                 else {
-                    errors = append_error(errors, "Perseveration: Recurrent opening of cream carton");
+                    errors = append_error(st, errors, "Perseveration: Recurrent opening of cream carton");
                     results->perseverations++;
                 }
                 break;
             }
             case ACTION_TEAR_OPEN: {
-                if (action->arg1 == NULL) {
-                    errors = append_error(errors, "Bizarre: NULL object in tearing open!");
+                if (action->arg1 == OBJECT_NONE) {
+                    errors = append_error(st, errors, "Bizarre: NULL object in tearing open!");
                     results->bizarre++;
 		}
                 else if (!is_sugar_packet(action->arg1)) {
-                    g_snprintf(buffer, 128, "Object substitution (%s) on tearing open", action->arg1);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution (%s) on tearing open", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
                 }
-                else if (!sugar_packet_is_open) {
-                    sugar_packet_is_open = TRUE;
+                else if (!st->sugar_packet_is_open) {
+                    st->sugar_packet_is_open = TRUE;
                 }
                 else if ((action->prev != NULL) && (action->prev->act == ACTION_TEAR_OPEN)) {
-                    errors = append_error(errors, "Quality: Continuous perseveration on opening sugar packet");
+                    errors = append_error(st, errors, "Quality: Continuous perseveration on opening sugar packet");
                     results->quality++;
                 }
                 else {
-                    errors = append_error(errors, "Perseveration: Recurrent opening of sugar packet");
+                    errors = append_error(st, errors, "Perseveration: Recurrent opening of sugar packet");
                     results->perseverations++;
                 }
                 break;
             }
             case ACTION_PULL_OPEN: {
-                if (action->arg1 == NULL) {
-                    errors = append_error(errors, "Bizarre: NULL object in pulling open!");
+                if (action->arg1 == OBJECT_NONE) {
+                    errors = append_error(st, errors, "Bizarre: NULL object in pulling open!");
                     results->bizarre++;
 		}
                 else if (!is_coffee_packet(action->arg1)) {
-                    g_snprintf(buffer, 128, "Object substitution (%s) on pulling open", action->arg1);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution (%s) on pulling open", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
                 }
-                else if (!coffee_packet_is_open) {
-                    coffee_packet_is_open = TRUE;
+                else if (!st->coffee_packet_is_open) {
+                    st->coffee_packet_is_open = TRUE;
                 }
                 else if ((action->prev != NULL) && (action->prev->act == ACTION_PULL_OPEN)) {
-                    errors = append_error(errors, "Quality: Continuous perseveration on opening coffee packet");
+                    errors = append_error(st, errors, "Quality: Continuous perseveration on opening coffee packet");
                     results->quality++;
                 }
                 else {
-                    errors = append_error(errors, "Perseveration: Recurrent opening of coffee packet");
+                    errors = append_error(st, errors, "Perseveration: Recurrent opening of coffee packet");
                     results->perseverations++;
                 }
                 break;
             }
             case ACTION_PULL_OFF: {
-                if (action->arg1 == NULL) {
-                    errors = append_error(errors, "Bizarre: NULL object in pulling off!");
+                if (action->arg1 == OBJECT_NONE) {
+                    errors = append_error(st, errors, "Bizarre: NULL object in pulling off!");
                     results->bizarre++;
 		}
                 else if (!is_sugar_bowl(action->arg1)) {
-                    g_snprintf(buffer, 128, "Object substitution (%s) on pulling off", action->arg1);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution (%s) on pulling off", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
                 }
-                else if (!sugar_bowl_is_open) {
-                    sugar_bowl_is_open = TRUE;
+                else if (!st->sugar_bowl_is_open) {
+                    st->sugar_bowl_is_open = TRUE;
                 }
                 else if ((action->prev != NULL) && (action->prev->act == ACTION_PULL_OPEN)) {
-                    errors = append_error(errors, "Quality: Continuous perseveration on opening sugar bowl");
+                    errors = append_error(st, errors, "Quality: Continuous perseveration on opening sugar bowl");
                     results->quality++;
                 }
                 else {
-                    errors = append_error(errors, "Perseveration: Recurrent opening of sugar bowl");
+                    errors = append_error(st, errors, "Perseveration: Recurrent opening of sugar bowl");
                     results->perseverations++;
                 }
                 break;
             }
             case ACTION_SCOOP: {
-                if (action->arg2 == NULL) {
-                    errors = append_error(errors, "Tool omission: Scooping without an implement");
+                if (action->arg2 == OBJECT_NONE) {
+                    errors = append_error(st, errors, "Tool omission: Scooping without an implement");
                     results->tool_omission++;
                 }
                 else if (is_spoon(action->arg2)) {
-                    if (spoon_contents != NULL) {
-                        if (action_compare(action->prev, ACTION_SCOOP, action->arg1, "spoon")) {
-                            errors = append_error(errors, "Quality: Perseverative scooping with full spoon");
+                    if (st->spoon_contents != INGREDIENT_NONE) {
+                        if (action_compare(action->prev, ACTION_SCOOP, action->arg1, OBJECT_SPOON)) {
+                            errors = append_error(st, errors, "Quality: Perseverative scooping with full spoon");
                             results->quality++;
                         }
-                        else if (action_compare(action->next, ACTION_POUR, "spoon", NULL)) {
-                            errors = append_error(errors, "Reversal: Scooping with full spoon");
+                        else if (action_compare(action->next, ACTION_POUR, OBJECT_SPOON, OBJECT_NONE)) {
+                            errors = append_error(st, errors, "Reversal: Scooping with full spoon");
                             results->reversals++;
                         }
                         else {
-                            errors = append_error(errors, "Perseveration: Recurrent scooping with full spoon");
+                            errors = append_error(st, errors, "Perseveration: Recurrent scooping with full spoon");
                             results->perseverations++;
                         }
                     }
                     else if (is_mug(action->arg1)) {
-                        errors = append_error(errors, "Object substitution: Scooping from mug");
+                        errors = append_error(st, errors, "Object substitution: Scooping from mug");
                         results->object_sub++;
                     }
-                    else if (is_cream_carton(action->arg1) && !cream_carton_is_open) {
-                        errors = append_error(errors, "Geature substitution: Scooping from closed cream carton");
+                    else if (is_cream_carton(action->arg1) && !st->cream_carton_is_open) {
+                        errors = append_error(st, errors, "Geature substitution: Scooping from closed cream carton");
                         results->gesture_sub++;
                     }
-                    else if (is_sugar_packet(action->arg1) && !sugar_packet_is_open) {
-                        errors = append_error(errors, "Geature substitution: Scooping from closed sugar packet");
+                    else if (is_sugar_packet(action->arg1) && !st->sugar_packet_is_open) {
+                        errors = append_error(st, errors, "Geature substitution: Scooping from closed sugar packet");
                         results->gesture_sub++;
                     }
-                    else if (is_coffee_packet(action->arg1) && !coffee_packet_is_open) {
-                        errors = append_error(errors, "Geature substitution: Scooping from closed coffee packet");
+                    else if (is_coffee_packet(action->arg1) && !st->coffee_packet_is_open) {
+                        errors = append_error(st, errors, "Geature substitution: Scooping from closed coffee packet");
                         results->gesture_sub++;
                     }
                     else if (!is_sugar_bowl(action->arg1)) {
-                        g_snprintf(buffer, 128, "Object substitution: Scooping from %s (should be sugar bowl)", action->arg1);
-                        errors = append_error(errors, buffer);
+                        g_snprintf(buffer, 128, "Object substitution: Scooping from %s (should be sugar bowl)", object_name[action->arg1]);
+                        errors = append_error(st, errors, buffer);
                         results->object_sub++;
                     }
-                    else if (!sugar_bowl_is_open) {
-                        errors = append_error(errors, "Anticipation: Scooping from closed sugar bowl");
+                    else if (!st->sugar_bowl_is_open) {
+                        errors = append_error(st, errors, "Anticipation: Scooping from closed sugar bowl");
                         results->anticipations++;
                     }
                     else {
-                        spoon_contents = "sugar";
+                        st->spoon_contents = INGREDIENT_SUGAR;
                     }
                 }
                 else if (is_lid(action->arg2)) {
-                    if (lid_contents != NULL) {
-                        if (action_compare(action->prev, ACTION_SCOOP, action->arg1, "lid")) {
-                            errors = append_error(errors, "Quality: Continuous perseveration of scooping with full lid");
+                    if (st->lid_contents != INGREDIENT_NONE) {
+                        if (action_compare(action->prev, ACTION_SCOOP, action->arg1, OBJECT_SUGAR_BOWL_LID)) {
+                            errors = append_error(st, errors, "Quality: Continuous perseveration of scooping with full lid");
                             results->quality++;
                         }
-                        else if (action_compare(action->next, ACTION_POUR, "lid", NULL)) {
-                            errors = append_error(errors, "Reversal: Scooping with full lid");
+                        else if (action_compare(action->next, ACTION_POUR, OBJECT_SUGAR_BOWL_LID, OBJECT_NONE)) {
+                            errors = append_error(st, errors, "Reversal: Scooping with full lid");
                             results->reversals++;
                         }
                         else {
-                            errors = append_error(errors, "Perseveration: Recurrent scooping with full lid");
+                            errors = append_error(st, errors, "Perseveration: Recurrent scooping with full lid");
                             results->perseverations++;
                         }
                     }
                     else if (!is_sugar_bowl(action->arg1)) {
-                        g_snprintf(buffer, 128, "Action addition: Scooping from non sugar bowl (%s)", action->arg1);
-                        errors = append_error(errors, buffer);
+                        g_snprintf(buffer, 128, "Action addition: Scooping from non sugar bowl (%s)", object_name[action->arg1]);
+                        errors = append_error(st, errors, buffer);
                         results->action_addition++;
                     }
-                    else if (!sugar_bowl_is_open) {
-                        errors = append_error(errors, "Anticipation: Scooping from closed sugar bowl");
+                    else if (!st->sugar_bowl_is_open) {
+                        errors = append_error(st, errors, "Anticipation: Scooping from closed sugar bowl");
                         results->anticipations++;
                     }
                     else {
                         if (sugar_bowl_lid_is_poured_into_mug(action->next)) {
-                            errors = append_error(errors, "Object substitution: Scooping with lid");
+                            errors = append_error(st, errors, "Object substitution: Scooping with lid");
                             results->object_sub++;
 			}
 			else {
-                            errors = append_error(errors, "Action addition: Scooping with lid");
+                            errors = append_error(st, errors, "Action addition: Scooping with lid");
                             results->action_addition++;
 			}
-                        lid_contents = "sugar";
+                        st->lid_contents = INGREDIENT_SUGAR;
                     }
                 }
                 else if (is_sugar_bowl(action->arg2)) {
-                    errors = append_error(errors, "Object substitution: Scooping with sugar bowl");
+                    errors = append_error(st, errors, "Object substitution: Scooping with sugar bowl");
                     results->object_sub++;
                 }
                 else if (is_mug(action->arg2)) {
-                    errors = append_error(errors, "Object substitution: Scooping with mug");
+                    errors = append_error(st, errors, "Object substitution: Scooping with mug");
                     results->object_sub++;
                 }
                 else {
-                    g_snprintf(buffer, 128, "Gesture substitution: Scooping with %s", action->arg2);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Gesture substitution: Scooping with %s", object_name[action->arg2]);
+                    errors = append_error(st, errors, buffer);
                     results->gesture_sub++;
                 }
                 break;
             }
             case ACTION_SIP: {
-                if (action->arg1 == NULL) {
-                    errors = append_error(errors, "Bizarre: NULL object in sipping!");
+                if (action->arg1 == OBJECT_NONE) {
+                    errors = append_error(st, errors, "Bizarre: NULL object in sipping!");
                     results->bizarre++;
                 }
                 else if (is_sugar_bowl(action->arg1)) {
-                    if (sugar_bowl_is_open) {
-                        errors = append_error(errors, "Action addition: Sipping from the open sugar bowl");
+                    if (st->sugar_bowl_is_open) {
+                        errors = append_error(st, errors, "Action addition: Sipping from the open sugar bowl");
                         results->action_addition++;
                     }
                     else {
-                        errors = append_error(errors, "Anticipation: Sipping from the closed sugar bowl");
+                        errors = append_error(st, errors, "Anticipation: Sipping from the closed sugar bowl");
                         results->anticipations++;
                     }
                     previous_subtask = A2_BREAK;
                 }
                 else if (is_sugar_packet(action->arg1)) {
-                    if (sugar_packet_is_open) {
-                        errors = append_error(errors, "Action addition: Sipping from the open sugar packet");
+                    if (st->sugar_packet_is_open) {
+                        errors = append_error(st, errors, "Action addition: Sipping from the open sugar packet");
                         results->action_addition++;
                     }
                     else {
-                        errors = append_error(errors, "Anticipation: Sipping from closed sugar packet");
+                        errors = append_error(st, errors, "Anticipation: Sipping from closed sugar packet");
                         results->anticipations++;
                     }
                     previous_subtask = A2_BREAK;
                 }
                 else if (is_coffee_packet(action->arg1)) {
-                    if (coffee_packet_is_open) {
-                        errors = append_error(errors, "Action addition: Sipping from the open coffee packet");
+                    if (st->coffee_packet_is_open) {
+                        errors = append_error(st, errors, "Action addition: Sipping from the open coffee packet");
                         results->action_addition++;
                     }
                     else {
-                        errors = append_error(errors, "Anticipation: Sipping from closed coffee packet");
+                        errors = append_error(st, errors, "Anticipation: Sipping from closed coffee packet");
                         results->anticipations++;
                     }
                     previous_subtask = A2_BREAK;
                 }
                 else if (is_cream_carton(action->arg1)) {
-                    if (cream_carton_is_open) {
-                        errors = append_error(errors, "Action addition: Sipping from the open cream carton");
+                    if (st->cream_carton_is_open) {
+                        errors = append_error(st, errors, "Action addition: Sipping from the open cream carton");
                         results->action_addition++;
                     }
                     else {
-                        errors = append_error(errors, "Anticipation: Sipping from closed cream carton");
+                        errors = append_error(st, errors, "Anticipation: Sipping from closed cream carton");
                         results->anticipations++;
                     }
                     previous_subtask = A2_BREAK;
                 }
                 else if (is_spoon(action->arg1)) {
-                    if (spoon_contents == NULL) {
-                        errors = append_error(errors, "Gesture substitution: Sipping from empty spoon");
+                    if (st->spoon_contents == INGREDIENT_NONE) {
+                        errors = append_error(st, errors, "Gesture substitution: Sipping from empty spoon");
                         results->gesture_sub++;
                     }
                     else {
-                        errors = append_error(errors, "Action addition: Sipping from non-empty spoon");
+                        errors = append_error(st, errors, "Action addition: Sipping from non-empty spoon");
                         results->action_addition++;
                         previous_subtask = A2_BREAK;
-                        spoon_contents = NULL;
+                        st->spoon_contents = INGREDIENT_NONE;
                     }
                 }
                 else if (!is_mug(action->arg1)) {
-                    g_snprintf(buffer, 128, "Gesture substitution: Sipping from %s", action->arg1);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Gesture substitution: Sipping from %s", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->gesture_sub++;
                     previous_subtask = A2_BREAK;
                 }
                 else {
-                    sip_count++;
-                    if (sip_count > 2) {
+                    st->sip_count++;
+                    if (st->sip_count > 2) {
                         if (previous_subtask == DRINK_BEVERAGE) {
-                            errors = append_error(errors, "Perseveration: Continuous sipping");
+                            errors = append_error(st, errors, "Perseveration: Continuous sipping");
                             results->perseverations++;
                         }
                         else {
-                            errors = append_error(errors, "Perseveration: Recurrent sipping (after a pause)");
+                            errors = append_error(st, errors, "Perseveration: Recurrent sipping (after a pause)");
                             results->perseverations++;
                         }
                     }
-                    if (!all_ingredients_added(task) && ingredients_added_after_current_action(action)) {
-                        errors = append_error(errors, "Anticipation: Sipping before adding further ingredients");
+                    if (!all_ingredients_added(st, task) && ingredients_added_after_current_action(action)) {
+                        errors = append_error(st, errors, "Anticipation: Sipping before adding further ingredients");
                         results->anticipations++;
                     }
                     previous_subtask = DRINK_BEVERAGE;
@@ -1640,83 +1627,83 @@ static GList *process_all_actions(GList *errors, TaskType *task, ACS2 *results)
                 break;
             }
             case ACTION_STIR: {
-                if (action->arg2 == NULL) {
-                    errors = append_error(errors, "Tool omission on stirring");
+                if (action->arg2 == OBJECT_NONE) {
+                    errors = append_error(st, errors, "Tool omission on stirring");
                     results->tool_omission++;
                 }
                 else if (!is_spoon(action->arg2)) {
-                    g_snprintf(buffer, 128, "Object substitution: Stirring with %s", action->arg1);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution: Stirring with %s", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
                 }
                 else if (is_spoon(action->arg1)) {
-                    errors = append_error(errors, "Bizarre: Stirring spoon with spoon!");
+                    errors = append_error(st, errors, "Bizarre: Stirring spoon with spoon!");
                     results->bizarre++;
                 }
                 else if (!is_mug(action->arg1)) {
-                    g_snprintf(buffer, 128, "Object substitution: Stirring the %s with spoon", action->arg1);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution: Stirring the %s with spoon", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
                 }
                 else if (previous_subtask == STIR_DRINK) {
-                    errors = append_error(errors, "Perseveration: Continuous stirring");
+                    errors = append_error(st, errors, "Perseveration: Continuous stirring");
                     results->perseverations++;
                 }
                 else if (previous_subtask == ADD_COFFEE) {
-                    stirred_coffee = TRUE;
+                    st->stirred_coffee = TRUE;
                 }                
                 else if (previous_subtask == ADD_SUGAR) {
-                    stirred_sugar = TRUE;
+                    st->stirred_sugar = TRUE;
                 }                
                 else if (previous_subtask == ADD_MILK) {
-                    stirred_cream = TRUE;
+                    st->stirred_cream = TRUE;
                 }
-                else if (!added_cream && !added_sugar && !added_coffee) {
+                else if (!st->added_cream && !st->added_sugar && !st->added_coffee) {
                     if (next_steps_add_but_dont_stir_ingredient(action)) {
-                        errors = append_error(errors, "Reversal: Stirring before adding");
+                        errors = append_error(st, errors, "Reversal: Stirring before adding");
                         results->anticipations++;
                     }
                     else {
-                        errors = append_error(errors, "Anticipation: Stirring before adding anything");
+                        errors = append_error(st, errors, "Anticipation: Stirring before adding anything");
                         results->anticipations++;
                     }
                 }
-                else if (all_ingredients_have_been_stirred_in()) {
-                    errors = append_error(errors, "Perseveration: Recurrent stirring");
+                else if (all_ingredients_have_been_stirred_in(st)) {
+                    errors = append_error(st, errors, "Perseveration: Recurrent stirring");
                     results->perseverations++;
                 }
                 else {
-                    if (added_coffee) { stirred_coffee = TRUE; }
-                    if (added_sugar)  { stirred_sugar = TRUE; }
-                    if (added_cream)   { stirred_cream = TRUE; }
+                    if (st->added_coffee) { st->stirred_coffee = TRUE; }
+                    if (st->added_sugar)  { st->stirred_sugar = TRUE; }
+                    if (st->added_cream)   { st->stirred_cream = TRUE; }
                 }
                 previous_subtask = STIR_DRINK;
                 break;
             }
             case ACTION_DIP: {
-                if (action->arg1 == NULL) {
-                    errors = append_error(errors, "Tool omission on steeping");
+                if (action->arg1 == OBJECT_NONE) {
+                    errors = append_error(st, errors, "Tool omission on steeping");
                     results->tool_omission++;
                 }
                 else if (!is_teabag(action->arg1)) {
-                    g_snprintf(buffer, 128, "Object substitution (%s) on steeping", action->arg1);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution (%s) on steeping", object_name[action->arg1]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
 		}
                 else if (!is_mug(action->arg2)) {
-                    g_snprintf(buffer, 128, "Object substitution: Steeping in %s", action->arg2);
-                    errors = append_error(errors, buffer);
+                    g_snprintf(buffer, 128, "Object substitution: Steeping in %s", object_name[action->arg2]);
+                    errors = append_error(st, errors, buffer);
                     results->object_sub++;
                 }
-                else if (!added_tea) {
-                    added_tea = TRUE;
+                else if (!st->added_tea) {
+                    st->added_tea = TRUE;
                 }
                 else if (previous_subtask == STEEP_TEA) {
-                    errors = append_error(errors, "Perseveration: Continuous steeping of the tea");
+                    errors = append_error(st, errors, "Perseveration: Continuous steeping of the tea");
                     results->perseverations++;
                 }
                 else {
-                    errors = append_error(errors, "Perseveration: Recurrent tea steeping (after a pause)");
+                    errors = append_error(st, errors, "Perseveration: Recurrent tea steeping (after a pause)");
                     results->perseverations++;
                 }
                 previous_subtask = STEEP_TEA;
@@ -1735,83 +1722,83 @@ static GList *process_all_actions(GList *errors, TaskType *task, ACS2 *results)
     return(errors);
 }
 
-static GList *check_for_additions_and_omissions(GList *errors, TaskType *task, ACS2 *results)
+static GList *check_for_additions_and_omissions(ActionLog *log, Acs2State *st, GList *errors, TaskType *task, ACS2 *results)
 {
     switch (task->base) {
         case TASK_TEA: {
-            if (added_coffee) {
-                errors = append_error(errors, "Action addition: Coffee added when making tea");
+            if (st->added_coffee) {
+                errors = append_error(st, errors, "Action addition: Coffee added when making tea");
                 results->action_addition++;
             }
-            if (!added_tea) {
-                errors = append_error(errors, "Omission: Tea omitted when making tea");
+            if (!st->added_tea) {
+                errors = append_error(st, errors, "Omission: Tea omitted when making tea");
                 results->omissions++;
             }
-            if (added_cream) {
-                errors = append_error(errors, "Action addition: Milk added when making tea");
+            if (st->added_cream) {
+                errors = append_error(st, errors, "Action addition: Milk added when making tea");
                 results->action_addition++;
             }
-            if (!added_sugar) {
-                errors = append_error(errors, "Omission: Sugar not added");
+            if (!st->added_sugar) {
+                errors = append_error(st, errors, "Omission: Sugar not added");
                 results->omissions++;
             }
-            else if (!stirred_sugar) {
-                errors = append_error(errors, "Omission: Sugar added but not stirred in");
+            else if (!st->stirred_sugar) {
+                errors = append_error(st, errors, "Omission: Sugar added but not stirred in");
                 results->omissions++;
             }
-            if (sip_count == 0) {
-                errors = append_error(errors, "Omission: Drink not drunk");
+            if (st->sip_count == 0) {
+                errors = append_error(st, errors, "Omission: Drink not drunk");
                 results->omissions++;
             }
-            else if (sip_count == 1) {
-                errors = append_error(errors, "Omission: Only one sip");
+            else if (st->sip_count == 1) {
+                errors = append_error(st, errors, "Omission: Only one sip");
                 results->omissions++;
             }
 
-            if (added_tea && added_sugar && stirred_sugar && (sip_count == 2) && task_complete) {
+            if (st->added_tea && st->added_sugar && st->stirred_sugar && (st->sip_count == 2) && log->task_complete) {
                 results->accomplished = 1;
             }
             break;
         }
         case TASK_COFFEE: {
-            if (!added_coffee) {
-                errors = append_error(errors, "Omission: Coffee omitted when making coffee");
+            if (!st->added_coffee) {
+                errors = append_error(st, errors, "Omission: Coffee omitted when making coffee");
                 results->omissions++;
             }
-            else if (!stirred_coffee) {
-                errors = append_error(errors, "Omission: Coffee added but not stirred in");
+            else if (!st->stirred_coffee) {
+                errors = append_error(st, errors, "Omission: Coffee added but not stirred in");
                 results->omissions++;
             }
-            if (added_tea) {
-                errors = append_error(errors, "Action addition: Tea added when making coffee");
+            if (st->added_tea) {
+                errors = append_error(st, errors, "Action addition: Tea added when making coffee");
                 results->action_addition++;
             }
-            if (!added_cream) {
-                errors = append_error(errors, "Omission: Milk not added when making coffee");
+            if (!st->added_cream) {
+                errors = append_error(st, errors, "Omission: Milk not added when making coffee");
                 results->omissions++;
             }
-            else if (!stirred_cream) {
-                errors = append_error(errors, "Omission: Milk added but not stirred in");
+            else if (!st->stirred_cream) {
+                errors = append_error(st, errors, "Omission: Milk added but not stirred in");
                 results->omissions++;
             }
-            if (!added_sugar) {
-                errors = append_error(errors, "Omission: Sugar not added");
+            if (!st->added_sugar) {
+                errors = append_error(st, errors, "Omission: Sugar not added");
                 results->omissions++;
             }
-            else if (!stirred_sugar) {
-                errors = append_error(errors, "Omission: Sugar added but not stirred in");
+            else if (!st->stirred_sugar) {
+                errors = append_error(st, errors, "Omission: Sugar added but not stirred in");
                 results->omissions++;
             }
-            if (sip_count == 0) {
-                errors = append_error(errors, "Omission: Drink not drunk");
+            if (st->sip_count == 0) {
+                errors = append_error(st, errors, "Omission: Drink not drunk");
                 results->omissions++;
             }
-            else if (sip_count == 1) {
-                errors = append_error(errors, "Omission: Only one sip");
+            else if (st->sip_count == 1) {
+                errors = append_error(st, errors, "Omission: Only one sip");
                 results->omissions++;
             }
 
-            if (added_coffee && added_cream && stirred_cream && added_sugar && stirred_sugar && (sip_count == 2) && task_complete) {
+            if (st->added_coffee && st->added_cream && st->stirred_cream && st->added_sugar && st->stirred_sugar && (st->sip_count == 2) && log->task_complete) {
                 results->accomplished = 1;
             }
 
@@ -1821,33 +1808,60 @@ static GList *check_for_additions_and_omissions(GList *errors, TaskType *task, A
             break;
         }
     }
-    if (!task_complete) {
-        errors = append_error(errors, "Capture: Task not completed");
+    if (!log->task_complete) {
+        errors = append_error(st, errors, "Capture: Task not completed");
     }
     return(errors);
 }
 
 #if LOG_ERRORS
-static void log_actions_to_file(char *file)
+static void log_actions_to_file(ActionLog *log, char *file)
 {
     FILE *fp = fopen(file, "a");
-    print_actions_to_file(fp);
+    print_log_to_file(log, fp);
     fclose(fp);
 }
 #endif
 
-GList *analyse_actions_with_acs2(TaskType *task, ACS2 *results)
+static GList *analyse_log_with_acs2(ActionLog *log, TaskType *task, ACS2 *results, Boolean report)
 {
     GList *errors = NULL;
+    Acs2State state;
 
 #if LOG_ERRORS
-    log_actions_to_file("ERROR_LOG");
+    log_actions_to_file(log, "ERROR_LOG");
 #endif
-    initialise_state();
+    PROFILE_ENTER(PROFILE_CLASSIFY);
+    initialise_state(&state);
+    state.report = report;
     initialise_counts(results);
-    errors = process_all_actions(errors, task, results);
-    errors = check_for_additions_and_omissions(errors, task, results);
-    return(errors);
+    look_ahead(log);
+    errors = process_all_actions(log, &state, errors, task, results);
+    errors = check_for_additions_and_omissions(log, &state, errors, task, results);
+    PROFILE_EXIT(PROFILE_CLASSIFY);
+    return(g_list_reverse(errors));
+}
+
+GList *analyse_context_with_acs2(WorldContext *wc, TaskType *task, ACS2 *results)
+{
+    return(analyse_log_with_acs2(world_context_action_log(wc), task, results, TRUE));
+}
+
+GList *analyse_actions_with_acs2(TaskType *task, ACS2 *results)
+{
+    return(analyse_context_with_acs2(world_context_default(), task, results));
+}
+
+/* As above, when only the counts are wanted: no error strings are built */
+
+void analyse_context_count_with_acs2(WorldContext *wc, TaskType *task, ACS2 *results)
+{
+    analyse_log_with_acs2(world_context_action_log(wc), task, results, FALSE);
+}
+
+void analyse_actions_count_with_acs2(TaskType *task, ACS2 *results)
+{
+    analyse_context_count_with_acs2(world_context_default(), task, results);
 }
 
 void analyse_actions_code_free_error_list(GList *errors)
@@ -6,15 +6,24 @@
 typedef enum {FALSE, TRUE} Boolean;
 
 #include "lib_network.h"
+#include "lib_profile.h"
 #include "utils_maths.h"
 
 #include <math.h>
 #include <ctype.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 typedef enum {ERROR_NONE, 
     ERROR_RW_HEADER1, ERROR_RW_ALLOC1, ERROR_RW_READ1,
     ERROR_RW_HEADER2, ERROR_RW_ALLOC2, ERROR_RW_READ2,
-    ERROR_RW_HEADER3, ERROR_RW_ALLOC3, ERROR_RW_READ3} ErrorType;
+    ERROR_RW_HEADER3, ERROR_RW_ALLOC3, ERROR_RW_READ3,
+    ERROR_RW_VERSION, ERROR_RW_CHECKSUM} ErrorType;
 
 /******************************************************************************/
 
@@ -195,6 +204,7 @@ SequenceList *read_training_sequences(char *filename, int in_width, int out_widt
                 ok = FALSE;
             }
             else {
+                new->set = NULL;
                 last->tail = new;
                 last = last->tail;
             }
@@ -298,6 +308,19 @@ int sequence_list_length(SequenceList *seqs)
     return(n);
 }
 
+int sequence_list_max_length(SequenceList *seqs)
+{
+    int n, max = 0;
+
+    while (seqs != NULL) {
+        if ((n = pattern_list_length(seqs->head)) > max) {
+            max = n;
+        }
+        seqs = seqs->tail;
+    }
+    return(max);
+}
+
 void sequence_list_print(SequenceList *seqs, int in_width, int out_width, FILE *fp)
 {
     while (seqs != NULL) {
@@ -307,10 +330,17 @@ void sequence_list_print(SequenceList *seqs, int in_width, int out_width, FILE *
     }
 }
 
+static void sequence_set_free(SequenceSet *set);
+
 void sequence_list_free(SequenceList *seqs)
 {
     SequenceList *tmp;
 
+    if ((seqs != NULL) && (seqs->set != NULL)) {
+        /* A memory-mapped set: the nodes belong to the set */
+        sequence_set_free(seqs->set);
+        return;
+    }
     while (seqs != NULL) {
         tmp = seqs;
         pattern_list_free(tmp->head);
@@ -319,6 +349,202 @@ void sequence_list_free(SequenceList *seqs)
     }
 }
 
+/******************************************************************************/
+/* Binary training sets *******************************************************/
+
+/* A binary training set is a header, a table of sequence offsets, and then  */
+/* the inputs and targets of all patterns as two contiguous arrays of        */
+/* doubles (in native byte order). It is loaded by mapping the file into     */
+/* memory, with the PatternList vectors pointing directly into the mapping.  */
+/*                                                                           */
+/*   char    magic[8]                  "SRNSEQ01"                            */
+/*   int32   byte_order                0x01020304                            */
+/*   int32   in_width, out_width                                             */
+/*   int32   num_seqs, num_patterns                                          */
+/*   int32   reserved                                                        */
+/*   int32   offset[num_seqs+1]        Sequence s is patterns offset[s] to   */
+/*                                     offset[s+1]-1 (padded to 8 bytes)     */
+/*   double  vector_in[num_patterns][in_width]                               */
+/*   double  vector_out[num_patterns][out_width]                             */
+
+#define SEQ_BIN_MAGIC "SRNSEQ01"
+#define SEQ_BIN_BYTE_ORDER 0x01020304
+
+typedef struct seq_bin_header {
+    char    magic[8];
+    int32_t byte_order;
+    int32_t in_width, out_width;
+    int32_t num_seqs, num_patterns;
+    int32_t reserved;
+} SeqBinHeader;
+
+static size_t seq_bin_offset_size(int num_seqs)
+{
+    /* The offset table, padded so that the vectors are 8-byte aligned: */
+    return((((num_seqs+1) * sizeof(int32_t) + 7) / 8) * 8);
+}
+
+Boolean training_set_write_binary(SequenceList *seqs, int in_width, int out_width, char *filename)
+{
+    char tmpname[1024];
+    SeqBinHeader header;
+    SequenceList *s;
+    PatternList *p;
+    int32_t *offset;
+    size_t offset_size;
+    Boolean ok;
+    FILE *fp;
+    int i;
+
+    memset(&header, 0, sizeof(SeqBinHeader));
+    memcpy(header.magic, SEQ_BIN_MAGIC, 8);
+    header.byte_order = SEQ_BIN_BYTE_ORDER;
+    header.in_width = in_width;
+    header.out_width = out_width;
+    header.num_seqs = sequence_list_length(seqs);
+    for (s = seqs; s != NULL; s = s->tail) {
+        header.num_patterns += pattern_list_length(s->head);
+    }
+
+    offset_size = seq_bin_offset_size(header.num_seqs);
+    if ((offset = (int32_t *)calloc(1, offset_size)) == NULL) {
+        return(FALSE);
+    }
+    for (s = seqs, i = 0; s != NULL; s = s->tail, i++) {
+        offset[i+1] = offset[i] + pattern_list_length(s->head);
+    }
+
+    /* Write to a temporary file and rename it, so readers never see a */
+    /* partly written file. It is named per process, since the farm's  */
+    /* jobs may all convert the same training set at once:             */
+    snprintf(tmpname, 1024, "%s.%d.tmp", filename, (int) getpid());
+    if ((fp = fopen(tmpname, "wb")) == NULL) {
+        free(offset);
+        return(FALSE);
+    }
+    ok = (fwrite(&header, sizeof(SeqBinHeader), 1, fp) == 1);
+    ok = ok && (fwrite(offset, offset_size, 1, fp) == 1);
+    for (s = seqs; ok && (s != NULL); s = s->tail) {
+        for (p = s->head; ok && (p != NULL); p = p->next) {
+            ok = (fwrite(p->vector_in, sizeof(double), in_width, fp) == in_width);
+        }
+    }
+    for (s = seqs; ok && (s != NULL); s = s->tail) {
+        for (p = s->head; ok && (p != NULL); p = p->next) {
+            ok = (fwrite(p->vector_out, sizeof(double), out_width, fp) == out_width);
+        }
+    }
+    ok = (fclose(fp) == 0) && ok;
+    free(offset);
+
+    if (!ok || (rename(tmpname, filename) != 0)) {
+        remove(tmpname);
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+static void sequence_set_free(SequenceSet *set)
+{
+    munmap(set->map, set->map_size);
+    free(set);
+}
+
+SequenceList *read_training_sequences_binary(char *filename, int in_width, int out_width)
+{
+    /* Map a binary training set into memory. The PatternList and SequenceList */
+    /* nodes are allocated in one block along with the SequenceSet, and freed  */
+    /* (and the file unmapped) by sequence_list_free:                          */
+
+    SeqBinHeader *header;
+    SequenceSet *set;
+    SequenceList *seqs;
+    PatternList *pats;
+    struct stat st;
+    size_t size;
+    void *map;
+    int fd, i, j;
+
+    if ((fd = open(filename, O_RDONLY)) < 0) {
+        return(NULL);
+    }
+    else if ((fstat(fd, &st) != 0) || (st.st_size < (off_t) sizeof(SeqBinHeader))) {
+        close(fd);
+        return(NULL);
+    }
+    /* Private, writable mapping: pages are only copied if a vector is changed */
+    map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return(NULL);
+    }
+
+    header = (SeqBinHeader *)map;
+    size = sizeof(SeqBinHeader);
+    if ((memcmp(header->magic, SEQ_BIN_MAGIC, 8) != 0) || (header->byte_order != SEQ_BIN_BYTE_ORDER)) {
+        munmap(map, st.st_size);
+        return(NULL);
+    }
+    else if ((header->in_width != in_width) || (header->out_width != out_width)) {
+        fprintf(stderr, "WARNING: %s has %d inputs and %d outputs (expected %d and %d)\n", filename, header->in_width, header->out_width, in_width, out_width);
+        munmap(map, st.st_size);
+        return(NULL);
+    }
+    else if ((header->num_seqs < 1) || (header->num_patterns < 0)) {
+        munmap(map, st.st_size);
+        return(NULL);
+    }
+    size += seq_bin_offset_size(header->num_seqs) + header->num_patterns * (in_width + out_width) * sizeof(double);
+    if ((size_t) st.st_size != size) {
+        fprintf(stderr, "WARNING: %s is truncated or corrupt\n", filename);
+        munmap(map, st.st_size);
+        return(NULL);
+    }
+
+    if ((set = (SequenceSet *)malloc(sizeof(SequenceSet) + header->num_seqs * sizeof(SequenceList) + header->num_patterns * sizeof(PatternList))) == NULL) {
+        munmap(map, st.st_size);
+        return(NULL);
+    }
+    set->map = map;
+    set->map_size = st.st_size;
+    set->in_width = in_width;
+    set->out_width = out_width;
+    set->num_seqs = header->num_seqs;
+    set->num_patterns = header->num_patterns;
+    set->offset = (int *)((char *)map + sizeof(SeqBinHeader));
+    set->vector_in = (double *)((char *)set->offset + seq_bin_offset_size(set->num_seqs));
+    set->vector_out = set->vector_in + set->num_patterns * in_width;
+
+    seqs = (SequenceList *)(set + 1);
+    pats = (PatternList *)(seqs + set->num_seqs);
+    for (i = 0; i < set->num_patterns; i++) {
+        pats[i].vector_in = &set->vector_in[i * in_width];
+        pats[i].vector_out = &set->vector_out[i * out_width];
+        pats[i].next = NULL;
+    }
+    for (i = 0; i < set->num_seqs; i++) {
+        if ((set->offset[i] < 0) || (set->offset[i+1] <= set->offset[i]) || (set->offset[i+1] > set->num_patterns)) {
+            fprintf(stderr, "WARNING: %s is truncated or corrupt\n", filename);
+            sequence_set_free(set);
+            return(NULL);
+        }
+        for (j = set->offset[i]; j < set->offset[i+1] - 1; j++) {
+            pats[j].next = &pats[j+1];
+        }
+        seqs[i].head = &pats[set->offset[i]];
+        seqs[i].tail = (i+1 < set->num_seqs) ? &seqs[i+1] : NULL;
+        seqs[i].set = set;
+    }
+    return(seqs);
+}
+
+static Boolean file_is_newer(char *file1, char *file2)
+{
+    struct stat st1, st2;
+
+    return((stat(file1, &st1) == 0) && (stat(file2, &st2) == 0) && (st1.st_mtime >= st2.st_mtime));
+}
+
 /******************************************************************************/
 /******************************************************************************/
 /******************************************************************************/
@@ -377,42 +603,48 @@ void network_tell_randomise_hidden_units(Network *net)
     }
 }
 
-void network_perturb_weights_ih(Network *net, double variance)
+#define NOISE_BLOCK 256
+
+static void vector_add_normal_noise(double *v, int n, double sd)
 {
-    double sd = sqrt(variance);
-    int i, j;
+    // Add N(0, sd) noise to each of the n elements of v, generating the noise
+    // a block at a time:
 
-    if (net->weights_ih != NULL) {
-        for (i = 0; i < (net->in_width+1); i++) {
-            for (j = 0; j < net->hidden_width; j++) {
-                net->weights_ih[i * net->hidden_width + j] += random_normal(0, sd);
-            }
+    double noise[NOISE_BLOCK];
+    int i, k, m;
+
+    for (i = 0; i < n; i += m) {
+        m = (n - i < NOISE_BLOCK) ? n - i : NOISE_BLOCK;
+        random_fill_normal(noise, m, 0.0, sd);
+        for (k = 0; k < m; k++) {
+            v[i+k] += noise[k];
         }
     }
 }
 
-void network_perturb_weights_ch(Network *net, double variance)
+void network_perturb_weights_ih(Network *net, double variance)
 {
-    double sd = sqrt(variance);
-    int i, j;
+    PROFILE_ENTER(PROFILE_LESION);
+    if (net->weights_ih != NULL) {
+        vector_add_normal_noise(net->weights_ih, (net->in_width+1) * net->hidden_width, sqrt(variance));
+    }
+    PROFILE_EXIT(PROFILE_LESION);
+}
 
+void network_perturb_weights_ch(Network *net, double variance)
+{
+    PROFILE_ENTER(PROFILE_LESION);
     if (net->weights_hh != NULL) {
-        for (i = 0; i < net->hidden_width; i++) {
-            for (j = 0; j < net->hidden_width; j++) {
-                net->weights_hh[i * net->hidden_width + j] += random_normal(0, sd);
-            }
-        }
+        vector_add_normal_noise(net->weights_hh, net->hidden_width * net->hidden_width, sqrt(variance));
     }
+    PROFILE_EXIT(PROFILE_LESION);
 }
 
 void network_inject_noise(Network *net, double variance)
 {
-    double sd = sqrt(variance);
-    int i;
-
-    for (i = 0; i < net->hidden_width; i++) {
-        net->units_hidden[i] += random_normal(0, sd);
-    }
+    PROFILE_ENTER(PROFILE_LESION);
+    vector_add_normal_noise(net->units_hidden, net->hidden_width, sqrt(variance));
+    PROFILE_EXIT(PROFILE_LESION);
 }
 
 void network_print_state(FILE *fp, Network *net, char *message)
@@ -440,34 +672,34 @@ void network_print_state(FILE *fp, Network *net, char *message)
 
 /******************************************************************************/
 
-void network_lesion_weights_ih(Network *net, double severity)
+static void vector_lesion(double *w, int n, double severity)
 {
-    int i, j;
+    // Zero each of the n weights in w with probability severity, skipping
+    // directly from one lesioned weight to the next:
+
+    int k;
+
+    for (k = random_bernoulli_next(-1, n, severity); k < n; k = random_bernoulli_next(k, n, severity)) {
+        w[k] = 0;
+    }
+}
 
+void network_lesion_weights_ih(Network *net, double severity)
+{
+    PROFILE_ENTER(PROFILE_LESION);
     if (net->weights_ih != NULL) {
-        for (i = 0; i < (net->in_width+1); i++) {
-            for (j = 0; j < net->hidden_width; j++) {
-                if (random_uniform(0.0, 1.0) < severity) {
-                    net->weights_ih[i * net->hidden_width + j] = 0;
-                }
-            }
-        }
+        vector_lesion(net->weights_ih, (net->in_width+1) * net->hidden_width, severity);
     }
+    PROFILE_EXIT(PROFILE_LESION);
 }
 
 void network_lesion_weights_ch(Network *net, double severity)
 {
-    int i, j;
-
+    PROFILE_ENTER(PROFILE_LESION);
     if (net->weights_hh != NULL) {
-        for (i = 0; i < net->hidden_width; i++) {
-            for (j = 0; j < net->hidden_width; j++) {
-                if (random_uniform(0.0, 1.0) < severity) {
-                    net->weights_hh[i * net->hidden_width + j] = 0;
-                }
-            }
-        }
+        vector_lesion(net->weights_hh, net->hidden_width * net->hidden_width, severity);
     }
+    PROFILE_EXIT(PROFILE_LESION);
 }
 
 /******************************************************************************/
@@ -476,6 +708,7 @@ void network_ablate_context(Network *net, double severity)
 {
     int i, j;
 
+    PROFILE_ENTER(PROFILE_LESION);
     if (net->weights_hh != NULL) {
         for (i = 0; i < net->hidden_width; i++) {
             if (random_uniform(0.0, 1.0) < severity) {
@@ -485,6 +718,7 @@ void network_ablate_context(Network *net, double severity)
             }
         }
     }
+    PROFILE_EXIT(PROFILE_LESION);
 }
 
 /******************************************************************************/
@@ -493,6 +727,8 @@ void network_scale_weights(Network *net, double proportion)
 {
     int i, j;
 
+    PROFILE_ENTER(PROFILE_LESION);
+
     /* Scale input to hidden weights: */
     if (net->weights_ih != NULL) {
         for (i = 0; i < (net->in_width+1); i++) {
@@ -519,6 +755,289 @@ void network_scale_weights(Network *net, double proportion)
             }
         }
     }
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+/******************************************************************************/
+/* Damage overlays: Each function below draws random numbers in the same     */
+/* order as the corresponding network_ function above, so damage applied to  */
+/* an overlay gives exactly the weights that damaging a copy would give.     */
+
+#define DAMAGE_BIT_TEST(mask, k) ((mask)[(k) >> 5] & (1u << ((k) & 31)))
+#define DAMAGE_BIT_SET(mask, k) ((mask)[(k) >> 5] |= (1u << ((k) & 31)))
+
+static int damage_mask_words(int n)
+{
+    return((n + 31) / 32);
+}
+
+void damage_overlay_destroy(DamageOverlay *damage)
+{
+    if (damage != NULL) {
+        free(damage->severed_ih);
+        free(damage->severed_hh);
+        free(damage->noise_ih);
+        free(damage->noise_hh);
+        free(damage->ablated);
+        free(damage->rank_ih.order);
+        free(damage->rank_ih.key);
+        free(damage->rank_hh.order);
+        free(damage->rank_hh.key);
+        free(damage);
+    }
+}
+
+DamageOverlay *damage_overlay_create(Network *net)
+{
+    int nih = (net->in_width+1) * net->hidden_width;
+    int nhh = net->hidden_width * net->hidden_width;
+    DamageOverlay *damage;
+
+    if ((damage = (DamageOverlay *)calloc(1, sizeof(DamageOverlay))) != NULL) {
+        damage->in_width = net->in_width;
+        damage->hidden_width = net->hidden_width;
+        damage->out_width = net->out_width;
+        damage->severed_ih = (unsigned int *)calloc(damage_mask_words(nih), sizeof(unsigned int));
+        damage->severed_hh = (unsigned int *)calloc(damage_mask_words(nhh), sizeof(unsigned int));
+        damage->noise_ih = (double *)calloc(nih, sizeof(double));
+        damage->noise_hh = (double *)calloc(nhh, sizeof(double));
+        damage->ablated = (Boolean *)calloc(net->hidden_width, sizeof(Boolean));
+        damage->scale = 1.0;
+        damage->rank_ih.n = nih;
+        damage->rank_ih.order = (int *)malloc(nih * sizeof(int));
+        damage->rank_ih.key = (double *)malloc(nih * sizeof(double));
+        damage->rank_hh.n = nhh;
+        damage->rank_hh.order = (int *)malloc(nhh * sizeof(int));
+        damage->rank_hh.key = (double *)malloc(nhh * sizeof(double));
+
+        if ((damage->severed_ih == NULL) || (damage->severed_hh == NULL) || (damage->noise_ih == NULL) || (damage->noise_hh == NULL) || (damage->ablated == NULL) || (damage->rank_ih.order == NULL) || (damage->rank_ih.key == NULL) || (damage->rank_hh.order == NULL) || (damage->rank_hh.key == NULL)) {
+            damage_overlay_destroy(damage);
+            return(NULL);
+        }
+    }
+    return(damage);
+}
+
+void damage_overlay_clear(DamageOverlay *damage)
+{
+    int nih = (damage->in_width+1) * damage->hidden_width;
+    int nhh = damage->hidden_width * damage->hidden_width;
+
+    if (damage->any_severed) {
+        memset(damage->severed_ih, 0, damage_mask_words(nih) * sizeof(unsigned int));
+        memset(damage->severed_hh, 0, damage_mask_words(nhh) * sizeof(unsigned int));
+    }
+    if (damage->any_noise) {
+        memset(damage->noise_ih, 0, nih * sizeof(double));
+        memset(damage->noise_hh, 0, nhh * sizeof(double));
+    }
+    if (damage->any_ablated) {
+        memset(damage->ablated, 0, damage->hidden_width * sizeof(Boolean));
+    }
+    damage->scale = 1.0;
+    damage->any_severed = FALSE;
+    damage->any_noise = FALSE;
+    damage->any_ablated = FALSE;
+    damage->rank_ih.severed = 0;
+    damage->rank_hh.severed = 0;
+}
+
+void damage_overlay_perturb_weights_ih(DamageOverlay *damage, double variance)
+{
+    PROFILE_ENTER(PROFILE_LESION);
+    vector_add_normal_noise(damage->noise_ih, (damage->in_width+1) * damage->hidden_width, sqrt(variance));
+    damage->any_noise = TRUE;
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+void damage_overlay_perturb_weights_ch(DamageOverlay *damage, double variance)
+{
+    PROFILE_ENTER(PROFILE_LESION);
+    vector_add_normal_noise(damage->noise_hh, damage->hidden_width * damage->hidden_width, sqrt(variance));
+    damage->any_noise = TRUE;
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+static void damage_overlay_sever(unsigned int *mask, int n, double severity, Boolean *any)
+{
+    // Mark each of n weights as severed with probability severity, drawing
+    // the same random numbers as vector_lesion():
+
+    int k;
+
+    for (k = random_bernoulli_next(-1, n, severity); k < n; k = random_bernoulli_next(k, n, severity)) {
+        DAMAGE_BIT_SET(mask, k);
+        *any = TRUE;
+    }
+}
+
+void damage_overlay_lesion_weights_ih(DamageOverlay *damage, double severity)
+{
+    PROFILE_ENTER(PROFILE_LESION);
+    damage_overlay_sever(damage->severed_ih, (damage->in_width+1) * damage->hidden_width, severity, &damage->any_severed);
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+void damage_overlay_lesion_weights_ch(DamageOverlay *damage, double severity)
+{
+    PROFILE_ENTER(PROFILE_LESION);
+    damage_overlay_sever(damage->severed_hh, damage->hidden_width * damage->hidden_width, severity, &damage->any_severed);
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+void damage_overlay_rank_weights(DamageOverlay *damage)
+{
+    // Draw a new ranking of the connections for nested lesions. This does
+    // not restore connections already severed (use damage_overlay_clear()):
+
+    PROFILE_ENTER(PROFILE_LESION);
+    random_ranking(damage->rank_ih.n, damage->rank_ih.order, damage->rank_ih.key);
+    random_ranking(damage->rank_hh.n, damage->rank_hh.order, damage->rank_hh.key);
+    damage->rank_ih.severed = 0;
+    damage->rank_hh.severed = 0;
+    damage->ranked = TRUE;
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+static void lesion_ranking_sever(LesionRanking *rank, unsigned int *mask, double severity, Boolean *any)
+{
+    // Only the connections ranked between the last severity and this one
+    // need to be severed, so stepping up through the levels costs no more
+    // in total than the most severe lesion:
+
+    while ((rank->severed < rank->n) && (rank->key[rank->severed] < severity)) {
+        DAMAGE_BIT_SET(mask, rank->order[rank->severed]);
+        rank->severed++;
+        *any = TRUE;
+    }
+}
+
+void damage_overlay_lesion_nested_ih(DamageOverlay *damage, double severity)
+{
+    PROFILE_ENTER(PROFILE_LESION);
+    if (!damage->ranked) {
+        damage_overlay_rank_weights(damage);
+    }
+    lesion_ranking_sever(&damage->rank_ih, damage->severed_ih, severity, &damage->any_severed);
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+void damage_overlay_lesion_nested_ch(DamageOverlay *damage, double severity)
+{
+    PROFILE_ENTER(PROFILE_LESION);
+    if (!damage->ranked) {
+        damage_overlay_rank_weights(damage);
+    }
+    lesion_ranking_sever(&damage->rank_hh, damage->severed_hh, severity, &damage->any_severed);
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+void damage_overlay_ablate_context(DamageOverlay *damage, double severity)
+{
+    int i;
+
+    PROFILE_ENTER(PROFILE_LESION);
+    for (i = 0; i < damage->hidden_width; i++) {
+        if (random_uniform(0.0, 1.0) < severity) {
+            damage->ablated[i] = TRUE;
+            damage->any_ablated = TRUE;
+        }
+    }
+    PROFILE_EXIT(PROFILE_LESION);
+}
+
+void damage_overlay_scale_weights(DamageOverlay *damage, double proportion)
+{
+    damage->scale *= proportion;
+}
+
+void network_tell_damage(Network *net, DamageOverlay *damage)
+{
+    /* Propagate through the weights as damaged by damage (NULL for none): */
+
+    net->damage = damage;
+}
+
+/*----------------------------------------------------------------------------*/
+/* The damaged forward pass, for one network state. Sums are accumulated in  */
+/* the same order as network_tell_propagate2(), so the result is identical   */
+/* to propagating through a copy of the weights damaged in place.            */
+
+static void damage_accumulate(DamageOverlay *damage, int n, double x, double *w, unsigned int *severed, double *noise, int k0, double *t)
+{
+    /* t[j] += x * (damaged weight j), for the n weights from one unit: */
+
+    double scale = damage->scale;
+    double wk;
+    int j;
+
+    if (x == 0.0) {
+        /* Adding zero leaves the sums unchanged */
+    }
+    else if ((severed == NULL) || !damage->any_severed) {
+        if ((noise == NULL) || !damage->any_noise) {
+            for (j = 0; j < n; j++) {
+                t[j] += x * (w[j] * scale);
+            }
+        }
+        else {
+            for (j = 0; j < n; j++) {
+                t[j] += x * ((w[j] + noise[k0 + j]) * scale);
+            }
+        }
+    }
+    else {
+        for (j = 0; j < n; j++) {
+            if (DAMAGE_BIT_TEST(severed, k0 + j)) {
+                wk = 0.0;
+            }
+            else if ((noise != NULL) && damage->any_noise) {
+                wk = w[j] + noise[k0 + j];
+            }
+            else {
+                wk = w[j];
+            }
+            t[j] += x * (wk * scale);
+        }
+    }
+}
+
+static void network_damaged_propagate_hidden(Network *net, DamageOverlay *damage, double *units_in, double *units_hidden, double *tmp_hidden)
+{
+    int iw = net->in_width, hw = net->hidden_width;
+    int i, j;
+
+    for (j = 0; j < hw; j++) {
+        tmp_hidden[j] = 0.0;
+    }
+    for (i = 0; i < (iw+1); i++) {
+        damage_accumulate(damage, hw, units_in[i], &net->weights_ih[i * hw], damage->severed_ih, damage->noise_ih, i * hw, tmp_hidden);
+    }
+    for (i = 0; i < hw; i++) {
+        /* An ablated context unit contributes nothing: */
+        if (!(damage->any_ablated && damage->ablated[i])) {
+            damage_accumulate(damage, hw, units_hidden[i], &net->weights_hh[i * hw], damage->severed_hh, damage->noise_hh, i * hw, tmp_hidden);
+        }
+    }
+    for (j = 0; j < hw; j++) {
+        units_hidden[j] = sigmoid(tmp_hidden[j]);
+    }
+}
+
+static void network_damaged_propagate_output(Network *net, DamageOverlay *damage, double *units_hidden, double *units_out, double *tmp_out)
+{
+    int hw = net->hidden_width, ow = net->out_width;
+    int i, j;
+
+    for (j = 0; j < ow; j++) {
+        tmp_out[j] = 0.0;
+    }
+    for (i = 0; i < (hw+1); i++) {
+        damage_accumulate(damage, ow, units_hidden[i], &net->weights_ho[i * ow], NULL, NULL, i * ow, tmp_out);
+    }
+    for (j = 0; j < ow; j++) {
+        units_out[j] = sigmoid(tmp_out[j]);
+    }
 }
 
 /******************************************************************************/
@@ -710,6 +1229,21 @@ void network_tell_initialise(Network *net)
     network_tell_initialise_units(net);
 }
 
+static void network_free_bptt_workspace(Network *net)
+{
+    if (net->bptt_hidden != NULL) { free(net->bptt_hidden); }
+    if (net->bptt_error != NULL) { free(net->bptt_error); }
+    if (net->bptt_out != NULL) { free(net->bptt_out); }
+    if (net->bptt_delta != NULL) { free(net->bptt_delta); }
+    if (net->bptt_epsilon != NULL) { free(net->bptt_epsilon); }
+    net->bptt_hidden = NULL;
+    net->bptt_error = NULL;
+    net->bptt_out = NULL;
+    net->bptt_delta = NULL;
+    net->bptt_epsilon = NULL;
+    net->bptt_length = 0;
+}
+
 void network_tell_destroy(Network *net)
 {
     /* SRN Version: */
@@ -726,6 +1260,7 @@ void network_tell_destroy(Network *net)
         if (net->tmp_ih_deltas != NULL) { free(net->tmp_ih_deltas); }
         if (net->tmp_hh_deltas != NULL) { free(net->tmp_hh_deltas); }
         if (net->tmp_ho_deltas != NULL) { free(net->tmp_ho_deltas); }
+        network_free_bptt_workspace(net);
         free(net);
     }
 }
@@ -762,6 +1297,17 @@ Network *network_create(int iw, int hw, int ow)
         net->tmp_ih_deltas = (double *)malloc((net->in_width+1) * net->hidden_width * sizeof(double));
         net->tmp_hh_deltas = (double *)malloc(net->hidden_width * net->hidden_width * sizeof(double));
         net->tmp_ho_deltas = (double *)malloc((net->hidden_width+1) * net->out_width * sizeof(double));
+
+        /* The BPTT workspace is allocated when the training set is known: */
+
+        net->bptt_length = 0;
+        net->bptt_hidden = NULL;
+        net->bptt_error = NULL;
+        net->bptt_out = NULL;
+        net->bptt_delta = NULL;
+        net->bptt_epsilon = NULL;
+
+        net->damage = NULL;
     }
     return(net);
 }
@@ -830,6 +1376,28 @@ Network *network_copy(Network *net)
     return(new);
 }
 
+Boolean network_copy_weights(Network *dst, Network *src)
+{
+    /* Overwrite the weights of dst with those of src, without reallocating */
+    /* anything. Used to restore a damaged working copy of a network:       */
+
+    int iw, hw, ow;
+
+    iw = src->in_width;
+    hw = src->hidden_width;
+    ow = src->out_width;
+
+    if ((dst->in_width != iw) || (dst->hidden_width != hw) || (dst->out_width != ow)) {
+        return(FALSE);
+    }
+    else {
+        memcpy(dst->weights_ih, src->weights_ih, (iw+1) * hw * sizeof(double));
+        memcpy(dst->weights_hh, src->weights_hh, hw * hw * sizeof(double));
+        memcpy(dst->weights_ho, src->weights_ho, (hw+1) * ow * sizeof(double));
+        return(TRUE);
+    }
+}
+
 void network_tell_input(Network *net, double *vector)
 {
     /* SRN Version: */
@@ -848,6 +1416,14 @@ void network_tell_propagate(Network *net)
 
     int i, j;
 
+    PROFILE_ENTER(PROFILE_PROPAGATE);
+    if (net->damage != NULL) {
+        network_damaged_propagate_output(net, net->damage, net->units_hidden, net->units_out, net->tmp_out);
+        network_damaged_propagate_hidden(net, net->damage, net->units_in, net->units_hidden, net->tmp_hidden);
+        PROFILE_EXIT(PROFILE_PROPAGATE);
+        return;
+    }
+
     /* Propagate from hidden to output: */
 
     if (net->tmp_out != NULL) {
@@ -879,6 +1455,7 @@ void network_tell_propagate(Network *net)
             net->units_hidden[j] = sigmoid(net->tmp_hidden[j]);
         }
     }
+    PROFILE_EXIT(PROFILE_PROPAGATE);
 }
 
 void network_tell_propagate2(Network *net)
@@ -887,6 +1464,14 @@ void network_tell_propagate2(Network *net)
 
     int i, j;
 
+    PROFILE_ENTER(PROFILE_PROPAGATE);
+    if (net->damage != NULL) {
+        network_damaged_propagate_hidden(net, net->damage, net->units_in, net->units_hidden, net->tmp_hidden);
+        network_damaged_propagate_output(net, net->damage, net->units_hidden, net->units_out, net->tmp_out);
+        PROFILE_EXIT(PROFILE_PROPAGATE);
+        return;
+    }
+
     /* Propagate from input and hidden to hidden: */
 
     if (net->tmp_hidden != NULL) {
@@ -918,35 +1503,216 @@ void network_tell_propagate2(Network *net)
             net->units_out[j] = sigmoid(net->tmp_out[j]);
         }
     }
+    PROFILE_EXIT(PROFILE_PROPAGATE);
 }
 
 /******************************************************************************/
-/******************************************************************************/
+/* Batched propagation: Advance many independent copies of the network state  */
+/* (one row of the batch per episode) in lock-step. Rows that use the same    */
+/* weights are propagated together, so each step is a matrix-matrix product  */
+/* rather than one matrix-vector product per episode. The result for each row */
+/* is identical to that of network_tell_propagate2().                         */
 
-static void training_sequences_randomise(SequenceList *sequences)
+NetworkBatch *network_batch_create(int size, int iw, int hw, int ow)
 {
-    if (sequences != NULL) {
-        SequenceList *tmp, *this;
-    
-        for (tmp = sequences; tmp->tail != NULL; tmp = tmp->tail) {
-            PatternList *pl;
-            int i = random_int(sequence_list_length(tmp));
-
-            this = tmp->tail;
-            while (--i > 0) {
-                this = this->tail;
-            }
+    NetworkBatch *batch;
+    int b;
+
+    if ((batch = (NetworkBatch *)malloc(sizeof(NetworkBatch))) != NULL) {
+        batch->size = size;
+        batch->in_width = iw;
+        batch->hidden_width = hw;
+        batch->out_width = ow;
+        batch->units_in = (double *)calloc(size * (iw+1), sizeof(double));
+        batch->units_hidden = (double *)calloc(size * (hw+1), sizeof(double));
+        batch->units_out = (double *)calloc(size * ow, sizeof(double));
+        batch->tmp_hidden = (double *)malloc(size * hw * sizeof(double));
+        batch->tmp_out = (double *)malloc(size * ow * sizeof(double));
+        batch->active = (Boolean *)malloc(size * sizeof(Boolean));
+
+        if ((batch->units_in == NULL) || (batch->units_hidden == NULL) || (batch->units_out == NULL) || (batch->tmp_hidden == NULL) || (batch->tmp_out == NULL) || (batch->active == NULL)) {
+            network_batch_destroy(batch);
+            return(NULL);
+        }
+        for (b = 0; b < size; b++) {
+            batch->units_in[b * (iw+1) + iw] = 1.0;     // The bias units ... never change these!
+            batch->units_hidden[b * (hw+1) + hw] = 1.0;
+            batch->active[b] = TRUE;
+        }
+    }
+    return(batch);
+}
 
-            pl = this->head;
-            this->head = tmp->head;
-            tmp->head = pl;
-        }
+void network_batch_destroy(NetworkBatch *batch)
+{
+    if (batch != NULL) {
+        if (batch->units_in != NULL) { free(batch->units_in); }
+        if (batch->units_hidden != NULL) { free(batch->units_hidden); }
+        if (batch->units_out != NULL) { free(batch->units_out); }
+        if (batch->tmp_hidden != NULL) { free(batch->tmp_hidden); }
+        if (batch->tmp_out != NULL) { free(batch->tmp_out); }
+        if (batch->active != NULL) { free(batch->active); }
+        free(batch);
     }
 }
 
-static void network_train_initialise_deltas(Network *net)
+void network_batch_tell_input(NetworkBatch *batch, int b, double *vector)
 {
-    /* SRN Version: */
+    memcpy(&batch->units_in[b * (batch->in_width+1)], vector, batch->in_width * sizeof(double));
+}
+
+void network_batch_ask_output(NetworkBatch *batch, int b, double *vector)
+{
+    memcpy(vector, &batch->units_out[b * batch->out_width], batch->out_width * sizeof(double));
+}
+
+void network_batch_randomise_hidden_units(NetworkBatch *batch, int b)
+{
+    double *h = &batch->units_hidden[b * (batch->hidden_width+1)];
+    int i;
+
+    for (i = 0; i < batch->hidden_width; i++) {
+        h[i] = random_uniform(0.01, 0.99);
+    }
+}
+
+void network_batch_inject_noise(NetworkBatch *batch, int b, double variance)
+{
+    vector_add_normal_noise(&batch->units_hidden[b * (batch->hidden_width+1)], batch->hidden_width, sqrt(variance));
+}
+
+static void network_batch_propagate_rows(Network *net, NetworkBatch *batch, int b0, int b1)
+{
+    /* Propagate rows b0 .. b1-1 (all active) through the weights of net. The */
+    /* loops run over weight rows outermost, so each row of each matrix is    */
+    /* loaded once per step and the innermost loop is over contiguous memory. */
+
+    int iw = batch->in_width, hw = batch->hidden_width, ow = batch->out_width;
+    double *w, *t, x;
+    int b, i, j;
+
+    /* Input and hidden to hidden: */
+
+    for (b = b0; b < b1; b++) {
+        t = &batch->tmp_hidden[b * hw];
+        for (j = 0; j < hw; j++) {
+            t[j] = 0.0;
+        }
+    }
+    for (i = 0; i < (iw+1); i++) {
+        w = &net->weights_ih[i * hw];
+        for (b = b0; b < b1; b++) {
+            /* Most inputs are zero, and adding zero leaves the sum unchanged: */
+            if ((x = batch->units_in[b * (iw+1) + i]) != 0.0) {
+                t = &batch->tmp_hidden[b * hw];
+                for (j = 0; j < hw; j++) {
+                    t[j] += x * w[j];
+                }
+            }
+        }
+    }
+    for (i = 0; i < hw; i++) {
+        w = &net->weights_hh[i * hw];
+        for (b = b0; b < b1; b++) {
+            x = batch->units_hidden[b * (hw+1) + i];
+            t = &batch->tmp_hidden[b * hw];
+            for (j = 0; j < hw; j++) {
+                t[j] += x * w[j];
+            }
+        }
+    }
+    for (b = b0; b < b1; b++) {
+        t = &batch->tmp_hidden[b * hw];
+        for (j = 0; j < hw; j++) {
+            batch->units_hidden[b * (hw+1) + j] = sigmoid(t[j]);
+        }
+    }
+
+    /* Hidden to output: */
+
+    for (b = b0; b < b1; b++) {
+        t = &batch->tmp_out[b * ow];
+        for (j = 0; j < ow; j++) {
+            t[j] = 0.0;
+        }
+    }
+    for (i = 0; i < (hw+1); i++) {
+        w = &net->weights_ho[i * ow];
+        for (b = b0; b < b1; b++) {
+            x = batch->units_hidden[b * (hw+1) + i];
+            t = &batch->tmp_out[b * ow];
+            for (j = 0; j < ow; j++) {
+                t[j] += x * w[j];
+            }
+        }
+    }
+    for (b = b0; b < b1; b++) {
+        t = &batch->tmp_out[b * ow];
+        for (j = 0; j < ow; j++) {
+            batch->units_out[b * ow + j] = sigmoid(t[j]);
+        }
+    }
+}
+
+void network_batch_propagate2(NetworkBatch *batch, Network **nets, DamageOverlay **damage)
+{
+    /* nets[b] gives the weights for row b, and damage[b] (if damage is not  */
+    /* NULL) any damage to apply to them. Inactive rows are skipped, damaged */
+    /* rows are propagated individually, and each run of consecutive active  */
+    /* undamaged rows sharing weights is propagated as one block:            */
+
+    int iw = batch->in_width, hw = batch->hidden_width, ow = batch->out_width;
+    int b0 = 0, b1;
+
+    PROFILE_ENTER(PROFILE_PROPAGATE);
+    while (b0 < batch->size) {
+        if (!batch->active[b0]) {
+            b0++;
+        }
+        else if ((damage != NULL) && (damage[b0] != NULL)) {
+            network_damaged_propagate_hidden(nets[b0], damage[b0], &batch->units_in[b0 * (iw+1)], &batch->units_hidden[b0 * (hw+1)], &batch->tmp_hidden[b0 * hw]);
+            network_damaged_propagate_output(nets[b0], damage[b0], &batch->units_hidden[b0 * (hw+1)], &batch->units_out[b0 * ow], &batch->tmp_out[b0 * ow]);
+            b0++;
+        }
+        else {
+            b1 = b0 + 1;
+            while ((b1 < batch->size) && batch->active[b1] && (nets[b1] == nets[b0]) && ((damage == NULL) || (damage[b1] == NULL))) {
+                b1++;
+            }
+            network_batch_propagate_rows(nets[b0], batch, b0, b1);
+            b0 = b1;
+        }
+    }
+    PROFILE_EXIT(PROFILE_PROPAGATE);
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+static void training_sequences_randomise(SequenceList *sequences)
+{
+    if (sequences != NULL) {
+        SequenceList *tmp, *this;
+    
+        for (tmp = sequences; tmp->tail != NULL; tmp = tmp->tail) {
+            PatternList *pl;
+            int i = random_int(sequence_list_length(tmp));
+
+            this = tmp->tail;
+            while (--i > 0) {
+                this = this->tail;
+            }
+
+            pl = this->head;
+            this->head = tmp->head;
+            tmp->head = pl;
+        }
+    }
+}
+
+static void network_train_initialise_deltas(Network *net)
+{
+    /* SRN Version: */
 
     int i, j;
 
@@ -973,6 +1739,7 @@ static void network_train_update_weights(Network *net, double lr)
 
     int i, j;
 
+    PROFILE_ENTER(PROFILE_BPTT_UPDATE);
     for (i = 0; i < (net->in_width+1); i++) {
         for (j = 0; j < net->hidden_width; j++) {
             net->weights_ih[i * net->hidden_width + j] -= lr * net->tmp_ih_deltas[i * net->hidden_width + j];
@@ -988,29 +1755,101 @@ static void network_train_update_weights(Network *net, double lr)
             net->weights_ho[i * net->out_width + j] -= lr * net->tmp_ho_deltas[i * net->out_width + j];
         }
     }
+    PROFILE_EXIT(PROFILE_BPTT_UPDATE);
+}
+
+/* The dot product of two contiguous vectors, added to sum. By default this  */
+/* accumulates strictly in order, so results are identical to the original   */
+/* unit-by-unit BPTT loop. Compiling with -DBPTT_SIMD instead uses four      */
+/* partial sums, which the compiler can vectorise; with GCC on x86-64 AVX2   */
+/* and AVX-512 versions are also built and the best is selected at run time. */
+
+#if defined(BPTT_SIMD) && defined(__GNUC__) && defined(__x86_64__)
+__attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+static double vector_dot_add(double sum, int n, const double *a, const double *b)
+{
+    int i;
+#ifdef BPTT_SIMD
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+    for (i = 0; i + 3 < n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i+1] * b[i+1];
+        s2 += a[i+2] * b[i+2];
+        s3 += a[i+3] * b[i+3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i] * b[i];
+    }
+    return(sum + ((s0 + s1) + (s2 + s3)));
+#else
+
+    for (i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return(sum);
+#endif
 }
 
-static void network_calculate_weight_changes(Network *net, PatternList *patterns, double (*net_error_function)(), Boolean penalty)
+Boolean network_reserve_bptt_workspace(Network *net, int length)
+{
+    /* Make sure the BPTT workspace can hold a sequence of the given length  */
+    /* (plus the two extra time steps needed for the output lag). The space  */
+    /* only ever grows, so once reserved training makes no heap allocations: */
+
+    int units = net->hidden_width + net->out_width;
+
+    if (length <= net->bptt_length) {
+        return(TRUE);
+    }
+
+    network_free_bptt_workspace(net);
+    net->bptt_hidden = (double *)malloc((length+2) * net->hidden_width * sizeof(double));
+    net->bptt_error = (double *)malloc((length+2) * net->out_width * sizeof(double));
+    net->bptt_out = (double *)malloc((length+2) * net->out_width * sizeof(double));
+    net->bptt_delta = (double *)malloc((length+2) * units * sizeof(double));
+    net->bptt_epsilon = (double *)malloc((length+2) * units * sizeof(double));
+
+    if ((net->bptt_hidden == NULL) || (net->bptt_error == NULL) || (net->bptt_out == NULL) || (net->bptt_delta == NULL) || (net->bptt_epsilon == NULL)) {
+        network_free_bptt_workspace(net);
+        return(FALSE);
+    }
+    net->bptt_length = length;
+    return(TRUE);
+}
+
+static Boolean network_calculate_sequence_changes(Network *net, PatternList *patterns, double (*net_error_function)(), Boolean penalty)
 {
     /* SRN learning: An implementation of BPTT, based on Williams & Zipser, 1995 */
+    /* The hidden units should already hold the initial state for the sequence. */
 
     int n = pattern_list_length(patterns);
 //    int hw = net->hidden_width;
     int units = net->hidden_width + net->out_width;
-    double *history_hidden = (double *)malloc((n+2) * net->hidden_width * sizeof(double));
-    double *history_error = (double *)malloc((n+2) * net->out_width * sizeof(double));
-    double *history_out = (double *)malloc((n+2) * net->out_width * sizeof(double));
-    double *delta = (double *)malloc((n+2) * units * sizeof(double));
-    double *epsilon = (double *)malloc((n+2) * units * sizeof(double));
+    double *history_hidden, *history_error, *history_out;
+    double *delta, *epsilon;
     PatternList *this, *prev;
-    double y, weight_lk, df;
-    int i, j, k, l, t;
+    double y, df;
+    int i, j, k, t;
+
+    /* 0: The workspace is normally reserved for the longest sequence when the */
+    /* training set is loaded, so this only allocates if that wasn't done:     */
+
+    if (!network_reserve_bptt_workspace(net, n)) {
+        return(FALSE);
+    }
+    history_hidden = net->bptt_hidden;
+    history_error = net->bptt_error;
+    history_out = net->bptt_out;
+    delta = net->bptt_delta;
+    epsilon = net->bptt_epsilon;
 
     /* 1: Run the network over the entire sequence and collect its state: */
 
+    PROFILE_ENTER(PROFILE_BPTT_FORWARD);
     prev = NULL;
     this = patterns;
-    network_tell_randomise_hidden_units(net); /* 10/02/04 */
     for (t = 0; t < n+2; t++) {
         if (this != NULL) {
             network_tell_input(net, this->vector_in);
@@ -1026,6 +1865,7 @@ static void network_calculate_weight_changes(Network *net, PatternList *patterns
             history_error[t * net->out_width + i] = (prev == NULL ? 0.0 : net_error_function(prev->vector_out[i], history_out[t * net->out_width + i]));
         }
     }
+    PROFILE_EXIT(PROFILE_BPTT_FORWARD);
 
 #if DEBUG
     fprintf(stdout, "HISTORY_ERROR\n");
@@ -1039,33 +1879,30 @@ static void network_calculate_weight_changes(Network *net, PatternList *patterns
     fprintf(stdout, "\n");
 #endif
 
-    /* 2: Calculate epsilon and delta for each non-input unit (equations 17-19): */
+    /* 2: Calculate epsilon and delta for each non-input unit (equations 17-19). */
+    /* Only hidden units have outgoing weights, so only they receive error from */
+    /* the next time step: the dot product of each hidden unit's outgoing rows  */
+    /* of weights_hh and weights_ho with the next step's hidden/output deltas:  */
 
+    PROFILE_ENTER(PROFILE_BPTT_BACKWARD);
     for (t = n+1; t > 0; t--) {
+        double *delta_next = &delta[(t+1) * units];
+
         for (k = 0; k < units; k++) {
             /* Calculate the external error for each node: */
             epsilon[t * units + k] = (k < net->hidden_width ? 0.0 : history_error[t * net->out_width + (k - net->hidden_width)]);
+        }
+        if (t < (n+1)) {
+            /* Add in the sum of delta terms to epsilon for hidden units: */
+            for (k = 0; k < net->hidden_width; k++) {
+                double e = epsilon[t * units + k];
 
-            /* Add in the sum of delta terms to epsilon if appropriate: */
-            if (t < (n+1)) {
-                for (l = 0; l < units; l++) {
-                    if (k < net->hidden_width) {
-                        if (l < net->hidden_width) {
-                            /* Weight from hidden unit k to hidden unit l: */
-                            weight_lk  = net->weights_hh[k*net->hidden_width+l];
-                        }
-                        else {
-                            /* Weight from hidden unit k to output unit (l-hidden_width): */
-                            weight_lk  = net->weights_ho[k*net->out_width+(l-net->hidden_width)];
-                        }
-                    }
-                    else {
-                        /* Weight from output unit (k-hidden_width) to unit l: */
-                        weight_lk = 0.0;
-                    }
-                    epsilon[t * units + k] += weight_lk * delta[(t+1) * units + l];
-                }
+                e = vector_dot_add(e, net->hidden_width, &net->weights_hh[k * net->hidden_width], delta_next);
+                e = vector_dot_add(e, net->out_width, &net->weights_ho[k * net->out_width], &delta_next[net->hidden_width]);
+                epsilon[t * units + k] = e;
             }
+        }
+        for (k = 0; k < units; k++) {
             /* And calculate the deltas... */
             y = (k < net->hidden_width ? history_hidden[t * net->hidden_width + k] : history_out[t * net->out_width + (k - net->hidden_width)]);
             df = y * (1-y);
@@ -1088,8 +1925,11 @@ static void network_calculate_weight_changes(Network *net, PatternList *patterns
 #endif
     }
 
+    PROFILE_EXIT(PROFILE_BPTT_BACKWARD);
+
     /* 3: Calculate the weight matrix updates (equation 20): */
 
+    PROFILE_ENTER(PROFILE_BPTT_UPDATE);
     this = patterns;
     for (t = 1; t < (n+2); t++) {
 
@@ -1125,35 +1965,40 @@ static void network_calculate_weight_changes(Network *net, PatternList *patterns
             this = this->next;
         }
     }
-
-    /* 4: Release all allocated space: */
-    free(history_hidden);
-    free(history_out);
-    free(history_error);
-    free(delta);
-    free(epsilon);
+    PROFILE_EXIT(PROFILE_BPTT_UPDATE);
+    return(TRUE);
 }
 
-Boolean network_train(Network *net, SequenceList *seqs, double lr, ErrorFunction ef, WeightUpdateTime wut, Boolean penalty)
+static Boolean network_calculate_weight_changes(Network *net, PatternList *patterns, double (*net_error_function)(), Boolean penalty)
 {
-    /* SRN Version: */
-
-    double (*net_error_function)() = NULL;
+    network_tell_randomise_hidden_units(net); /* 10/02/04 */
+    return(network_calculate_sequence_changes(net, patterns, net_error_function, penalty));
+}
 
+static double (*network_error_function(ErrorFunction ef))()
+{
     switch (ef) {
         case SUM_SQUARE_ERROR: {
-            net_error_function = net_error_ssq; break;
+            return(net_error_ssq);
         }
         case RMS_ERROR: { // Same as SSE
-            net_error_function = net_error_ssq; break;
+            return(net_error_ssq);
         }
         case CROSS_ENTROPY: {
-            net_error_function = net_error_cross_entropy; break;
+            return(net_error_cross_entropy);
         }
         case SOFT_MAX_ERROR: {
-            net_error_function = net_error_soft_max; break;
+            return(net_error_soft_max);
         }
     }
+    return(NULL);
+}
+
+Boolean network_train(Network *net, SequenceList *seqs, double lr, ErrorFunction ef, WeightUpdateTime wut, Boolean penalty)
+{
+    /* SRN Version: */
+
+    double (*net_error_function)() = network_error_function(ef);
 
     if ((net->tmp_ih_deltas == NULL) || (net->tmp_hh_deltas == NULL) || (net->tmp_ho_deltas == NULL)) {
         return(FALSE);
@@ -1166,7 +2011,9 @@ Boolean network_train(Network *net, SequenceList *seqs, double lr, ErrorFunction
 
         /* Run the training data, accumulating weight changes over all sequences: */
         while (seqs != NULL) {
-            network_calculate_weight_changes(net, seqs->head, net_error_function, penalty);
+            if (!network_calculate_weight_changes(net, seqs->head, net_error_function, penalty)) {
+                return(FALSE);
+            }
             seqs = seqs->tail;
         }
 
@@ -1185,7 +2032,9 @@ Boolean network_train(Network *net, SequenceList *seqs, double lr, ErrorFunction
             network_train_initialise_deltas(net);
 
             /* Run the training data, over the current pattern: */
-            network_calculate_weight_changes(net, seqs->head, net_error_function, penalty);
+            if (!network_calculate_weight_changes(net, seqs->head, net_error_function, penalty)) {
+                return(FALSE);
+            }
 
             /* Now update the weights: */
             network_train_update_weights(net, lr);
@@ -1198,6 +2047,252 @@ Boolean network_train(Network *net, SequenceList *seqs, double lr, ErrorFunction
     return(TRUE);
 }
 
+/******************************************************************************/
+/* Parallel epoch-wise training ***********************************************/
+
+/* With UPDATE_BY_EPOCH each sequence's BPTT is independent given the        */
+/* weights, so the sequences can be shared out between threads. Sequences    */
+/* are grouped into fixed blocks of TRAINER_BLOCK, each of which accumulates */
+/* its weight changes (in sequence order) into its own buffer, from initial  */
+/* hidden states drawn in sequence order before the threads start. The      */
+/* block buffers are then summed pairwise in a fixed tree, so the result is  */
+/* the same whatever the number of threads.                                  */
+
+#define TRAINER_BLOCK 8
+
+typedef struct trainer_thread {
+    NetworkTrainer *trainer;
+    Network        *shadow;  /* Units and workspace, sharing the weights */
+    pthread_t       id;
+    int             index;
+    Boolean         started;
+    Boolean         ok;
+} TrainerThread;
+
+struct network_trainer {
+    Network        *net;
+    int             threads;
+    int             num_seqs;
+    int             num_blocks;
+    int             block_size;  /* Number of weights (ih + hh + ho) */
+    PatternList   **seqs;
+    double         *hidden;      /* Initial hidden state of each sequence */
+    double         *deltas;      /* Weight changes of each block */
+    TrainerThread  *thread;
+    double        (*net_error_function)();
+    Boolean         penalty;
+};
+
+static void network_shadow_destroy(Network *shadow)
+{
+    /* Only free what the shadow owns (not the weights or deltas): */
+
+    if (shadow != NULL) {
+        if (shadow->units_in != NULL) { free(shadow->units_in); }
+        if (shadow->units_hidden != NULL) { free(shadow->units_hidden); }
+        if (shadow->units_out != NULL) { free(shadow->units_out); }
+        if (shadow->tmp_hidden != NULL) { free(shadow->tmp_hidden); }
+        if (shadow->tmp_out != NULL) { free(shadow->tmp_out); }
+        network_free_bptt_workspace(shadow);
+        free(shadow);
+    }
+}
+
+static Network *network_shadow_create(Network *net, int length)
+{
+    /* A network with its own units and BPTT workspace, but which uses the */
+    /* weights of net:                                                     */
+
+    Network *shadow;
+
+    if ((shadow = (Network *)calloc(1, sizeof(Network))) != NULL) {
+        shadow->in_width = net->in_width;
+        shadow->hidden_width = net->hidden_width;
+        shadow->out_width = net->out_width;
+        shadow->units_in = (double *)calloc(net->in_width+1, sizeof(double));
+        shadow->units_hidden = (double *)calloc(net->hidden_width+1, sizeof(double));
+        shadow->units_out = (double *)calloc(net->out_width, sizeof(double));
+        shadow->tmp_hidden = (double *)malloc(net->hidden_width * sizeof(double));
+        shadow->tmp_out = (double *)malloc(net->out_width * sizeof(double));
+
+        if ((shadow->units_in == NULL) || (shadow->units_hidden == NULL) || (shadow->units_out == NULL) || (shadow->tmp_hidden == NULL) || (shadow->tmp_out == NULL) || !network_reserve_bptt_workspace(shadow, length)) {
+            network_shadow_destroy(shadow);
+            return(NULL);
+        }
+        shadow->units_in[net->in_width] = 1.0; // The bias unit ... never change this!
+        shadow->units_hidden[net->hidden_width] = 1.0; // The bias unit ... never change this!
+    }
+    return(shadow);
+}
+
+void network_trainer_destroy(NetworkTrainer *tr)
+{
+    int i;
+
+    if (tr != NULL) {
+        if (tr->thread != NULL) {
+            for (i = 0; i < tr->threads; i++) {
+                network_shadow_destroy(tr->thread[i].shadow);
+            }
+            free(tr->thread);
+        }
+        if (tr->seqs != NULL) { free(tr->seqs); }
+        if (tr->hidden != NULL) { free(tr->hidden); }
+        if (tr->deltas != NULL) { free(tr->deltas); }
+        free(tr);
+    }
+}
+
+NetworkTrainer *network_trainer_create(Network *net, SequenceList *seqs, int threads)
+{
+    /* The trainer holds on to the sequences of seqs, so it should be */
+    /* recreated if the training set changes:                         */
+
+    NetworkTrainer *tr;
+    int iw = net->in_width, hw = net->hidden_width, ow = net->out_width;
+    int length = sequence_list_max_length(seqs);
+    int i;
+
+    if ((tr = (NetworkTrainer *)calloc(1, sizeof(NetworkTrainer))) == NULL) {
+        return(NULL);
+    }
+    tr->net = net;
+    tr->threads = (threads < 1) ? 1 : threads;
+    tr->num_seqs = sequence_list_length(seqs);
+    tr->num_blocks = (tr->num_seqs + TRAINER_BLOCK - 1) / TRAINER_BLOCK;
+    tr->block_size = (iw+1) * hw + hw * hw + (hw+1) * ow;
+    tr->seqs = (PatternList **)malloc((tr->num_seqs+1) * sizeof(PatternList *));
+    tr->hidden = (double *)malloc((tr->num_seqs+1) * hw * sizeof(double));
+    tr->deltas = (double *)malloc((tr->num_blocks+1) * tr->block_size * sizeof(double));
+    tr->thread = (TrainerThread *)calloc(tr->threads, sizeof(TrainerThread));
+
+    if ((tr->seqs == NULL) || (tr->hidden == NULL) || (tr->deltas == NULL) || (tr->thread == NULL)) {
+        network_trainer_destroy(tr);
+        return(NULL);
+    }
+    for (i = 0; i < tr->num_seqs; i++) {
+        tr->seqs[i] = seqs->head;
+        seqs = seqs->tail;
+    }
+    for (i = 0; i < tr->threads; i++) {
+        tr->thread[i].trainer = tr;
+        tr->thread[i].index = i;
+        if ((tr->thread[i].shadow = network_shadow_create(net, length)) == NULL) {
+            network_trainer_destroy(tr);
+            return(NULL);
+        }
+    }
+    return(tr);
+}
+
+static void *network_trainer_thread(void *arg)
+{
+    TrainerThread *th = (TrainerThread *)arg;
+    NetworkTrainer *tr = th->trainer;
+    Network *shadow = th->shadow;
+    int hw = shadow->hidden_width;
+    int b, s, s1;
+
+    th->ok = TRUE;
+    for (b = th->index; th->ok && (b < tr->num_blocks); b += tr->threads) {
+        double *block = &tr->deltas[b * tr->block_size];
+
+        memset(block, 0, tr->block_size * sizeof(double));
+        shadow->tmp_ih_deltas = block;
+        shadow->tmp_hh_deltas = shadow->tmp_ih_deltas + (shadow->in_width+1) * hw;
+        shadow->tmp_ho_deltas = shadow->tmp_hh_deltas + hw * hw;
+
+        s1 = (b+1) * TRAINER_BLOCK;
+        if (s1 > tr->num_seqs) {
+            s1 = tr->num_seqs;
+        }
+        for (s = b * TRAINER_BLOCK; th->ok && (s < s1); s++) {
+            memcpy(shadow->units_hidden, &tr->hidden[s * hw], hw * sizeof(double));
+            th->ok = network_calculate_sequence_changes(shadow, tr->seqs[s], tr->net_error_function, tr->penalty);
+        }
+    }
+    return(NULL);
+}
+
+Boolean network_trainer_epoch(NetworkTrainer *tr, double lr, ErrorFunction ef, Boolean penalty)
+{
+    /* One epoch of UPDATE_BY_EPOCH training, spread over the threads: */
+
+    Network *net = tr->net;
+    int hw = net->hidden_width;
+    Boolean ok = TRUE;
+    int i, b, stride;
+
+    if ((net->tmp_ih_deltas == NULL) || (net->tmp_hh_deltas == NULL) || (net->tmp_ho_deltas == NULL)) {
+        return(FALSE);
+    }
+    else if ((tr->thread[0].shadow->in_width != net->in_width) || (tr->thread[0].shadow->hidden_width != hw) || (tr->thread[0].shadow->out_width != net->out_width)) {
+        fprintf(stderr, "ERROR: Network size has changed since the trainer was created\n");
+        return(FALSE);
+    }
+
+    tr->net_error_function = network_error_function(ef);
+    tr->penalty = penalty;
+
+    /* Draw the initial hidden states in the same order as network_train: */
+    for (i = 0; i < tr->num_seqs * hw; i++) {
+        tr->hidden[i] = random_uniform(0.01, 0.99);
+    }
+
+    /* The weights may have been reallocated (e.g. by restoring them): */
+    for (i = 0; i < tr->threads; i++) {
+        tr->thread[i].shadow->weights_ih = net->weights_ih;
+        tr->thread[i].shadow->weights_hh = net->weights_hh;
+        tr->thread[i].shadow->weights_ho = net->weights_ho;
+    }
+
+    /* Run the blocks, the calling thread acting as worker 0: */
+    for (i = 1; i < tr->threads; i++) {
+        tr->thread[i].started = (pthread_create(&tr->thread[i].id, NULL, network_trainer_thread, &tr->thread[i]) == 0);
+    }
+    network_trainer_thread(&tr->thread[0]);
+    for (i = 1; i < tr->threads; i++) {
+        if (tr->thread[i].started) {
+            pthread_join(tr->thread[i].id, NULL);
+        }
+        else {
+            /* Couldn't start the thread, so do its share here: */
+            network_trainer_thread(&tr->thread[i]);
+        }
+    }
+    for (i = 0; i < tr->threads; i++) {
+        ok = ok && tr->thread[i].ok;
+    }
+    if (!ok) {
+        return(FALSE);
+    }
+
+    /* Pairwise reduction of the block weight changes into block 0: */
+    for (stride = 1; stride < tr->num_blocks; stride *= 2) {
+        for (b = 0; b + stride < tr->num_blocks; b += 2 * stride) {
+            double *dst = &tr->deltas[b * tr->block_size];
+            double *src = &tr->deltas[(b + stride) * tr->block_size];
+
+            for (i = 0; i < tr->block_size; i++) {
+                dst[i] += src[i];
+            }
+        }
+    }
+
+    /* Now update the weights: */
+    network_train_initialise_deltas(net);
+    if (tr->num_blocks > 0) {
+        int ih = (net->in_width+1) * hw;
+
+        memcpy(net->tmp_ih_deltas, tr->deltas, ih * sizeof(double));
+        memcpy(net->tmp_hh_deltas, tr->deltas + ih, hw * hw * sizeof(double));
+        memcpy(net->tmp_ho_deltas, tr->deltas + ih + hw * hw, (hw+1) * net->out_width * sizeof(double));
+    }
+    network_train_update_weights(net, lr);
+
+    return(TRUE);
+}
+
 /******************************************************************************/
 
 static double network_srn_test_pattern(Network *net, PatternList *patterns, ErrorFunction ef)
@@ -1236,7 +2331,7 @@ double network_test(Network *net, SequenceList *seqs, ErrorFunction ef)
 
 /******************************************************************************/
 
-Boolean network_dump_weights(FILE *fp, Network *net)
+static Boolean network_dump_matrices(FILE *fp, Network *net)
 {
     /* SRN Version: */
 
@@ -1258,6 +2353,66 @@ Boolean network_dump_weights(FILE *fp, Network *net)
     return(TRUE);
 }
 
+Boolean network_dump_weights(FILE *fp, Network *net)
+{
+    Boolean ok;
+
+    PROFILE_ENTER(PROFILE_WEIGHT_IO);
+    ok = network_dump_matrices(fp, net);
+    PROFILE_EXIT(PROFILE_WEIGHT_IO);
+    return(ok);
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void network_install_weights(Network *net, int i, int h, int o, double *ih, double *hh, double *ho)
+{
+    /* Take ownership of the given weights, resizing the network to match: */
+
+    /* Set up the input units, hidden and output units: */
+
+    if (net->in_width != i) {
+        net->in_width = i;
+        free(net->units_in);
+        net->units_in = (double *)malloc((net->in_width+1) * sizeof(double));
+    }
+    if (net->hidden_width != h) {
+        net->hidden_width = h;
+        free(net->units_hidden);
+        net->units_hidden = (double *)malloc((net->hidden_width+1) * sizeof(double));
+    }
+    if (net->out_width != o) {
+        net->out_width = o;
+        free(net->units_out);
+        net->units_out = (double *)malloc(net->out_width * sizeof(double));
+    }
+
+    /* Replace the old weights with the new: */
+
+    free(net->weights_ih);
+    net->weights_ih = ih;
+
+    free(net->weights_hh);
+    net->weights_hh = hh;
+
+    free(net->weights_ho);
+    net->weights_ho = ho;
+
+    /* Reallocate the temporary space (in case the network's size has changed): */
+
+    free(net->tmp_hidden);
+    net->tmp_hidden = (double *)malloc(net->hidden_width * sizeof(double));
+    free(net->tmp_out);
+    net->tmp_out = (double *)malloc(net->out_width * sizeof(double));
+    free(net->tmp_ih_deltas);
+    net->tmp_ih_deltas = (double *)malloc((net->in_width+1) * net->hidden_width * sizeof(double));
+    free(net->tmp_hh_deltas);
+    net->tmp_hh_deltas = (double *)malloc(net->hidden_width * net->hidden_width * sizeof(double));
+    free(net->tmp_ho_deltas);
+    net->tmp_ho_deltas = (double *)malloc((net->hidden_width+1) * net->out_width * sizeof(double));
+    network_free_bptt_workspace(net);
+}
+
 /*----------------------------------------------------------------------------*/
 
 int network_restore_weights(FILE *fp, Network *net)
@@ -1315,49 +2470,203 @@ int network_restore_weights(FILE *fp, Network *net)
         return(ERROR_RW_READ1);
     }
 
-    /* Set up the input units, hidden and output units: */
+    network_install_weights(net, i, h, o, ih, hh, ho);
+    return(0);
+}
 
-    if (net->in_width != i) {
-        net->in_width = i;
-        free(net->units_in);
-        net->units_in = (double *)malloc((net->in_width+1) * sizeof(double));
+/*----------------------------------------------------------------------------*/
+/* Binary weight file format (native byte order, all fields 8-byte aligned): */
+/*   char     magic[8]                 "SRNWGT\0\0"                           */
+/*   int32    version                  WGT_BIN_VERSION                       */
+/*   int32    byte_order               0x01020304 as written                 */
+/*   int32    in_width, hidden_width, out_width                             */
+/*   int32    reserved                                                       */
+/*   uint64   checksum                 FNV-1a over header and weights        */
+/*   double   weights_ih[in_width+1][hidden_width]                           */
+/*   double   weights_hh[hidden_width][hidden_width]                         */
+/*   double   weights_ho[hidden_width+1][out_width]                          */
+
+#define WGT_BIN_MAGIC "SRNWGT\0\0"
+#define WGT_BIN_VERSION 1
+#define WGT_BIN_BYTE_ORDER 0x01020304
+
+typedef struct wgt_bin_header {
+    char     magic[8];
+    int32_t  version;
+    int32_t  byte_order;
+    int32_t  in_width, hidden_width, out_width;
+    int32_t  reserved;
+    uint64_t checksum;
+} WgtBinHeader;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t bytes)
+{
+    const unsigned char *byte = (const unsigned char *)data;
+    size_t k;
+
+    for (k = 0; k < bytes; k++) {
+        hash = (hash ^ byte[k]) * 0x100000001b3ULL;
     }
-    if (net->hidden_width != h) {
-        net->hidden_width = h;
-        free(net->units_hidden);
-        net->units_hidden = (double *)malloc((net->hidden_width+1) * sizeof(double));
+    return(hash);
+}
+
+static uint64_t network_weight_checksum(WgtBinHeader *header, double *ih, double *hh, double *ho)
+{
+    /* FNV-1a over the header (with the checksum field zero) and weights: */
+
+    WgtBinHeader h0 = *header;
+    int i = header->in_width, h = header->hidden_width, o = header->out_width;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    h0.checksum = 0;
+    hash = fnv1a(hash, &h0, sizeof(WgtBinHeader));
+    hash = fnv1a(hash, ih, (i+1) * h * sizeof(double));
+    hash = fnv1a(hash, hh, h * h * sizeof(double));
+    hash = fnv1a(hash, ho, (h+1) * o * sizeof(double));
+    return(hash);
+}
+
+Boolean network_save_weights_binary(char *filename, Network *net)
+{
+    int i = net->in_width, h = net->hidden_width, o = net->out_width;
+    char tmpname[1024];
+    WgtBinHeader header;
+    Boolean ok;
+    FILE *fp;
+
+    memset(&header, 0, sizeof(WgtBinHeader));
+    memcpy(header.magic, WGT_BIN_MAGIC, 8);
+    header.version = WGT_BIN_VERSION;
+    header.byte_order = WGT_BIN_BYTE_ORDER;
+    header.in_width = i;
+    header.hidden_width = h;
+    header.out_width = o;
+    header.checksum = network_weight_checksum(&header, net->weights_ih, net->weights_hh, net->weights_ho);
+
+    /* Write to a temporary file (named per process, since several may load */
+    /* the same weights at once) and rename it when complete:               */
+    snprintf(tmpname, 1024, "%s.%d.tmp", filename, (int) getpid());
+    if ((fp = fopen(tmpname, "wb")) == NULL) {
+        return(FALSE);
     }
-    if (net->out_width != o) {
-        net->out_width = o;
-        free(net->units_out);
-        net->units_out = (double *)malloc(net->out_width * sizeof(double));
+    ok = (fwrite(&header, sizeof(WgtBinHeader), 1, fp) == 1);
+    ok = ok && (fwrite(net->weights_ih, sizeof(double), (i+1) * h, fp) == (i+1) * h);
+    ok = ok && (fwrite(net->weights_hh, sizeof(double), h * h, fp) == h * h);
+    ok = ok && (fwrite(net->weights_ho, sizeof(double), (h+1) * o, fp) == (h+1) * o);
+    ok = (fclose(fp) == 0) && ok;
+
+    if (!ok || (rename(tmpname, filename) != 0)) {
+        remove(tmpname);
+        return(FALSE);
     }
+    return(TRUE);
+}
 
-    /* Replace the old weights with the new: */
+static int network_restore_weights_binary(FILE *fp, Network *net)
+{
+    WgtBinHeader header;
+    double *ih, *hh, *ho;
+    int i, h, o;
 
-    free(net->weights_ih);
-    net->weights_ih = ih;
+    if ((fread(&header, sizeof(WgtBinHeader), 1, fp) != 1) || (memcmp(header.magic, WGT_BIN_MAGIC, 8) != 0)) {
+        return(ERROR_RW_HEADER1);
+    }
+    else if ((header.version != WGT_BIN_VERSION) || (header.byte_order != WGT_BIN_BYTE_ORDER)) {
+        return(ERROR_RW_VERSION);
+    }
+    else if ((header.in_width < 1) || (header.hidden_width < 1) || (header.out_width < 1)) {
+        return(ERROR_RW_HEADER1);
+    }
 
-    free(net->weights_hh);
-    net->weights_hh = hh;
+    i = header.in_width;
+    h = header.hidden_width;
+    o = header.out_width;
 
-    free(net->weights_ho);
-    net->weights_ho = ho;
+    ih = (double *)malloc((i+1) * h * sizeof(double));
+    hh = (double *)malloc(h * h * sizeof(double));
+    ho = (double *)malloc((h+1) * o * sizeof(double));
+    if ((ih == NULL) || (hh == NULL) || (ho == NULL)) {
+        free(ih);
+        free(hh);
+        free(ho);
+        return(ERROR_RW_ALLOC1);
+    }
+    else if ((fread(ih, sizeof(double), (i+1) * h, fp) != (i+1) * h) ||
+             (fread(hh, sizeof(double), h * h, fp) != h * h) ||
+             (fread(ho, sizeof(double), (h+1) * o, fp) != (h+1) * o) ||
+             (fgetc(fp) != EOF)) {
+        free(ih);
+        free(hh);
+        free(ho);
+        return(ERROR_RW_READ1);
+    }
+    else if (network_weight_checksum(&header, ih, hh, ho) != header.checksum) {
+        free(ih);
+        free(hh);
+        free(ho);
+        return(ERROR_RW_CHECKSUM);
+    }
 
-    /* Reallocate the temporary space (in case the network's size has changed): */
+    network_install_weights(net, i, h, o, ih, hh, ho);
+    return(0);
+}
 
-    free(net->tmp_hidden);
-    net->tmp_hidden = (double *)malloc(net->hidden_width * sizeof(double));
-    free(net->tmp_out);
-    net->tmp_out = (double *)malloc(net->out_width * sizeof(double));
-    free(net->tmp_ih_deltas);
-    net->tmp_ih_deltas = (double *)malloc((net->in_width+1) * net->hidden_width * sizeof(double));
-    free(net->tmp_hh_deltas);
-    net->tmp_hh_deltas = (double *)malloc(net->hidden_width * net->hidden_width * sizeof(double));
-    free(net->tmp_ho_deltas);
-    net->tmp_ho_deltas = (double *)malloc((net->hidden_width+1) * net->out_width * sizeof(double));
+static Boolean file_is_binary_weights(FILE *fp)
+{
+    char magic[8];
+    Boolean binary;
 
-   return(0);
+    binary = (fread(magic, 1, 8, fp) == 8) && (memcmp(magic, WGT_BIN_MAGIC, 8) == 0);
+    rewind(fp);
+    return(binary);
+}
+
+static int network_read_weight_file(char *file, Network *net)
+{
+    /* Use the binary sidecar (file.bin) if it is up to date, otherwise read */
+    /* the text and try to write the sidecar for next time. A binary file    */
+    /* may also be given directly. Returns -1 if file cannot be read, else   */
+    /* as network_restore_weights:                                           */
+
+    char binfile[1024];
+    FILE *fp;
+    int j;
+
+    snprintf(binfile, 1024, "%s.bin", file);
+    if (file_is_newer(binfile, file) && ((fp = fopen(binfile, "rb")) != NULL)) {
+        j = network_restore_weights_binary(fp, net);
+        fclose(fp);
+        if (j == 0) {
+            return(0);
+        }
+        fprintf(stderr, "WARNING: %s is corrupt or out of date (error %d) ... reading %s\n", binfile, j, file);
+    }
+
+    if ((fp = fopen(file, "rb")) == NULL) {
+        return(-1);
+    }
+    else if (file_is_binary_weights(fp)) {
+        j = network_restore_weights_binary(fp, net);
+        fclose(fp);
+    }
+    else if ((j = network_restore_weights(fp, net)) == 0) {
+        fclose(fp);
+        network_save_weights_binary(binfile, net);
+    }
+    else {
+        fclose(fp);
+    }
+    return(j);
+}
+
+int network_restore_weights_from_file(char *file, Network *net)
+{
+    int j;
+
+    PROFILE_ENTER(PROFILE_WEIGHT_IO);
+    j = network_read_weight_file(file, net);
+    PROFILE_EXIT(PROFILE_WEIGHT_IO);
+    return(j);
 }
 
 /******************************************************************************/
@@ -1374,7 +2683,24 @@ int training_set_length(SequenceList *patterns)
 
 SequenceList *training_set_read(char *file, int w_in, int w_out)
 {
-    return(read_training_sequences(file, w_in, w_out));
+    /* Use the binary sidecar (file.bin) if it is up to date, otherwise read */
+    /* the text and try to write the sidecar for next time. A binary file    */
+    /* may also be given directly:                                           */
+
+    SequenceList *seqs;
+    char binfile[1024];
+
+    if ((seqs = read_training_sequences_binary(file, w_in, w_out)) != NULL) {
+        return(seqs);
+    }
+    snprintf(binfile, 1024, "%s.bin", file);
+    if (file_is_newer(binfile, file) && ((seqs = read_training_sequences_binary(binfile, w_in, w_out)) != NULL)) {
+        return(seqs);
+    }
+    if ((seqs = read_training_sequences(file, w_in, w_out)) != NULL) {
+        training_set_write_binary(seqs, w_in, w_out, binfile);
+    }
+    return(seqs);
 }
 
 SequenceList *training_set_next(SequenceList *current)
@@ -10,9 +10,23 @@ typedef struct pattern_list {
     struct pattern_list *next;
 } PatternList;
 
+/* A training set loaded from the binary format, mapped into memory. The    */
+/* inputs and targets of all patterns are contiguous, in sequence order:    */
+
+typedef struct sequence_set {
+    void *map;
+    size_t map_size;
+    int in_width, out_width;
+    int num_seqs, num_patterns;
+    int *offset;           /* Sequence s is patterns offset[s] .. offset[s+1]-1 */
+    double *vector_in;     /* num_patterns rows of in_width inputs */
+    double *vector_out;    /* num_patterns rows of out_width targets */
+} SequenceSet;
+
 typedef struct sequence_list {
     PatternList *head;
     struct sequence_list *tail;
+    SequenceSet *set;      /* The mapped set this belongs to, or NULL */
 } SequenceList;
 
 extern int pattern_list_length(PatternList *patterns);
@@ -20,11 +34,14 @@ extern void pattern_list_free(PatternList *patterns);
 
 extern PatternList *read_training_patterns(char *filename, int in_width, int out_width);
 extern SequenceList *read_training_sequences(char *filename, int in_width, int out_width);
+extern SequenceList *read_training_sequences_binary(char *filename, int in_width, int out_width);
+extern Boolean training_set_write_binary(SequenceList *seqs, int in_width, int out_width, char *filename);
 
 extern void print_vector(FILE *fp, int n, double *vector_in);
 extern void print_string(FILE *fp, int width, char *string);
 
 extern int sequence_list_length(SequenceList *seqs);
+extern int sequence_list_max_length(SequenceList *seqs);
 extern void sequence_list_free(SequenceList *seqs);
 extern void sequence_list_print_stats(SequenceList *seqs, FILE *fp);
 
@@ -37,6 +54,34 @@ typedef enum {SUM_SQUARE_ERROR, RMS_ERROR, CROSS_ENTROPY, SOFT_MAX_ERROR} ErrorF
 #define TrainingDataList SequenceList
 #define WEIGHT_PREFIX "WEIGHTS_SRN"
 
+/* Damage to a network, applied to its weights as the propagate routines use */
+/* them rather than by changing the weights, so that damaged networks need   */
+/* not be copies and many overlays may share one set of weights. The weight  */
+/* used is (w + noise) * scale, or zero if the connection is severed or from */
+/* an ablated context unit:                                                  */
+
+/* For nested lesions the connections are ranked once, with a key in (0, 1) */
+/* each, and severity s severs those with key below s. The lesions at        */
+/* increasing severities are then nested, each a superset of the last:       */
+
+typedef struct lesion_ranking {
+    int n;                                 /* Connections ranked */
+    int *order;                            /* In the order they are severed */
+    double *key;                           /* Severity at which each goes */
+    int severed;                           /* order[0 ... severed-1] are severed */
+} LesionRanking;
+
+typedef struct damage_overlay {
+    int in_width, hidden_width, out_width;
+    unsigned int *severed_ih, *severed_hh; /* One bit per connection */
+    double *noise_ih, *noise_hh;           /* Added to each weight */
+    Boolean *ablated;                      /* Context units removed */
+    double scale;                          /* Multiplies all weights */
+    Boolean any_severed, any_noise, any_ablated;
+    Boolean ranked;                        /* Rankings below have been drawn */
+    LesionRanking rank_ih, rank_hh;
+} DamageOverlay;
+
 typedef struct network {
     int in_width, hidden_width, out_width;
     double *weights_ih, *weights_ho, *weights_hh;
@@ -46,10 +91,28 @@ typedef struct network {
     double *tmp_ih_deltas;
     double *tmp_hh_deltas;
     double *tmp_ho_deltas;
+    /* BPTT workspace, reused across training sequences: */
+    int bptt_length;
+    double *bptt_hidden, *bptt_error, *bptt_out;
+    double *bptt_delta, *bptt_epsilon;
+    DamageOverlay *damage;   /* Applied when propagating, or NULL */
 } Network;
 
+/* A batch of independent network states (units only) sharing the weights   */
+/* of one or more networks, for propagating many episodes in lock-step:      */
+
+typedef struct network_batch {
+    int size;
+    int in_width, hidden_width, out_width;
+    double *units_in, *units_hidden, *units_out;
+    double *tmp_hidden;
+    double *tmp_out;
+    Boolean *active;
+} NetworkBatch;
+
 extern Network *network_create(int iw, int hw, int ow);
 extern Network *network_copy(Network *net);
+extern Boolean network_copy_weights(Network *dst, Network *src);
 extern void network_tell_initialise(Network *net);
 extern void network_tell_destroy(Network *net);
 extern void network_tell_input(Network *net, double *vector);
@@ -63,12 +126,22 @@ extern void network_perturb_weights_ih(Network *net, double variance);
 extern void network_perturb_weights_ch(Network *net, double variance);
 extern void network_inject_noise(Network *net, double sv_noise);
 extern void network_print_state(FILE *fp, Network *net, char *message);
+extern void network_tell_damage(Network *net, DamageOverlay *damage);
 extern void network_lesion_weights_ih(Network *net, double severity);
 extern void network_lesion_weights_ch(Network *net, double severity);
 extern void network_ablate_context(Network *net, double proportion);
 extern void network_scale_weights(Network *net, double proportion);
 extern double network_test(Network *net, TrainingDataList *test_patterns, ErrorFunction ef);
 extern Boolean network_train(Network *net, TrainingDataList *test_patterns, double lr, ErrorFunction ef, WeightUpdateTime wut, Boolean penalty);
+extern Boolean network_reserve_bptt_workspace(Network *net, int length);
+
+/* Parallel UPDATE_BY_EPOCH training, with results independent of threads: */
+
+typedef struct network_trainer NetworkTrainer;
+
+extern NetworkTrainer *network_trainer_create(Network *net, TrainingDataList *seqs, int threads);
+extern Boolean network_trainer_epoch(NetworkTrainer *tr, double lr, ErrorFunction ef, Boolean penalty);
+extern void network_trainer_destroy(NetworkTrainer *tr);
 
 extern void training_set_free(TrainingDataList *patterns);
 extern int training_set_length(TrainingDataList *patterns);
@@ -78,6 +151,29 @@ extern double *training_set_input_vector(TrainingDataList *patterns);
 
 extern Boolean network_dump_weights(FILE *fp, Network *net);
 extern int network_restore_weights(FILE *fp, Network *net);
+extern int network_restore_weights_from_file(char *file, Network *net);
+extern Boolean network_save_weights_binary(char *filename, Network *net);
+
+extern NetworkBatch *network_batch_create(int size, int iw, int hw, int ow);
+extern void network_batch_destroy(NetworkBatch *batch);
+extern void network_batch_tell_input(NetworkBatch *batch, int b, double *vector);
+extern void network_batch_ask_output(NetworkBatch *batch, int b, double *vector);
+extern void network_batch_randomise_hidden_units(NetworkBatch *batch, int b);
+extern void network_batch_inject_noise(NetworkBatch *batch, int b, double variance);
+extern void network_batch_propagate2(NetworkBatch *batch, Network **nets, DamageOverlay **damage);
+
+extern DamageOverlay *damage_overlay_create(Network *net);
+extern void damage_overlay_destroy(DamageOverlay *damage);
+extern void damage_overlay_clear(DamageOverlay *damage);
+extern void damage_overlay_perturb_weights_ih(DamageOverlay *damage, double variance);
+extern void damage_overlay_perturb_weights_ch(DamageOverlay *damage, double variance);
+extern void damage_overlay_lesion_weights_ih(DamageOverlay *damage, double severity);
+extern void damage_overlay_lesion_weights_ch(DamageOverlay *damage, double severity);
+extern void damage_overlay_rank_weights(DamageOverlay *damage);
+extern void damage_overlay_lesion_nested_ih(DamageOverlay *damage, double severity);
+extern void damage_overlay_lesion_nested_ch(DamageOverlay *damage, double severity);
+extern void damage_overlay_ablate_context(DamageOverlay *damage, double severity);
+extern void damage_overlay_scale_weights(DamageOverlay *damage, double proportion);
 
 extern double vector_net_conflict(double *vector, int width);
 
@@ -0,0 +1,208 @@
+/******************************************************************************/
+
+// Phase-level profiling. Each thread accumulates into its own counters
+// (so recording takes no lock and shares no cache lines), which are linked
+// into a global list the first time the thread records anything. Reports
+// sum over the list. A thread's counters outlive it, so that a report
+// written at exit includes threads that have been joined.
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "lib_profile.h"
+
+char *profile_phase_name[PROFILE_MAX] = {
+    "Propagate",
+    "BPTT forward",
+    "BPTT backward",
+    "BPTT update",
+    "World step",
+    "Classify",
+    "Lesion",
+    "Weight I/O"
+};
+
+typedef struct profile_counters {
+    int depth[PROFILE_MAX];        /* A phase may be entered within itself */
+    uint64_t start[PROFILE_MAX];
+    ProfileSummary phase[PROFILE_MAX];
+    struct profile_counters *next;
+} ProfileCounters;
+
+static __thread ProfileCounters *profile_local = NULL;
+static ProfileCounters *profile_threads = NULL;
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *profile_report_file = NULL;
+
+/******************************************************************************/
+
+static uint64_t profile_clock()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec);
+}
+
+static ProfileCounters *profile_counters_get()
+{
+    if (profile_local == NULL) {
+        if ((profile_local = (ProfileCounters *)calloc(1, sizeof(ProfileCounters))) != NULL) {
+            pthread_mutex_lock(&profile_lock);
+            profile_local->next = profile_threads;
+            profile_threads = profile_local;
+            pthread_mutex_unlock(&profile_lock);
+        }
+    }
+    return(profile_local);
+}
+
+/* Counters are written only by their own thread, but may be read (or     */
+/* reset) from another while it runs, so all accesses are atomic. Relaxed  */
+/* ordering is enough: a live view need only be approximately current.    */
+
+static void counter_add(uint64_t *counter, uint64_t x)
+{
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + x, __ATOMIC_RELAXED);
+}
+
+static int duration_bucket(uint64_t ns)
+{
+    int b = 0;
+
+    while ((ns >>= 1) != 0) {
+        b++;
+    }
+    return((b < PROFILE_BUCKETS) ? b : PROFILE_BUCKETS - 1);
+}
+
+void profile_enter(ProfilePhase phase)
+{
+    ProfileCounters *pc;
+
+    if (((pc = profile_counters_get()) != NULL) && (pc->depth[phase]++ == 0)) {
+        pc->start[phase] = profile_clock();
+    }
+}
+
+void profile_exit(ProfilePhase phase)
+{
+    ProfileCounters *pc;
+    ProfileSummary *s;
+    uint64_t ns;
+
+    /* Only the outermost call of a nested phase is counted: */
+
+    if (((pc = profile_counters_get()) != NULL) && (--pc->depth[phase] == 0)) {
+        ns = profile_clock() - pc->start[phase];
+        s = &pc->phase[phase];
+        counter_add(&s->calls, 1);
+        counter_add(&s->total_ns, ns);
+        counter_add(&s->histogram[duration_bucket(ns)], 1);
+        if (ns > __atomic_load_n(&s->max_ns, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&s->max_ns, ns, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/******************************************************************************/
+
+int profile_summarise(ProfileSummary *summary)
+{
+    /* Sum the counters of all threads into summary[PROFILE_MAX]. Returns */
+    /* the number of threads that have recorded anything:                 */
+
+    ProfileCounters *pc;
+    uint64_t x;
+    int p, b, threads = 0;
+
+    memset(summary, 0, PROFILE_MAX * sizeof(ProfileSummary));
+    pthread_mutex_lock(&profile_lock);
+    for (pc = profile_threads; pc != NULL; pc = pc->next) {
+        for (p = 0; p < PROFILE_MAX; p++) {
+            summary[p].calls += __atomic_load_n(&pc->phase[p].calls, __ATOMIC_RELAXED);
+            summary[p].total_ns += __atomic_load_n(&pc->phase[p].total_ns, __ATOMIC_RELAXED);
+            if ((x = __atomic_load_n(&pc->phase[p].max_ns, __ATOMIC_RELAXED)) > summary[p].max_ns) {
+                summary[p].max_ns = x;
+            }
+            for (b = 0; b < PROFILE_BUCKETS; b++) {
+                summary[p].histogram[b] += __atomic_load_n(&pc->phase[p].histogram[b], __ATOMIC_RELAXED);
+            }
+        }
+        threads++;
+    }
+    pthread_mutex_unlock(&profile_lock);
+    return(threads);
+}
+
+void profile_reset()
+{
+    /* Calls in progress on other threads may be partly counted: */
+
+    ProfileCounters *pc;
+    int p, b;
+
+    pthread_mutex_lock(&profile_lock);
+    for (pc = profile_threads; pc != NULL; pc = pc->next) {
+        for (p = 0; p < PROFILE_MAX; p++) {
+            __atomic_store_n(&pc->phase[p].calls, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&pc->phase[p].total_ns, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&pc->phase[p].max_ns, 0, __ATOMIC_RELAXED);
+            for (b = 0; b < PROFILE_BUCKETS; b++) {
+                __atomic_store_n(&pc->phase[p].histogram[b], 0, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    pthread_mutex_unlock(&profile_lock);
+}
+
+/******************************************************************************/
+
+void profile_write_report(FILE *fp)
+{
+    /* Tab-delimited: one row per phase, with its histogram in the last */
+    /* PROFILE_BUCKETS columns:                                          */
+
+    ProfileSummary summary[PROFILE_MAX];
+    int p, b, threads;
+
+    threads = profile_summarise(summary);
+    fprintf(fp, "# Profile over %d thread%s; times in seconds; bucket b counts calls of [2^b, 2^(b+1)) ns\n", threads, (threads == 1) ? "" : "s");
+    fprintf(fp, "Phase\tCalls\tTotal\tMean\tMax");
+    for (b = 0; b < PROFILE_BUCKETS; b++) {
+        fprintf(fp, "\tB%d", b);
+    }
+    fprintf(fp, "\n");
+    for (p = 0; p < PROFILE_MAX; p++) {
+        fprintf(fp, "%s\t%llu\t%.6f\t%.9f\t%.9f", profile_phase_name[p], (unsigned long long) summary[p].calls, summary[p].total_ns * 1e-9, (summary[p].calls > 0) ? summary[p].total_ns * 1e-9 / (double) summary[p].calls : 0.0, summary[p].max_ns * 1e-9);
+        for (b = 0; b < PROFILE_BUCKETS; b++) {
+            fprintf(fp, "\t%llu", (unsigned long long) summary[p].histogram[b]);
+        }
+        fprintf(fp, "\n");
+    }
+}
+
+static void profile_write_report_file()
+{
+    FILE *fp;
+
+    if ((fp = fopen(profile_report_file, "w")) == NULL) {
+        fprintf(stderr, "WARNING: Cannot write profile to %s\n", profile_report_file);
+    }
+    else {
+        profile_write_report(fp);
+        fclose(fp);
+    }
+}
+
+void profile_report_at_exit(char *filename)
+{
+    if (profile_report_file == NULL) {
+        atexit(profile_write_report_file);
+    }
+    free(profile_report_file);
+    profile_report_file = strdup(filename);
+}
+
+/******************************************************************************/
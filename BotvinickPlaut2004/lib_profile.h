@@ -0,0 +1,61 @@
+#ifndef _lib_profile_h_
+
+#define _lib_profile_h_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/******************************************************************************/
+
+/* Phase-level profiling: the time spent in, and the number of calls of,    */
+/* each of the hot phases of training and testing. Build with -DPROFILE to  */
+/* enable it; otherwise PROFILE_ENTER/EXIT expand to nothing. Phases may     */
+/* nest (BPTT forward includes its propagation), so the totals overlap. A    */
+/* phase entered again within itself is timed once, from the outermost call. */
+
+typedef enum profile_phase {
+    PROFILE_PROPAGATE,        /* Forward propagation, single or batched */
+    PROFILE_BPTT_FORWARD,     /* BPTT: running the sequence forwards */
+    PROFILE_BPTT_BACKWARD,    /* BPTT: epsilons and deltas */
+    PROFILE_BPTT_UPDATE,      /* BPTT: weight changes, and applying them */
+    PROFILE_WORLD_STEP,       /* Performing an action in the world */
+    PROFILE_CLASSIFY,         /* Scoring or classifying action sequences */
+    PROFILE_LESION,           /* Applying damage to weights or units */
+    PROFILE_WEIGHT_IO,        /* Reading or writing weight files */
+    PROFILE_MAX
+} ProfilePhase;
+
+/* Durations are also histogrammed: bucket b counts calls that took from   */
+/* 2^b to 2^(b+1)-1 nanoseconds.                                            */
+
+#define PROFILE_BUCKETS 32
+
+typedef struct profile_summary {
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t histogram[PROFILE_BUCKETS];
+} ProfileSummary;
+
+extern char *profile_phase_name[PROFILE_MAX];
+
+extern void profile_enter(ProfilePhase phase);
+extern void profile_exit(ProfilePhase phase);
+extern int  profile_summarise(ProfileSummary *summary);
+extern void profile_reset();
+extern void profile_write_report(FILE *fp);
+extern void profile_report_at_exit(char *filename);
+
+#ifdef PROFILE
+#define PROFILE_ENTER(phase) profile_enter(phase)
+#define PROFILE_EXIT(phase) profile_exit(phase)
+#define PROFILE_REPORT_AT_EXIT(filename) profile_report_at_exit(filename)
+#else
+#define PROFILE_ENTER(phase) ((void) 0)
+#define PROFILE_EXIT(phase) ((void) 0)
+#define PROFILE_REPORT_AT_EXIT(filename) ((void) 0)
+#endif
+
+/******************************************************************************/
+
+#endif
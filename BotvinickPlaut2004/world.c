@@ -1,15 +1,13 @@
 #include "bp.h"
+#include "lib_profile.h"
 #include "utils_maths.h"
 #include <stdlib.h>
 #include <string.h>
 #include <glib.h>
 
-extern void action_log_initialise();
-extern void action_log_record(ActionType act, int cycle, char *arg1, char *arg2);
 
 #define NAME_LENGTH 20
 
-typedef enum object_type    {OBJECT_CUP, OBJECT_TEABAG, OBJECT_COFFEE_PACKET, OBJECT_SUGAR_PACKET, OBJECT_SPOON, OBJECT_CARTON, OBJECT_SUGAR_BOWL, OBJECT_SUGAR_BOWL_LID} ObjectType;
 typedef enum access_state   {ACCESS_NONE, ACCESS_OPEN, ACCESS_CLOSED} AccessState;
 
 #define CONTAINS_NOTHING     0
@@ -40,20 +38,29 @@ typedef struct object_list {
     struct object_list *tail;
 } ObjectList;
 
-typedef struct current_state {
+/* All state of one simulated environment. Independent contexts may be used  */
+/* concurrently (e.g. one per thread in bp_sweep):                            */
+
+struct world_context {
     Object     *fixated;
     Object     *held;
     ObjectList *ol;
     Boolean     coffee_instruction;
     Boolean     tea_instruction;
-} CurrentState;
-
-static CurrentState cs;
+    char       *error_string;
+    char        error_buffer[WES_LENGTH];
+    ActionLog   log;
+};
 
-char *task_name[TASK_MAX];
+char *task_name[TASK_MAX] = {"None", "Coffee", "Tea"};
 
 char world_error_string[WES_LENGTH];
 
+/* The context used by the original (context-free) interface. Its error     */
+/* string is the global world_error_string:                                 */
+
+static WorldContext default_context = {NULL, NULL, NULL, FALSE, FALSE, world_error_string, "", {NULL, NULL, FALSE, NULL, 0, 0}};
+
 double object_empty_mug[18]              = {1.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
 double object_non_empty_mug1[18]         = {1.0, 1.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
 double object_non_empty_mug2[18]         = {1.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
@@ -124,7 +131,7 @@ static void show_content(char *when, Object *object)
 }
 #endif
 
-static Object *create_object(char *name, ObjectType ot, AccessState at, int contents)
+static Object *create_object(WorldContext *wc, char *name, ObjectType ot, AccessState at, int contents)
 {
     ObjectList *new = (ObjectList *)malloc(sizeof(ObjectList));
     Object *node = (Object *)malloc(sizeof(Object));
@@ -137,22 +144,81 @@ static Object *create_object(char *name, ObjectType ot, AccessState at, int cont
         node->ot = ot;
         node->at = at;
         new->head = node;
-        new->tail = cs.ol;
-        cs.ol = new;
+        new->tail = wc->ol;
+        wc->ol = new;
     }
     return(node);
 }
 
-void world_initialise(TaskType *task)
+static void free_objects(WorldContext *wc)
+{
+    ObjectList *next;
+
+    while (wc->ol != NULL) {
+        next = wc->ol->tail;
+        free(wc->ol->head);
+        free(wc->ol);
+        wc->ol = next;
+    }
+}
+
+WorldContext *world_context_create()
+{
+    WorldContext *wc;
+
+    if ((wc = (WorldContext *)malloc(sizeof(WorldContext))) != NULL) {
+        wc->fixated = NULL;
+        wc->held = NULL;
+        wc->ol = NULL;
+        wc->coffee_instruction = FALSE;
+        wc->tea_instruction = FALSE;
+        wc->error_string = wc->error_buffer;
+        wc->error_buffer[0] = '\0';
+        wc->log.first = NULL;
+        wc->log.last = NULL;
+        wc->log.task_complete = FALSE;
+        wc->log.arena = NULL;
+        wc->log.length = 0;
+        wc->log.capacity = 0;
+    }
+    return(wc);
+}
+
+void world_context_free(WorldContext *wc)
+{
+    if ((wc != NULL) && (wc != &default_context)) {
+        action_log_free(&wc->log);
+        free_objects(wc);
+        free(wc);
+    }
+}
+
+WorldContext *world_context_default()
+{
+    return(&default_context);
+}
+
+ActionLog *world_context_action_log(WorldContext *wc)
+{
+    return(&wc->log);
+}
+
+char *world_context_error_string(WorldContext *wc)
+{
+    return(wc->error_string);
+}
+
+void world_context_initialise(WorldContext *wc, TaskType *task)
 {
     Object *mug;
 
-    action_log_initialise();
+    action_log_initialise(&wc->log);
 
-    cs.ol = NULL;
+    /* Discard the objects of any previous episode: */
+    free_objects(wc);
 
     /* The mug (initially empty ... actually it contains hot water): */
-    mug = create_object("mug", OBJECT_CUP, ACCESS_OPEN, CONTAINS_WATER1 | CONTAINS_WATER2 | CONTAINS_WATER3 | CONTAINS_WATER4);
+    mug = create_object(wc, "mug", OBJECT_CUP, ACCESS_OPEN, CONTAINS_WATER1 | CONTAINS_WATER2 | CONTAINS_WATER3 | CONTAINS_WATER4);
     if (task->initial_state.mug_contains_coffee) {
         mug->contents = mug->contents | CONTAINS_COFFEE;
     }
@@ -166,34 +232,35 @@ void world_initialise(TaskType *task)
         mug->contents = mug->contents | CONTAINS_SUGAR1;
     }
     /* The spoon (initially empty): */
-    create_object("spoon", OBJECT_SPOON, ACCESS_NONE, CONTAINS_NOTHING);
+    create_object(wc, "spoon", OBJECT_SPOON, ACCESS_NONE, CONTAINS_NOTHING);
     /* The sugar bowl (initially closed): */
     if (task->initial_state.bowl_closed) {
-        create_object("sugar bowl", OBJECT_SUGAR_BOWL, ACCESS_CLOSED, CONTAINS_SUGAR1 | CONTAINS_SUGAR2 | CONTAINS_SUGAR3);
+        create_object(wc, "sugar bowl", OBJECT_SUGAR_BOWL, ACCESS_CLOSED, CONTAINS_SUGAR1 | CONTAINS_SUGAR2 | CONTAINS_SUGAR3);
     }
     else {
-        create_object("sugar bowl", OBJECT_SUGAR_BOWL, ACCESS_OPEN, CONTAINS_SUGAR1 | CONTAINS_SUGAR2 | CONTAINS_SUGAR3);
+        create_object(wc, "sugar bowl", OBJECT_SUGAR_BOWL, ACCESS_OPEN, CONTAINS_SUGAR1 | CONTAINS_SUGAR2 | CONTAINS_SUGAR3);
     }
     /* The sugar bowl lid: */
-    create_object("lid", OBJECT_SUGAR_BOWL_LID, ACCESS_NONE, CONTAINS_NOTHING);
+    create_object(wc, "lid", OBJECT_SUGAR_BOWL_LID, ACCESS_NONE, CONTAINS_NOTHING);
     /* The cream carton (initially closed): */
-    create_object("cream carton", OBJECT_CARTON, ACCESS_CLOSED, CONTAINS_MILK1 | CONTAINS_MILK2 | CONTAINS_MILK3);
+    create_object(wc, "cream carton", OBJECT_CARTON, ACCESS_CLOSED, CONTAINS_MILK1 | CONTAINS_MILK2 | CONTAINS_MILK3);
     /* The coffee packet (initially closed): */
-    create_object("coffee packet", OBJECT_COFFEE_PACKET, ACCESS_CLOSED, CONTAINS_COFFEE);
+    create_object(wc, "coffee packet", OBJECT_COFFEE_PACKET, ACCESS_CLOSED, CONTAINS_COFFEE);
     /* The sugar pack (initially closed): */
-    create_object("sugar packet", OBJECT_SUGAR_PACKET, ACCESS_CLOSED, CONTAINS_SUGAR1);
+    create_object(wc, "sugar packet", OBJECT_SUGAR_PACKET, ACCESS_CLOSED, CONTAINS_SUGAR1);
     /* The teabag: */
-    create_object("teabag", OBJECT_TEABAG, ACCESS_CLOSED, CONTAINS_TEA);
+    create_object(wc, "teabag", OBJECT_TEABAG, ACCESS_CLOSED, CONTAINS_TEA);
     /* The instructions (zero in first 18 features): */
-    cs.coffee_instruction = (task->base == TASK_COFFEE);
-    cs.tea_instruction = (task->base == TASK_TEA);
+    wc->coffee_instruction = (task->base == TASK_COFFEE);
+    wc->tea_instruction = (task->base == TASK_TEA);
 
-    cs.held = NULL;
-    cs.fixated = mug;
+    wc->held = NULL;
+    wc->fixated = mug;
+}
 
-    task_name[TASK_NONE] = "None";
-    task_name[TASK_COFFEE] = "Coffee";
-    task_name[TASK_TEA] = "Tea";
+void world_initialise(TaskType *task)
+{
+    world_context_initialise(&default_context, task);
 }
 
 /******************************************************************************/
@@ -256,31 +323,31 @@ static void build_object_vector(double *vector, Object *object)
 
 /******************************************************************************/
 
-static void world_set_fixation_vector(double *vector)
+static void world_set_fixation_vector(WorldContext *wc, double *vector)
 {
     // Fixate vector: 18 features from object, plus tea instruction or coffee instruction
 
     int i;
 
-    if (cs.fixated != NULL) {
-        build_object_vector(vector, cs.fixated);
+    if (wc->fixated != NULL) {
+        build_object_vector(vector, wc->fixated);
     }
     else {
         for (i = 0; i < 18; i++) {
             vector[i] = 0.0;
         }
     }
-    vector[18] = (cs.coffee_instruction ? 1.0 : 0.0);
-    vector[19] = (cs.tea_instruction ? 1.0 : 0.0);
+    vector[18] = (wc->coffee_instruction ? 1.0 : 0.0);
+    vector[19] = (wc->tea_instruction ? 1.0 : 0.0);
 }
 
-static void world_set_held_vector(double *vector)
+static void world_set_held_vector(WorldContext *wc, double *vector)
 {
     // Held vector: 18 features from object, plus the "nothing" feature
 
     int i;
 
-    if (cs.held == NULL) {
+    if (wc->held == NULL) {
         for (i = 0; i < 18; i++) {
             vector[i] = 0.0;
         }
@@ -288,17 +355,22 @@ static void world_set_held_vector(double *vector)
     }
     else {
         // Set the first 18 features of vector:
-        build_object_vector(vector, cs.held);
+        build_object_vector(vector, wc->held);
         vector[18] = 0.0;
     }
 }
 
-void world_set_network_input_vector(double *vector)
+void world_context_set_network_input_vector(WorldContext *wc, double *vector)
 {
     // vector should be 39 units long
 
-    world_set_fixation_vector(vector);    /* First 20 units */
-    world_set_held_vector(&vector[20]);   /* Next 19 units  */
+    world_set_fixation_vector(wc, vector);    /* First 20 units */
+    world_set_held_vector(wc, &vector[20]);   /* Next 19 units  */
+}
+
+void world_set_network_input_vector(double *vector)
+{
+    world_context_set_network_input_vector(&default_context, vector);
 }
 
 /******************************************************************************/
@@ -337,36 +409,41 @@ static void world_print_object_state(FILE *fp, Object *obj)
     fprintf(fp, "\n");
 }
 
-void world_print_state(FILE *fp)
+void world_context_print_state(WorldContext *wc, FILE *fp)
 {
     ObjectList *os;
 
     fprintf(fp, "FIXATED:\n");
     fprintf(fp, "  ");
-    world_print_object_state(fp, cs.fixated);
+    world_print_object_state(fp, wc->fixated);
     fprintf(fp, "HELD:\n");
     fprintf(fp, "  ");
-    world_print_object_state(fp, cs.held);
+    world_print_object_state(fp, wc->held);
     fprintf(fp, "INSTRUCTIONS:");
-    if (cs.coffee_instruction) {
+    if (wc->coffee_instruction) {
         fprintf(fp, " coffee");
     }
-    if (cs.tea_instruction) {
+    if (wc->tea_instruction) {
         fprintf(fp, " tea");
     }
     fprintf(fp, "\nSTATE:\n");
-    for (os = cs.ol; os != NULL; os = os->tail) {
+    for (os = wc->ol; os != NULL; os = os->tail) {
         fprintf(fp, "  ");
         world_print_object_state(fp, os->head);
     }
     fprintf(fp, "\n");
 }
 
+void world_print_state(FILE *fp)
+{
+    world_context_print_state(&default_context, fp);
+}
+
 /******************************************************************************/
 
-static Object *locate_object(char *name)
+static Object *locate_object(WorldContext *wc, char *name)
 {
-    ObjectList *os = cs.ol;
+    ObjectList *os = wc->ol;
     while (os != NULL) {
         if (strncmp(os->head->name, name, NAME_LENGTH) == 0) {
             return(os->head);
@@ -669,356 +746,364 @@ ActionType world_get_network_output_action(FILE *fp, double *vector)
     return((ActionType) j);
 }
 
-Boolean world_perform_action(ActionType action)
+Boolean world_context_perform_action(WorldContext *wc, ActionType action)
 {
     Boolean error = TRUE;
     int cycle = 0;
     Object *tmp;
 
+    PROFILE_ENTER(PROFILE_WORLD_STEP);
+
     /* Unset the instruction units: */
-    cs.coffee_instruction = FALSE;
-    cs.tea_instruction = FALSE;
+    wc->coffee_instruction = FALSE;
+    wc->tea_instruction = FALSE;
 
     switch (action) {
         case ACTION_PICK_UP: {
-            if (cs.held != NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "pick up failed: already holding %s", cs.held->name);
+            if (wc->held != NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pick up failed: already holding %s", wc->held->name);
             }
-            else if (cs.fixated == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "pick up failed: Not fixated on anything");
+            else if (wc->fixated == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pick up failed: Not fixated on anything");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "pick up %s", cs.fixated->name);
-                action_log_record(ACTION_PICK_UP, cycle, cs.fixated->name, NULL);
-                cs.held = cs.fixated;
+                g_snprintf(wc->error_string, WES_LENGTH, "pick up %s", wc->fixated->name);
+                action_log_record(&wc->log, ACTION_PICK_UP, cycle, wc->fixated->ot, OBJECT_NONE);
+                wc->held = wc->fixated;
                 error = FALSE;
             }
             break;
         }
         case ACTION_PUT_DOWN: {
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "put down failed: not holding anything");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "put down failed: not holding anything");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "put down %s", cs.held->name);
-                action_log_record(ACTION_PUT_DOWN, cycle, cs.held->name, NULL);
-                cs.held = NULL;
+                g_snprintf(wc->error_string, WES_LENGTH, "put down %s", wc->held->name);
+                action_log_record(&wc->log, ACTION_PUT_DOWN, cycle, wc->held->ot, OBJECT_NONE);
+                wc->held = NULL;
                 error = FALSE;
             }
             break;
         }
         case ACTION_POUR: {
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "pour failed: not holding anything");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pour failed: not holding anything");
             }
-            else if (cs.held->contents == CONTAINS_NOTHING) {
-                g_snprintf(world_error_string, WES_LENGTH, "pour failed: source (%s) is empty", cs.held->name);
+            else if (wc->held->contents == CONTAINS_NOTHING) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pour failed: source (%s) is empty", wc->held->name);
             }
-            else if (cs.held->at == ACCESS_CLOSED) {
-                g_snprintf(world_error_string, WES_LENGTH, "pour failed: source (%s) is closed", cs.held->name);
+            else if (wc->held->at == ACCESS_CLOSED) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pour failed: source (%s) is closed", wc->held->name);
             }
-            else if (cs.fixated == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "pour failed: No target");
+            else if (wc->fixated == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pour failed: No target");
             }
-            else if (cs.fixated->at == ACCESS_CLOSED) {
-                g_snprintf(world_error_string, WES_LENGTH, "pour failed: target (%s) is closed", cs.fixated->name);
+            else if (wc->fixated->at == ACCESS_CLOSED) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pour failed: target (%s) is closed", wc->fixated->name);
             }
-            else if ((cs.fixated->ot != OBJECT_CUP) && (cs.fixated->ot != OBJECT_SUGAR_BOWL) && (cs.fixated->ot != OBJECT_CARTON)) {
-                g_snprintf(world_error_string, WES_LENGTH, "pour failed: target (%s) is not valid", cs.fixated->name);
+            else if ((wc->fixated->ot != OBJECT_CUP) && (wc->fixated->ot != OBJECT_SUGAR_BOWL) && (wc->fixated->ot != OBJECT_CARTON)) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pour failed: target (%s) is not valid", wc->fixated->name);
             }
             else {
-                transfer_content_some(cs.held, cs.fixated);
-                g_snprintf(world_error_string, WES_LENGTH, "pour %s into %s", cs.held->name, cs.fixated->name);
-                action_log_record(ACTION_POUR, cycle, cs.held->name, cs.fixated->name);
+                transfer_content_some(wc->held, wc->fixated);
+                g_snprintf(wc->error_string, WES_LENGTH, "pour %s into %s", wc->held->name, wc->fixated->name);
+                action_log_record(&wc->log, ACTION_POUR, cycle, wc->held->ot, wc->fixated->ot);
                 error = FALSE;
             }
             break;
         }
         case ACTION_PULL_OPEN: {
             /* Peel open the coffee packet */
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "Cannot pull open: Hand is empty");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "Cannot pull open: Hand is empty");
             }
-            else if (cs.held->ot != OBJECT_COFFEE_PACKET) {
-                g_snprintf(world_error_string, WES_LENGTH, "pull open failed: target (%s) is not coffee packet", cs.fixated->name);
+            else if (wc->held->ot != OBJECT_COFFEE_PACKET) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pull open failed: target (%s) is not coffee packet", wc->fixated->name);
             }
-            else if (cs.held->at != ACCESS_CLOSED) {
-                g_snprintf(world_error_string, WES_LENGTH, "pull open failed: target (%s) is not closed", cs.fixated->name);
+            else if (wc->held->at != ACCESS_CLOSED) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pull open failed: target (%s) is not closed", wc->fixated->name);
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "pull open %s", cs.held->name);
-                cs.held->at = ACCESS_OPEN;
-                action_log_record(ACTION_PULL_OPEN, cycle, cs.held->name, NULL);
+                g_snprintf(wc->error_string, WES_LENGTH, "pull open %s", wc->held->name);
+                wc->held->at = ACCESS_OPEN;
+                action_log_record(&wc->log, ACTION_PULL_OPEN, cycle, wc->held->ot, OBJECT_NONE);
                 error = FALSE;
             }
             break;
         }
         case ACTION_TEAR_OPEN: {
             /* Tear open the sugar packet */
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "Cannot tear open: Hand is empty");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "Cannot tear open: Hand is empty");
             }
-            else if (cs.held->ot != OBJECT_SUGAR_PACKET) {
-                g_snprintf(world_error_string, WES_LENGTH, "tear open failed: target (%s) is not sugar packet", cs.fixated->name);
+            else if (wc->held->ot != OBJECT_SUGAR_PACKET) {
+                g_snprintf(wc->error_string, WES_LENGTH, "tear open failed: target (%s) is not sugar packet", wc->fixated->name);
             }
-            else if (cs.held->at != ACCESS_CLOSED) {
-                g_snprintf(world_error_string, WES_LENGTH, "tear open failed: target (%s) is not closed", cs.fixated->name);
+            else if (wc->held->at != ACCESS_CLOSED) {
+                g_snprintf(wc->error_string, WES_LENGTH, "tear open failed: target (%s) is not closed", wc->fixated->name);
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "tear open %s", cs.held->name);
-                cs.held->at = ACCESS_OPEN;
-                action_log_record(ACTION_TEAR_OPEN, cycle, cs.held->name, NULL);
+                g_snprintf(wc->error_string, WES_LENGTH, "tear open %s", wc->held->name);
+                wc->held->at = ACCESS_OPEN;
+                action_log_record(&wc->log, ACTION_TEAR_OPEN, cycle, wc->held->ot, OBJECT_NONE);
                 error = FALSE;
             }
             break;
         }
         case ACTION_PEEL_OPEN: {
             /* Pull open the cream carton */
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "Cannot peel open: Hand is empty");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "Cannot peel open: Hand is empty");
             }
-            else if (cs.held->ot != OBJECT_CARTON) {
-                g_snprintf(world_error_string, WES_LENGTH, "peel open failed: target (%s) is not carton", cs.fixated->name);
+            else if (wc->held->ot != OBJECT_CARTON) {
+                g_snprintf(wc->error_string, WES_LENGTH, "peel open failed: target (%s) is not carton", wc->fixated->name);
             }
-            else if (cs.held->at != ACCESS_CLOSED) {
-                g_snprintf(world_error_string, WES_LENGTH, "peel open failed: target (%s) is not closed", cs.fixated->name);
+            else if (wc->held->at != ACCESS_CLOSED) {
+                g_snprintf(wc->error_string, WES_LENGTH, "peel open failed: target (%s) is not closed", wc->fixated->name);
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "peel open %s", cs.held->name);
-                cs.held->at = ACCESS_OPEN;
-                action_log_record(ACTION_PEEL_OPEN, cycle, cs.held->name, NULL);
+                g_snprintf(wc->error_string, WES_LENGTH, "peel open %s", wc->held->name);
+                wc->held->at = ACCESS_OPEN;
+                action_log_record(&wc->log, ACTION_PEEL_OPEN, cycle, wc->held->ot, OBJECT_NONE);
                 error = FALSE;
             }
             break;
         }
         case ACTION_PULL_OFF: {
             /* Pull the lid off the sugar bowl */
-            if (cs.held != NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "Cannot pull off: Hand is being used");
+            if (wc->held != NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "Cannot pull off: Hand is being used");
             }
-            else if (cs.fixated->ot != OBJECT_SUGAR_BOWL) {
-                g_snprintf(world_error_string, WES_LENGTH, "pull off failed: target (%s) is not sugar bowl", cs.fixated->name);
+            else if (wc->fixated->ot != OBJECT_SUGAR_BOWL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pull off failed: target (%s) is not sugar bowl", wc->fixated->name);
             }
-            else if (cs.fixated->at != ACCESS_CLOSED) {
-                g_snprintf(world_error_string, WES_LENGTH, "pull off failed: target (%s) is not closed", cs.fixated->name);
+            else if (wc->fixated->at != ACCESS_CLOSED) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pull off failed: target (%s) is not closed", wc->fixated->name);
             }
-            else if ((tmp = locate_object("lid")) == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "pull off failed: cannot locate sugar bowl lid");
+            else if ((tmp = locate_object(wc, "lid")) == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "pull off failed: cannot locate sugar bowl lid");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "pull off %s from %s", tmp->name, cs.fixated->name);
-                cs.held = tmp;
-                cs.fixated->at = ACCESS_OPEN;
-                action_log_record(ACTION_PULL_OFF, cycle, cs.fixated->name, cs.held->name);
+                g_snprintf(wc->error_string, WES_LENGTH, "pull off %s from %s", tmp->name, wc->fixated->name);
+                wc->held = tmp;
+                wc->fixated->at = ACCESS_OPEN;
+                action_log_record(&wc->log, ACTION_PULL_OFF, cycle, wc->fixated->ot, wc->held->ot);
                 error = FALSE;
             }
             break;
         }
         case ACTION_SCOOP: {
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "scoop failed: not holding anything");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "scoop failed: not holding anything");
             }
-            else if (cs.held->ot != OBJECT_SPOON) {
-                g_snprintf(world_error_string, WES_LENGTH, "scoop failed: held object (%s) is not spoon", cs.held->name);
+            else if (wc->held->ot != OBJECT_SPOON) {
+                g_snprintf(wc->error_string, WES_LENGTH, "scoop failed: held object (%s) is not spoon", wc->held->name);
             }
-            else if (cs.held->contents != CONTAINS_NOTHING) {
-                g_snprintf(world_error_string, WES_LENGTH, "scoop failed: spoon is not empty");
+            else if (wc->held->contents != CONTAINS_NOTHING) {
+                g_snprintf(wc->error_string, WES_LENGTH, "scoop failed: spoon is not empty");
             }
-            else if (cs.fixated == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "scoop failed: No target");
+            else if (wc->fixated == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "scoop failed: No target");
             }
-            else if (cs.fixated->at == ACCESS_CLOSED) {
-                g_snprintf(world_error_string, WES_LENGTH, "scoop failed: target (%s) is closed", cs.fixated->name);
+            else if (wc->fixated->at == ACCESS_CLOSED) {
+                g_snprintf(wc->error_string, WES_LENGTH, "scoop failed: target (%s) is closed", wc->fixated->name);
             }
-            else if (cs.fixated->contents == CONTAINS_NOTHING) {
-                g_snprintf(world_error_string, WES_LENGTH, "scoop failed: target (%s) is empty", cs.fixated->name);
+            else if (wc->fixated->contents == CONTAINS_NOTHING) {
+                g_snprintf(wc->error_string, WES_LENGTH, "scoop failed: target (%s) is empty", wc->fixated->name);
             }
-            else if ((cs.fixated->ot != OBJECT_CUP) && (cs.fixated->ot != OBJECT_SUGAR_BOWL) && (cs.fixated->ot != OBJECT_CARTON)) {
-                g_snprintf(world_error_string, WES_LENGTH, "scoop failed: target (%s) is not valid", cs.fixated->name);
+            else if ((wc->fixated->ot != OBJECT_CUP) && (wc->fixated->ot != OBJECT_SUGAR_BOWL) && (wc->fixated->ot != OBJECT_CARTON)) {
+                g_snprintf(wc->error_string, WES_LENGTH, "scoop failed: target (%s) is not valid", wc->fixated->name);
             }
             else {
-                transfer_content_some(cs.fixated, cs.held);
-                g_snprintf(world_error_string, WES_LENGTH, "scoop with %s from %s", cs.held->name, cs.fixated->name);
-                action_log_record(ACTION_SCOOP, cycle, cs.fixated->name, cs.held->name);
+                transfer_content_some(wc->fixated, wc->held);
+                g_snprintf(wc->error_string, WES_LENGTH, "scoop with %s from %s", wc->held->name, wc->fixated->name);
+                action_log_record(&wc->log, ACTION_SCOOP, cycle, wc->fixated->ot, wc->held->ot);
                 error = FALSE;
             }
             break;
         }
         case ACTION_SIP: {
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "sip failed: Hand is empty");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "sip failed: Hand is empty");
             }
-            else if (cs.held->at == ACCESS_CLOSED) {
-                g_snprintf(world_error_string, WES_LENGTH, "sip failed: Held object (%s) is closed", cs.held->name);
+            else if (wc->held->at == ACCESS_CLOSED) {
+                g_snprintf(wc->error_string, WES_LENGTH, "sip failed: Held object (%s) is closed", wc->held->name);
             }
-            else if (cs.held->contents == CONTAINS_NOTHING) {
-                g_snprintf(world_error_string, WES_LENGTH, "sip failed: Held object (%s) is empty", cs.held->name);
+            else if (wc->held->contents == CONTAINS_NOTHING) {
+                g_snprintf(wc->error_string, WES_LENGTH, "sip failed: Held object (%s) is empty", wc->held->name);
             }
             else {
-                sip_content(cs.held);
-                g_snprintf(world_error_string, WES_LENGTH, "sip from %s", cs.held->name);
-                action_log_record(ACTION_SIP, cycle, cs.held->name, NULL);
+                sip_content(wc->held);
+                g_snprintf(wc->error_string, WES_LENGTH, "sip from %s", wc->held->name);
+                action_log_record(&wc->log, ACTION_SIP, cycle, wc->held->ot, OBJECT_NONE);
                 error = FALSE;
             }
             break;
         }
         case ACTION_STIR: {
             // Dip stir the contents of a container ... hopefully the mug with the spoon
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "stir failed: Hand is empty");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "stir failed: Hand is empty");
             }
-            else if (cs.held->ot != OBJECT_SPOON) {
-                g_snprintf(world_error_string, WES_LENGTH, "stir failed: Held object (%s) is not spoon", cs.held->name);
+            else if (wc->held->ot != OBJECT_SPOON) {
+                g_snprintf(wc->error_string, WES_LENGTH, "stir failed: Held object (%s) is not spoon", wc->held->name);
             }
-            else if (cs.fixated == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "stir failed: No fixated target");
+            else if (wc->fixated == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "stir failed: No fixated target");
             }
-            else if (cs.fixated->at != ACCESS_OPEN) {
-                g_snprintf(world_error_string, WES_LENGTH, "stir failed: Target (%s) is not open", cs.fixated->name);
+            else if (wc->fixated->at != ACCESS_OPEN) {
+                g_snprintf(wc->error_string, WES_LENGTH, "stir failed: Target (%s) is not open", wc->fixated->name);
             }
-            else if (cs.fixated->contents == CONTAINS_NOTHING) {
-                g_snprintf(world_error_string, WES_LENGTH, "stir failed: Target (%s) is empty", cs.fixated->name);
+            else if (wc->fixated->contents == CONTAINS_NOTHING) {
+                g_snprintf(wc->error_string, WES_LENGTH, "stir failed: Target (%s) is empty", wc->fixated->name);
             }
-            else if ((cs.fixated->ot != OBJECT_CUP) && (cs.fixated->ot != OBJECT_SUGAR_BOWL) && (cs.fixated->ot != OBJECT_CARTON)) {
-                g_snprintf(world_error_string, WES_LENGTH, "stir failed: Target (%s) is not sensible", cs.fixated->name);
+            else if ((wc->fixated->ot != OBJECT_CUP) && (wc->fixated->ot != OBJECT_SUGAR_BOWL) && (wc->fixated->ot != OBJECT_CARTON)) {
+                g_snprintf(wc->error_string, WES_LENGTH, "stir failed: Target (%s) is not sensible", wc->fixated->name);
             }
             else {
-                if (cs.held->contents != CONTAINS_NOTHING) {
-                    transfer_content_all(cs.held, cs.fixated);
+                if (wc->held->contents != CONTAINS_NOTHING) {
+                    transfer_content_all(wc->held, wc->fixated);
                 }
-                g_snprintf(world_error_string, WES_LENGTH, "stir %s with %s", cs.fixated->name, cs.held->name);
-                cs.fixated->mixed = TRUE;
-                action_log_record(ACTION_STIR, cycle, cs.fixated->name, cs.held->name);
+                g_snprintf(wc->error_string, WES_LENGTH, "stir %s with %s", wc->fixated->name, wc->held->name);
+                wc->fixated->mixed = TRUE;
+                action_log_record(&wc->log, ACTION_STIR, cycle, wc->fixated->ot, wc->held->ot);
                 error = FALSE;
             }
             break;
         }
         case ACTION_DIP: {
             // Dip the teabag into a container ... hopefully the mug
-            if (cs.held == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "dip failed: Hand is empty");
+            if (wc->held == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "dip failed: Hand is empty");
             }
-            else if (cs.held->ot != OBJECT_TEABAG) {
-                g_snprintf(world_error_string, WES_LENGTH, "dip failed: Held object (%s) is not teabag", cs.held->name);
+            else if (wc->held->ot != OBJECT_TEABAG) {
+                g_snprintf(wc->error_string, WES_LENGTH, "dip failed: Held object (%s) is not teabag", wc->held->name);
             }
-            else if (cs.fixated->at != ACCESS_OPEN) {
-                g_snprintf(world_error_string, WES_LENGTH, "dip failed: Target (%s) is not open", cs.fixated->name);
+            else if (wc->fixated->at != ACCESS_OPEN) {
+                g_snprintf(wc->error_string, WES_LENGTH, "dip failed: Target (%s) is not open", wc->fixated->name);
             }
-            else if ((cs.fixated->ot != OBJECT_CUP) && (cs.fixated->ot != OBJECT_SUGAR_BOWL) && (cs.fixated->ot != OBJECT_CARTON)) {
-                g_snprintf(world_error_string, WES_LENGTH, "dip failed: Target (%s) is not sensible", cs.fixated->name);
+            else if ((wc->fixated->ot != OBJECT_CUP) && (wc->fixated->ot != OBJECT_SUGAR_BOWL) && (wc->fixated->ot != OBJECT_CARTON)) {
+                g_snprintf(wc->error_string, WES_LENGTH, "dip failed: Target (%s) is not sensible", wc->fixated->name);
             }
             else {
-                if (cs.fixated->contents & (CONTAINS_WATER1 | CONTAINS_WATER2 | CONTAINS_WATER3 | CONTAINS_WATER4)) {
-                    cs.fixated->infused = TRUE;
+                if (wc->fixated->contents & (CONTAINS_WATER1 | CONTAINS_WATER2 | CONTAINS_WATER3 | CONTAINS_WATER4)) {
+                    wc->fixated->infused = TRUE;
                 }
-                g_snprintf(world_error_string, WES_LENGTH, "dip %s into %s", cs.held->name, cs.fixated->name);
-                action_log_record(ACTION_DIP, cycle, cs.held->name, cs.fixated->name);
+                g_snprintf(wc->error_string, WES_LENGTH, "dip %s into %s", wc->held->name, wc->fixated->name);
+                action_log_record(&wc->log, ACTION_DIP, cycle, wc->held->ot, wc->fixated->ot);
                 error = FALSE;
             }
             break;
         }
         case ACTION_SAY_DONE: {
-            g_snprintf(world_error_string, WES_LENGTH, "Done!");
-            action_log_record(ACTION_SAY_DONE, cycle, NULL, NULL);
+            g_snprintf(wc->error_string, WES_LENGTH, "Done!");
+            action_log_record(&wc->log, ACTION_SAY_DONE, cycle, OBJECT_NONE, OBJECT_NONE);
             error = FALSE;
             break;
         }
         case ACTION_FIXATE_CUP: {
-            if ((tmp = locate_object("mug")) == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_cup failed: cannot locate target");
+            if ((tmp = locate_object(wc, "mug")) == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_cup failed: cannot locate target");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_cup (target is %s)", tmp->name);
-                cs.fixated = tmp;
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_cup (target is %s)", tmp->name);
+                wc->fixated = tmp;
                 error = FALSE;
 	    }
             break;
         }
         case ACTION_FIXATE_TEABAG: {
-            if ((tmp = locate_object("teabag")) == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_teabag failed: cannot locate target");
+            if ((tmp = locate_object(wc, "teabag")) == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_teabag failed: cannot locate target");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_teabag (target is %s)", tmp->name);
-                cs.fixated = tmp;
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_teabag (target is %s)", tmp->name);
+                wc->fixated = tmp;
                 error = FALSE;
 	    }
             break;
         }
         case ACTION_FIXATE_COFFEE_PACKET: {
-            if ((tmp = locate_object("coffee packet")) == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_coffee_pack failed: cannot locate target");
+            if ((tmp = locate_object(wc, "coffee packet")) == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_coffee_pack failed: cannot locate target");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_coffee_pack (target is %s)", tmp->name);
-                cs.fixated = tmp;
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_coffee_pack (target is %s)", tmp->name);
+                wc->fixated = tmp;
                 error = FALSE;
 	    }
             break;
         }
         case ACTION_FIXATE_SPOON: {
-            if ((tmp = locate_object("spoon")) == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_spoon failed: cannot locate target");
+            if ((tmp = locate_object(wc, "spoon")) == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_spoon failed: cannot locate target");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_spoon (target is %s)", tmp->name);
-                cs.fixated = tmp;
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_spoon (target is %s)", tmp->name);
+                wc->fixated = tmp;
                 error = FALSE;
 	    }
             break;
         }
         case ACTION_FIXATE_CARTON: {
-            if ((tmp = locate_object("cream carton")) == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_cream_carton failed: cannot locate target");
+            if ((tmp = locate_object(wc, "cream carton")) == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_cream_carton failed: cannot locate target");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_cream_carton (target is %s)", tmp->name);
-                cs.fixated = tmp;
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_cream_carton (target is %s)", tmp->name);
+                wc->fixated = tmp;
                 error = FALSE;
 	    }
             break;
         }
         case ACTION_FIXATE_SUGAR_PACKET: {
 #ifdef SUGAR_HACK
-            tmp = locate_object((random_uniform(0.0, 1.0) > 0.5) ? "sugar packet" : "sugar bowl");
+            tmp = locate_object(wc, (random_uniform(0.0, 1.0) > 0.5) ? "sugar packet" : "sugar bowl");
             if (tmp == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_sugar failed: cannot locate target");
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_sugar failed: cannot locate target");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_sugar (target is %s)", tmp->name);
-                cs.fixated = tmp;
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_sugar (target is %s)", tmp->name);
+                wc->fixated = tmp;
                 error = FALSE;
             }
 #else
-            if ((tmp = locate_object("sugar packet")) == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_sugar_packet failed: cannot locate target");
+            if ((tmp = locate_object(wc, "sugar packet")) == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_sugar_packet failed: cannot locate target");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_sugar_packet (target is %s)", tmp->name);
-                cs.fixated = tmp;
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_sugar_packet (target is %s)", tmp->name);
+                wc->fixated = tmp;
                 error = FALSE;
             }
 #endif
             break;
         }
         case ACTION_FIXATE_SUGAR_BOWL: {
-            if ((tmp = locate_object("sugar bowl")) == NULL) {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_sugar_bowl failed: cannot locate target");
+            if ((tmp = locate_object(wc, "sugar bowl")) == NULL) {
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_sugar_bowl failed: cannot locate target");
             }
             else {
-                g_snprintf(world_error_string, WES_LENGTH, "fixate_sugar_bowl (target is %s)", tmp->name);
-                cs.fixated = tmp;
+                g_snprintf(wc->error_string, WES_LENGTH, "fixate_sugar_bowl (target is %s)", tmp->name);
+                wc->fixated = tmp;
                 error = FALSE;
             }
             break;
         }
         default: {
-            g_snprintf(world_error_string, WES_LENGTH, "Ignoring unrecognised action");
+            g_snprintf(wc->error_string, WES_LENGTH, "Ignoring unrecognised action");
         }
     }
+    PROFILE_EXIT(PROFILE_WORLD_STEP);
     return(!error);
 }
 
+Boolean world_perform_action(ActionType action)
+{
+    return(world_context_perform_action(&default_context, action));
+}
+
 /******************************************************************************/
 
 Boolean world_decode_action(char *buffer, int l, ActionType action)
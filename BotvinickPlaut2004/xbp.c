@@ -1,4 +1,5 @@
 #include "bp.h"
+#include "lib_profile.h"
 #include <stdlib.h>
 #include <time.h>
 #include <gtk/gtk.h>
@@ -17,6 +18,7 @@ int main(int argc, char **argv)
 
     gtk_init(&argc, &argv);
     srand((int) t0);
+    PROFILE_REPORT_AT_EXIT("xbp_profile.dat");
 
     world_initialise(&task);
     if ((frame = make_widgets()) != NULL)  {
@@ -51,6 +51,19 @@ typedef enum known_sequences {
 extern char *task_name[3];
 extern char *variant_name[NUM_VARIANTS];
 
+// Incremental classification of an action sequence, one action at a time:
+
+typedef struct sequence_classifier {
+    int node;                  // Position in the reference sequences
+    int rule;                  // Best rule matched so far
+    Boolean fixed;             // No later action can change the category
+} SequenceClassifier;
+
+extern void sequence_classifier_start(SequenceClassifier *c);
+extern Boolean sequence_classifier_step(SequenceClassifier *c, ActionType action);
+extern int sequence_classifier_category(SequenceClassifier *c);
+extern int categorise_action_sequence(ActionType *sequence);
+
 extern ActionType sequence_coffee1[37];
 extern ActionType sequence_coffee2[37];
 extern ActionType sequence_coffee3[37];
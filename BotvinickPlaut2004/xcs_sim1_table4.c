@@ -2,6 +2,8 @@
 #include "xframe.h"
 #include "lib_cairox_2_0.h"
 #include "xcs_sequences.h"
+#include "lib_profile.h"
+#include <pthread.h>
 
 extern void initialise_state(TaskType *task);
 
@@ -156,181 +158,216 @@ static void initialise_sim1_results()
     }
 }
 
-static Boolean sequence_compare(ActionType *known, ActionType *observed)
+/******************************************************************************/
+/* Classification of action sequences: The reference sequences are compiled  */
+/* (once, on first use) into a trie over actions. A rule either requires the  */
+/* observed sequence to end where its reference does (EXACT) or only to begin */
+/* with the reference (PREFIX). Rules are listed in priority order, and the   */
+/* first rule that matches gives the category, so each node records the best  */
+/* prefix rule accepted there, the best exact rule accepted if the next       */
+/* action is ACTION_SAY_DONE, and the best rule that could still be accepted  */
+/* further down. Once the best rule matched so far beats everything below the */
+/* current node the category can no longer change.                            */
+
+#define NUM_ACTIONS (ACTION_NONE + 1)
+
+typedef struct classifier_rule {
+    ActionType *sequence;      // Terminated by ACTION_SAY_DONE
+    Boolean exact;             // Match the whole sequence, or only a prefix
+    KnownSequences category;
+} ClassifierRule;
+
+static ClassifierRule classifier_rule[] = {
+    {sequence_coffee1,          TRUE,  SEQ_COFFEE1},
+    {sequence_coffee2,          TRUE,  SEQ_COFFEE2},
+    {sequence_coffee3,          TRUE,  SEQ_COFFEE3},
+    {sequence_coffee4,          TRUE,  SEQ_COFFEE4},
+    {sequence_coffee5,          TRUE,  SEQ_COFFEE5},
+    {sequence_coffee6,          TRUE,  SEQ_COFFEE6},
+    {sequence_coffee1_1sip,     FALSE, SEQ_COFFEE1_1SIP},
+    {sequence_coffee2_1sip,     FALSE, SEQ_COFFEE2_1SIP},
+    {sequence_coffee3_1sip,     FALSE, SEQ_COFFEE3_1SIP},
+    {sequence_coffee4_1sip,     FALSE, SEQ_COFFEE4_1SIP},
+    {sequence_coffee5_1sip,     FALSE, SEQ_COFFEE5_1SIP},
+    {sequence_coffee6_1sip,     FALSE, SEQ_COFFEE6_1SIP},
+    {sequence_coffee1_error,    FALSE, SEQ_ERROR_COFFEE1},
+    {sequence_coffee2_error,    FALSE, SEQ_ERROR_COFFEE2},
+    {sequence_coffee3_error,    FALSE, SEQ_ERROR_COFFEE3},
+    {sequence_coffee4_error,    FALSE, SEQ_ERROR_COFFEE4},
+    {sequence_coffee5_error,    FALSE, SEQ_ERROR_COFFEE5},
+    {sequence_coffee6_error,    FALSE, SEQ_ERROR_COFFEE6},
+    {sequence_coffee_s1_drink,  TRUE,  SEQ_ERROR_COFFEE_S1},
+    {sequence_coffee_s2_drink,  TRUE,  SEQ_ERROR_COFFEE_S2},
+    {sequence_coffee_c_drink,   TRUE,  SEQ_ERROR_COFFEE_C},
+    {sequence_coffee_drink,     TRUE,  SEQ_ERROR_COFFEE_D},
+    {sequence_coffee_start,     FALSE, SEQ_ERROR_COFFEE},
+    {sequence_tea1,             TRUE,  SEQ_TEA1},
+    {sequence_tea2,             TRUE,  SEQ_TEA2},
+    {sequence_tea3,             TRUE,  SEQ_TEA3},
+    {sequence_tea1_1sip,        FALSE, SEQ_TEA1_1SIP},
+    {sequence_tea2_1sip,        FALSE, SEQ_TEA2_1SIP},
+    {sequence_tea3_1sip,        FALSE, SEQ_TEA3_1SIP},
+    {sequence_tea1_with_cream,  FALSE, SEQ_TEA1_CREAM},
+    {sequence_tea2_with_cream,  FALSE, SEQ_TEA2_CREAM},
+    {sequence_tea1_error,       FALSE, SEQ_ERROR_TEA1},
+    {sequence_tea2_error,       FALSE, SEQ_ERROR_TEA2},
+    {sequence_tea_start,        FALSE, SEQ_ERROR_TEA},
+    {sequence_pickup_sip,       FALSE, SEQ_PICKUP_SIP},
+    {sequence_sugar_pack,       TRUE,  SEQ_SUGAR_PACK},
+    {sequence_sugar_bowl,       TRUE,  SEQ_SUGAR_BOWL}
+};
+
+#define NUM_RULES ((int) (sizeof(classifier_rule) / sizeof(ClassifierRule)))
+
+typedef struct trie_node {
+    int next[NUM_ACTIONS];     // Child for each action, or 0 (the root)
+    int prefix;                // Best rule accepted on reaching the node
+    int exact;                 // Best rule accepted if the sequence ends here
+    int below;                 // Best rule accepted at or below the node
+} TrieNode;
+
+static TrieNode *trie = NULL;
+
+static int trie_best_below(int node)
 {
-    int i = 0;
+    /* Fill in the best rule that can still be accepted from each node: */
+
+    int a, c, below, best = trie[node].exact;
+
+    for (a = 0; a < NUM_ACTIONS; a++) {
+        if ((c = trie[node].next[a]) > 0) {
+            below = trie_best_below(c);
+            best = MIN(best, MIN(below, trie[c].prefix));
+        }
+    }
+    trie[node].below = best;
+    return(best);
+}
+
+static void trie_build()
+{
+    int i, j, a, node, nodes = 1, max_nodes = 1;
 
-    while (known[i] == observed[i]) {
-        if (known[i] == ACTION_SAY_DONE) {
-            return(TRUE);
+    for (i = 0; i < NUM_RULES; i++) {
+        for (j = 0; classifier_rule[i].sequence[j] != ACTION_SAY_DONE; j++) {
+            max_nodes++;
+        }
+    }
+    trie = (TrieNode *)malloc(max_nodes * sizeof(TrieNode));
+    for (node = 0; node < max_nodes; node++) {
+        for (a = 0; a < NUM_ACTIONS; a++) {
+            trie[node].next[a] = 0;
+        }
+        trie[node].prefix = NUM_RULES;
+        trie[node].exact = NUM_RULES;
+    }
+
+    for (i = 0; i < NUM_RULES; i++) {
+        node = 0;
+        for (j = 0; (a = classifier_rule[i].sequence[j]) != ACTION_SAY_DONE; j++) {
+            if (trie[node].next[a] == 0) {
+                trie[node].next[a] = nodes++;
+            }
+            node = trie[node].next[a];
+        }
+        // Rules are added in priority order, so the first to reach a node wins:
+        if (classifier_rule[i].exact) {
+            trie[node].exact = MIN(trie[node].exact, i);
         }
         else {
-            i++;
+            trie[node].prefix = MIN(trie[node].prefix, i);
         }
     }
-    return(FALSE);
+    trie_best_below(0);
 }
 
-static Boolean subsequence_compare(ActionType *known, ActionType *observed)
+void sequence_classifier_start(SequenceClassifier *c)
 {
-    int i = 0;
+    static pthread_once_t trie_once = PTHREAD_ONCE_INIT;
 
-    while ((known[i] != ACTION_SAY_DONE) && (known[i] == observed[i])) {
-        i++;
-    }
-    return(known[i] == ACTION_SAY_DONE);
+    // Classifiers may be started concurrently, from simulation threads:
+    pthread_once(&trie_once, trie_build);
+    c->node = 0;
+    c->rule = NUM_RULES;
+    c->fixed = FALSE;
 }
 
-int categorise_action_sequence(ActionType *sequence)
+Boolean sequence_classifier_step(SequenceClassifier *c, ActionType action)
 {
-    /* Answers:
-        0: Ground -> Sugar (pack) -> Cream -> Drink
-        1: Ground -> Sugar (bowl) -> Cream -> Drink
-        2: Ground -> Cream -> Sugar (pack) -> Drink
-        3: Ground -> Cream -> Sugar (bowl) -> Drink
-        4: Teabag -> Sugar (pack) -> Drink
-        5: Teabag -> Sugar (bowl) -> Drink
-        6: Error
-    */
-   
-    if (sequence_compare(sequence_coffee1, sequence)) {
-        return(SEQ_COFFEE1);
-    }
-    else if (sequence_compare(sequence_coffee2, sequence)) {
-        return(SEQ_COFFEE2);
-    }
-    else if (sequence_compare(sequence_coffee3, sequence)) {
-        return(SEQ_COFFEE3);
-    }
-    else if (sequence_compare(sequence_coffee4, sequence)) {
-        return(SEQ_COFFEE4);
-    }
-    else if (sequence_compare(sequence_coffee5, sequence)) {
-        return(SEQ_COFFEE5);
-    }
-    else if (sequence_compare(sequence_coffee6, sequence)) {
-        return(SEQ_COFFEE6);
-    }
-    else if (subsequence_compare(sequence_coffee1_1sip, sequence)) {
-        return(SEQ_COFFEE1_1SIP);
-    }
-    else if (subsequence_compare(sequence_coffee2_1sip, sequence)) {
-        return(SEQ_COFFEE2_1SIP);
-    }
-    else if (subsequence_compare(sequence_coffee3_1sip, sequence)) {
-        return(SEQ_COFFEE3_1SIP);
-    }
-    else if (subsequence_compare(sequence_coffee4_1sip, sequence)) {
-        return(SEQ_COFFEE4_1SIP);
-    }
-    else if (subsequence_compare(sequence_coffee5_1sip, sequence)) {
-        return(SEQ_COFFEE5_1SIP);
-    }
-    else if (subsequence_compare(sequence_coffee6_1sip, sequence)) {
-        return(SEQ_COFFEE6_1SIP);
-    }
-    else if (subsequence_compare(sequence_coffee1_error, sequence)) {
-        return(SEQ_ERROR_COFFEE1);
-    }
-    else if (subsequence_compare(sequence_coffee2_error, sequence)) {
-        return(SEQ_ERROR_COFFEE2);
-    }
-    else if (subsequence_compare(sequence_coffee3_error, sequence)) {
-        return(SEQ_ERROR_COFFEE3);
-    }
-    else if (subsequence_compare(sequence_coffee4_error, sequence)) {
-        return(SEQ_ERROR_COFFEE4);
-    }
-    else if (subsequence_compare(sequence_coffee5_error, sequence)) {
-        return(SEQ_ERROR_COFFEE5);
-    }
-    else if (subsequence_compare(sequence_coffee6_error, sequence)) {
-        return(SEQ_ERROR_COFFEE6);
-    }
-    else if (sequence_compare(sequence_coffee_s1_drink, sequence)) {
-        return(SEQ_ERROR_COFFEE_S1);
-    }
-    else if (sequence_compare(sequence_coffee_s2_drink, sequence)) {
-        return(SEQ_ERROR_COFFEE_S2);
-    }
-    else if (sequence_compare(sequence_coffee_c_drink, sequence)) {
-        return(SEQ_ERROR_COFFEE_C);
-    }
-    else if (sequence_compare(sequence_coffee_drink, sequence)) {
-        return(SEQ_ERROR_COFFEE_D);
-    }
-    else if (subsequence_compare(sequence_coffee_start, sequence)) {
-        return(SEQ_ERROR_COFFEE);
-    }
-    else if (sequence_compare(sequence_tea1, sequence)) {
-        return(SEQ_TEA1);
-    }
-    else if (sequence_compare(sequence_tea2, sequence)) {
-        return(SEQ_TEA2);
-    }
-    else if (sequence_compare(sequence_tea3, sequence)) {
-        return(SEQ_TEA3);
-    }
-    else if (subsequence_compare(sequence_tea1_1sip, sequence)) {
-        return(SEQ_TEA1_1SIP);
-    }
-    else if (subsequence_compare(sequence_tea2_1sip, sequence)) {
-        return(SEQ_TEA2_1SIP);
-    }
-    else if (subsequence_compare(sequence_tea3_1sip, sequence)) {
-        return(SEQ_TEA3_1SIP);
-    }
-    else if (subsequence_compare(sequence_tea1_with_cream, sequence)) {
-        return(SEQ_TEA1_CREAM);
-    }
-    else if (subsequence_compare(sequence_tea2_with_cream, sequence)) {
-        return(SEQ_TEA2_CREAM);
-    }
-    else if (subsequence_compare(sequence_tea1_error, sequence)) {
-        return(SEQ_ERROR_TEA1);
-    }
-    else if (subsequence_compare(sequence_tea2_error, sequence)) {
-        return(SEQ_ERROR_TEA2);
+    /* Advance over the next action. Returns TRUE once the category is fixed, */
+    /* after which further actions are ignored.                               */
+
+    if (c->fixed) {
+        return(TRUE);
     }
-    else if (subsequence_compare(sequence_tea_start, sequence)) {
-        return(SEQ_ERROR_TEA);
+    else if (action == ACTION_SAY_DONE) {
+        c->rule = MIN(c->rule, trie[c->node].exact);
+        c->fixed = TRUE;
     }
-    else if (subsequence_compare(sequence_pickup_sip, sequence)) {
-        return(SEQ_PICKUP_SIP);
+    else if ((action < 0) || (action >= NUM_ACTIONS) || (trie[c->node].next[action] == 0)) {
+        c->fixed = TRUE;       // Off the trie: nothing more can match
     }
-    else if (sequence_compare(sequence_sugar_pack, sequence)) {
-        return(SEQ_SUGAR_PACK);
+    else {
+        c->node = trie[c->node].next[action];
+        c->rule = MIN(c->rule, trie[c->node].prefix);
+        c->fixed = (c->rule < trie[c->node].below);
     }
-    else if (sequence_compare(sequence_sugar_bowl, sequence)) {
-        return(SEQ_SUGAR_BOWL);
+    return(c->fixed);
+}
+
+int sequence_classifier_category(SequenceClassifier *c)
+{
+    if (c->rule < NUM_RULES) {
+        return(classifier_rule[c->rule].category);
     }
     else {
         return(SEQ_ERROR);
     }
 }
 
+int categorise_action_sequence(ActionType *sequence)
+{
+    /* The sequence must end with ACTION_SAY_DONE, or leave the reference     */
+    /* sequences before its end                                               */
+
+    SequenceClassifier c;
+    int i = 0;
+
+    PROFILE_ENTER(PROFILE_CLASSIFY);
+    sequence_classifier_start(&c);
+    while (!sequence_classifier_step(&c, sequence[i])) {
+        i++;
+    }
+    PROFILE_EXIT(PROFILE_CLASSIFY);
+    return(sequence_classifier_category(&c));
+}
+
 static int run_one_simulation()
 {
     /* Run one simulation and categorise it according to the possible targets */
 
     double *vector_in = (double *)malloc(IN_WIDTH * sizeof(double));
     double *vector_out = (double *)malloc(OUT_WIDTH * sizeof(double));
-    int count = 0;
-    ActionType this[100];
+    SequenceClassifier classifier;
+    ActionType action;
+
+    /* The episode stops as soon as its category is fixed: by ACTION_SAY_DONE */
+    /* at the latest, or on leaving the reference sequences                  */
 
+    sequence_classifier_start(&classifier);
     do {
         world_set_network_input_vector(vector_in);
         network_tell_input(xg.net, vector_in);
         network_tell_propagate2(xg.net);
         network_ask_output(xg.net, vector_out);
-        this[count] = world_get_network_output_action(NULL, vector_out);
-        world_perform_action(this[count]);
-    } while ((this[count] != ACTION_SAY_DONE) && (count++ < 100));
+        action = world_get_network_output_action(NULL, vector_out);
+        world_perform_action(action);
+    } while (!sequence_classifier_step(&classifier, action));
 
     free(vector_in);
     free(vector_out);
 
-    return(categorise_action_sequence(this));
+    return(sequence_classifier_category(&classifier));
 }
 
 static void generate_sim1_results_callback(GtkWidget *mi, void *count)
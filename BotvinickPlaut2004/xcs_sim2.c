@@ -2,19 +2,37 @@
 #include "xframe.h"
 #include "lib_cairox_2_0.h"
 #include "xcs_sequences.h"
-
-extern void initialise_state(TaskType *task);
-extern int categorise_action_sequence(ActionType *sequence);
-extern void xgraph_set_error_scores();
-extern void initialise_widgets();
+#include "utils_maths.h"
+#include <pthread.h>
 
 /******************************************************************************/
 
 static GtkWidget *viewer_widget = NULL;
 static cairo_surface_t *viewer_surface = NULL;
 
+#define CS_SIM2_NETWORKS 10
+#define REDRAW_INTERVAL 100    /* Milliseconds between redraws while running */
+
 /* The results matrix has 4 dimensions: instruction, weights, sequence */
-static int cs_sim2_results[3][10][NUM_VARIANTS];
+static int cs_sim2_results[3][CS_SIM2_NETWORKS][NUM_VARIANTS];
+
+/* The simulations run on worker threads, one per weight file. A worker     */
+/* publishes each result by an atomic increment of its own part of the      */
+/* table, so it never waits for the display. The table only ever grows, so  */
+/* the viewer draws from a copy taken with atomic loads, on a timer in the  */
+/* GTK main loop while any worker is running.                                */
+
+typedef struct cs_sim2_job {
+    pthread_t  thread;
+    int        l;              // Index of the weight file
+    long       count;          // Trials of each task
+    uint64_t   seed;
+    Network   *net;            // The worker's own copy of the network
+} CsSim2Job;
+
+static CsSim2Job cs_sim2_job[CS_SIM2_NETWORKS];
+static int cs_sim2_running = 0;        // Workers yet to finish
+static guint cs_sim2_timer = 0;
 
 /******************************************************************************/
 
@@ -22,7 +40,6 @@ static int cs_sim2_results[3][10][NUM_VARIANTS];
 Boolean sim2_load_weights_from_disk(int net_count)
 {
     char file[64], buffer[128];
-    FILE *fp;
     Boolean success;
     int j;
 
@@ -30,13 +47,12 @@ Boolean sim2_load_weights_from_disk(int net_count)
 
     g_snprintf(file, 64, "Weights/srn_20000_%02d.wgt", net_count+1);
 
-    if ((fp = fopen(file, "r")) == NULL) {
+    if ((j = network_restore_weights_from_file(file, xg.net)) < 0) {
         g_snprintf(buffer, 128, "ERROR: Cannot read %s ... weights not restored", file);
         success = FALSE;
     }
-    else if ((j = network_restore_weights(fp, xg.net)) > 0) {
+    else if (j > 0) {
         g_snprintf(buffer, 128, "ERROR: Weight file format error %d ... weights not restored", j);
-        fclose(fp);
         success = FALSE;
     }
     else {
@@ -46,8 +62,6 @@ Boolean sim2_load_weights_from_disk(int net_count)
         /* Initialise the graph and various viewers: */
         //        xgraph_set_error_scores();
         //        initialise_widgets();
-
-        fclose(fp);
         success = TRUE;
     }
     fprintf(stdout, "%s\n", buffer);
@@ -56,47 +70,54 @@ Boolean sim2_load_weights_from_disk(int net_count)
 
 /******************************************************************************/
 
-static double mean_result(int j, int i)
+static void cs_sim2_snapshot(int snapshot[3][CS_SIM2_NETWORKS][NUM_VARIANTS])
+{
+    int i, j, l;
+
+    for (j = 0; j < 3; j++) {
+        for (l = 0; l < CS_SIM2_NETWORKS; l++) {
+            for (i = 0; i < NUM_VARIANTS; i++) {
+                snapshot[j][l][i] = __atomic_load_n(&cs_sim2_results[j][l][i], __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+static double mean_result(int snapshot[3][CS_SIM2_NETWORKS][NUM_VARIANTS], int j, int i)
 {
     double sum = 0;
     int l = 0;
 
-    for (l = 0; l < 10; l++) {
-        sum = sum + cs_sim2_results[j][l][i];
+    for (l = 0; l < CS_SIM2_NETWORKS; l++) {
+        sum = sum + snapshot[j][l][i];
     }
     return(sum / (double) l);
 }
 
 /*----------------------------------------------------------------------------*/
 
-static void load_weight_file(int l)
+static Boolean load_weight_file(int l, Network *net)
 {
     char file[64], buffer[128];
-    FILE *fp;
+    Boolean success = FALSE;
     int j;
 
     /* Set this by hand for each weight set: */
 
     g_snprintf(file, 64, "DATA_SIMULATION_2/weights_2_%d.dat", l);
 
-    if ((fp = fopen(file, "r")) == NULL) {
+    if ((j = network_restore_weights_from_file(file, net)) < 0) {
         g_snprintf(buffer, 128, "ERROR: Cannot read %s ... weights not restored", file);
     }
-    else if ((j = network_restore_weights(fp, xg.net)) > 0) {
+    else if (j > 0) {
         g_snprintf(buffer, 128, "ERROR: Weight file format error %d ... weights not restored", j);
-        fclose(fp);
     }
     else {
-        gtk_label_set_text(GTK_LABEL(xg.weight_history_label), file);
         g_snprintf(buffer, 128, "Weights successfully restored from %s", file);
-
-        /* Initialise the graph and various viewers: */
-        xgraph_set_error_scores();
-        initialise_widgets();
-
-        fclose(fp);
+        success = TRUE;
     }
     fprintf(stdout, "%s\n", buffer);
+    return(success);
 }
 
 /******************************************************************************/
@@ -107,6 +128,7 @@ static Boolean cs_sim2_viewer_expose(GtkWidget *widg, GdkEvent *event, void *dat
         return(TRUE);
     }
     else {
+        static int snapshot[3][CS_SIM2_NETWORKS][NUM_VARIANTS];
         PangoLayout *layout;
         cairo_t *cr;
         CairoxTextParameters tp;
@@ -114,6 +136,8 @@ static Boolean cs_sim2_viewer_expose(GtkWidget *widg, GdkEvent *event, void *dat
         char buffer[128];
         int y = 0, i, j, w;
 
+        cs_sim2_snapshot(snapshot);
+
         cr = cairo_create(viewer_surface);
         layout = pango_cairo_create_layout(cr);
         pangox_layout_set_font_size(layout, 12);
@@ -158,7 +182,7 @@ static Boolean cs_sim2_viewer_expose(GtkWidget *widg, GdkEvent *event, void *dat
 
             y = y + 5;
             for (i = 0; i < NUM_VARIANTS; i++) {
-                double mean = mean_result(j, i);
+                double mean = mean_result(snapshot, j, i);
                 g_snprintf(buffer, 128, "%4.1f", mean); y = y + 15;
                 cairox_text_parameters_set(&tp, 355+100*j, y, PANGOX_XALIGN_RIGHT, PANGOX_YALIGN_BOTTOM, 0.0);
                 cairox_paint_pango_text(cr, &tp, layout, buffer);
@@ -191,7 +215,7 @@ static void initialise_cs_sim2_results()
 {
     int i, j, l;
     for (j = 0; j < 3; j++) {
-        for (l = 0; l < 10; l++) {
+        for (l = 0; l < CS_SIM2_NETWORKS; l++) {
             for (i = 0; i < NUM_VARIANTS; i++) {
                 cs_sim2_results[j][l][i] = 0;
             }
@@ -199,64 +223,116 @@ static void initialise_cs_sim2_results()
     }
 }
 
-static int run_one_simulation()
+static int run_one_simulation(Network *net, WorldContext *wc, TaskType *task)
 {
     /* Run one simulation and categorise it according to the possible targets */
 
-    double *vector_in = (double *)malloc(IN_WIDTH * sizeof(double));
-    double *vector_out = (double *)malloc(OUT_WIDTH * sizeof(double));
-    int count = 0;
-    ActionType this[100];
+    double vector_in[IN_WIDTH];
+    double vector_out[OUT_WIDTH];
+    SequenceClassifier classifier;
+    ActionType action;
 
+    world_context_initialise(wc, task);
+    network_tell_randomise_hidden_units(net);
+
+    sequence_classifier_start(&classifier);
     do {
-        world_set_network_input_vector(vector_in);
-        network_tell_input(xg.net, vector_in);
-        network_tell_propagate2(xg.net);
-        network_ask_output(xg.net, vector_out);
-        this[count] = world_get_network_output_action(NULL, vector_out);
-        world_perform_action(this[count]);
-    } while ((this[count] != ACTION_SAY_DONE) && (count++ < 100));
-
-    free(vector_in);
-    free(vector_out);
-
-    return(categorise_action_sequence(this));
+        world_context_set_network_input_vector(wc, vector_in);
+        network_tell_input(net, vector_in);
+        network_tell_propagate2(net);
+        network_ask_output(net, vector_out);
+        action = world_get_network_output_action(NULL, vector_out);
+        world_context_perform_action(wc, action);
+    } while (!sequence_classifier_step(&classifier, action));
+
+    return(sequence_classifier_category(&classifier));
 }
 
-static void generate_results_for_n_runs(int l, long count)
+static void *cs_sim2_worker(void *data)
 {
+    CsSim2Job *job = (CsSim2Job *)data;
+    WorldContext *wc;
+    RandomStream rng;
     int tt, i, s;
 
-    for (i = 0; i < count; i++) {
-        for (tt = 0; tt < 3; tt++) {
-            TaskType task = {(BaseTaskType) tt, DAMAGE_NONE, {pars.sugar_closed, FALSE, FALSE, FALSE, FALSE}};
+    if (!load_weight_file(job->l, job->net)) {
+        // Nothing to do
+    }
+    else if ((wc = world_context_create()) == NULL) {
+        fprintf(stderr, "ERROR: Cannot create a world for weight set %d\n", job->l);
+    }
+    else {
+        random_stream_initialise(&rng, job->seed, job->l, 0, 0, 0);
+        random_stream_select(&rng);
+        for (i = 0; i < job->count; i++) {
+            for (tt = 0; tt < 3; tt++) {
+                TaskType task = {(BaseTaskType) tt, DAMAGE_NONE, {pars.sugar_closed, FALSE, FALSE, FALSE, FALSE}};
+
+                s = run_one_simulation(job->net, wc, &task);
+                __atomic_fetch_add(&cs_sim2_results[tt][job->l][s], 1, __ATOMIC_RELAXED);
+            }
+        }
+        random_stream_select(NULL);
+        world_context_free(wc);
+    }
+    __atomic_fetch_sub(&cs_sim2_running, 1, __ATOMIC_RELEASE);
+    return(NULL);
+}
+
+static gboolean cs_sim2_redraw_timeout(gpointer data)
+{
+    int l;
 
-            initialise_state(&task);
-            s = run_one_simulation();
-            cs_sim2_results[tt][l][s]++;
+    cs_sim2_viewer_expose(NULL, NULL, NULL);
+    if (__atomic_load_n(&cs_sim2_running, __ATOMIC_ACQUIRE) > 0) {
+        return(TRUE);
+    }
+    else {
+        /* All done: Collect the workers and stop the timer */
+        for (l = 0; l < CS_SIM2_NETWORKS; l++) {
+            pthread_join(cs_sim2_job[l].thread, NULL);
+            network_destroy(cs_sim2_job[l].net);
+            cs_sim2_job[l].net = NULL;
         }
-        cs_sim2_viewer_expose(NULL, NULL, NULL);
+        cs_sim2_timer = 0;
+        return(FALSE);
     }
 }
 
 static void generate_cs_sim2_results_callback(GtkWidget *mi, void *count)
 {
-    /* Here we iterate over five weight files and for each of the    */
-    /* states of the sugar bowl.                                     */
+    /* Here we run each of the ten weight files, concurrently, for the       */
+    /* current state of the sugar bowl.                                     */
 
+    uint64_t seed = ((uint64_t) rand() << 31) ^ (uint64_t) rand();
     int l = 0;
 
-    for (l = 0; l < 10; l++) {
-        load_weight_file(l);
-        generate_results_for_n_runs(l, (long) count);
+    if (cs_sim2_timer != 0) {
+        fprintf(stderr, "WARNING: Simulation 2 is already running\n");
+        return;
+    }
+
+    cs_sim2_running = CS_SIM2_NETWORKS;
+    for (l = 0; l < CS_SIM2_NETWORKS; l++) {
+        cs_sim2_job[l].l = l;
+        cs_sim2_job[l].count = (long) count;
+        cs_sim2_job[l].seed = seed;
+        cs_sim2_job[l].net = network_copy(xg.net);
+        pthread_create(&cs_sim2_job[l].thread, NULL, cs_sim2_worker, &cs_sim2_job[l]);
     }
+    cs_sim2_timer = g_timeout_add(REDRAW_INTERVAL, cs_sim2_redraw_timeout, NULL);
 }
 
 static void clear_cs_sim2_results_callback(GtkWidget *mi, void *dummy)
 {
-    initialise_cs_sim2_results();
-    if (viewer_widget != NULL) {
-        cs_sim2_viewer_expose(NULL, NULL, NULL);
+    if (cs_sim2_timer != 0) {
+        fprintf(stderr, "WARNING: Simulation 2 is running ... results not cleared\n");
+    }
+    else {
+        initialise_cs_sim2_results();
+        if (viewer_widget != NULL) {
+            cs_sim2_viewer_expose(NULL, NULL, NULL);
+        }
     }
 }
 
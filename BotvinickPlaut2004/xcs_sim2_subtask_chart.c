@@ -431,6 +431,22 @@ static void action_list_score(ActionType this[MAX_STEPS], TaskType *task, int n,
 
 /*----------------------------------------------------------------------------*/
 
+static DamageOverlay *sc_damage_attach(Network *net)
+{
+    /* Clear the damage overlay and attach it to net: */
+
+    static DamageOverlay *damage = NULL;
+
+    if (damage == NULL) {
+        damage = damage_overlay_create(net);
+    }
+    else {
+        damage_overlay_clear(damage);
+    }
+    network_tell_damage(net, damage);
+    return(damage);
+}
+
 static void sc_run_and_score_activation_noise(Network *net, TaskType *task, int n, int i)
 {
     double *vector_in, *vector_out;
@@ -474,7 +490,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int n
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ch(net, sc_dd[1].level[i]);
+    damage_overlay_perturb_weights_ch(sc_damage_attach(net), sc_dd[1].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -483,6 +499,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int n
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -505,7 +522,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Lesion the context to hidden connections: */
-    network_lesion_weights_ch(net, sc_dd[2].level[i]);
+    damage_overlay_lesion_weights_ch(sc_damage_attach(net), sc_dd[2].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -514,6 +531,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -536,7 +554,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int n
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ih(net, sc_dd[3].level[i]);
+    damage_overlay_perturb_weights_ih(sc_damage_attach(net), sc_dd[3].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -545,6 +563,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int n
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -567,7 +586,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Lesion the context to hidden connections: */
-    network_lesion_weights_ih(net, sc_dd[4].level[i]);
+    damage_overlay_lesion_weights_ih(sc_damage_attach(net), sc_dd[4].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -576,6 +595,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -598,7 +618,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int n,
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Ablate the context units: */
-    network_ablate_context(net, sc_dd[5].level[i]);
+    damage_overlay_ablate_context(sc_damage_attach(net), sc_dd[5].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -607,6 +627,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int n,
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -629,7 +650,7 @@ static void sc_run_and_score_weight_scaling(Network *net, TaskType *task, int n,
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Scale weights: */
-    network_scale_weights(net, sc_dd[6].level[i]);
+    damage_overlay_scale_weights(sc_damage_attach(net), sc_dd[6].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -638,6 +659,7 @@ static void sc_run_and_score_weight_scaling(Network *net, TaskType *task, int n,
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -892,128 +914,86 @@ static void viewer_widget_run_callback(GtkWidget *mi, void *count)
                     }
                 }
                 else if (sc_task.damage == DAMAGE_CH_WEIGHT_NOISE) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_noise(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_noise(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_noise(xg.net, &sc_task, net_count, i);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_CH_WEIGHT_LESION) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, net_count, i);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_IH_WEIGHT_NOISE) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_noise(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_noise(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_noise(xg.net, &sc_task, net_count, i);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_IH_WEIGHT_LESION) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, net_count, i);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_CONTEXT_ABLATE) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_context_ablate(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_context_ablate(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_context_ablate(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_context_ablate(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_context_ablate(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_context_ablate(xg.net, &sc_task, net_count, i);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_WEIGHT_SCALE) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_weight_scaling(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_weight_scaling(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_weight_scaling(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_weight_scaling(xg.net, &sc_task, net_count, i);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_weight_scaling(tmp_net, &sc_task, net_count, i);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_weight_scaling(xg.net, &sc_task, net_count, i);
                         }
                     }
                 }
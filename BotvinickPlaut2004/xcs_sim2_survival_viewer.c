@@ -3,6 +3,7 @@
 #include "lib_cairox_2_0.h"
 #include "lib_cairoxg_2_5.h"
 #include "xcs_sequences.h"
+#include "utils_maths.h"
 
 // Average data over a maximum of 12 networks;
 #define MAX_NETS 12
@@ -15,6 +16,14 @@ static cairo_surface_t *viewer_surface = NULL;
 static TaskType sv_task = {TASK_COFFEE, DAMAGE_ACTIVATION_NOISE, {FALSE, FALSE, FALSE, FALSE, FALSE}};
 static int sv_data[MAX_NETS][TASK_MAX][MAX_STEPS];
 static double sv_level = 0.000;
+static DamageOverlay *sv_damage = NULL;
+
+// Nested lesions: Each trial ranks the connections with a random stream that
+// depends only on the network, trial number and task, so running the same
+// number of trials at a higher level severs a superset of the connections:
+#define SV_NESTED_SEED 2004
+static Boolean sv_nested = FALSE;
+static int sv_trial = 0;
 
 static char *sv_label[7] = {
     "Activation Noise (s.d.)",
@@ -158,7 +167,9 @@ static void sv_run_and_score_ch_weight_noise(Network *net, int net_count, TaskTy
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ch(net, sv_level);
+    damage_overlay_clear(sv_damage);
+    damage_overlay_perturb_weights_ch(sv_damage, sv_level);
+    network_tell_damage(net, sv_damage);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -167,6 +178,7 @@ static void sv_run_and_score_ch_weight_noise(Network *net, int net_count, TaskTy
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -182,6 +194,16 @@ static void sv_run_and_score_ch_weight_noise(Network *net, int net_count, TaskTy
     }
 }
 
+static void sv_rank_connections(int net_count, TaskType *task)
+{
+    RandomStream rs;
+
+    random_stream_initialise(&rs, SV_NESTED_SEED, net_count, sv_trial, task->base, 0);
+    random_stream_select(&rs);
+    damage_overlay_rank_weights(sv_damage);
+    random_stream_select(NULL);
+}
+
 static void sv_run_and_score_ch_weight_lesion(Network *net, int net_count, TaskType *task)
 {
     double    *vector_in;
@@ -195,7 +217,15 @@ static void sv_run_and_score_ch_weight_lesion(Network *net, int net_count, TaskT
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Lesion the context to hidden connections: */
-    network_lesion_weights_ch(net, sv_level);
+    damage_overlay_clear(sv_damage);
+    if (sv_nested) {
+        sv_rank_connections(net_count, task);
+        damage_overlay_lesion_nested_ch(sv_damage, sv_level);
+    }
+    else {
+        damage_overlay_lesion_weights_ch(sv_damage, sv_level);
+    }
+    network_tell_damage(net, sv_damage);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -204,6 +234,7 @@ static void sv_run_and_score_ch_weight_lesion(Network *net, int net_count, TaskT
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -232,7 +263,9 @@ static void sv_run_and_score_ih_weight_noise(Network *net, int net_count, TaskTy
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ih(net, sv_level);
+    damage_overlay_clear(sv_damage);
+    damage_overlay_perturb_weights_ih(sv_damage, sv_level);
+    network_tell_damage(net, sv_damage);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -241,6 +274,7 @@ static void sv_run_and_score_ih_weight_noise(Network *net, int net_count, TaskTy
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -269,7 +303,15 @@ static void sv_run_and_score_ih_weight_lesion(Network *net, int net_count, TaskT
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Lesion the context to hidden connections: */
-    network_lesion_weights_ih(net, sv_level);
+    damage_overlay_clear(sv_damage);
+    if (sv_nested) {
+        sv_rank_connections(net_count, task);
+        damage_overlay_lesion_nested_ih(sv_damage, sv_level);
+    }
+    else {
+        damage_overlay_lesion_weights_ih(sv_damage, sv_level);
+    }
+    network_tell_damage(net, sv_damage);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -278,6 +320,7 @@ static void sv_run_and_score_ih_weight_lesion(Network *net, int net_count, TaskT
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -306,7 +349,9 @@ static void sv_run_and_score_context_ablate(Network *net, int net_count, TaskTyp
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Ablate units in the context layer: */
-    network_ablate_context(net, sv_level);
+    damage_overlay_clear(sv_damage);
+    damage_overlay_ablate_context(sv_damage, sv_level);
+    network_tell_damage(net, sv_damage);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -315,6 +360,7 @@ static void sv_run_and_score_context_ablate(Network *net, int net_count, TaskTyp
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -343,7 +389,9 @@ static void sv_run_and_score_weight_scale(Network *net, int net_count, TaskType
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Scale network weights: */
-    network_scale_weights(net, sv_level);
+    damage_overlay_clear(sv_damage);
+    damage_overlay_scale_weights(sv_damage, sv_level);
+    network_tell_damage(net, sv_damage);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -352,6 +400,7 @@ static void sv_run_and_score_weight_scale(Network *net, int net_count, TaskType
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -601,10 +650,13 @@ static void survival_viewer_run_callback(GtkWidget *mi, void *count)
 
     // Save existing network so it can be restored once we're done:
     saved_net = network_copy(xg.net);
+    // Damage is applied through an overlay, leaving the loaded weights intact:
+    sv_damage = damage_overlay_create(xg.net);
 
     while ((net_count < MAX_NETS) && (sim2_load_weights_from_disk(net_count))) {
         j = (long) count;
         while (j-- > 0) {
+            sv_trial = j;
             if (sv_task.damage == DAMAGE_ACTIVATION_NOISE) {
                 if (sv_task.base == TASK_MAX) {
                     sv_task.base = TASK_COFFEE;
@@ -618,117 +670,75 @@ static void survival_viewer_run_callback(GtkWidget *mi, void *count)
                 }
             }
             else if (sv_task.damage == DAMAGE_CH_WEIGHT_NOISE) {
-                Network *tmp_net;
                 if (sv_task.base == TASK_MAX) {
                     sv_task.base = TASK_COFFEE;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ch_weight_noise(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ch_weight_noise(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_TEA;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ch_weight_noise(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ch_weight_noise(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_MAX;
                 }
                 else if (sv_task.base != TASK_NONE) {
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ch_weight_noise(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ch_weight_noise(xg.net, net_count, &sv_task);
                 }
             }
             else if (sv_task.damage == DAMAGE_CH_WEIGHT_LESION) {
-                Network *tmp_net;
                 if (sv_task.base == TASK_MAX) {
                     sv_task.base = TASK_COFFEE;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ch_weight_lesion(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ch_weight_lesion(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_TEA;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ch_weight_lesion(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ch_weight_lesion(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_MAX;
                 }
                 else if (sv_task.base != TASK_NONE) {
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ch_weight_lesion(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ch_weight_lesion(xg.net, net_count, &sv_task);
                 }
             }
             else if (sv_task.damage == DAMAGE_IH_WEIGHT_NOISE) {
-                Network *tmp_net;
                 if (sv_task.base == TASK_MAX) {
                     sv_task.base = TASK_COFFEE;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ih_weight_noise(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ih_weight_noise(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_TEA;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ih_weight_noise(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ih_weight_noise(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_MAX;
                 }
                 else if (sv_task.base != TASK_NONE) {
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ih_weight_noise(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ih_weight_noise(xg.net, net_count, &sv_task);
                 }
             }
             else if (sv_task.damage == DAMAGE_IH_WEIGHT_LESION) {
-                Network *tmp_net;
                 if (sv_task.base == TASK_MAX) {
                     sv_task.base = TASK_COFFEE;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ih_weight_lesion(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ih_weight_lesion(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_TEA;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ih_weight_lesion(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ih_weight_lesion(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_MAX;
                 }
                 else if (sv_task.base != TASK_NONE) {
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_ih_weight_lesion(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_ih_weight_lesion(xg.net, net_count, &sv_task);
                 }
             }
             else if (sv_task.damage == DAMAGE_CONTEXT_ABLATE) {
-                Network *tmp_net;
                 if (sv_task.base == TASK_MAX) {
                     sv_task.base = TASK_COFFEE;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_context_ablate(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_context_ablate(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_TEA;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_context_ablate(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_context_ablate(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_MAX;
                 }
                 else if (sv_task.base != TASK_NONE) {
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_context_ablate(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_context_ablate(xg.net, net_count, &sv_task);
                 }
             }
             else if (sv_task.damage == DAMAGE_WEIGHT_SCALE) {
-                Network *tmp_net;
                 if (sv_task.base == TASK_MAX) {
                     sv_task.base = TASK_COFFEE;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_weight_scale(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_weight_scale(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_TEA;
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_weight_scale(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_weight_scale(xg.net, net_count, &sv_task);
                     sv_task.base = TASK_MAX;
                 }
                 else if (sv_task.base != TASK_NONE) {
-                    tmp_net = network_copy(xg.net);
-                    sv_run_and_score_weight_scale(tmp_net, net_count, &sv_task);
-                    network_tell_destroy(tmp_net);
+                    sv_run_and_score_weight_scale(xg.net, net_count, &sv_task);
                 }
             }
             else {
@@ -739,6 +749,8 @@ static void survival_viewer_run_callback(GtkWidget *mi, void *count)
     }
     // Expose the viewer
     survival_viewer_expose(NULL, NULL, NULL);
+    damage_overlay_destroy(sv_damage);
+    sv_damage = NULL;
     // Restore the saved network
     network_tell_destroy(xg.net);
     xg.net = saved_net;
@@ -755,6 +767,12 @@ static void set_damage_callback(GtkWidget *cb, void *dummy)
     survival_viewer_reset_callback(NULL, NULL);
 }
 
+static void callback_toggle_nested(GtkWidget *button, void *dummy)
+{
+    sv_nested = (Boolean) gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(button));
+    survival_viewer_reset_callback(NULL, NULL);
+}
+
 static void callback_spin_noise(GtkWidget *widget, GtkSpinButton *tmp)
 {
     sv_level = gtk_spin_button_get_value(tmp);
@@ -859,6 +877,13 @@ void create_bp_sim2_survival_plot_viewer(GtkWidget *vbox)
     g_signal_connect(G_OBJECT(adj), "value_changed", G_CALLBACK(callback_spin_noise), tmp);
     gtk_widget_show(tmp);
 
+    /*--- Nested connection lesions: ---*/
+    tmp = gtk_check_button_new_with_label("Nested");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(tmp), sv_nested);
+    g_signal_connect(G_OBJECT(tmp), "toggled", G_CALLBACK(callback_toggle_nested), NULL);
+    gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 3);
+    gtk_widget_show(tmp);
+
     /*--- Padding: ---*/
     tmp = gtk_label_new("");
     gtk_box_pack_start(GTK_BOX(hbox), tmp, TRUE, TRUE, 5);
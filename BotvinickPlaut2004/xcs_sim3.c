@@ -37,19 +37,17 @@ static double mean_result(int j, int i)
 static void load_weight_file(int l)
 {
     char file[64], buffer[128];
-    FILE *fp;
     int j;
 
     /* Set this by hand for each weight set: */
 
     g_snprintf(file, 64, "DATA_SIMULATION_3/weights_2%c_%d.dat", abc, l);
 
-    if ((fp = fopen(file, "r")) == NULL) {
+    if ((j = network_restore_weights_from_file(file, xg.net)) < 0) {
         g_snprintf(buffer, 128, "ERROR: Cannot read %s ... weights not restored", file);
     }
-    else if ((j = network_restore_weights(fp, xg.net)) > 0) {
+    else if (j > 0) {
         g_snprintf(buffer, 128, "ERROR: Weight file format error %d ... weights not restored", j);
-        fclose(fp);
     }
     else {
         gtk_label_set_text(GTK_LABEL(xg.weight_history_label), file);
@@ -58,8 +56,6 @@ static void load_weight_file(int l)
         /* Initialise the graph and various viewers: */
         xgraph_set_error_scores();
         initialise_widgets();
-
-        fclose(fp);
     }
     fprintf(stdout, "%s\n", buffer);
 }
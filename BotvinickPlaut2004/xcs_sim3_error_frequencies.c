@@ -45,11 +45,26 @@ static char *category_names[ERROR_CATEGORIES] = {
     "Bizarre"};
 
 extern void analyse_actions_with_acs1(TaskType *task, ACS1 *results);
-extern GList *analyse_actions_with_acs2(TaskType *task, ACS2 *results);
-extern void analyse_actions_code_free_error_list(GList *errors);
+extern void analyse_actions_count_with_acs2(TaskType *task, ACS2 *results);
 
 /******************************************************************************/
 
+static DamageOverlay *sc_damage_attach(Network *net)
+{
+    /* Clear the damage overlay and attach it to net: */
+
+    static DamageOverlay *damage = NULL;
+
+    if (damage == NULL) {
+        damage = damage_overlay_create(net);
+    }
+    else {
+        damage_overlay_clear(damage);
+    }
+    network_tell_damage(net, damage);
+    return(damage);
+}
+
 static void sc_run_and_score_activation_noise(Network *net, TaskType *task, int i)
 {
     double *vector_in = (double *)malloc(IN_WIDTH * sizeof(double));
@@ -58,7 +73,6 @@ static void sc_run_and_score_activation_noise(Network *net, TaskType *task, int
     ACS1        res1;
     ACS2        res2;
     int count = 0;
-    GList      *errors = NULL;
 
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
@@ -79,8 +93,7 @@ static void sc_run_and_score_activation_noise(Network *net, TaskType *task, int
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[i][0] += res2.omissions;
     sc_data[i][1] += res2.anticipations;
@@ -105,12 +118,11 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
     ACS1        res1;
     ACS2        res2;
     int count = 0;
-    GList      *errors = NULL;
 
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ch(net, sc_dd[1].level[i]);
+    damage_overlay_perturb_weights_ch(sc_damage_attach(net), sc_dd[1].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -119,6 +131,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
         this[count] = world_get_network_output_action(NULL, vector_out);
         world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -126,8 +139,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[i][0] += res2.omissions;
     sc_data[i][1] += res2.anticipations;
@@ -152,12 +164,11 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
     ACS1        res1;
     ACS2        res2;
     int count = 0;
-    GList      *errors = NULL;
 
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Just lesion the context to hidden connections: */
-    network_lesion_weights_ch(net, sc_dd[2].level[i]);
+    damage_overlay_lesion_weights_ch(sc_damage_attach(net), sc_dd[2].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -166,6 +177,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
         this[count] = world_get_network_output_action(NULL, vector_out);
         world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -173,8 +185,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[i][0] += res2.omissions;
     sc_data[i][1] += res2.anticipations;
@@ -199,12 +210,11 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
     ACS1        res1;
     ACS2        res2;
     int count = 0;
-    GList      *errors = NULL;
 
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ih(net, sc_dd[3].level[i]);
+    damage_overlay_perturb_weights_ih(sc_damage_attach(net), sc_dd[3].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -213,6 +223,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
         this[count] = world_get_network_output_action(NULL, vector_out);
         world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -220,8 +231,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[i][0] += res2.omissions;
     sc_data[i][1] += res2.anticipations;
@@ -246,12 +256,11 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
     ACS1        res1;
     ACS2        res2;
     int count = 0;
-    GList      *errors = NULL;
 
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Just lesion the context to hidden connections: */
-    network_lesion_weights_ih(net, sc_dd[4].level[i]);
+    damage_overlay_lesion_weights_ih(sc_damage_attach(net), sc_dd[4].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -260,6 +269,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
         this[count] = world_get_network_output_action(NULL, vector_out);
         world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -267,8 +277,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[i][0] += res2.omissions;
     sc_data[i][1] += res2.anticipations;
@@ -293,12 +302,11 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i)
     ACS1        res1;
     ACS2        res2;
     int count = 0;
-    GList      *errors = NULL;
 
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Ablate units in the context layer: */
-    network_ablate_context(net, sc_dd[5].level[i]);
+    damage_overlay_ablate_context(sc_damage_attach(net), sc_dd[5].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -307,6 +315,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i)
         this[count] = world_get_network_output_action(NULL, vector_out);
         world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -314,8 +323,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i)
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[i][0] += res2.omissions;
     sc_data[i][1] += res2.anticipations;
@@ -340,12 +348,11 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i)
     ACS1        res1;
     ACS2        res2;
     int count = 0;
-    GList      *errors = NULL;
 
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Scale network weights: */
-    network_scale_weights(net, sc_dd[6].level[i]);
+    damage_overlay_scale_weights(sc_damage_attach(net), sc_dd[6].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -354,6 +361,7 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i)
         this[count] = world_get_network_output_action(NULL, vector_out);
         world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -361,8 +369,7 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i)
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[i][0] += res2.omissions;
     sc_data[i][1] += res2.anticipations;
@@ -655,44 +662,32 @@ static void error_frequencies_table_step_callback(GtkWidget *mi, void *count)
         }
         else if (sc_task.damage == DAMAGE_CH_WEIGHT_NOISE) {
             for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
-                Network *tmp_net = network_copy(xg.net);
-                sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, i);
-                network_tell_destroy(tmp_net);
+                sc_run_and_score_ch_weight_noise(xg.net, &sc_task, i);
             }
 	}
         else if (sc_task.damage == DAMAGE_CH_WEIGHT_LESION) {
             for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
-                Network *tmp_net = network_copy(xg.net);
-                sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, i);
-                network_tell_destroy(tmp_net);
+                sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, i);
             }
 	}
         else if (sc_task.damage == DAMAGE_IH_WEIGHT_NOISE) {
             for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
-                Network *tmp_net = network_copy(xg.net);
-                sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, i);
-                network_tell_destroy(tmp_net);
+                sc_run_and_score_ih_weight_noise(xg.net, &sc_task, i);
             }
 	}
         else if (sc_task.damage == DAMAGE_IH_WEIGHT_LESION) {
             for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
-                Network *tmp_net = network_copy(xg.net);
-                sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, i);
-                network_tell_destroy(tmp_net);
+                sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, i);
             }
 	}
         else if (sc_task.damage == DAMAGE_CONTEXT_ABLATE) {
             for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
-                Network *tmp_net = network_copy(xg.net);
-                sc_run_and_score_context_ablate(tmp_net, &sc_task, i);
-                network_tell_destroy(tmp_net);
+                sc_run_and_score_context_ablate(xg.net, &sc_task, i);
             }
         }
         else if (sc_task.damage == DAMAGE_WEIGHT_SCALE) {
             for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
-                Network *tmp_net = network_copy(xg.net);
-                sc_run_and_score_weight_scale(tmp_net, &sc_task, i);
-                network_tell_destroy(tmp_net);
+                sc_run_and_score_weight_scale(xg.net, &sc_task, i);
             }
         }
         else {
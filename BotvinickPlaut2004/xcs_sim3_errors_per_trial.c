@@ -38,8 +38,7 @@ static DamageDetails sc_dd[7] = {
 static int vertical_scale = 5;
 
 extern void analyse_actions_with_acs1(TaskType *task, ACS1 *results);
-extern GList *analyse_actions_with_acs2(TaskType *task, ACS2 *results);
-extern void analyse_actions_code_free_error_list(GList *errors);
+extern void analyse_actions_count_with_acs2(TaskType *task, ACS2 *results);
 
 static GraphStruct *errors_per_trial_chart;
 
@@ -48,6 +47,22 @@ extern Boolean sim2_load_weights_from_disk(int net_count);
 
 /******************************************************************************/
 
+static DamageOverlay *sc_damage_attach(Network *net)
+{
+    /* Clear the damage overlay and attach it to net: */
+
+    static DamageOverlay *damage = NULL;
+
+    if (damage == NULL) {
+        damage = damage_overlay_create(net);
+    }
+    else {
+        damage_overlay_clear(damage);
+    }
+    network_tell_damage(net, damage);
+    return(damage);
+}
+
 static void sc_run_and_score_activation_noise(Network *net, TaskType *task, int i, int nw)
 {
     double    *vector_in;
@@ -56,7 +71,6 @@ static void sc_run_and_score_activation_noise(Network *net, TaskType *task, int
     ACS1       res1;
     ACS2       res2;
     int        count = 0;
-    GList     *errors = NULL;
 
     vector_in = (double *)malloc(net->in_width * sizeof(double));
     vector_out = (double *)malloc(net->out_width * sizeof(double));
@@ -80,8 +94,7 @@ static void sc_run_and_score_activation_noise(Network *net, TaskType *task, int
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[nw][task->base][i][0] += res2.omissions;
     sc_data[nw][task->base][i][1] += res2.anticipations;
@@ -103,7 +116,6 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
     ACS1       res1;
     ACS2       res2;
     int        count = 0;
-    GList     *errors = NULL;
 
     vector_in = (double *)malloc(net->in_width * sizeof(double));
     vector_out = (double *)malloc(net->out_width * sizeof(double));
@@ -111,7 +123,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ch(net, sc_dd[1].level[i]);
+    damage_overlay_perturb_weights_ch(sc_damage_attach(net), sc_dd[1].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -120,6 +132,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -127,8 +140,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[nw][task->base][i][0] += res2.omissions;
     sc_data[nw][task->base][i][1] += res2.anticipations;
@@ -150,7 +162,6 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
     ACS1       res1;
     ACS2       res2;
     int        count = 0;
-    GList     *errors = NULL;
 
     vector_in = (double *)malloc(net->in_width * sizeof(double));
     vector_out = (double *)malloc(net->out_width * sizeof(double));
@@ -158,7 +169,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Lesion the context to hidden connections: */
-    network_lesion_weights_ch(net, sc_dd[2].level[i]);
+    damage_overlay_lesion_weights_ch(sc_damage_attach(net), sc_dd[2].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -167,6 +178,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -174,8 +186,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[nw][task->base][i][0] += res2.omissions;
     sc_data[nw][task->base][i][1] += res2.anticipations;
@@ -197,7 +208,6 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
     ACS1       res1;
     ACS2       res2;
     int        count = 0;
-    GList     *errors = NULL;
 
     vector_in = (double *)malloc(net->in_width * sizeof(double));
     vector_out = (double *)malloc(net->out_width * sizeof(double));
@@ -205,7 +215,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ih(net, sc_dd[3].level[i]);
+    damage_overlay_perturb_weights_ih(sc_damage_attach(net), sc_dd[3].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -214,6 +224,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -221,8 +232,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[nw][task->base][i][0] += res2.omissions;
     sc_data[nw][task->base][i][1] += res2.anticipations;
@@ -244,7 +254,6 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
     ACS1       res1;
     ACS2       res2;
     int        count = 0;
-    GList     *errors = NULL;
 
     vector_in = (double *)malloc(net->in_width * sizeof(double));
     vector_out = (double *)malloc(net->out_width * sizeof(double));
@@ -252,7 +261,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Lesion the context to hidden connections: */
-    network_lesion_weights_ih(net, sc_dd[4].level[i]);
+    damage_overlay_lesion_weights_ih(sc_damage_attach(net), sc_dd[4].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -261,6 +270,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -268,8 +278,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[nw][task->base][i][0] += res2.omissions;
     sc_data[nw][task->base][i][1] += res2.anticipations;
@@ -291,7 +300,6 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i,
     ACS1       res1;
     ACS2       res2;
     int        count = 0;
-    GList     *errors = NULL;
 
     vector_in = (double *)malloc(net->in_width * sizeof(double));
     vector_out = (double *)malloc(net->out_width * sizeof(double));
@@ -299,7 +307,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i,
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Remove context units */
-    network_ablate_context(net, sc_dd[5].level[i]);
+    damage_overlay_ablate_context(sc_damage_attach(net), sc_dd[5].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -308,6 +316,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i,
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -315,8 +324,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i,
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[nw][task->base][i][0] += res2.omissions;
     sc_data[nw][task->base][i][1] += res2.anticipations;
@@ -338,7 +346,6 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i, i
     ACS1       res1;
     ACS2       res2;
     int        count = 0;
-    GList     *errors = NULL;
 
     vector_in = (double *)malloc(net->in_width * sizeof(double));
     vector_out = (double *)malloc(net->out_width * sizeof(double));
@@ -346,7 +353,7 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i, i
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Scale network weights */
-    network_scale_weights(net, sc_dd[6].level[i]);
+    damage_overlay_scale_weights(sc_damage_attach(net), sc_dd[6].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -355,6 +362,7 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i, i
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -362,8 +370,7 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i, i
     /* Now score the actions: */
 
     analyse_actions_with_acs1(task, &res1);
-    errors = analyse_actions_with_acs2(task, &res2);
-    analyse_actions_code_free_error_list(errors);
+    analyse_actions_count_with_acs2(task, &res2);
 
     sc_data[nw][task->base][i][0] += res2.omissions;
     sc_data[nw][task->base][i][1] += res2.anticipations;
@@ -613,128 +620,86 @@ static void errors_per_trial_chart_step_callback(GtkWidget *mi, void *count)
                     }
                 }
                 else if (sc_task.damage == DAMAGE_CH_WEIGHT_NOISE) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_noise(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_noise(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_noise(xg.net, &sc_task, i, net_count);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_CH_WEIGHT_LESION) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, i, net_count);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_IH_WEIGHT_NOISE) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_noise(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_noise(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_noise(xg.net, &sc_task, i, net_count);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_IH_WEIGHT_LESION) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, i, net_count);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_CONTEXT_ABLATE) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_context_ablate(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_context_ablate(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_context_ablate(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_context_ablate(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_context_ablate(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_context_ablate(xg.net, &sc_task, i, net_count);
                         }
                     }
                 }
                 else if (sc_task.damage == DAMAGE_WEIGHT_SCALE) {
-                    Network *tmp_net = NULL;
                     for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                         if (sc_task.base == TASK_MAX) {
                             sc_task.base = TASK_COFFEE;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_weight_scale(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_weight_scale(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_TEA;
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_weight_scale(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_weight_scale(xg.net, &sc_task, i, net_count);
                             sc_task.base = TASK_MAX;
                         }
                         else {
-                            tmp_net = network_copy(xg.net);
-                            sc_run_and_score_weight_scale(tmp_net, &sc_task, i, net_count);
-                            network_tell_destroy(tmp_net);
+                            sc_run_and_score_weight_scale(xg.net, &sc_task, i, net_count);
                         }
                     }
                 }
@@ -43,6 +43,22 @@ static GraphStruct *independents_chart;
 
 /******************************************************************************/
 
+static DamageOverlay *sc_damage_attach(Network *net)
+{
+    /* Clear the damage overlay and attach it to net: */
+
+    static DamageOverlay *damage = NULL;
+
+    if (damage == NULL) {
+        damage = damage_overlay_create(net);
+    }
+    else {
+        damage_overlay_clear(damage);
+    }
+    network_tell_damage(net, damage);
+    return(damage);
+}
+
 static void sc_run_and_score_activation_noise(Network *net, TaskType *task, int i, int nc)
 {
     double     *vector_in;
@@ -94,7 +110,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ch(net, sc_dd[1].level[i]);
+    damage_overlay_perturb_weights_ch(sc_damage_attach(net), sc_dd[1].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -103,6 +119,7 @@ static void sc_run_and_score_ch_weight_noise(Network *net, TaskType *task, int i
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -132,7 +149,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Lesion the context to hidden connections: */
-    network_lesion_weights_ch(net, sc_dd[2].level[i]);
+    damage_overlay_lesion_weights_ch(sc_damage_attach(net), sc_dd[2].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -141,6 +158,7 @@ static void sc_run_and_score_ch_weight_lesion(Network *net, TaskType *task, int
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -170,7 +188,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Add noise to context to hidden connections: */
-    network_perturb_weights_ih(net, sc_dd[3].level[i]);
+    damage_overlay_perturb_weights_ih(sc_damage_attach(net), sc_dd[3].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -179,6 +197,7 @@ static void sc_run_and_score_ih_weight_noise(Network *net, TaskType *task, int i
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -208,7 +227,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Lesion the context to hidden connections: */
-    network_lesion_weights_ih(net, sc_dd[4].level[i]);
+    damage_overlay_lesion_weights_ih(sc_damage_attach(net), sc_dd[4].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -217,6 +236,7 @@ static void sc_run_and_score_ih_weight_lesion(Network *net, TaskType *task, int
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -246,7 +266,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i,
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Ablate the context units: */
-    network_ablate_context(net, sc_dd[5].level[i]);
+    damage_overlay_ablate_context(sc_damage_attach(net), sc_dd[5].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -255,6 +275,7 @@ static void sc_run_and_score_context_ablate(Network *net, TaskType *task, int i,
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -284,7 +305,7 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i, i
     world_initialise(task);
     network_tell_randomise_hidden_units(net);
     /* Scale weights: */
-    network_scale_weights(net, sc_dd[6].level[i]);
+    damage_overlay_scale_weights(sc_damage_attach(net), sc_dd[6].level[i]);
     do {
 	world_set_network_input_vector(vector_in);
 	network_tell_input(net, vector_in);
@@ -293,6 +314,7 @@ static void sc_run_and_score_weight_scale(Network *net, TaskType *task, int i, i
 	this[count] = world_get_network_output_action(NULL, vector_out);
 	world_perform_action(this[count]);
     } while ((this[count] != ACTION_SAY_DONE) && (++count < MAX_STEPS));
+    network_tell_damage(net, NULL);
 
     free(vector_in);
     free(vector_out);
@@ -537,128 +559,86 @@ static void independents_chart_step_callback(GtkWidget *mi, void *count)
                 }
             }
             else if (sc_task.damage == DAMAGE_CH_WEIGHT_NOISE) {
-                Network *tmp_net;
                 for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                     if (sc_task.base == TASK_MAX) {
                         sc_task.base = TASK_COFFEE;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ch_weight_noise(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_TEA;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ch_weight_noise(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_MAX;
                     }
                     else if (sc_task.base != TASK_NONE) {
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ch_weight_noise(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ch_weight_noise(xg.net, &sc_task, i, net_count);
                     }
                 }
             }
             else if (sc_task.damage == DAMAGE_CH_WEIGHT_LESION) {
-                Network *tmp_net;
                 for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                     if (sc_task.base == TASK_MAX) {
                         sc_task.base = TASK_COFFEE;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_TEA;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_MAX;
                     }
                     else if (sc_task.base != TASK_NONE) {
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ch_weight_lesion(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ch_weight_lesion(xg.net, &sc_task, i, net_count);
                     }
                 }
             }
             else if (sc_task.damage == DAMAGE_IH_WEIGHT_NOISE) {
-                Network *tmp_net;
                 for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                     if (sc_task.base == TASK_MAX) {
                         sc_task.base = TASK_COFFEE;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ih_weight_noise(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_TEA;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ih_weight_noise(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_MAX;
                     }
                     else if (sc_task.base != TASK_NONE) {
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ih_weight_noise(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ih_weight_noise(xg.net, &sc_task, i, net_count);
                     }
                 }
             }
             else if (sc_task.damage == DAMAGE_IH_WEIGHT_LESION) {
-                Network *tmp_net;
                 for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                     if (sc_task.base == TASK_MAX) {
                         sc_task.base = TASK_COFFEE;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_TEA;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_MAX;
                     }
                     else if (sc_task.base != TASK_NONE) {
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_ih_weight_lesion(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_ih_weight_lesion(xg.net, &sc_task, i, net_count);
                     }
                 }
             }
             else if (sc_task.damage == DAMAGE_CONTEXT_ABLATE) {
-                Network *tmp_net;
                 for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                     if (sc_task.base == TASK_MAX) {
                         sc_task.base = TASK_COFFEE;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_context_ablate(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_context_ablate(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_TEA;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_context_ablate(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_context_ablate(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_MAX;
                     }
                     else if (sc_task.base != TASK_NONE) {
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_context_ablate(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_context_ablate(xg.net, &sc_task, i, net_count);
                     }
                 }
             }
             else if (sc_task.damage == DAMAGE_WEIGHT_SCALE) {
-                Network *tmp_net;
                 for (i = 0; i < sc_dd[sc_task.damage-1].num_levels; i++) {
                     if (sc_task.base == TASK_MAX) {
                         sc_task.base = TASK_COFFEE;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_weight_scale(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_weight_scale(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_TEA;
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_weight_scale(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_weight_scale(xg.net, &sc_task, i, net_count);
                         sc_task.base = TASK_MAX;
                     }
                     else if (sc_task.base != TASK_NONE) {
-                        tmp_net = network_copy(xg.net);
-                        sc_run_and_score_weight_scale(tmp_net, &sc_task, i, net_count);
-                        network_tell_destroy(tmp_net);
+                        sc_run_and_score_weight_scale(xg.net, &sc_task, i, net_count);
                     }
                 }
             }
@@ -28,6 +28,9 @@ extern void create_bp_independents_chart_viewer(GtkWidget *vbox);
 extern void create_bp_error_frequencies_viewer(GtkWidget *vbox);
 extern void create_bp_errors_per_trial_viewer(GtkWidget *vbox);
 extern GtkWidget *create_jb_analysis_page();
+#ifdef PROFILE
+extern void create_profile_viewer(GtkWidget *vbox);
+#endif
 
 XGlobals xg =   {NULL,
                  NULL,
@@ -88,15 +91,13 @@ static void select_weight_file(GtkWidget *w, GtkWidget *chooser)
 {
     char *file = (char *)gtk_file_selection_get_filename(GTK_FILE_SELECTION(chooser));
     char buffer[128];
-    FILE *fp;
     int j;
 
-    if ((fp = fopen(file, "r")) == NULL) {
+    if ((j = network_restore_weights_from_file(file, xg.net)) < 0) {
         g_snprintf(buffer, 128, "ERROR: Cannot read file ... weights not restored");
     }
-    else if ((j = network_restore_weights(fp, xg.net)) > 0) {
+    else if (j > 0) {
         g_snprintf(buffer, 128, "ERROR: Weight file format error %d ... weights not restored", j);
-        fclose(fp);
     }
     else {
         gtk_label_set_text(GTK_LABEL(xg.weight_history_label), file);
@@ -105,8 +106,6 @@ static void select_weight_file(GtkWidget *w, GtkWidget *chooser)
         /* Initialise the graph and various viewers: */
         xgraph_set_error_scores();
         initialise_widgets();
-
-        fclose(fp);
     }
     gtkx_warn(chooser, buffer);
     gtk_widget_destroy(chooser);
@@ -212,6 +211,9 @@ int reload_training_data(char *file)
 {
     training_set_free(xg.first);
     xg.first = xtraining_set_read(file, IN_WIDTH, OUT_WIDTH);
+    if (xg.net != NULL) {
+        network_reserve_bptt_workspace(xg.net, sequence_list_max_length(xg.first));
+    }
     return(training_set_length(xg.first));
 }
 
@@ -767,12 +769,24 @@ GtkWidget *make_widgets()
     gtk_notebook_append_page(GTK_NOTEBOOK(notes), page, gtk_label_new("JB Analysis"));
     gtk_widget_show(page);
 
+#ifdef PROFILE
+    /* Page A8: Phase-level profile (only when built with -DPROFILE): */
+
+    page = gtk_vbox_new(FALSE, 0);
+    create_profile_viewer(page);
+    gtk_notebook_append_page(GTK_NOTEBOOK(notes), page, gtk_label_new("Profile"));
+    gtk_widget_show(page);
+#endif
+
     /* End of notebook pages */
 
     gtk_widget_show(notes);
  
     xg.first = xtraining_set_read(TRAINING_SET, IN_WIDTH, OUT_WIDTH);
     xg.net = network_create(IN_WIDTH, HIDDEN_WIDTH, OUT_WIDTH);
+    if (xg.net != NULL) {
+        network_reserve_bptt_workspace(xg.net, sequence_list_max_length(xg.first));
+    }
 
     gtk_window_set_position(GTK_WINDOW(xg.frame), GTK_WIN_POS_CENTER);
     return(xg.frame);
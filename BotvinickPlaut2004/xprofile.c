@@ -0,0 +1,196 @@
+#include "xframe.h"
+#include "lib_cairox_2_0.h"
+#include "lib_profile.h"
+
+/******************************************************************************/
+
+/* A live view of the phase-level profile (see lib_profile.h). The table is */
+/* redrawn from the counters twice a second while the page is visible, so   */
+/* it follows training or an analysis as it runs.                           */
+
+static GtkWidget *viewer_widget = NULL;
+static cairo_surface_t *viewer_surface = NULL;
+static guint profile_timer = 0;
+
+#define REFRESH_INTERVAL 500    /* Milliseconds between refreshes */
+
+/******************************************************************************/
+
+static void paint_histogram(cairo_t *cr, ProfileSummary *s, int x, int y)
+{
+    /* One bar per duration bucket, scaled to the fullest bucket: */
+
+    uint64_t most = 0;
+    int b;
+
+    for (b = 0; b < PROFILE_BUCKETS; b++) {
+        most = MAX(most, s->histogram[b]);
+    }
+    cairo_set_source_rgb(cr, 0.8, 0.8, 0.8);
+    cairo_rectangle(cr, x, y-12, 4*PROFILE_BUCKETS, 12);
+    cairo_stroke(cr);
+    if (most > 0) {
+        cairo_set_source_rgb(cr, 0.2, 0.4, 0.8);
+        for (b = 0; b < PROFILE_BUCKETS; b++) {
+            double h = 12.0 * s->histogram[b] / (double) most;
+            cairo_rectangle(cr, x+4*b, y-h, 3, h);
+        }
+        cairo_fill(cr);
+    }
+    cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+}
+
+static Boolean profile_viewer_expose(GtkWidget *widg, GdkEvent *event, void *data)
+{
+    if (!GTK_WIDGET_MAPPED(viewer_widget) || (viewer_surface == NULL)) {
+        return(TRUE);
+    }
+    else {
+        char *heading[5] = {"Phase", "Calls", "Total (s)", "Mean (us)", "Max (ms)"};
+        int column[5] = {10, 230, 330, 430, 530};
+        ProfileSummary summary[PROFILE_MAX];
+        PangoLayout *layout;
+        cairo_t *cr;
+        CairoxTextParameters tp;
+        CairoxLineParameters lp;
+        char buffer[128];
+        int y = 15, p, c, threads;
+
+        threads = profile_summarise(summary);
+
+        cr = cairo_create(viewer_surface);
+        layout = pango_cairo_create_layout(cr);
+        pangox_layout_set_font_size(layout, 12);
+
+        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+        cairo_paint(cr);
+        cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+
+        cairox_text_parameters_set(&tp, column[0], y, PANGOX_XALIGN_LEFT, PANGOX_YALIGN_BOTTOM, 0.0);
+        cairox_paint_pango_text(cr, &tp, layout, heading[0]);
+        for (c = 1; c < 5; c++) {
+            cairox_text_parameters_set(&tp, column[c], y, PANGOX_XALIGN_RIGHT, PANGOX_YALIGN_BOTTOM, 0.0);
+            cairox_paint_pango_text(cr, &tp, layout, heading[c]);
+        }
+        cairox_text_parameters_set(&tp, 560, y, PANGOX_XALIGN_LEFT, PANGOX_YALIGN_BOTTOM, 0.0);
+        cairox_paint_pango_text(cr, &tp, layout, "Durations (1ns to 4s, log scale)");
+        cairox_line_parameters_set(&lp, 1.0, LS_SOLID, FALSE);
+        cairox_paint_line(cr, &lp, 5, y+2, 560+4*PROFILE_BUCKETS+100, y+2);
+
+        y = y + 5;
+        for (p = 0; p < PROFILE_MAX; p++) {
+            y = y + 18;
+            cairox_text_parameters_set(&tp, column[0], y, PANGOX_XALIGN_LEFT, PANGOX_YALIGN_BOTTOM, 0.0);
+            cairox_paint_pango_text(cr, &tp, layout, profile_phase_name[p]);
+
+            g_snprintf(buffer, 128, "%llu", (unsigned long long) summary[p].calls);
+            cairox_text_parameters_set(&tp, column[1], y, PANGOX_XALIGN_RIGHT, PANGOX_YALIGN_BOTTOM, 0.0);
+            cairox_paint_pango_text(cr, &tp, layout, buffer);
+
+            g_snprintf(buffer, 128, "%.3f", summary[p].total_ns * 1e-9);
+            cairox_text_parameters_set(&tp, column[2], y, PANGOX_XALIGN_RIGHT, PANGOX_YALIGN_BOTTOM, 0.0);
+            cairox_paint_pango_text(cr, &tp, layout, buffer);
+
+            g_snprintf(buffer, 128, "%.2f", (summary[p].calls > 0) ? summary[p].total_ns * 1e-3 / (double) summary[p].calls : 0.0);
+            cairox_text_parameters_set(&tp, column[3], y, PANGOX_XALIGN_RIGHT, PANGOX_YALIGN_BOTTOM, 0.0);
+            cairox_paint_pango_text(cr, &tp, layout, buffer);
+
+            g_snprintf(buffer, 128, "%.3f", summary[p].max_ns * 1e-6);
+            cairox_text_parameters_set(&tp, column[4], y, PANGOX_XALIGN_RIGHT, PANGOX_YALIGN_BOTTOM, 0.0);
+            cairox_paint_pango_text(cr, &tp, layout, buffer);
+
+            paint_histogram(cr, &summary[p], 560, y-2);
+        }
+
+        y = y + 30;
+        g_snprintf(buffer, 128, "Counted over %d thread%s. Nested phases overlap, so totals need not sum to the elapsed time.", threads, (threads == 1) ? "" : "s");
+        cairox_text_parameters_set(&tp, column[0], y, PANGOX_XALIGN_LEFT, PANGOX_YALIGN_BOTTOM, 0.0);
+        cairox_paint_pango_text(cr, &tp, layout, buffer);
+
+        g_object_unref(layout);
+        cairo_destroy(cr);
+
+        /* Now copy the surface to the window: */
+        if ((viewer_widget->window != NULL) && ((cr = gdk_cairo_create(viewer_widget->window)) != NULL)) {
+            cairo_set_source_surface(cr, viewer_surface, 0, 0);
+            cairo_paint(cr);
+            cairo_destroy(cr);
+        }
+        return(FALSE);
+    }
+}
+
+/******************************************************************************/
+
+static gboolean profile_refresh_timeout(void *data)
+{
+    /* The expose does nothing while the page is hidden: */
+
+    profile_viewer_expose(NULL, NULL, NULL);
+    return(TRUE);
+}
+
+static void reset_profile_callback(GtkWidget *mi, void *dummy)
+{
+    profile_reset();
+    profile_viewer_expose(NULL, NULL, NULL);
+}
+
+static void save_profile_callback(GtkWidget *mi, void *dummy)
+{
+    FILE *fp;
+
+    if ((fp = fopen("xbp_profile_snapshot.dat", "w")) == NULL) {
+        fprintf(stderr, "WARNING: Cannot write profile to xbp_profile_snapshot.dat\n");
+    }
+    else {
+        profile_write_report(fp);
+        fclose(fp);
+        fprintf(stdout, "Profile saved to xbp_profile_snapshot.dat\n");
+    }
+}
+
+static void destroy_profile_viewer_callback(GtkWidget *widget, void *dummy)
+{
+    if (profile_timer != 0) {
+        g_source_remove(profile_timer);
+        profile_timer = 0;
+    }
+}
+
+void create_profile_viewer(GtkWidget *vbox)
+{
+    GtkWidget *page = gtk_vbox_new(FALSE, 0);
+    GtkWidget *toolbar, *hbox;
+
+    hbox = gtk_hbox_new(FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(page), hbox, FALSE, FALSE, 0);
+    gtk_widget_show(hbox);
+
+    toolbar = gtk_toolbar_new();
+    gtk_toolbar_set_style(GTK_TOOLBAR(toolbar), GTK_TOOLBAR_TEXT);
+    gtk_toolbar_set_orientation(GTK_TOOLBAR(toolbar), GTK_ORIENTATION_HORIZONTAL);
+    gtk_box_pack_start(GTK_BOX(hbox), toolbar, FALSE, FALSE, 0);
+    gtk_widget_show(toolbar);
+
+    gtk_toolbar_append_item(GTK_TOOLBAR(toolbar), "Reset", NULL, NULL, NULL, G_CALLBACK(reset_profile_callback), NULL);
+    gtk_toolbar_append_item(GTK_TOOLBAR(toolbar), "Save", NULL, NULL, NULL, G_CALLBACK(save_profile_callback), NULL);
+
+    /* The viewer: */
+
+    viewer_widget = gtk_drawing_area_new();
+    g_signal_connect(G_OBJECT(viewer_widget), "expose_event", G_CALLBACK(profile_viewer_expose), NULL);
+    g_signal_connect(G_OBJECT(viewer_widget), "configure_event", G_CALLBACK(gtkx_configure_surface_callback), &viewer_surface);
+    g_signal_connect(G_OBJECT(viewer_widget), "destroy", G_CALLBACK(gtkx_destroy_surface_callback), &viewer_surface);
+    g_signal_connect(G_OBJECT(viewer_widget), "destroy", G_CALLBACK(destroy_profile_viewer_callback), NULL);
+    gtk_widget_set_events(viewer_widget, GDK_EXPOSURE_MASK);
+    gtk_box_pack_start(GTK_BOX(page), viewer_widget, TRUE, TRUE, 0);
+    gtk_widget_show(viewer_widget);
+
+    gtk_container_add(GTK_CONTAINER(vbox), page);
+    gtk_widget_show(page);
+
+    profile_timer = g_timeout_add(REFRESH_INTERVAL, profile_refresh_timeout, NULL);
+}
+
+/******************************************************************************/
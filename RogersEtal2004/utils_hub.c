@@ -15,6 +15,9 @@ Why isn't this lib_network.c???
 #include "lib_maths.h"
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "lib_string.h"
 
 #define BIAS -2.0
@@ -371,6 +374,49 @@ PatternList *pattern_list_get_best_name_match(PatternList *patterns, double *vec
 /* Create/destroy/copy a network: *********************************************/
 /******************************************************************************/
 
+static void network_free_workspace(Network *n)
+{
+    if (n->work_hidden != NULL) { free(n->work_hidden); }
+    if (n->work_error != NULL) { free(n->work_error); }
+    if (n->work_out != NULL) { free(n->work_out); }
+    if (n->work_delta != NULL) { free(n->work_delta); }
+    if (n->work_epsilon != NULL) { free(n->work_epsilon); }
+    n->work_hidden = NULL;
+    n->work_error = NULL;
+    n->work_out = NULL;
+    n->work_delta = NULL;
+    n->work_epsilon = NULL;
+    n->work_cycles = -1;
+}
+
+static Boolean network_reserve_workspace(Network *n, int cycles)
+{
+    /* Make sure the workspace can hold the history of a settling sequence */
+    /* of the given length (plus two cycles of lag). It only ever grows, so */
+    /* after the first pattern training makes no further heap allocations. */
+    /* For FF networks (cycles = 0) the space only holds output deltas:    */
+
+    int units = n->hidden_width + n->out_width;
+
+    if (cycles <= n->work_cycles) {
+        return(TRUE);
+    }
+
+    network_free_workspace(n);
+    n->work_hidden = (double *)malloc((cycles+2) * n->hidden_width * sizeof(double));
+    n->work_error = (double *)malloc((cycles+2) * n->out_width * sizeof(double));
+    n->work_out = (double *)malloc((cycles+2) * n->out_width * sizeof(double));
+    n->work_delta = (double *)malloc((cycles+2) * units * sizeof(double));
+    n->work_epsilon = (double *)malloc((cycles+2) * units * sizeof(double));
+
+    if ((n->work_hidden == NULL) || (n->work_error == NULL) || (n->work_out == NULL) || (n->work_delta == NULL) || (n->work_epsilon == NULL)) {
+        network_free_workspace(n);
+        return(FALSE);
+    }
+    n->work_cycles = cycles;
+    return(TRUE);
+}
+
 void network_destroy(Network *n)
 {
     /* Generalised Version (FF and SRN): */
@@ -389,6 +435,7 @@ void network_destroy(Network *n)
         if (n->previous_ih_deltas != NULL) { free(n->previous_ih_deltas); }
         if (n->previous_hh_deltas != NULL) { free(n->previous_hh_deltas); }
         if (n->previous_ho_deltas != NULL) { free(n->previous_ho_deltas); }
+        network_free_workspace(n);
         free(n);
     }
 }
@@ -470,6 +517,7 @@ Network *network_create(NetworkType nt, int iw, int hw, int ow)
         n->nt = nt;
         n->settled = FALSE;
         n->cycles = 0;
+        n->damage = NULL;
 
         /* 1. Weights: */
 
@@ -516,6 +564,14 @@ Network *network_create(NetworkType nt, int iw, int hw, int ow)
         }
         n->previous_ho_deltas = (double *)malloc((n->hidden_width+1) * n->out_width * sizeof(double));
 
+        /* The training workspace is allocated when first needed: */
+        n->work_cycles = -1;
+        n->work_hidden = NULL;
+        n->work_error = NULL;
+        n->work_out = NULL;
+        n->work_delta = NULL;
+        n->work_epsilon = NULL;
+
         /* Initialise the previous_*_deltas, for momentum calculations: */
         for (i = 0; i < (n->in_width+1); i++) {
             for (j = 0; j < n->hidden_width; j++) {
@@ -552,6 +608,8 @@ void network_parameters_set(Network *n, NetworkParameters *p)
     n->params.wut = p->wut;             // Update by item or by epoch
     n->params.epochs = p->epochs;       // Maximum number of epochs to train
     n->params.criterion = p->criterion; // Training criterion
+    n->params.test_interval = p->test_interval;       // Epochs between criterion tests
+    n->params.test_in_training = p->test_in_training; // Criterion error from training pass
 }
 
 /*----------------------------------------------------------------------------*/
@@ -573,6 +631,7 @@ Network *network_copy(Network *n)
         r->nt = n->nt;
         r->settled = n->settled;
         r->cycles = n->cycles;
+        r->damage = NULL;
 
         if ((r->weights_ih = (double *)malloc((r->in_width+1) * r->hidden_width * sizeof(double))) != NULL) {
             for (i = 0; i < (r->in_width+1); i++) {
@@ -650,6 +709,14 @@ Network *network_copy(Network *n)
         }
         r->previous_ho_deltas = (double *)malloc((r->hidden_width+1) * r->out_width * sizeof(double));
 
+        /* The training workspace is allocated when first needed: */
+        r->work_cycles = -1;
+        r->work_hidden = NULL;
+        r->work_error = NULL;
+        r->work_out = NULL;
+        r->work_delta = NULL;
+        r->work_epsilon = NULL;
+
         /* Initialise the previous_*_deltas, for momentum calculations: */
         for (i = 0; i < (r->in_width+1); i++) {
             for (j = 0; j < r->hidden_width; j++) {
@@ -772,79 +839,81 @@ void network_tell_initialise_output(Network *n)
     }
 }
 
-void network_inject_noise(Network *n, double variance)
+// Noise is added to weights and units a block at a time, with each block of
+// random values generated by a single call:
+
+#define NOISE_BLOCK 256
+
+static void vector_add_noise(double *v, int n, double noise_sd, Boolean normal)
 {
-    double sd = sqrt(variance);
-    int i;
+    // Add noise to each of the n values in v: normal with s.d. noise_sd, or
+    // uniform on [-noise_sd, noise_sd]:
 
-    for (i = 0; i < n->hidden_width; i++) {
-        n->units_hidden[i] += random_normal(0, sd);
+    double noise[NOISE_BLOCK];
+    int i, k, m;
+
+    for (i = 0; i < n; i += m) {
+        m = (n - i < NOISE_BLOCK) ? n - i : NOISE_BLOCK;
+        if (normal) {
+            random_fill_normal(noise, m, 0.0, noise_sd);
+        }
+        else {
+            random_fill_uniform(noise, m, -noise_sd, noise_sd);
+        }
+        for (k = 0; k < m; k++) {
+            v[i+k] += noise[k];
+        }
     }
 }
 
+void network_inject_noise(Network *n, double variance)
+{
+    vector_add_noise(n->units_hidden, n->hidden_width, sqrt(variance), TRUE);
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
-void network_sever_weights_ih(Network *n, double severity)
+static void vector_sever(double *w, int n, double severity)
 {
-    int i, j;
+    // Sever each of the n weights in w with probability severity. The gap to
+    // the next severed weight is sampled directly, so sparse lesions of the
+    // larger weight matrices take few random numbers:
+
+    int k;
+
+    for (k = random_bernoulli_next(-1, n, severity); k < n; k = random_bernoulli_next(k, n, severity)) {
+        w[k] = 0.0;
+    }
+}
 
+void network_sever_weights_ih(Network *n, double severity)
+{
     if (n->weights_ih != NULL) {
-// fprintf(stdout, "Sever IH weights at %f severity\n", severity);
-        for (i = 0; i < n->in_width; i++) { // Don't lesion the bias!
-            for (j = 0; j < n->hidden_width; j++) {
-                if (random_uniform(0.0, 1.0) < severity) {
-                    n->weights_ih[i * n->hidden_width + j] = 0.0;
-                }
-            }
-        }
 #ifdef BIAS_LESION
-	i = n->in_width;
-        for (j = 0; j < n->hidden_width; j++) {
-            if (random_uniform(0.0, 1.0) < severity) {
-                n->weights_ih[i * n->hidden_width + j] = 0.0;
-            }
-        }
+        vector_sever(n->weights_ih, (n->in_width+1) * n->hidden_width, severity);
+#else
+        // Don't lesion the bias (the last row):
+        vector_sever(n->weights_ih, n->in_width * n->hidden_width, severity);
 #endif
     }
 }
 
 void network_sever_weights_hh(Network *n, double severity)
 {
-    int i, j;
-
-    if (n->weights_hh != NULL) { // For SRN only
-// fprintf(stdout, "Sever HH weights at %f severity\n", severity);
-        for (i = 0; i < n->hidden_width; i++) { // No hidden to hidden bias to worry about
-            for (j = 0; j < n->hidden_width; j++) {
-                if (random_uniform(0.0, 1.0) < severity) {
-                    n->weights_hh[i * n->hidden_width + j] = 0.0;
-                }
-            }
-        }
+    if (n->weights_hh != NULL) { // For SRN only; no hidden to hidden bias
+        vector_sever(n->weights_hh, n->hidden_width * n->hidden_width, severity);
     }
 }
 
 void network_sever_weights_ho(Network *n, double severity)
 {
-    int i, j;
-
     if (n->weights_ho != NULL) {
-// fprintf(stdout, "Sever HO weights at %f severity\n", severity);
-        for (i = 0; i < n->hidden_width; i++) { // Don't lesion the bias!
-            for (j = 0; j < n->out_width; j++) {
-                if (random_uniform(0.0, 1.0) < severity) {
-                    n->weights_ho[i * n->out_width + j] = 0.0;
-                }
-            }
-        }
 #ifdef BIAS_LESION
-	i = n->hidden_width;
-        for (j = 0; j < n->out_width; j++) {
-            if (random_uniform(0.0, 1.0) < severity) {
-                n->weights_ho[i * n->out_width + j] = 0.0;
-            }
-        }
+        vector_sever(n->weights_ho, (n->hidden_width+1) * n->out_width, severity);
+#else
+        // Don't lesion the bias (the last row):
+        vector_sever(n->weights_ho, n->hidden_width * n->out_width, severity);
 #endif
     }
 }
@@ -862,56 +931,33 @@ void network_sever_weights(Network *net, double severity)
 
 void network_perturb_weights_ih(Network *n, double noise_sd)
 {
-    int i, j;
+    // Uniform noise (pass TRUE for normal noise):
 
     if (n->weights_ih != NULL) {
-        for (i = 0; i < n->in_width; i++) { // Don't lesion the bias!
-            for (j = 0; j < n->hidden_width; j++) {
-                n->weights_ih[i * n->hidden_width + j] += random_uniform(-noise_sd, noise_sd);
-                //                n->weights_ih[i * n->hidden_width + j] += random_normal(0, noise_sd);
-            }
-        }
 #ifdef BIAS_LESION
-	i = n->in_width;
-        for (j = 0; j < n->hidden_width; j++) {
-            n->weights_ih[i * n->hidden_width + j] += random_uniform(-noise_sd, noise_sd);
-            //                n->weights_ih[i * n->hidden_width + j] += random_normal(0, noise_sd);
-        }
+        vector_add_noise(n->weights_ih, (n->in_width+1) * n->hidden_width, noise_sd, FALSE);
+#else
+        // Don't lesion the bias (the last row):
+        vector_add_noise(n->weights_ih, n->in_width * n->hidden_width, noise_sd, FALSE);
 #endif
     }
 }
 
 void network_perturb_weights_hh(Network *n, double noise_sd)
 {
-    int i, j;
-
-    if (n->weights_hh != NULL) { // For SRN only
-        for (i = 0; i < n->hidden_width; i++) { // No hidden to hidden bias to worry about
-            for (j = 0; j < n->hidden_width; j++) {
-                n->weights_hh[i * n->hidden_width + j] += random_uniform(-noise_sd, noise_sd);
-                //                n->weights_hh[i * n->hidden_width + j] += random_normal(0, noise_sd);
-            }
-        }
+    if (n->weights_hh != NULL) { // For SRN only; no hidden to hidden bias
+        vector_add_noise(n->weights_hh, n->hidden_width * n->hidden_width, noise_sd, FALSE);
     }
 }
 
 void network_perturb_weights_ho(Network *n, double noise_sd)
 {
-    int i, j;
-
     if (n->weights_ho != NULL) {
-        for (i = 0; i < n->hidden_width; i++) { // Don't lesion the bias!
-            for (j = 0; j < n->out_width; j++) {
-                n->weights_ho[i * n->out_width + j] += random_uniform(-noise_sd, noise_sd);
-                //                n->weights_ho[i * n->out_width + j] += random_normal(0.0, noise_sd);
-            }
-        }
 #ifdef BIAS_LESION
-	i = n->hidden_width;
-        for (j = 0; j < n->out_width; j++) {
-            n->weights_ho[i * n->out_width + j] += random_uniform(-noise_sd, noise_sd);
-            //                n->weights_ho[i * n->out_width + j] += random_normal(0.0, noise_sd);
-        }
+        vector_add_noise(n->weights_ho, (n->hidden_width+1) * n->out_width, noise_sd, FALSE);
+#else
+        // Don't lesion the bias (the last row):
+        vector_add_noise(n->weights_ho, n->hidden_width * n->out_width, noise_sd, FALSE);
 #endif
     }
 }
@@ -1008,6 +1054,218 @@ void network_ablate_units(Network *n, double severity)
     }
 }
 
+/******************************************************************************/
+/* Damage overlays: These consume random numbers exactly as the network_     */
+/* sever/perturb/scale/ablate functions above do, so a network propagated    */
+/* through an overlay matches a copy damaged in place, without the copy.     */
+
+#define DAMAGE_BIT_TEST(mask, k) ((mask)[(k) >> 5] & (1u << ((k) & 31)))
+#define DAMAGE_BIT_SET(mask, k) ((mask)[(k) >> 5] |= (1u << ((k) & 31)))
+
+static int damage_mask_words(int n)
+{
+    return((n + 31) / 32);
+}
+
+static int damage_rows(int width)
+{
+    // Rows of a weight matrix open to damage (the bias row comes last):
+#ifdef BIAS_LESION
+    return(width+1);
+#else
+    return(width);
+#endif
+}
+
+void damage_overlay_destroy(DamageOverlay *d)
+{
+    if (d != NULL) {
+        free(d->severed_ih);
+        free(d->severed_hh);
+        free(d->severed_ho);
+        free(d->noise_ih);
+        free(d->noise_hh);
+        free(d->noise_ho);
+        free(d->ablated);
+        free(d->rank_ih.order);
+        free(d->rank_ih.key);
+        free(d->rank_hh.order);
+        free(d->rank_hh.key);
+        free(d->rank_ho.order);
+        free(d->rank_ho.key);
+        free(d);
+    }
+}
+
+DamageOverlay *damage_overlay_create(Network *net)
+{
+    int nih = (net->in_width+1) * net->hidden_width;
+    int nhh = net->hidden_width * net->hidden_width;
+    int nho = (net->hidden_width+1) * net->out_width;
+    DamageOverlay *d;
+
+    if ((d = (DamageOverlay *)calloc(1, sizeof(DamageOverlay))) != NULL) {
+        d->recurrent = (net->weights_hh != NULL);
+        d->in_width = net->in_width;
+        d->hidden_width = net->hidden_width;
+        d->out_width = net->out_width;
+        d->severed_ih = (unsigned int *)calloc(damage_mask_words(nih), sizeof(unsigned int));
+        d->severed_hh = (unsigned int *)calloc(damage_mask_words(nhh), sizeof(unsigned int));
+        d->severed_ho = (unsigned int *)calloc(damage_mask_words(nho), sizeof(unsigned int));
+        d->noise_ih = (double *)calloc(nih, sizeof(double));
+        d->noise_hh = (double *)calloc(nhh, sizeof(double));
+        d->noise_ho = (double *)calloc(nho, sizeof(double));
+        d->ablated = (Boolean *)calloc(net->hidden_width, sizeof(Boolean));
+        d->scale = 1.0;
+        d->rank_ih.n = damage_rows(net->in_width) * net->hidden_width;
+        d->rank_hh.n = d->recurrent ? nhh : 0;
+        d->rank_ho.n = damage_rows(net->hidden_width) * net->out_width;
+        d->rank_ih.order = (int *)malloc(nih * sizeof(int));
+        d->rank_ih.key = (double *)malloc(nih * sizeof(double));
+        d->rank_hh.order = (int *)malloc(nhh * sizeof(int));
+        d->rank_hh.key = (double *)malloc(nhh * sizeof(double));
+        d->rank_ho.order = (int *)malloc(nho * sizeof(int));
+        d->rank_ho.key = (double *)malloc(nho * sizeof(double));
+
+        if ((d->severed_ih == NULL) || (d->severed_hh == NULL) || (d->severed_ho == NULL) || (d->noise_ih == NULL) || (d->noise_hh == NULL) || (d->noise_ho == NULL) || (d->ablated == NULL) || (d->rank_ih.order == NULL) || (d->rank_ih.key == NULL) || (d->rank_hh.order == NULL) || (d->rank_hh.key == NULL) || (d->rank_ho.order == NULL) || (d->rank_ho.key == NULL)) {
+            damage_overlay_destroy(d);
+            return(NULL);
+        }
+    }
+    return(d);
+}
+
+void damage_overlay_clear(DamageOverlay *d)
+{
+    int nih = (d->in_width+1) * d->hidden_width;
+    int nhh = d->hidden_width * d->hidden_width;
+    int nho = (d->hidden_width+1) * d->out_width;
+
+    if (d->any_severed) {
+        memset(d->severed_ih, 0, damage_mask_words(nih) * sizeof(unsigned int));
+        memset(d->severed_hh, 0, damage_mask_words(nhh) * sizeof(unsigned int));
+        memset(d->severed_ho, 0, damage_mask_words(nho) * sizeof(unsigned int));
+    }
+    if (d->any_noise) {
+        memset(d->noise_ih, 0, nih * sizeof(double));
+        memset(d->noise_hh, 0, nhh * sizeof(double));
+        memset(d->noise_ho, 0, nho * sizeof(double));
+    }
+    if (d->any_ablated) {
+        memset(d->ablated, 0, d->hidden_width * sizeof(Boolean));
+    }
+    d->scale = 1.0;
+    d->any_severed = FALSE;
+    d->any_noise = FALSE;
+    d->any_ablated = FALSE;
+    d->rank_ih.severed = 0;
+    d->rank_hh.severed = 0;
+    d->rank_ho.severed = 0;
+}
+
+static void damage_overlay_cut(unsigned int *mask, int n, double severity, Boolean *any)
+{
+    int k;
+
+    for (k = random_bernoulli_next(-1, n, severity); k < n; k = random_bernoulli_next(k, n, severity)) {
+        DAMAGE_BIT_SET(mask, k);
+        *any = TRUE;
+    }
+}
+
+void damage_overlay_sever_weights(DamageOverlay *d, double severity)
+{
+    damage_overlay_cut(d->severed_ih, damage_rows(d->in_width) * d->hidden_width, severity, &d->any_severed);
+    if (d->recurrent) {
+        damage_overlay_cut(d->severed_hh, d->hidden_width * d->hidden_width, severity, &d->any_severed);
+    }
+    damage_overlay_cut(d->severed_ho, damage_rows(d->hidden_width) * d->out_width, severity, &d->any_severed);
+}
+
+void damage_overlay_rank_weights(DamageOverlay *d)
+{
+    // Rank the connections afresh for nested lesions. Connections severed
+    // under the old ranking remain so until the overlay is cleared:
+
+    random_ranking(d->rank_ih.n, d->rank_ih.order, d->rank_ih.key);
+    random_ranking(d->rank_hh.n, d->rank_hh.order, d->rank_hh.key);
+    random_ranking(d->rank_ho.n, d->rank_ho.order, d->rank_ho.key);
+    d->rank_ih.severed = 0;
+    d->rank_hh.severed = 0;
+    d->rank_ho.severed = 0;
+    d->ranked = TRUE;
+}
+
+static void damage_overlay_cut_ranked(LesionRanking *rank, unsigned int *mask, double severity, Boolean *any)
+{
+    while ((rank->severed < rank->n) && (rank->key[rank->severed] < severity)) {
+        DAMAGE_BIT_SET(mask, rank->order[rank->severed]);
+        rank->severed++;
+        *any = TRUE;
+    }
+}
+
+void damage_overlay_sever_nested(DamageOverlay *d, double severity)
+{
+    // Sever the connections ranked below severity. Called with increasing
+    // severities (without clearing), each call severs only the connections
+    // ranked since the last, so a whole series of levels costs no more than
+    // the most severe lesion:
+
+    if (!d->ranked) {
+        damage_overlay_rank_weights(d);
+    }
+    damage_overlay_cut_ranked(&d->rank_ih, d->severed_ih, severity, &d->any_severed);
+    damage_overlay_cut_ranked(&d->rank_hh, d->severed_hh, severity, &d->any_severed);
+    damage_overlay_cut_ranked(&d->rank_ho, d->severed_ho, severity, &d->any_severed);
+}
+
+void damage_overlay_perturb_weights(DamageOverlay *d, double noise_sd)
+{
+    vector_add_noise(d->noise_ih, damage_rows(d->in_width) * d->hidden_width, noise_sd, FALSE);
+    if (d->recurrent) {
+        vector_add_noise(d->noise_hh, d->hidden_width * d->hidden_width, noise_sd, FALSE);
+    }
+    vector_add_noise(d->noise_ho, damage_rows(d->hidden_width) * d->out_width, noise_sd, FALSE);
+    d->any_noise = TRUE;
+}
+
+void damage_overlay_ablate_units(DamageOverlay *d, double severity)
+{
+    int i;
+
+    for (i = 0; i < d->hidden_width; i++) {
+        if (random_uniform(0.0, 1.0) < severity) {
+            d->ablated[i] = TRUE;
+            d->any_ablated = TRUE;
+        }
+    }
+}
+
+void damage_overlay_scale_weights(DamageOverlay *d, double scale)
+{
+    d->scale *= scale;
+}
+
+void network_tell_damage(Network *n, DamageOverlay *d)
+{
+    // Propagate through the weights as damaged by d (NULL to undamage):
+    n->damage = d;
+}
+
+static double damage_weight(DamageOverlay *d, double w, unsigned int *severed, double *noise, int k, int row, int rows)
+{
+    // Weight k (in the given row of its matrix) as seen through d:
+
+    if (d->any_severed && DAMAGE_BIT_TEST(severed, k)) {
+        return(0.0);
+    }
+    if (d->any_noise) {
+        w += noise[k];
+    }
+    return((row < rows) ? w * d->scale : w);
+}
+
 /******************************************************************************/
 
 void network_zero_input(Network *n)
@@ -1150,43 +1408,93 @@ static double time_average(double new_net, double net, int ticks)
     }
 }
 
-void network_tell_propagate(Network *n)
+static void network_damaged_propagate_units(Network *n, DamageOverlay *d)
 {
-    /* Generalised version (FF or SRN) */
+    // network_tell_propagate through the damaged weights, summing in the
+    // same order so the result matches a damaged copy exactly:
 
+    int ih_rows = damage_rows(n->in_width);
+    int ho_rows = damage_rows(n->hidden_width);
     double net_in, new_net_in;
-    int i, j;
+    int i, j, k;
 
-    /* Propagate from input to hidden: */
     if (n->units_hidden != NULL) {
         for (j = 0; j < n->hidden_width; j++) {
             new_net_in = 0.0;
             net_in = sigmoid_inverse(n->units_hidden[j]);
             for (i = 0; i < (n->in_width+1); i++) {
-                new_net_in += n->units_in[i] * n->weights_ih[i * n->hidden_width + j];
+                k = i * n->hidden_width + j;
+                new_net_in += n->units_in[i] * damage_weight(d, n->weights_ih[k], d->severed_ih, d->noise_ih, k, i, ih_rows);
             }
-            /* If recurrent, then add in recurrent input: */
             if (n->nt == NT_RECURRENT) {
                 for (i = 0; i < n->hidden_width; i++) {
-                    new_net_in += n->units_hidden_prev[i] * n->weights_hh[i * n->hidden_width + j];
+                    k = i * n->hidden_width + j;
+                    if (!d->ablated[i]) {
+                        new_net_in += n->units_hidden_prev[i] * damage_weight(d, n->weights_hh[k], d->severed_hh, d->noise_hh, k, i, n->hidden_width);
+                    }
                 }
             }
-            /* And calculate the post-synaptic value: */
             n->units_hidden[j] = sigmoid(time_average(new_net_in, net_in, n->params.ticks));
         }
     }
 
-    /* Propagate from hidden to output: */
     if (n->units_out != NULL) {
         for (j = 0; j < n->out_width; j++) {
             new_net_in = 0.0;
             net_in = sigmoid_inverse(n->units_out[j]);
             for (i = 0; i < (n->hidden_width+1); i++) {
-                new_net_in += n->units_hidden[i] * n->weights_ho[i * n->out_width + j];
+                k = i * n->out_width + j;
+                if ((i == n->hidden_width) || !d->ablated[i]) {
+                    new_net_in += n->units_hidden[i] * damage_weight(d, n->weights_ho[k], d->severed_ho, d->noise_ho, k, i, ho_rows);
+                }
             }
             n->units_out[j] = sigmoid(time_average(new_net_in, net_in, n->params.ticks));
         }
     }
+}
+
+void network_tell_propagate(Network *n)
+{
+    /* Generalised version (FF or SRN) */
+
+    double net_in, new_net_in;
+    int i, j;
+
+    if (n->damage != NULL) {
+        network_damaged_propagate_units(n, n->damage);
+    }
+    else {
+        /* Propagate from input to hidden: */
+        if (n->units_hidden != NULL) {
+            for (j = 0; j < n->hidden_width; j++) {
+                new_net_in = 0.0;
+                net_in = sigmoid_inverse(n->units_hidden[j]);
+                for (i = 0; i < (n->in_width+1); i++) {
+                    new_net_in += n->units_in[i] * n->weights_ih[i * n->hidden_width + j];
+                }
+                /* If recurrent, then add in recurrent input: */
+                if (n->nt == NT_RECURRENT) {
+                    for (i = 0; i < n->hidden_width; i++) {
+                        new_net_in += n->units_hidden_prev[i] * n->weights_hh[i * n->hidden_width + j];
+                    }
+                }
+                /* And calculate the post-synaptic value: */
+                n->units_hidden[j] = sigmoid(time_average(new_net_in, net_in, n->params.ticks));
+            }
+        }
+
+        /* Propagate from hidden to output: */
+        if (n->units_out != NULL) {
+            for (j = 0; j < n->out_width; j++) {
+                new_net_in = 0.0;
+                net_in = sigmoid_inverse(n->units_out[j]);
+                for (i = 0; i < (n->hidden_width+1); i++) {
+                    new_net_in += n->units_hidden[i] * n->weights_ho[i * n->out_width + j];
+                }
+                n->units_out[j] = sigmoid(time_average(new_net_in, net_in, n->params.ticks));
+            }
+        }
+    }
 
     if (n->nt == NT_RECURRENT) {
 
@@ -1577,10 +1885,11 @@ static void network_accumulate_weight_changes_ff(Network *n, double *test_in, do
     double *delta_ho;
     int i, j, k;
 
-    if ((delta_ho = (double *)malloc(n->out_width * sizeof(double))) == NULL) {
+    if (!network_reserve_workspace(n, 0)) {
         fprintf(stderr, "ERROR: Allocation failure in %s at %d\n", __FILE__, __LINE__);
         return;
     }
+    delta_ho = n->work_delta;
 
     /* This will change activity in the network ... perhaps we should be */
     /* using our own copy of the network */
@@ -1619,9 +1928,42 @@ static void network_accumulate_weight_changes_ff(Network *n, double *test_in, do
         n->tmp_ih_deltas[n->in_width * n->hidden_width + j] = 0;
     }
 #endif
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* The dot product of two contiguous vectors, added to sum. By default this  */
+/* accumulates strictly in order, so results are identical to the original   */
+/* unit-by-unit BPTT loop. Compiling with -DBPTT_SIMD instead uses four      */
+/* partial sums, which the compiler can vectorise; with GCC on x86-64 AVX2   */
+/* and AVX-512 versions are also built and the best is selected at run time. */
+
+#if defined(BPTT_SIMD) && defined(__GNUC__) && defined(__x86_64__)
+__attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+static double vector_dot_add(double sum, int n, const double *a, const double *b)
+{
+    int i;
+#ifdef BPTT_SIMD
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+    for (i = 0; i + 3 < n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i+1] * b[i+1];
+        s2 += a[i+2] * b[i+2];
+        s3 += a[i+3] * b[i+3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i] * b[i];
+    }
+    return(sum + ((s0 + s1) + (s2 + s3)));
+#else
 
-    /* Deallocate temporary space: */
-    free(delta_ho);
+    for (i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return(sum);
+#endif
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1632,16 +1974,23 @@ static void network_accumulate_weight_changes_srn(Network *n, double *test_in, d
 
     int cycles = n->params.ticks * n->params.sc;
     int units = n->hidden_width + n->out_width;
-    double *history_hidden = (double *)malloc((cycles+2) * n->hidden_width * sizeof(double));
-    double *history_error = (double *)malloc((cycles+2) * n->out_width * sizeof(double));
-    double *history_out = (double *)malloc((cycles+2) * n->out_width * sizeof(double));
-    double *delta = (double *)malloc((cycles+2) * units * sizeof(double));
-    double *epsilon = (double *)malloc((cycles+2) * units * sizeof(double));
-    double y, weight_lk, df;
-    int i, j, k, l, t;
+    double *history_hidden, *history_error, *history_out;
+    double *delta, *epsilon;
+    double y, df;
+    int i, j, k, t;
 
     Boolean penalty = FALSE;
 
+    if (!network_reserve_workspace(n, cycles)) {
+        fprintf(stderr, "ERROR: Allocation failure in %s at %d\n", __FILE__, __LINE__);
+        return;
+    }
+    history_hidden = n->work_hidden;
+    history_error = n->work_error;
+    history_out = n->work_out;
+    delta = n->work_delta;
+    epsilon = n->work_epsilon;
+
 #if DEBUG
     FILE *fp_dbg = fopen("debug.out", "a");
 #endif
@@ -1682,33 +2031,29 @@ static void network_accumulate_weight_changes_srn(Network *n, double *test_in, d
     fprintf(fp_dbg, "\n");
 #endif
 
-    /* 2: Calculate epsilon and delta for each non-input unit (equations 17-19): */
+    /* 2: Calculate epsilon and delta for each non-input unit (equations 17-19). */
+    /* Only hidden units have outgoing weights, so only they receive error from */
+    /* the next time step: the dot product of each hidden unit's outgoing rows  */
+    /* of weights_hh and weights_ho with the next step's hidden/output deltas:  */
 
     for (t = cycles+1; t > 0; t--) {
+        double *delta_next = &delta[(t+1) * units];
+
         for (k = 0; k < units; k++) {
             /* Calculate the external error for each node: */
             epsilon[t * units + k] = (k < n->hidden_width ? 0.0 : history_error[t * n->out_width + (k - n->hidden_width)]);
+        }
+        if (t < (cycles+1)) {
+            /* Add in the sum of delta terms to epsilon for hidden units: */
+            for (k = 0; k < n->hidden_width; k++) {
+                double e = epsilon[t * units + k];
 
-            /* Add in the sum of delta terms to epsilon if appropriate: */
-            if (t < (cycles+1)) {
-                for (l = 0; l < units; l++) {
-                    if (k < n->hidden_width) {
-                        if (l < n->hidden_width) {
-                            /* Weight from hidden unit k to hidden unit l: */
-                            weight_lk  = n->weights_hh[k*n->hidden_width+l];
-                        }
-                        else {
-                            /* Weight from hidden unit k to output unit (l-hidden_width): */
-                            weight_lk  = n->weights_ho[k*n->out_width+(l-n->hidden_width)];
-                        }
-                    }
-                    else {
-                        /* Weight from output unit (k-hidden_width) to unit l: */
-                        weight_lk = 0.0;
-                    }
-                    epsilon[t * units + k] += weight_lk * delta[(t+1) * units + l];
-                }
+                e = vector_dot_add(e, n->hidden_width, &n->weights_hh[k * n->hidden_width], delta_next);
+                e = vector_dot_add(e, n->out_width, &n->weights_ho[k * n->out_width], &delta_next[n->hidden_width]);
+                epsilon[t * units + k] = e;
             }
+        }
+        for (k = 0; k < units; k++) {
             /* And calculate the deltas... */
             y = (k < n->hidden_width ? history_hidden[t * n->hidden_width + k] : history_out[t * n->out_width + (k - n->hidden_width)]);
             df = y * (1-y);
@@ -1780,13 +2125,6 @@ static void network_accumulate_weight_changes_srn(Network *n, double *test_in, d
         fprintf(fp_dbg, "\n");
 #endif
 
-    /* 4: Release all allocated space: */
-    free(history_hidden);
-    free(history_out);
-    free(history_error);
-    free(delta);
-    free(epsilon);
-
 #if DEBUG
     fclose(fp_dbg);
 #endif
@@ -1812,12 +2150,50 @@ static void network_accumulate_weight_changes(Network *n, double *test_in, doubl
     }
 }
 
-Boolean network_train(Network *n, PatternList *patterns)
+static double vector_compare(ErrorFunction ef, int width, double *v1, double *v2)
+{
+    double (*net_error_function)() = NULL;
+    double err;
+    int i;
+
+    switch (ef) {
+        case EF_SUM_SQUARE: {
+            net_error_function = net_error_ssq; break;
+        }
+        case EF_CROSS_ENTROPY: {
+            net_error_function = net_error_cross_entropy; break;
+        }
+        case EF_SOFT_MAX: {
+            net_error_function = net_error_soft_max; break;
+        }
+        case EF_MAX: {
+            net_error_function = NULL; break;
+        }
+    }
+
+    err = 0.0;
+    if (net_error_function != NULL) {
+        for (i = 0; i < width; i++) {
+            err += fabs(net_error_function(v1[i], v2[i]));
+        }
+    }
+    return(err / width);
+}
+
+/* One epoch of training. If error is not NULL it receives the error of the */
+/* network on the epoch's (randomly clamped) training patterns, scaled as by */
+/* network_test, taken from the outputs of the training pass. When updating  */
+/* by epoch this is the error before the update; when updating by item, each */
+/* pattern is scored before its own update.                                  */
+
+Boolean network_train_with_error(Network *n, PatternList *patterns, ErrorFunction ef, double *error)
 {
     double (*net_error_function)() = NULL;
     double *vector_in = NULL;
     double *vector_out = NULL;
-    ClampedPatternList *clamped_patterns;
+    ClampedPatternList *clamped_patterns, *first;
+    double e = 0.0;
+    int l = 0;
 
     switch (n->params.ef) {
         case EF_SUM_SQUARE: {
@@ -1846,6 +2222,7 @@ Boolean network_train(Network *n, PatternList *patterns)
 
     /* First generate the randomised clamped training patterns: */
     clamped_patterns = network_generate_randomised_clamped_pattern_set(patterns);
+    first = clamped_patterns;
 
     if (n->params.wut == WU_BY_EPOCH) {
 
@@ -1857,6 +2234,10 @@ Boolean network_train(Network *n, PatternList *patterns)
             hub_build_target_vector(clamped_patterns, vector_out);
             hub_build_input_vector(clamped_patterns, vector_in);
             network_accumulate_weight_changes(n, vector_in, vector_out, &(clamped_patterns->clamp), net_error_function);
+            if (error != NULL) {
+                e += vector_compare(ef, NUM_IO, vector_out, n->units_out);
+                l++;
+            }
             clamped_patterns = clamped_patterns->next;
         }
 
@@ -1876,6 +2257,10 @@ Boolean network_train(Network *n, PatternList *patterns)
             hub_build_input_vector(clamped_patterns, vector_in);
             network_train_initialise_deltas(n);
             network_accumulate_weight_changes(n, vector_in, vector_out, &(clamped_patterns->clamp), net_error_function);
+            if (error != NULL) {
+                e += vector_compare(ef, NUM_IO, vector_out, n->units_out);
+                l++;
+            }
             network_train_update_weights(n, wd);
 
             /* And move on to the next pattern: */
@@ -1883,22 +2268,49 @@ Boolean network_train(Network *n, PatternList *patterns)
         }
     }
 
-    network_free_clamped_pattern_list(clamped_patterns);
+    network_free_clamped_pattern_list(first);
 
     free(vector_in);
     free(vector_out);
+
+    if (error != NULL) {
+        *error = (l > 0) ? e / (double) l : 0.0;
+    }
     return(TRUE);
 }
 
+Boolean network_train(Network *n, PatternList *patterns)
+{
+    return(network_train_with_error(n, patterns, n->params.ef, NULL));
+}
+
 void network_train_to_criterion(Network *n, PatternList *patterns)
 {
+    /* Test every test_interval epochs. If test_in_training is set (and we */
+    /* update by epoch) the error comes from the training pass, so no      */
+    /* settling pass is needed to test, but it is measured on the training */
+    /* clamping of the patterns, and before that epoch's weight update.    */
+
+    Boolean fused = n->params.test_in_training && (n->params.wut == WU_BY_EPOCH);
+    int k = MAX(n->params.test_interval, 1);
+    double error;
     int i;
 
     for (i = 0; i < n->params.epochs; i++) {
-        network_train(n, patterns);
-
-        if (network_test(n, patterns, n->params.ef) < n->params.criterion) {
-            return;
+        if (((i+1) % k) != 0) {
+            network_train(n, patterns);
+        }
+        else if (fused) {
+            network_train_with_error(n, patterns, n->params.ef, &error);
+            if (error < n->params.criterion) {
+                return;
+            }
+        }
+        else {
+            network_train(n, patterns);
+            if (network_test(n, patterns, n->params.ef) < n->params.criterion) {
+                return;
+            }
         }
     }
 }
@@ -1916,36 +2328,6 @@ void network_train_to_epochs(Network *n, PatternList *patterns)
 /* SECTION XX: Test the network against a set of patterns *********************/
 /******************************************************************************/
 
-static double vector_compare(ErrorFunction ef, int width, double *v1, double *v2)
-{
-    double (*net_error_function)() = NULL;
-    double err;
-    int i;
-
-    switch (ef) {
-        case EF_SUM_SQUARE: {
-            net_error_function = net_error_ssq; break;
-        }
-        case EF_CROSS_ENTROPY: {
-            net_error_function = net_error_cross_entropy; break;
-        }
-        case EF_SOFT_MAX: {
-            net_error_function = net_error_soft_max; break;
-        }
-        case EF_MAX: {
-            net_error_function = NULL; break;
-        }
-    }
-
-    err = 0.0;
-    if (net_error_function != NULL) {
-        for (i = 0; i < width; i++) {
-            err += fabs(net_error_function(v1[i], v2[1]));
-        }
-    }
-    return(err / width);
-}
-
 static double network_test_pattern(Network *n, ClampedPatternList *clamped_pattern, ErrorFunction ef)
 {
     double *vector_in = NULL, *vector_out = NULL, *real_out = NULL;
@@ -2350,6 +2732,9 @@ Network *network_read_from_file(FILE *fp, char  **error)
     int i, h = 0, o, h1, h2;
     char *segment;
 
+    /* Not all parameters are saved in the file, so zero the rest: */
+    memset(&np, 0, sizeof(NetworkParameters));
+
     while ((segment = net_weight_file_read_segment(fp)) != NULL) {
         if (network_segment_specifies_weights(segment, 'I', 'H', &i, &h)) {
             if ((ih = (double *)malloc((i+1) * h * sizeof(double))) == NULL) {
@@ -2444,6 +2829,215 @@ Network *network_read_from_file(FILE *fp, char  **error)
     return(n);
 }
 
+/*----------------------------------------------------------------------------*/
+/* Binary weight files (native byte order). The header holds the network     */
+/* type, layer sizes and all of the network parameters. The weights follow   */
+/* (IH, then HH for recurrent networks, then HO), and the checksum is FNV-1a */
+/* over the header (checksum field zero) and the weights:                    */
+
+#define WGT_BIN_MAGIC "HUBWGT\0\0"
+#define WGT_BIN_VERSION 1
+#define WGT_BIN_BYTE_ORDER 0x01020304
+
+typedef struct wgt_bin_header {
+    char     magic[8];
+    int32_t  version;
+    int32_t  byte_order;
+    int32_t  nt;
+    int32_t  in_width, hidden_width, out_width;
+    int32_t  ui, ticks, sc, ef, wut, epochs;
+    double   wn, lr, momentum, wd, st, criterion;
+    uint64_t checksum;
+} WgtBinHeader;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t bytes)
+{
+    const unsigned char *byte = (const unsigned char *)data;
+    size_t k;
+
+    for (k = 0; k < bytes; k++) {
+        hash = (hash ^ byte[k]) * 0x100000001b3ULL;
+    }
+    return(hash);
+}
+
+static uint64_t network_weight_checksum(WgtBinHeader *header, Network *n)
+{
+    WgtBinHeader h0 = *header;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    int h = n->hidden_width;
+
+    h0.checksum = 0;
+    hash = fnv1a(hash, &h0, sizeof(WgtBinHeader));
+    hash = fnv1a(hash, n->weights_ih, (n->in_width+1) * h * sizeof(double));
+    if (n->weights_hh != NULL) {
+        hash = fnv1a(hash, n->weights_hh, h * h * sizeof(double));
+    }
+    hash = fnv1a(hash, n->weights_ho, (h+1) * n->out_width * sizeof(double));
+    return(hash);
+}
+
+Boolean network_write_to_binary_file(char *filename, Network *n)
+{
+    int i = n->in_width, h = n->hidden_width, o = n->out_width;
+    char tmpname[1024];
+    WgtBinHeader header;
+    Boolean ok;
+    FILE *fp;
+
+    memset(&header, 0, sizeof(WgtBinHeader));
+    memcpy(header.magic, WGT_BIN_MAGIC, 8);
+    header.version = WGT_BIN_VERSION;
+    header.byte_order = WGT_BIN_BYTE_ORDER;
+    header.nt = (n->weights_hh != NULL) ? NT_RECURRENT : NT_FEEDFORWARD;
+    header.in_width = i;
+    header.hidden_width = h;
+    header.out_width = o;
+    header.ui = n->params.ui;
+    header.ticks = n->params.ticks;
+    header.sc = n->params.sc;
+    header.ef = n->params.ef;
+    header.wut = n->params.wut;
+    header.epochs = n->params.epochs;
+    header.wn = n->params.wn;
+    header.lr = n->params.lr;
+    header.momentum = n->params.momentum;
+    header.wd = n->params.wd;
+    header.st = n->params.st;
+    header.criterion = n->params.criterion;
+    header.checksum = network_weight_checksum(&header, n);
+
+    /* Each process writes its own temporary file, renamed once complete: */
+    g_snprintf(tmpname, 1024, "%s.%d.tmp", filename, (int) getpid());
+    if ((fp = fopen(tmpname, "wb")) == NULL) {
+        return(FALSE);
+    }
+    ok = (fwrite(&header, sizeof(WgtBinHeader), 1, fp) == 1);
+    ok = ok && (fwrite(n->weights_ih, sizeof(double), (i+1) * h, fp) == (i+1) * h);
+    if (n->weights_hh != NULL) {
+        ok = ok && (fwrite(n->weights_hh, sizeof(double), h * h, fp) == h * h);
+    }
+    ok = ok && (fwrite(n->weights_ho, sizeof(double), (h+1) * o, fp) == (h+1) * o);
+    ok = (fclose(fp) == 0) && ok;
+
+    if (!ok || (rename(tmpname, filename) != 0)) {
+        remove(tmpname);
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+static Network *network_read_from_binary_file(FILE *fp, char **error)
+{
+    WgtBinHeader header;
+    NetworkParameters np;
+    Network *n;
+    int i, h, o;
+
+    if ((fread(&header, sizeof(WgtBinHeader), 1, fp) != 1) || (memcmp(header.magic, WGT_BIN_MAGIC, 8) != 0)) {
+        *error = "Not a binary weight file";
+        return(NULL);
+    }
+    else if ((header.version != WGT_BIN_VERSION) || (header.byte_order != WGT_BIN_BYTE_ORDER)) {
+        *error = "Unsupported binary weight file version or byte order";
+        return(NULL);
+    }
+    else if ((header.nt < 0) || (header.nt >= NT_MAX) || (header.in_width < 1) || (header.hidden_width < 1) || (header.out_width < 1)) {
+        *error = "Malformed binary weight file header";
+        return(NULL);
+    }
+    else if ((header.ui < 0) || (header.ui >= UI_MAX) || (header.ef < 0) || (header.ef >= EF_MAX) || (header.wut < 0) || (header.wut >= WU_MAX)) {
+        *error = "Malformed binary weight file header";
+        return(NULL);
+    }
+
+    i = header.in_width;
+    h = header.hidden_width;
+    o = header.out_width;
+
+    if ((n = network_create((NetworkType) header.nt, i, h, o)) == NULL) {
+        *error = "Allocation failure";
+        return(NULL);
+    }
+    else if ((fread(n->weights_ih, sizeof(double), (i+1) * h, fp) != (i+1) * h) ||
+             ((n->weights_hh != NULL) && (fread(n->weights_hh, sizeof(double), h * h, fp) != h * h)) ||
+             (fread(n->weights_ho, sizeof(double), (h+1) * o, fp) != (h+1) * o) ||
+             (fgetc(fp) != EOF)) {
+        network_destroy(n);
+        *error = "Binary weight file is truncated or too long";
+        return(NULL);
+    }
+    else if (network_weight_checksum(&header, n) != header.checksum) {
+        network_destroy(n);
+        *error = "Binary weight file checksum mismatch";
+        return(NULL);
+    }
+
+    /* The criterion testing fields are not saved, so zero them: */
+    memset(&np, 0, sizeof(NetworkParameters));
+    np.ui = (UnitInitialisation) header.ui;
+    np.ticks = header.ticks;
+    np.sc = header.sc;
+    np.ef = (ErrorFunction) header.ef;
+    np.wut = (WeightUpdateTime) header.wut;
+    np.epochs = header.epochs;
+    np.wn = header.wn;
+    np.lr = header.lr;
+    np.momentum = header.momentum;
+    np.wd = header.wd;
+    np.st = header.st;
+    np.criterion = header.criterion;
+    network_parameters_set(n, &np);
+
+    return(n);
+}
+
+static Boolean file_is_newer(char *file1, char *file2)
+{
+    struct stat st1, st2;
+
+    return((stat(file1, &st1) == 0) && (stat(file2, &st2) == 0) && (st1.st_mtime >= st2.st_mtime));
+}
+
+Network *network_read_from_named_file(char *filename, char **error)
+{
+    /* Read a text or binary weight file. A text file's binary sidecar     */
+    /* (filename.bin) is read instead if it is at least as recent, and is  */
+    /* (re)written after the text has been read otherwise:                 */
+
+    char binfile[1024];
+    char magic[8];
+    Network *n;
+    FILE *fp;
+
+    g_snprintf(binfile, 1024, "%s.bin", filename);
+    if (file_is_newer(binfile, filename) && ((fp = fopen(binfile, "rb")) != NULL)) {
+        n = network_read_from_binary_file(fp, error);
+        fclose(fp);
+        if (n != NULL) {
+            return(n);
+        }
+        fprintf(stderr, "WARNING: %s: %s ... reading %s\n", binfile, *error, filename);
+    }
+
+    if ((fp = fopen(filename, "rb")) == NULL) {
+        *error = "Cannot open file";
+        return(NULL);
+    }
+    if ((fread(magic, 1, 8, fp) == 8) && (memcmp(magic, WGT_BIN_MAGIC, 8) == 0)) {
+        rewind(fp);
+        n = network_read_from_binary_file(fp, error);
+    }
+    else {
+        rewind(fp);
+        if ((n = network_read_from_file(fp, error)) != NULL) {
+            network_write_to_binary_file(binfile, n);
+        }
+    }
+    fclose(fp);
+    return(n);
+}
+
 #if FALSE
 Network *network_read_from_file(FILE *fp, char  **error)
 {
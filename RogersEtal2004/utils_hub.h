@@ -47,8 +47,38 @@ typedef struct network_parameters {
     WeightUpdateTime wut;        // Update by item or by epoch
     int              epochs;     // Maximum number of epochs to train
     double           criterion;  // Criterion error when training should terminate
+    int              test_interval;    // Epochs between criterion tests (0 is every epoch)
+    Boolean          test_in_training; // Take the criterion error from the training pass
 } NetworkParameters;
 
+// Damage that leaves a network's weights untouched: propagation reads each
+// weight as (w + noise) * scale, or zero if the connection is severed or
+// leaves an ablated hidden unit. Bias weights are spared, as they are by the
+// network_sever/perturb/scale functions, unless BIAS_LESION is defined.
+
+// Nested lesions rank the connections once, giving each a key in (0, 1); a
+// severity s then severs the connections with key below s, so each lesion
+// contains every less severe one:
+
+typedef struct lesion_ranking {
+    int n;                     // Connections ranked
+    int *order;                // The connections, in the order severed
+    double *key;               // Severity at which each is severed
+    int severed;               // order[0 ... severed-1] are severed
+} LesionRanking;
+
+typedef struct damage_overlay {
+    Boolean recurrent;
+    int in_width, hidden_width, out_width;
+    unsigned int *severed_ih, *severed_hh, *severed_ho; // One bit per weight
+    double *noise_ih, *noise_hh, *noise_ho;
+    Boolean *ablated;          // Hidden units with all outgoing weights cut
+    double scale;
+    Boolean any_severed, any_noise, any_ablated;
+    Boolean ranked;            // Rankings for nested lesions drawn
+    LesionRanking rank_ih, rank_hh, rank_ho;
+} DamageOverlay;
+
 typedef struct network {
     NetworkType      nt;       // FF or Recurrent
     Boolean          settled;  // True when settled
@@ -59,6 +89,11 @@ typedef struct network {
     double *tmp_ih_deltas, *tmp_hh_deltas, *tmp_ho_deltas;
     double *previous_ih_deltas, *previous_hh_deltas, *previous_ho_deltas;
     NetworkParameters params;
+    // Training workspace, sized for the longest settling sequence seen so
+    // far and reused by every call to network_train:
+    int work_cycles;
+    double *work_hidden, *work_error, *work_out, *work_delta, *work_epsilon;
+    DamageOverlay *damage;     // Not owned by the network; NULL if undamaged
 } Network;
 
 /* Defined in utils_hub.c: ****************************************************/
@@ -107,9 +142,20 @@ extern void network_scale_weights_hh(Network *net, double noise_sd);
 extern void network_scale_weights_ho(Network *net, double noise_sd);
 extern void network_scale_weights(Network *net, double noise_sd);
 extern void network_ablate_units(Network *net, double severity);
+extern DamageOverlay *damage_overlay_create(Network *net);
+extern void damage_overlay_destroy(DamageOverlay *d);
+extern void damage_overlay_clear(DamageOverlay *d);
+extern void damage_overlay_sever_weights(DamageOverlay *d, double severity);
+extern void damage_overlay_rank_weights(DamageOverlay *d);
+extern void damage_overlay_sever_nested(DamageOverlay *d, double severity);
+extern void damage_overlay_perturb_weights(DamageOverlay *d, double noise_sd);
+extern void damage_overlay_scale_weights(DamageOverlay *d, double scale);
+extern void damage_overlay_ablate_units(DamageOverlay *d, double severity);
+extern void network_tell_damage(Network *n, DamageOverlay *d);
 extern double network_test(Network *n, PatternList *test_patterns, ErrorFunction ef);
 extern double network_test_max_bit(Network *n, PatternList *patterns);
 extern Boolean network_train(Network *n, PatternList *test_patterns);
+extern Boolean network_train_with_error(Network *n, PatternList *patterns, ErrorFunction ef, double *error);
 extern void network_train_to_criterion(Network *n, PatternList *seqs);
 extern void network_train_to_epochs(Network *n, PatternList *seqs);
 extern void training_set_free(PatternList *patterns);
@@ -119,6 +165,8 @@ extern PatternList *training_set_next(PatternList *patterns);
 extern double *training_set_input_vector(PatternList *patterns);
 extern Boolean network_write_to_file(FILE *fp, Network *n);
 extern Network *network_read_from_file(FILE *fp, char **error);
+extern Network *network_read_from_named_file(char *filename, char **error);
+extern Boolean network_write_to_binary_file(char *filename, Network *n);
 extern double net_conflict(Network *n);
 extern void network_inject_noise(Network *n, double sv_noise);
 
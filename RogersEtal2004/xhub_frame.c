@@ -264,21 +264,13 @@ Boolean weight_file_read(XGlobals *xg, char *filename)
     char buffer[128];
     char *err = NULL;
     Network *new_net = NULL;
-    FILE *fp;
 
-    if ((fp = fopen(filename, "r")) == NULL) {
-        g_snprintf(buffer, 128, "ERROR: Failed to open weight file (%s)", filename);
-        gtkx_warn(xg->frame, buffer);
-        return(FALSE);
-    }
-    else if ((new_net = network_read_from_file(fp, &err)) == NULL) {
-        fclose(fp);
-        g_snprintf(buffer, 128, "ERROR: Weight file format error (%s) ... weights not restored", err);
+    if ((new_net = network_read_from_named_file(filename, &err)) == NULL) {
+        g_snprintf(buffer, 128, "ERROR: Failed to read weight file %s (%s) ... weights not restored", filename, err);
         gtkx_warn(xg->frame, buffer);
         return(FALSE);
     }
     else {
-        fclose(fp);
         fprintf(stdout, "Weights successfully restored from %s\n", filename);
         network_parameters_set(new_net, &(xg->net->params));
         network_destroy(xg->net);
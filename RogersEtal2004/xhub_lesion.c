@@ -48,9 +48,10 @@ will be 20 sets of saved weights, so this only works for 20 replications.
 #define MAX_ABLATE      1.00
 #define MIN_SCALE       0.75
 #define MAX_SCALE       0.55
-#define MAX_NETWORKS     300
 // Replications per network:
 #define MAX_REPS         10
+// Replications per individual in the individual differences graphs:
+#define INDIVIDUAL_REPS  25
 
 // Number of points in the graphs:
 #define MAX_POINTS       21
@@ -62,12 +63,23 @@ static GraphStruct *damage_graph_data = NULL;
 static GtkWidget   *damage_graph_viewer = NULL;
 static LesionType   damage_graph_damage_type  = LESION_SEVER_WEIGHTS;
 static Boolean      damage_graph_colour = TRUE;
+static Boolean      damage_graph_nested = FALSE;
 static Boolean      damage_graph_paused = FALSE;
 static int          damage_graph_repetitions = 0;
 static int          damage_graph_id = 0;
 static int          damage_graph_reload = 0;
 static char        *damage_graph_folder_name = NULL;
 
+// Proportion correct at each point, over all networks since the last reset:
+static RunningStats damage_graph_animal[MAX_POINTS];
+static RunningStats damage_graph_artifact[MAX_POINTS];
+
+// During a run the graph is redrawn from a timer, at most every
+// REDRAW_INTERVAL ms, however quickly the networks are tested:
+#define REDRAW_INTERVAL  100
+static Boolean      damage_graph_redraw_pending = FALSE;
+static guint        damage_graph_redraw_timer = 0;
+
 //  Add names of more damage types here if necessary
 static char *damage_prefix[4] = {
     "zero",
@@ -155,6 +167,27 @@ static Boolean lesion_viewer_repaint(XGlobals *xg)
     return(FALSE);
 }
 
+static gboolean lesion_viewer_redraw_timeout(gpointer data)
+{
+    if (damage_graph_redraw_pending) {
+        damage_graph_redraw_pending = FALSE;
+        lesion_viewer_repaint((XGlobals *)data);
+        return(TRUE);
+    }
+    else {
+        damage_graph_redraw_timer = 0;
+        return(FALSE);
+    }
+}
+
+static void lesion_viewer_request_redraw(XGlobals *xg)
+{
+    damage_graph_redraw_pending = TRUE;
+    if (damage_graph_redraw_timer == 0) {
+        damage_graph_redraw_timer = g_timeout_add(REDRAW_INTERVAL, lesion_viewer_redraw_timeout, xg);
+    }
+}
+
 /******************************************************************************/
 
 Boolean name_is_unique(PatternList *patterns, double name_vec[NUM_NAME])
@@ -224,15 +257,20 @@ static void test_naming(Network *test_net, PatternList *patterns, double *animal
 
 /*----------------------------------------------------------------------------*/
 
-static void save_results_to_graph(int num_net, int i, double ll, double an_err, double art_err)
+static void reset_results()
 {
-    // We need these to be static so that values persist while we sum
-    // over replications
-    static float animal_error[MAX_NETWORKS][MAX_POINTS];
-    static float artifact_error[MAX_NETWORKS][MAX_POINTS];
+    int i;
 
-    animal_error[num_net][i] = an_err;
-    artifact_error[num_net][i] = art_err;
+    for (i = 0; i < MAX_POINTS; i++) {
+        running_stats_reset(&damage_graph_animal[i]);
+        running_stats_reset(&damage_graph_artifact[i]);
+    }
+}
+
+static void save_results_to_graph(int num_net, int i, double ll, double an_err, double art_err)
+{
+    running_stats_add(&damage_graph_animal[i], an_err);
+    running_stats_add(&damage_graph_artifact[i], art_err);
 
     if (damage_graph_reload == RELOAD_SAMPLE_P4_CLOUD) {
         double jitter = 0.0;
@@ -263,32 +301,13 @@ static void save_results_to_graph(int num_net, int i, double ll, double an_err,
     else {
         /* Otherwise, we show means and standard errors: */
 
-        double sum_animal_e;
-        double sum_artifact_e;
-        double ssq_animal_e;
-        double ssq_artifact_e;
-        int k;
-
-        sum_animal_e = 0;
-        sum_artifact_e = 0;
-        ssq_animal_e = 0;
-        ssq_artifact_e = 0;
-
-        for (k = 0; k <= num_net; k++) {
-            sum_animal_e += animal_error[k][i];
-            ssq_animal_e += (animal_error[k][i] * animal_error[k][i]);
-            sum_artifact_e += artifact_error[k][i];
-            ssq_artifact_e += (artifact_error[k][i] * artifact_error[k][i]);
-        }
-
         // Now log the results on the graph:
         damage_graph_data->dataset[0].x[i] = ll;
         damage_graph_data->dataset[1].x[i] = ll;
-        // Set line data to means of [num_net][i] for k = 0 < num_net
-        damage_graph_data->dataset[0].y[i] = (num_net+1 > 0) ? sum_animal_e / (double) (num_net+1) : 0.0;
-        damage_graph_data->dataset[0].se[i] = sqrt((ssq_animal_e - (sum_animal_e*sum_animal_e / (double) (num_net+1)))/((double) num_net)) / sqrt(num_net+1);
-        damage_graph_data->dataset[1].y[i] = (num_net+1 > 0) ? sum_artifact_e / (double) (num_net+1) : 0.0;
-        damage_graph_data->dataset[1].se[i] = sqrt((ssq_artifact_e - (sum_artifact_e*sum_artifact_e / (double) (num_net+1)))/((double) num_net)) / sqrt(num_net+1);
+        damage_graph_data->dataset[0].y[i] = running_stats_mean(&damage_graph_animal[i]);
+        damage_graph_data->dataset[0].se[i] = running_stats_se(&damage_graph_animal[i]);
+        damage_graph_data->dataset[1].y[i] = running_stats_mean(&damage_graph_artifact[i]);
+        damage_graph_data->dataset[1].se[i] = running_stats_se(&damage_graph_artifact[i]);
 
     // The above calculation of SE assumes that observations from each network
     // are independent. If we're looking at behaviour of the general
@@ -302,17 +321,16 @@ static void save_results_to_graph(int num_net, int i, double ll, double an_err,
 
 static void generate_lesion_data(XGlobals *xg, int steps)
 {
-    Network *tmp, *my_net;
+    Network *my_net;
+    DamageOverlay *damage;
+    DamageOverlay *nested[MAX_REPS];
+    Boolean nesting = damage_graph_nested && (damage_graph_damage_type == LESION_SEVER_WEIGHTS);
     int i, num_net, num_rep;
     char filename[128];
     FILE *fp;
 
     damage_graph_paused = FALSE;
 
-    if (damage_graph_repetitions + steps > MAX_NETWORKS) {
-        steps = MAX_NETWORKS - damage_graph_repetitions;
-    }
-
 
     for (num_net = 0; num_net < steps; num_net++) {
         damage_graph_repetitions++;
@@ -410,6 +428,19 @@ static void generate_lesion_data(XGlobals *xg, int steps)
             interval_width = 0;
         }
 
+        // Each replication damages my_net through the overlay, not a copy:
+        damage = damage_overlay_create(my_net);
+        network_tell_damage(my_net, damage);
+
+        if (nesting) {
+            // Nested lesions: each repetition keeps its own overlay, with one
+            // ranking of the connections, from the first level to the last:
+            for (num_rep = 0; num_rep < MAX_REPS; num_rep++) {
+                nested[num_rep] = damage_overlay_create(my_net);
+                damage_overlay_rank_weights(nested[num_rep]);
+            }
+        }
+
         for (i = 0; i < MAX_POINTS; i++) {
             double ll;
             double an_err, art_err;
@@ -435,19 +466,23 @@ static void generate_lesion_data(XGlobals *xg, int steps)
 
             // Repeat multiple times per network, accumulating results as we go
             for (num_rep = 0; num_rep < MAX_REPS; num_rep++) {
-                tmp = network_copy(my_net);
+                damage_overlay_clear(damage);
 
-                if (damage_graph_damage_type == LESION_SEVER_WEIGHTS) {
-                    network_sever_weights(tmp, ll / 100.0);
+                if (nesting) {
+                    damage_overlay_sever_nested(nested[num_rep], ll / 100.0);
+                    network_tell_damage(my_net, nested[num_rep]);
+                }
+                else if (damage_graph_damage_type == LESION_SEVER_WEIGHTS) {
+                    damage_overlay_sever_weights(damage, ll / 100.0);
                 }
                 else if (damage_graph_damage_type == LESION_PERTURB_WEIGHTS) {
-                    network_perturb_weights(tmp, ll);
+                    damage_overlay_perturb_weights(damage, ll);
                 }
                 else if (damage_graph_damage_type == LESION_ABLATE_UNITS) {
-                    network_ablate_units(tmp, ll / 100.0);
+                    damage_overlay_ablate_units(damage, ll / 100.0);
                 }
                 else if (damage_graph_damage_type == LESION_SCALE_WEIGHTS) {
-                    network_scale_weights(tmp, ll);
+                    damage_overlay_scale_weights(damage, ll);
                 }
                 else {
                     fprintf(stdout, "WARNING: Unknown damage type!\n");
@@ -455,14 +490,13 @@ static void generate_lesion_data(XGlobals *xg, int steps)
 
                 if (damage_graph_id == 0) { // Naming: Animals versus Artifacts
                     double an_err_tmp, art_err_tmp;
-                    test_naming(tmp, xg->pattern_set, &an_err_tmp, &art_err_tmp);
+                    test_naming(my_net, xg->pattern_set, &an_err_tmp, &art_err_tmp);
                     an_err_sum += an_err_tmp;
                     art_err_sum += art_err_tmp;
                 }
                 else { // Lambon Ralph graphs:
                     // Do nothing
                 }
-                network_destroy(tmp);
             }
             an_err = an_err_sum / (double) MAX_REPS;
             art_err = art_err_sum / (double) MAX_REPS;
@@ -495,12 +529,19 @@ static void generate_lesion_data(XGlobals *xg, int steps)
         fclose(fp);
 #endif
 
+        network_tell_damage(my_net, NULL);
+        damage_overlay_destroy(damage);
+        if (nesting) {
+            for (num_rep = 0; num_rep < MAX_REPS; num_rep++) {
+                damage_overlay_destroy(nested[num_rep]);
+            }
+        }
         network_destroy(my_net);
-        lesion_viewer_repaint(xg);
+        lesion_viewer_request_redraw(xg);
         gtkx_flush_events();
 
 	if (damage_graph_paused) {
-	  num_net = MAX_NETWORKS;
+	  num_net = steps;
 	}
         fprintf(stdout, "\n");
     }
@@ -513,7 +554,8 @@ static void generate_lesion_data(XGlobals *xg, int steps)
 static void callback_run_individual_differences(GtkWidget *button, XGlobals *xg)
 {
     char filename[64];
-    Network *tmp, *my_net;
+    Network *my_net;
+    DamageOverlay *damage;
     int individuals = 20;
     int i, j, k;
 
@@ -522,6 +564,7 @@ static void callback_run_individual_differences(GtkWidget *button, XGlobals *xg)
     pattern_file_load_from_folder(xg, damage_graph_folder_name);
     for (j = 0; j < individuals; j++) {
         damage_graph_repetitions = 0;
+        reset_results();
         fprintf(stdout, "Network %3d of %3d ...", j+1, individuals); fflush(stdout);
 
         // Load weights:
@@ -529,31 +572,47 @@ static void callback_run_individual_differences(GtkWidget *button, XGlobals *xg)
 
         weight_file_read(xg, filename);
         my_net = network_copy(xg->net);
+        damage = damage_overlay_create(my_net);
+        network_tell_damage(my_net, damage);
 
-        for (k = 0; k < 25; k++) {
+        for (k = 0; k < INDIVIDUAL_REPS; k++) {
             damage_graph_repetitions++;
             damage_graph_data->dataset[0].points = MAX_POINTS;
             damage_graph_data->dataset[1].points = MAX_POINTS;
 
+            if (damage_graph_nested) {
+                // One ranking for all levels of this repetition:
+                damage_overlay_clear(damage);
+                damage_overlay_rank_weights(damage);
+            }
+
             for (i = 0; i < MAX_POINTS; i++) {
                 double ll;
-                tmp = network_copy(my_net);
+
+                if (!damage_graph_nested || (damage_graph_damage_type != LESION_SEVER_WEIGHTS)) {
+                    damage_overlay_clear(damage);
+                }
 
                 if (damage_graph_damage_type == LESION_SEVER_WEIGHTS) {
                     ll = 100 * i * MAX_SEVER / (double) (MAX_POINTS - 1);
-                    network_sever_weights(tmp, ll / 100.0);
+                    if (damage_graph_nested) {
+                        damage_overlay_sever_nested(damage, ll / 100.0);
+                    }
+                    else {
+                        damage_overlay_sever_weights(damage, ll / 100.0);
+                    }
                 }
                 else if (damage_graph_damage_type == LESION_PERTURB_WEIGHTS) {
                     ll = i * MAX_PERTURB / (double) (MAX_POINTS - 1);
-                    network_perturb_weights(tmp, ll);
+                    damage_overlay_perturb_weights(damage, ll);
                 }
                 else if (damage_graph_damage_type == LESION_ABLATE_UNITS) {
                     ll = 100 * i * MAX_ABLATE / (double) (MAX_POINTS - 1);
-                    network_ablate_units(tmp, ll / 100.0);
+                    damage_overlay_ablate_units(damage, ll / 100.0);
                 }
                 else if (damage_graph_damage_type == LESION_SCALE_WEIGHTS) {
                     ll = MIN_SCALE - (MIN_SCALE-MAX_SCALE) * (i / (double) (MAX_POINTS - 1));
-                    network_scale_weights(tmp, ll);
+                    damage_overlay_scale_weights(damage, ll);
                 }
                 else {
                     ll = 0.0;
@@ -561,19 +620,20 @@ static void callback_run_individual_differences(GtkWidget *button, XGlobals *xg)
                 }
 
                 if (damage_graph_id == 0) { // Naming: Animals versus Artifacts
-                    test_naming(tmp, xg->pattern_set, k, i, ll);
+                    test_naming(my_net, xg->pattern_set, k, i, ll);
                 }
                 else { // Lambon Ralph et al. (2007) graphs:
                     // Do nothing
                 }
-                network_destroy(tmp);
             }
-            lesion_viewer_repaint(xg);
+            lesion_viewer_request_redraw(xg);
             gtkx_flush_events();
     	    if (damage_graph_paused) {
-                j = individuals; k = MAX_NETWORKS;
+                j = individuals; k = INDIVIDUAL_REPS;
             }
         }
+        network_tell_damage(my_net, NULL);
+        damage_overlay_destroy(damage);
         network_destroy(my_net);
         fprintf(stdout, "\n");
 
@@ -611,6 +671,7 @@ static void callback_lesion_graph_restart(GtkWidget *button, XGlobals *xg)
     int i;
 
     damage_graph_repetitions = 0;
+    reset_results();
     for (i = 0; i < 20; i++) {
         damage_graph_data->dataset[2*i].points = 0;
         damage_graph_data->dataset[2*i+1].points = 0;
@@ -646,6 +707,13 @@ static void callback_toggle_colour(GtkWidget *button, XGlobals *xg)
 
 /*----------------------------------------------------------------------------*/
 
+static void callback_toggle_nested(GtkWidget *button, XGlobals *xg)
+{
+    damage_graph_nested = (Boolean) (GTK_TOGGLE_BUTTON(button)->active);
+}
+
+/*----------------------------------------------------------------------------*/
+
 static void reset_graph_data()
 {
     int i;
@@ -730,6 +798,7 @@ static void reset_graph_data()
     }
 
     damage_graph_repetitions = 0;
+    reset_results();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -811,6 +880,10 @@ static void lesion_viewer_destroy(GtkWidget *viewer1, XGlobals xg)
     graph_destroy(damage_graph_data);
     damage_graph_data = NULL;
     damage_graph_viewer = NULL;
+    if (damage_graph_redraw_timer != 0) {
+        g_source_remove(damage_graph_redraw_timer);
+        damage_graph_redraw_timer = 0;
+    }
 }
 
 /*----------------------------------------------------------------------------*/
@@ -916,6 +989,21 @@ void hub_lesion_create_widgets(GtkWidget *page, XGlobals *xg)
     gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 5);
     gtk_widget_show(tmp);
 
+    /* Widgets for nested (cumulative) severing of connections: */
+    tmp = gtk_label_new("Nested: ");
+    gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 0);
+    gtk_widget_show(tmp);
+    tmp = gtk_check_button_new();
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(tmp), damage_graph_nested);
+    gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 0);
+    g_signal_connect(G_OBJECT(tmp), "toggled", G_CALLBACK(callback_toggle_nested), xg);
+    gtk_widget_show(tmp);
+
+    /*--- Spacer: ---*/
+    tmp = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 5);
+    gtk_widget_show(tmp);
+
     /* Widgets for setting colour/greyscale: */
     tmp = gtk_label_new("Colour: ");
     gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 0);
@@ -23,6 +23,19 @@
         double euclidean_distance(int n, double *a, double *b);
         double jaccard_distance(int n, double *a, double *b);
         double vector_set_variability(int n, int l, double *v);
+        void   random_stream_initialise(RandomStream *rs, uint64_t seed, uint32_t id0, uint32_t id1, uint32_t id2, uint32_t id3);
+        uint32_t random_stream_next(RandomStream *rs);
+        double random_stream_uniform(RandomStream *rs, double low, double high);
+        double random_stream_normal(RandomStream *rs, double mean, double sd);
+        int    random_stream_int(RandomStream *rs, int n);
+        void   random_stream_fill_uniform(RandomStream *rs, double *buffer, int n, double low, double high);
+        void   random_stream_fill_normal(RandomStream *rs, double *buffer, int n, double mean, double sd);
+        void   random_stream_select(RandomStream *rs);
+        void   random_fill_normal(double *buffer, int n, double mean, double sd);
+        void   random_fill_uniform(double *buffer, int n, double low, double high);
+        int    random_bernoulli_next(int i, int n, double p);
+        int    random_bernoulli_indices(int n, double p, int *indices);
+        void   random_ranking(int n, int *order, double *key);
 
 *******************************************************************************/
 /******** Include files: ******************************************************/
@@ -34,19 +47,34 @@
 
 /******************************************************************************/
 
+// The stream (if any) that random_uniform() etc. draw from on this thread:
+static __thread RandomStream *random_thread_stream = NULL;
+
 double random_normal(double mean, double sd)
 {
     // This generates a random integer with given mean and standard deviation
 
-    double r1 = (rand() + 1.0) / (RAND_MAX + 1.0);
-    double r2 = (rand() + 1.0) / (RAND_MAX + 1.0);
+    double r1, r2;
+
+    if (random_thread_stream != NULL) {
+        return(random_stream_normal(random_thread_stream, mean, sd));
+    }
+
+    r1 = (rand() + 1.0) / (RAND_MAX + 1.0);
+    r2 = (rand() + 1.0) / (RAND_MAX + 1.0);
 
     return(mean + sd * sqrt(-2 * log(r1)) * cos(6.2831853 * r2));
 }
 
 double random_uniform(double low, double high)
 {
-    double r = (rand() + 1.0) / (RAND_MAX + 1.0);
+    double r;
+
+    if (random_thread_stream != NULL) {
+        return(random_stream_uniform(random_thread_stream, low, high));
+    }
+
+    r = (rand() + 1.0) / (RAND_MAX + 1.0);
 
     return(low + (r * (high - low)));
 }
@@ -55,9 +83,310 @@ int random_int(int n)
 {
     // This generates a random integer in the range [0, n)
 
+    if (random_thread_stream != NULL) {
+        return(random_stream_int(random_thread_stream, n));
+    }
+
     return(n * (rand() + 1.0) / (RAND_MAX + 1.0));
 }
 
+/******************************************************************************/
+/* Counter-based random streams: Block n of a stream is Philox4x32-10 (Salmon */
+/* et al., 2011) applied to the counter n under the stream's key. No state is */
+/* shared between streams, and a stream's output is the same on any thread.  */
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+static void philox4x32_10(const uint32_t *counter, const uint32_t *key, uint32_t *out)
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    uint64_t p0, p1;
+    int r;
+
+    for (r = 0; r < 10; r++) {
+        p0 = (uint64_t) PHILOX_M0 * c0;
+        p1 = (uint64_t) PHILOX_M1 * c2;
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) p1;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+void random_stream_initialise(RandomStream *rs, uint64_t seed, uint32_t id0, uint32_t id1, uint32_t id2, uint32_t id3)
+{
+    // The ids are enciphered under the seed to give the stream's key and the
+    // fixed half of its counter. Encipherment is a bijection, so distinct id
+    // tuples always give distinct streams.
+
+    uint32_t ids[4], seed_key[2], image[4];
+
+    ids[0] = id0;
+    ids[1] = id1;
+    ids[2] = id2;
+    ids[3] = id3;
+    seed_key[0] = (uint32_t) seed;
+    seed_key[1] = (uint32_t) (seed >> 32);
+    philox4x32_10(ids, seed_key, image);
+
+    rs->key[0] = image[0];
+    rs->key[1] = image[1];
+    rs->counter[0] = 0;
+    rs->counter[1] = 0;
+    rs->counter[2] = image[2];
+    rs->counter[3] = image[3];
+    rs->used = 4;
+    rs->has_spare = 0;
+    rs->spare = 0.0;
+}
+
+uint32_t random_stream_next(RandomStream *rs)
+{
+    if (rs->used == 4) {
+        philox4x32_10(rs->counter, rs->key, rs->block);
+        if (++rs->counter[0] == 0) {
+            rs->counter[1]++;
+        }
+        rs->used = 0;
+    }
+    return(rs->block[rs->used++]);
+}
+
+static double random_stream_open01(RandomStream *rs)
+{
+    // Uniform on the open interval (0, 1), so it is always safe to take logs:
+
+    return((random_stream_next(rs) + 0.5) * (1.0 / 4294967296.0));
+}
+
+double random_stream_uniform(RandomStream *rs, double low, double high)
+{
+    return(low + (random_stream_open01(rs) * (high - low)));
+}
+
+int random_stream_int(RandomStream *rs, int n)
+{
+    // A random integer in the range [0, n)
+
+    return((int) (n * random_stream_open01(rs)));
+}
+
+double random_stream_normal(RandomStream *rs, double mean, double sd)
+{
+    // Box-Muller, keeping the second variate of each pair for the next call:
+
+    double r, theta;
+
+    if (rs->has_spare) {
+        rs->has_spare = 0;
+        return(mean + sd * rs->spare);
+    }
+    r = sqrt(-2.0 * log(random_stream_open01(rs)));
+    theta = 6.283185307179586 * random_stream_open01(rs);
+    rs->spare = r * sin(theta);
+    rs->has_spare = 1;
+    return(mean + sd * r * cos(theta));
+}
+
+void random_stream_fill_uniform(RandomStream *rs, double *buffer, int n, double low, double high)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        buffer[i] = low + (random_stream_open01(rs) * (high - low));
+    }
+}
+
+// Gaussian buffers are filled a block of Box-Muller pairs at a time: the
+// uniforms for the whole block are drawn first, then transformed by a loop
+// with no dependencies between iterations, which the compiler can unroll
+// and vectorise.
+
+#define RANDOM_BLOCK 128
+
+static void box_muller_block(int pairs, const double *u1, const double *u2, double *buffer, double mean, double sd)
+{
+    double r, theta;
+    int k;
+
+    for (k = 0; k < pairs; k++) {
+        r = sd * sqrt(-2.0 * log(u1[k]));
+        theta = 6.283185307179586 * u2[k];
+        buffer[2*k] = mean + r * cos(theta);
+        buffer[2*k+1] = mean + r * sin(theta);
+    }
+}
+
+void random_stream_fill_normal(RandomStream *rs, double *buffer, int n, double mean, double sd)
+{
+    // Both variates of each Box-Muller pair are used:
+
+    double u1[RANDOM_BLOCK], u2[RANDOM_BLOCK];
+    int i = 0, k, pairs;
+
+    if ((n > 0) && rs->has_spare) {
+        buffer[i++] = random_stream_normal(rs, mean, sd);
+    }
+    while (i + 1 < n) {
+        pairs = (n - i) / 2;
+        if (pairs > RANDOM_BLOCK) {
+            pairs = RANDOM_BLOCK;
+        }
+        for (k = 0; k < pairs; k++) {
+            u1[k] = random_stream_open01(rs);
+            u2[k] = random_stream_open01(rs);
+        }
+        box_muller_block(pairs, u1, u2, &buffer[i], mean, sd);
+        i += 2 * pairs;
+    }
+    if (i < n) {
+        buffer[i] = random_stream_normal(rs, mean, sd);
+    }
+}
+
+void random_stream_select(RandomStream *rs)
+{
+    // Make random_uniform(), random_normal() and random_int() draw from rs on
+    // the calling thread (or from rand() again, if rs is NULL):
+
+    random_thread_stream = rs;
+}
+
+/******************************************************************************/
+
+void random_fill_normal(double *buffer, int n, double mean, double sd)
+{
+    // Fill buffer with n values drawn as by random_normal(), but using both
+    // variates of each pair:
+
+    double u1[RANDOM_BLOCK], u2[RANDOM_BLOCK];
+    int i = 0, k, pairs;
+
+    if (random_thread_stream != NULL) {
+        random_stream_fill_normal(random_thread_stream, buffer, n, mean, sd);
+        return;
+    }
+    while (i + 1 < n) {
+        pairs = (n - i) / 2;
+        if (pairs > RANDOM_BLOCK) {
+            pairs = RANDOM_BLOCK;
+        }
+        for (k = 0; k < pairs; k++) {
+            u1[k] = (rand() + 1.0) / (RAND_MAX + 1.0);
+            u2[k] = (rand() + 1.0) / (RAND_MAX + 1.0);
+        }
+        box_muller_block(pairs, u1, u2, &buffer[i], mean, sd);
+        i += 2 * pairs;
+    }
+    if (i < n) {
+        buffer[i] = random_normal(mean, sd);
+    }
+}
+
+void random_fill_uniform(double *buffer, int n, double low, double high)
+{
+    int i;
+
+    if (random_thread_stream != NULL) {
+        random_stream_fill_uniform(random_thread_stream, buffer, n, low, high);
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        buffer[i] = low + (((rand() + 1.0) / (RAND_MAX + 1.0)) * (high - low));
+    }
+}
+
+/******************************************************************************/
+/* Bernoulli sampling by geometric skips: rather than testing each of n      */
+/* items against p, the gap to the next chosen item is drawn directly, as    */
+/* floor(log(u) / log(1 - p)), which has the same (geometric) distribution.  */
+/* This takes one random number per chosen item rather than one per item.   */
+
+int random_bernoulli_next(int i, int n, double p)
+{
+    // The next item after i (use -1 to start) chosen with probability p from
+    // 0 ... n-1, or n if there are no more:
+
+    double gap;
+
+    if (i + 1 >= n) {
+        return(n);
+    }
+    else if (p >= 1.0) {
+        return(i + 1);
+    }
+    else if (p <= 0.0) {
+        return(n);
+    }
+    gap = floor(log(random_uniform(0.0, 1.0)) / log1p(-p));
+    // The negated test also catches u == 0, which gives an infinite gap:
+    if (!(gap < (double) (n - 1 - i))) {
+        return(n);
+    }
+    return(i + 1 + (int) gap);
+}
+
+int random_bernoulli_indices(int n, double p, int *indices)
+{
+    // Store the indices chosen from 0 ... n-1 (in increasing order) in
+    // indices, which must have room for n, and return how many there are:
+
+    int i, count = 0;
+
+    for (i = random_bernoulli_next(-1, n, p); i < n; i = random_bernoulli_next(i, n, p)) {
+        indices[count++] = i;
+    }
+    return(count);
+}
+
+void random_ranking(int n, int *order, double *key)
+{
+    // A random ordering of 0 ... n-1 with increasing keys in (0, 1), where
+    // key[k] belongs to item order[k] and each item's key is uniform and
+    // independent of the others. Keys are formed directly in order, as the
+    // partial sums of n+1 exponential spacings divided by their total, so
+    // no sort is needed. Taking the items with key below p chooses each with
+    // probability p, and the items chosen for p are a subset of those for
+    // any larger p.
+
+    double u, sum = 0.0;
+    int i, j, tmp;
+
+    for (i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    for (i = n - 1; i > 0; i--) {
+        if ((j = random_int(i + 1)) > i) {
+            j = i;
+        }
+        tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for (i = 0; i <= n; i++) {
+        do {
+            u = random_uniform(0.0, 1.0);
+        } while (u <= 0.0);
+        sum -= log(u);
+        if (i < n) {
+            key[i] = sum;
+        }
+    }
+    for (i = 0; i < n; i++) {
+        key[i] /= sum;
+    }
+}
+
 double squared(double input)
 {
     return(input * input);
@@ -210,3 +539,58 @@ double jaccard_distance(int n, double *a, double *b)
 }
 
 /******************************************************************************/
+
+void running_stats_reset(RunningStats *rs)
+{
+    rs->n = 0;
+    rs->mean = 0.0;
+    rs->m2 = 0.0;
+}
+
+void running_stats_add(RunningStats *rs, double x)
+{
+    double delta = x - rs->mean;
+
+    rs->n++;
+    rs->mean += delta / (double) rs->n;
+    rs->m2 += delta * (x - rs->mean);
+}
+
+void running_stats_merge(RunningStats *rs, RunningStats *other)
+{
+    /* Combine two partial aggregates (Chan et al., 1979): */
+
+    long n = rs->n + other->n;
+    double delta = other->mean - rs->mean;
+
+    if (other->n == 0) {
+        return;
+    }
+    else if (rs->n == 0) {
+        *rs = *other;
+    }
+    else {
+        rs->mean += delta * other->n / (double) n;
+        rs->m2 += other->m2 + delta * delta * rs->n * (double) other->n / (double) n;
+        rs->n = n;
+    }
+}
+
+double running_stats_mean(RunningStats *rs)
+{
+    return(rs->mean);
+}
+
+double running_stats_variance(RunningStats *rs)
+{
+    /* The sample (n-1) variance, or 0 if there are fewer than two values: */
+
+    return((rs->n > 1) ? rs->m2 / (double) (rs->n - 1) : 0.0);
+}
+
+double running_stats_se(RunningStats *rs)
+{
+    return((rs->n > 1) ? sqrt(running_stats_variance(rs) / (double) rs->n) : 0.0);
+}
+
+/******************************************************************************/
@@ -2,6 +2,8 @@
 
 #define _lib_math_h_
 
+#include <stdint.h>
+
 extern double random_uniform(double low, double high);
 extern double random_normal(double mean, double sd);
 extern int    random_int(int n);
@@ -20,4 +22,47 @@ extern double euclidean_distance(int n, double *a, double *b);
 extern double jaccard_distance(int n, double *a, double *b);
 extern double vector_set_variability(int n, int l, double *v);
 
+/* A counter-based random stream (Philox4x32-10). Each stream is identified  */
+/* by a seed and four 32-bit ids, and its output depends on nothing else, so  */
+/* streams may be used on any thread in any order with reproducible results. */
+
+typedef struct random_stream {
+    uint32_t key[2];
+    uint32_t counter[4];   /* counter[0..1] count blocks; [2..3] fix the stream */
+    uint32_t block[4];
+    int      used;         /* Words of block[] already consumed */
+    int      has_spare;    /* Second variate of the last Box-Muller pair */
+    double   spare;
+} RandomStream;
+
+extern void   random_stream_initialise(RandomStream *rs, uint64_t seed, uint32_t id0, uint32_t id1, uint32_t id2, uint32_t id3);
+extern uint32_t random_stream_next(RandomStream *rs);
+extern double random_stream_uniform(RandomStream *rs, double low, double high);
+extern double random_stream_normal(RandomStream *rs, double mean, double sd);
+extern int    random_stream_int(RandomStream *rs, int n);
+extern void   random_stream_fill_uniform(RandomStream *rs, double *buffer, int n, double low, double high);
+extern void   random_stream_fill_normal(RandomStream *rs, double *buffer, int n, double mean, double sd);
+extern void   random_stream_select(RandomStream *rs);
+extern void   random_fill_normal(double *buffer, int n, double mean, double sd);
+extern void   random_fill_uniform(double *buffer, int n, double low, double high);
+extern int    random_bernoulli_next(int i, int n, double p);
+extern int    random_bernoulli_indices(int n, double p, int *indices);
+extern void   random_ranking(int n, int *order, double *key);
+
+/* Streaming mean and variance (Welford). Partial results, e.g. from separate */
+/* threads or processes, may be merged exactly with running_stats_merge.      */
+
+typedef struct running_stats {
+    long     n;
+    double   mean;
+    double   m2;           /* Sum of squared deviations from the mean */
+} RunningStats;
+
+extern void   running_stats_reset(RunningStats *rs);
+extern void   running_stats_add(RunningStats *rs, double x);
+extern void   running_stats_merge(RunningStats *rs, RunningStats *other);
+extern double running_stats_mean(RunningStats *rs);
+extern double running_stats_variance(RunningStats *rs);
+extern double running_stats_se(RunningStats *rs);
+
 #endif
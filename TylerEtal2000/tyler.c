@@ -9,6 +9,9 @@
 
 #include <glib.h>
 #include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <sys/stat.h>
 
 //    NetworkParameters pars: NT, WN, LR, Momentum, Decay, Error, Update, Epochs, Criterion
@@ -19,15 +22,68 @@ NetworkParameters pars =
 
 #define ERR_WRITE_CYCLES      1000
 
-#define ATTRACTOR_MAX 1<<12
-
-typedef struct at_tab_entry {
-  double vector[HIDDEN_WIDTH];
-  int count;
-} AtTabEntry;
-
-static AtTabEntry attractor_table[ATTRACTOR_MAX];
-static int attractor_count;
+/* Attractors are kept in a growable array, indexed by a hash of the grid  */
+/* cell containing each. A cell is ATTRACTOR_CELL_SCALE settling distances  */
+/* on a side, so a state that matches an attractor lies either in the same  */
+/* cell or, in those dimensions where it is within the settling distance of */
+/* a cell boundary, in the cell across that boundary. Only those cells are  */
+/* searched. Of several matches the earliest found is taken, as when the    */
+/* attractors were searched in order.                                       */
+
+#define ATTRACTOR_CELL_SCALE 64.0
+#define ATTRACTOR_INITIAL 256
+
+typedef struct attractor {
+    double vector[HIDDEN_WIDTH];
+    int count;
+    int first_input;           // The first input found to settle here
+    uint64_t cell;             // Hash of the grid cell containing vector
+    int next;                  // The next attractor in the same hash bucket
+} Attractor;
+
+typedef struct attractor_table {
+    Attractor *entry;
+    int count;
+    int size;                  // Entries allocated
+    int *bucket;               // First attractor in each bucket, or -1
+    int buckets;               // A power of 2, at least twice size
+} AttractorTable;
+
+/* The input space is enumerated in parallel. Workers take chunks of        */
+/* ENUMERATE_CHUNK inputs from a shared counter, each settling its own copy  */
+/* of the network and collecting attractors in its own table, and the tables */
+/* are merged when all inputs are done. Each chunk draws its initial hidden  */
+/* states from its own random stream, so the states reached do not depend   */
+/* on the number of threads.                                                 */
+
+/* In Gray code order (-g) consecutive inputs differ in one unit, so within */
+/* a chunk the input layer's contribution to the hidden units is updated by */
+/* one row of weights per input, instead of being recomputed in full. It is */
+/* recomputed at the start of each chunk, which bounds rounding drift.      */
+
+#define ENUMERATE_CHUNK (1<<16)
+#define MAX_THREADS 64
+#define PROGRESS_INTERVAL 250000   // Microseconds between progress checks
+
+typedef struct enumeration {
+    Network *net;              // The (possibly damaged) network; read only
+    uint64_t seed;
+    uint32_t id0, id1;         // Identify the network and damage level
+    int in_max;
+    Boolean gray;              // Enumerate in Gray code order
+    int next_chunk;            // Shared: the next chunk to be taken
+    int done;                  // Shared: inputs enumerated so far
+} Enumeration;
+
+typedef struct enumeration_worker {
+    pthread_t thread;
+    Enumeration *e;
+    AttractorTable *table;
+} EnumerationWorker;
+
+static int enumerate_threads = 1;
+static uint64_t enumerate_seed = 0;
+static Boolean enumerate_gray = FALSE;
 
 #define DAMAGE_LEVELS 21
 #define LESION_WEIGHTS TRUE
@@ -104,62 +160,312 @@ static void build_pattern(double vector_in[IO_WIDTH], int i)
     }
 }
 
-static void save_attractor(Network *net)
+static uint64_t attractor_cell_hash(long *cell)
 {
-    double vector_hidden[HIDDEN_WIDTH];
-    int i = 0, j;
+    uint64_t h = 0;
+    int d;
 
-    network_ask_hidden(net, vector_hidden);
+    for (d = 0; d < HIDDEN_WIDTH; d++) {
+        h = (h ^ (uint64_t) cell[d]) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 32;
+    }
+    return(h);
+}
 
-    while ((i < attractor_count) && (vector_sum_square_difference(HIDDEN_WIDTH, vector_hidden, attractor_table[i].vector) > NET_SETTLING_THRESHOLD)) {
-      i++;
+static void attractor_table_rebucket(AttractorTable *t)
+{
+    int i;
+
+    for (i = 0; i < t->buckets; i++) {
+        t->bucket[i] = -1;
+    }
+    for (i = 0; i < t->count; i++) {
+        int b = (int) (t->entry[i].cell & (uint64_t) (t->buckets - 1));
+        t->entry[i].next = t->bucket[b];
+        t->bucket[b] = i;
     }
+}
 
-    if (i == ATTRACTOR_MAX) {
-      fprintf(stdout, "WARNING: TABLE FULL ... TOO MANY ATTRACTORS!\n");
+static Boolean attractor_table_initialise(AttractorTable *t)
+{
+    t->count = 0;
+    t->size = ATTRACTOR_INITIAL;
+    t->buckets = 2 * ATTRACTOR_INITIAL;
+    t->entry = (Attractor *)malloc(t->size * sizeof(Attractor));
+    t->bucket = (int *)malloc(t->buckets * sizeof(int));
+    if ((t->entry == NULL) || (t->bucket == NULL)) {
+        return(FALSE);
     }
-    else if (i == attractor_count) {
-        for (j = 0; j < HIDDEN_WIDTH; j++) {
-            attractor_table[i].vector[j] = vector_hidden[j];
-	}
-        attractor_table[i].count = 1;
-        attractor_count++;
+    attractor_table_rebucket(t);
+    return(TRUE);
+}
+
+static void attractor_table_free(AttractorTable *t)
+{
+    free(t->entry);
+    free(t->bucket);
+    t->entry = NULL;
+    t->bucket = NULL;
+    t->count = t->size = t->buckets = 0;
+}
+
+static Boolean attractor_table_grow(AttractorTable *t)
+{
+    Attractor *entry;
+    int *bucket;
+
+    if ((entry = (Attractor *)realloc(t->entry, 2 * t->size * sizeof(Attractor))) == NULL) {
+        return(FALSE);
     }
-    else {
+    t->entry = entry;
+    t->size = 2 * t->size;
+    if (t->buckets < 2 * t->size) {
+        if ((bucket = (int *)realloc(t->bucket, 4 * t->size * sizeof(int))) == NULL) {
+            return(FALSE);
+        }
+        t->bucket = bucket;
+        t->buckets = 4 * t->size;
+        attractor_table_rebucket(t);
+    }
+    return(TRUE);
+}
+
+static int attractor_table_find(AttractorTable *t, double *vector, uint64_t *home)
+{
+    // Return the index of the earliest attractor within the settling distance
+    // of vector, or -1 if there is none. *home is set to vector's own cell:
+
+    double h = ATTRACTOR_CELL_SCALE * sqrt(NET_SETTLING_THRESHOLD);
+    double r = 1.0 / ATTRACTOR_CELL_SCALE;    // The settling distance, in cells
+    long cell[HIDDEN_WIDTH], probe[HIDDEN_WIDTH];
+    int near[HIDDEN_WIDTH], side[HIDDEN_WIDTH];
+    int d, i, k = 0, mask, found = -1;
+    uint64_t key;
+    double x;
+
+    // Find the cell, and the dimensions in which a neighbour could match:
+    for (d = 0; d < HIDDEN_WIDTH; d++) {
+        x = vector[d] / h;
+        cell[d] = (long) floor(x);
+        if (x - cell[d] <= r) {
+            near[k] = d;
+            side[k++] = -1;
+        }
+        else if (cell[d] + 1 - x <= r) {
+            near[k] = d;
+            side[k++] = 1;
+        }
+    }
+    *home = attractor_cell_hash(cell);
+
+    // Search the home cell and each combination of neighbours across the
+    // near boundaries:
+    for (mask = 0; mask < (1 << k); mask++) {
+        if (mask == 0) {
+            key = *home;
+        }
+        else {
+            for (d = 0; d < HIDDEN_WIDTH; d++) {
+                probe[d] = cell[d];
+            }
+            for (i = 0; i < k; i++) {
+                if (mask & (1 << i)) {
+                    probe[near[i]] += side[i];
+                }
+            }
+            key = attractor_cell_hash(probe);
+        }
+        for (i = t->bucket[key & (uint64_t) (t->buckets - 1)]; i >= 0; i = t->entry[i].next) {
+            if ((t->entry[i].cell == key) && ((found < 0) || (i < found)) && (vector_sum_square_difference(HIDDEN_WIDTH, vector, t->entry[i].vector) <= NET_SETTLING_THRESHOLD)) {
+                found = i;
+            }
+        }
+    }
+    return(found);
+}
+
+static void attractor_table_add(AttractorTable *t, double *vector, int count, int first_input)
+{
+    uint64_t cell;
+    int i, b, j;
+
+    if ((i = attractor_table_find(t, vector, &cell)) >= 0) {
         // Found a duplicate attractor!
-        attractor_table[i].count++;
+        t->entry[i].count += count;
+        t->entry[i].first_input = MIN(t->entry[i].first_input, first_input);
+    }
+    else if ((t->count == t->size) && !attractor_table_grow(t)) {
+        fprintf(stderr, "ERROR: Cannot extend the attractor table ... state not counted\n");
+    }
+    else {
+        i = t->count++;
+        for (j = 0; j < HIDDEN_WIDTH; j++) {
+            t->entry[i].vector[j] = vector[j];
+        }
+        t->entry[i].count = count;
+        t->entry[i].first_input = first_input;
+        t->entry[i].cell = cell;
+        b = (int) (cell & (uint64_t) (t->buckets - 1));
+        t->entry[i].next = t->bucket[b];
+        t->bucket[b] = i;
     }
 }
 
-static int count_attractors_by_damage_level(Network *net)
+static int attractor_compare_first_input(const void *a, const void *b)
+{
+    return((*(Attractor **)a)->first_input - (*(Attractor **)b)->first_input);
+}
+
+static void *enumerate_attractors_worker(void *data)
+{
+    EnumerationWorker *w = (EnumerationWorker *)data;
+    Enumeration *e = w->e;
+    double vector_in[IO_WIDTH];
+    double vector_hidden[HIDDEN_WIDTH];
+    double input_net[HIDDEN_WIDTH];
+    RandomStream rs;
+    Network *net;
+    int c, i, i1, b, p;
+
+    // Our own network, for its unit activations; the weights and damage are
+    // the same as the shared one's:
+    net = network_copy(e->net);
+    network_tell_damage(net, e->net->damage);
+    random_stream_select(&rs);
+
+    while ((c = __atomic_fetch_add(&e->next_chunk, 1, __ATOMIC_RELAXED)) < (e->in_max + ENUMERATE_CHUNK - 1) / ENUMERATE_CHUNK) {
+        random_stream_initialise(&rs, e->seed, e->id0, e->id1, (uint32_t) c, 0);
+        i1 = MIN((c + 1) * ENUMERATE_CHUNK, e->in_max);
+        for (i = c * ENUMERATE_CHUNK; i < i1; i++) {
+            if (!e->gray) {
+                // Construct the pattern:
+                p = i;
+                build_pattern(vector_in, p);
+                // set input to pattern i;
+                network_tell_input(net, vector_in);
+            }
+            else {
+                // The i-th Gray code differs from the last in bit ctz(i):
+                p = i ^ (i >> 1);
+                if (i == c * ENUMERATE_CHUNK) {
+                    build_pattern(vector_in, p);
+                    network_ask_input_net(net, vector_in, input_net);
+                }
+                else {
+                    b = __builtin_ctz(i);
+                    vector_in[b] = 1.0 - vector_in[b];
+                    network_adjust_input_net(net, input_net, b, (vector_in[b] > 0.5) ? 1.0 : -1.0);
+                }
+                network_tell_input_with_net(net, vector_in, input_net);
+            }
+            // run the network until it settles (or 100 cycles);
+            network_tell_randomise_hidden(net);
+            network_tell_propagate_full(net);
+            // add the hidden unit state to the table of state counts
+            network_ask_hidden(net, vector_hidden);
+            attractor_table_add(w->table, vector_hidden, 1, p);
+        }
+        __atomic_fetch_add(&e->done, i1 - c * ENUMERATE_CHUNK, __ATOMIC_RELEASE);
+    }
+
+    random_stream_select(NULL);
+    network_destroy(net);
+    return(NULL);
+}
+
+static int count_attractors_by_damage_level(Network *net, int j, int l)
 {
   // Start by just counting the attractors and writing the results to stdout
   // If that isn't too slow, do it for, say, 21 levels of damage and save the results
   // Note: This is only sensible for the unclamped RAN, so make sure clamps are set to 4 in utils_network.c
 
-    int i, in_max;
-    double vector_in[IO_WIDTH];
+    EnumerationWorker worker[MAX_THREADS];
+    AttractorTable *merged;
+    Attractor **found;
+    Enumeration e;
+    int threads = MAX(1, MIN(enumerate_threads, MAX_THREADS));
+    int done, reported = -1, started, k, n, m;
+
+    e.net = net;
+    e.seed = enumerate_seed;
+    e.id0 = (uint32_t) j;
+    e.id1 = (uint32_t) l;
+    e.in_max = 1<<IO_WIDTH;
+    e.gray = enumerate_gray;
+    e.next_chunk = 0;
+    e.done = 0;
+
+    if ((merged = (AttractorTable *)calloc(threads + 1, sizeof(AttractorTable))) == NULL) {
+        fprintf(stderr, "ERROR: Cannot allocate attractor tables\n");
+        return(0);
+    }
+    for (k = 0; k <= threads; k++) {
+        if (!attractor_table_initialise(&merged[k])) {
+            fprintf(stderr, "ERROR: Cannot allocate attractor tables\n");
+            for (k = 0; k <= threads; k++) {
+                attractor_table_free(&merged[k]);
+            }
+            free(merged);
+            return(0);
+        }
+    }
+    for (k = 0; k < threads; k++) {
+        worker[k].e = &e;
+        worker[k].table = &merged[k+1];
+        if (pthread_create(&worker[k].thread, NULL, enumerate_attractors_worker, &worker[k]) != 0) {
+            break;
+        }
+    }
+    // The chunks are shared out as the workers ask for them, so those that
+    // did start can do them all; if none did, do them here:
+    if (k < threads) {
+        fprintf(stderr, "WARNING: Started %d of %d enumeration threads\n", k, threads);
+    }
+    started = k;
+    if (started == 0) {
+        enumerate_attractors_worker(&worker[0]);
+    }
 
-    in_max = 1<<IO_WIDTH;
-    attractor_count = 0;
+    // And let the user know what's happening:
+    while ((done = __atomic_load_n(&e.done, __ATOMIC_ACQUIRE)) < e.in_max) {
+        if (done * 100.0 / e.in_max >= reported + 1) {
+            reported = (int) (done * 100.0 / e.in_max);
+            fprintf(stdout, "%10d inputs (%d %%)\n", done, reported);
+            fflush(stdout);
+        }
+        usleep(PROGRESS_INTERVAL);
+    }
 
-    for (i = 0; i < in_max; i++) {
-      // Construct the pattern:
-      build_pattern(vector_in, i);
-      // set input to pattern i;
-      network_tell_input(net, vector_in);
-      // run the network until it settles (or 100 cycles);
-      network_tell_randomise_hidden(net);
-      network_tell_propagate_full(net);
-      // add the hidden unit state to the table of state counts
-      save_attractor(net);
-      // And let the use know what's happening:
-      if ((i % (1<<16)) == 0) {
-        fprintf(stdout, "%10d inputs (%d %%); %d attractor states\n", i+1, (i+1)*100/in_max, attractor_count);
-      }
+    // Merge the workers' tables into merged[0], taking their attractors in
+    // the order in which they were first reached:
+    for (k = n = 0; k < threads; k++) {
+        if (k < started) {
+            pthread_join(worker[k].thread, NULL);
+        }
+        n += merged[k+1].count;
+    }
+    if ((found = (Attractor **)malloc(MAX(n, 1) * sizeof(Attractor *))) == NULL) {
+        fprintf(stderr, "ERROR: Cannot allocate attractor tables\n");
+    }
+    else {
+        for (k = m = 0; k < threads; k++) {
+            for (n = 0; n < merged[k+1].count; n++) {
+                found[m++] = &merged[k+1].entry[n];
+            }
+        }
+        qsort(found, m, sizeof(Attractor *), attractor_compare_first_input);
+        for (n = 0; n < m; n++) {
+            attractor_table_add(&merged[0], found[n]->vector, found[n]->count, found[n]->first_input);
+        }
+        free(found);
+    }
+    n = merged[0].count;
+    fprintf(stdout, "%10d inputs (100 %%); %d attractor states\n", e.in_max, n);
+    for (k = 0; k <= threads; k++) {
+        attractor_table_free(&merged[k]);
     }
-    fprintf(stdout, "%10d inputs (%d %%); %d attractor states\n", i+1, (i+1)*100/in_max, attractor_count);
-    return(attractor_count);
+    free(merged);
+    return(n);
 }
 
 void train_and_count_attractors(int j, char *training_set_file)
@@ -167,6 +473,7 @@ void train_and_count_attractors(int j, char *training_set_file)
     double rms, cross_entropy, sme;
     PatternList *training_set;
     Network *net;
+    DamageOverlay *damage;
     FILE *fp;
     int i;
 
@@ -184,28 +491,31 @@ void train_and_count_attractors(int j, char *training_set_file)
         network_train(net, &pars, training_set);
     }
 
+    damage = damage_overlay_create(net);
     for (i = 0; i < DAMAGE_LEVELS; i++) {
-        Network *tmp = network_copy(net);
         double ll;
 	int n;
 
+        damage_overlay_clear(damage);
         if (LESION_WEIGHTS) {
             ll = 100 * i * MAX_DAMAGE / (double) (DAMAGE_LEVELS - 1);
-            network_lesion_weights(tmp, ll / 100.0);
+            damage_overlay_lesion_weights(damage, ll / 100.0);
         }
         else {
             ll = i * MAX_NOISE / (double) (DAMAGE_LEVELS - 1);
-            network_perturb_weights(tmp, ll);
+            damage_overlay_perturb_weights(damage, ll);
 	}
-	n = count_attractors_by_damage_level(tmp);
+        network_tell_damage(net, damage);
+	n = count_attractors_by_damage_level(net, j, i);
+        network_tell_damage(net, NULL);
 	fp = fopen(LESION_RECORD_FILE, "a");
 	if (i > 0) {
             fprintf(fp, "\t");
 	}
 	fprintf(fp, "%d", n);
 	fclose(fp);
-        network_destroy(tmp);
     }
+    damage_overlay_destroy(damage);
     fp = fopen(LESION_RECORD_FILE, "a");
     fprintf(fp, "\n");
     fclose(fp);
@@ -214,13 +524,37 @@ void train_and_count_attractors(int j, char *training_set_file)
     network_destroy(net);
 }
 
+static void print_usage(FILE *fp)
+{
+    fprintf(fp, "Usage: tyler [-j threads] [-s seed] [-g]\n");
+}
+
 int main(int argc, char **argv)
 {
     FILE *fp;
     int i;
     long t0 = (long) time(NULL);
 
-    srand((int) t0);
+    enumerate_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    enumerate_seed = (uint64_t) t0;
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-j") == 0) && (i+1 < argc)) {
+            enumerate_threads = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-s") == 0) && (i+1 < argc)) {
+            enumerate_seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-g") == 0) {
+            enumerate_gray = TRUE;
+        }
+        else {
+            print_usage(stderr);
+            exit(1);
+        }
+    }
+    fprintf(stdout, "Enumerating attractors on %d thread(s); seed %llu\n", MAX(1, MIN(enumerate_threads, MAX_THREADS)), (unsigned long long) enumerate_seed);
+
+    srand((unsigned int) enumerate_seed);
 
     fp = fopen(LESION_RECORD_FILE, "w");
     for (i = 0; i < DAMAGE_LEVELS; i++) {
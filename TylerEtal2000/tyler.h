@@ -45,3 +45,22 @@ extern Boolean response_is_animal1(PatternList *training_set, double *r);
 extern Boolean response_is_animal2(PatternList *training_set, double *r);
 extern Boolean response_is_artifact1(PatternList *training_set, double *r);
 extern Boolean response_is_artifact2(PatternList *training_set, double *r);
+
+/* The measures plotted in the lesion figures (Figs 3-8), all computed from   */
+/* one presentation of each pattern. Feature errors are mean absolute errors  */
+/* per feature, the rest are percentages of the domain's patterns. Feature    */
+/* errors are ordered so that LM_FEATURE_ERROR(ft, artifact) indexes them.    */
+
+typedef enum {
+    LM_ANIMAL_DISTINCTIVE, LM_ARTIFACT_DISTINCTIVE,
+    LM_ANIMAL_SHARED, LM_ARTIFACT_SHARED,
+    LM_ANIMAL_FUNCTIONAL, LM_ARTIFACT_FUNCTIONAL,
+    LM_ANIMAL_CORRECT, LM_ARTIFACT_CORRECT,
+    LM_ANIMAL_BETWEEN, LM_ANIMAL_WITHIN,           // Category errors
+    LM_ARTIFACT_BETWEEN, LM_ARTIFACT_WITHIN,
+    LM_MAX
+} LesionMeasure;
+
+#define LM_FEATURE_ERROR(ft, artifact) (2 * (ft) + ((artifact) ? 1 : 0))
+
+extern void lesion_measure(Network *net, PatternList *training_set, double *measure);
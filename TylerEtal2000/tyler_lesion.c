@@ -0,0 +1,366 @@
+/******************************************************************************/
+
+// Headless lesion curves: train (or load) each network once, damage it at
+// each level once, and compute the data for all six lesion figures (Figs 3-8)
+// from a single presentation of each pattern at each level. Networks are
+// shared out among worker threads.
+
+#include "tyler.h"
+
+#include "lib_maths.h"
+
+#include <glib.h>
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define MAX_NETWORKS 1000
+#define MAX_POINTS     21
+#define MAX_THREADS    64
+
+// As in the lesion viewer (x_lesion_viewer.c):
+#define MAX_DAMAGE 1.00
+#define MAX_NOISE 3.00
+#define MAX_ABLATE 1.00
+#define MAX_SCALE 1.00
+
+//    NetworkParameters pars: NT, WN, LR, Momentum, Decay, Error, Update, Epochs, Criterion
+static NetworkParameters pars_ff =
+ {NT_FEEDFORWARD, 0.010, 0.250, 0.100, 0.000, SUM_SQUARE_ERROR, UPDATE_BY_EPOCH, 1000, 0.01};
+static NetworkParameters pars_recurrent =
+ {NT_RECURRENT, 0.010, 0.025, 0.100, 0.000, SUM_SQUARE_ERROR, UPDATE_BY_EPOCH, 1000, 0.01};
+
+static char *lesion_name[4] = {"zero", "noise", "ablate", "scale"};
+static char *lesion_axis[4] = {"Severed connections (%)", "Noise on weights (SD)", "Units removed (%)", "Scaling of weights"};
+
+typedef struct lesion_figure {
+    int number;
+    char *title;
+    int series;
+    LesionMeasure measure[4];
+    char *label[4];
+} LesionFigure;
+
+static LesionFigure figure[6] = {
+    {3, "Effect of Damage on Distinctive Perceptual Features (mean absolute error per feature)", 2,
+     {LM_ANIMAL_DISTINCTIVE, LM_ARTIFACT_DISTINCTIVE}, {"Living things", "Artefacts"}},
+    {4, "Effect of Damage on Features of Animals (mean absolute error per feature)", 2,
+     {LM_ANIMAL_SHARED, LM_ANIMAL_DISTINCTIVE}, {"Shared perceptual", "Distinctive perceptual"}},
+    {5, "Effect of Damage on Shared Features (mean absolute error per feature)", 2,
+     {LM_ANIMAL_SHARED, LM_ARTIFACT_SHARED}, {"Living things", "Artefacts"}},
+    {6, "Effect of Damage on Functional Features (mean absolute error per feature)", 2,
+     {LM_ANIMAL_FUNCTIONAL, LM_ARTIFACT_FUNCTIONAL}, {"Living things", "Artefacts"}},
+    {7, "Effect of Damage on Identity Judgements (percent patterns correct)", 2,
+     {LM_ANIMAL_CORRECT, LM_ARTIFACT_CORRECT}, {"Living things", "Artefacts"}},
+    {8, "Types of Error as a Function of Damage (percent patterns incorrect)", 4,
+     {LM_ANIMAL_BETWEEN, LM_ANIMAL_WITHIN, LM_ARTIFACT_BETWEEN, LM_ARTIFACT_WITHIN},
+     {"Living things; Between category", "Living things; Within category", "Artefacts; Between category", "Artefacts; Within category"}}
+};
+
+typedef struct lesion_spec {
+    NetworkParameters pars;
+    int lesion_type;           // Index into lesion_name[]
+    Boolean nested;            // Nested connection lesions
+    uint64_t seed;
+    char *pattern_file;
+    int num_nets;
+    char *file[MAX_NETWORKS];  // Weight files to load, if any; else train
+    int num_files;
+    double level[MAX_POINTS];
+    double (*result)[MAX_POINTS][LM_MAX];  // [network][level][measure]
+    Boolean *ok;               // Whether each network was tested
+    int next;                  // Shared: the next network to be run
+    int done;                  // Shared: networks finished
+} LesionSpec;
+
+/******************************************************************************/
+
+static double lesion_level(int lesion_type, int i)
+{
+    switch (lesion_type) {
+        case 0: return(100 * i * MAX_DAMAGE / (double) (MAX_POINTS - 1));
+        case 1: return(i * MAX_NOISE / (double) (MAX_POINTS - 1));
+        case 2: return(100.0 * i * MAX_ABLATE / (double) (MAX_POINTS - 1));
+        case 3: return(1.0 - (i * MAX_SCALE / (double) (MAX_POINTS - 1)));
+        default: return(0.0);
+    }
+}
+
+static Boolean run_network(LesionSpec *spec, int j)
+{
+    // Train or load network j, then test it at each level of damage, as
+    // generate_lesion_data() in the lesion viewer does:
+
+    PatternList *training_set;
+    DamageOverlay *damage;
+    Network *net;
+    double *hidden_prev;
+    int i, error;
+
+    // Training shuffles the patterns, so each network has its own copy:
+    if ((training_set = training_set_read(spec->pattern_file, IO_WIDTH, IO_WIDTH)) == NULL) {
+        fprintf(stderr, "ERROR: Cannot read %s ... network %d not run\n", spec->pattern_file, j+1);
+        return(FALSE);
+    }
+    if (spec->num_files > 0) {
+        if ((net = network_read_weights(spec->file[j], &error)) == NULL) {
+            fprintf(stderr, "ERROR: Cannot read weights from %s (error %d) ... network %d not run\n", spec->file[j], error, j+1);
+            training_set_free(training_set);
+            return(FALSE);
+        }
+    }
+    else {
+        net = network_initialise(spec->pars.nt, IO_WIDTH, HIDDEN_WIDTH, IO_WIDTH);
+        network_initialise_weights(net, spec->pars.wn);
+        network_train_to_epochs(net, &(spec->pars), training_set);
+    }
+
+    // Each level starts from the same context state:
+    damage = damage_overlay_create(net);
+    hidden_prev = (double *)malloc(net->hidden_width * sizeof(double));
+    if (net->units_hidden_prev != NULL) {
+        memcpy(hidden_prev, net->units_hidden_prev, net->hidden_width * sizeof(double));
+    }
+    if (spec->nested) {
+        damage_overlay_clear(damage);
+        damage_overlay_rank_weights(damage);
+    }
+
+    for (i = 0; i < MAX_POINTS; i++) {
+        if (net->units_hidden_prev != NULL) {
+            memcpy(net->units_hidden_prev, hidden_prev, net->hidden_width * sizeof(double));
+        }
+        if (!spec->nested || (spec->lesion_type != 0)) {
+            damage_overlay_clear(damage);
+        }
+        network_tell_damage(net, damage);
+        if (spec->lesion_type == 0) {
+            if (spec->nested) {
+                damage_overlay_lesion_nested(damage, spec->level[i] / 100.0);
+            }
+            else {
+                damage_overlay_lesion_weights(damage, spec->level[i] / 100.0);
+            }
+        }
+        else if (spec->lesion_type == 1) {
+            damage_overlay_perturb_weights(damage, spec->level[i]);
+        }
+        else if (spec->lesion_type == 2) {
+            damage_overlay_ablate_units(damage, spec->level[i] / 100.0);
+        }
+        else if (spec->lesion_type == 3) {
+            damage_overlay_scale_weights(damage, spec->level[i]);
+        }
+        lesion_measure(net, training_set, spec->result[j][i]);
+        network_tell_damage(net, NULL);
+    }
+
+    free(hidden_prev);
+    damage_overlay_destroy(damage);
+    network_destroy(net);
+    training_set_free(training_set);
+    return(TRUE);
+}
+
+static void *lesion_worker(void *data)
+{
+    // Each network draws its random numbers (initial weights, the order of
+    // training patterns and damage) from its own stream, so results do not
+    // depend on which thread runs it:
+
+    LesionSpec *spec = (LesionSpec *)data;
+    RandomStream rs;
+    int j, n;
+
+    random_stream_select(&rs);
+    while ((j = __atomic_fetch_add(&spec->next, 1, __ATOMIC_RELAXED)) < spec->num_nets) {
+        random_stream_initialise(&rs, spec->seed, (uint32_t) j, 0, 0, 0);
+        spec->ok[j] = run_network(spec, j);
+        n = __atomic_add_fetch(&spec->done, 1, __ATOMIC_RELAXED);
+        fprintf(stdout, "Network %4d done (%d of %d)\n", j+1, n, spec->num_nets);
+        fflush(stdout);
+    }
+    random_stream_select(NULL);
+    return(NULL);
+}
+
+/******************************************************************************/
+
+static Boolean write_figure(char *filename, LesionSpec *spec, LesionFigure *fig)
+{
+    // One row per level: the level, then the mean and standard error over
+    // the networks of each series. Networks are summed in order, so the
+    // table does not depend on the number of threads:
+
+    RunningStats rs;
+    FILE *fp;
+    int i, j, k, n = 0;
+
+    if ((fp = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "ERROR: Cannot write to %s\n", filename);
+        return(FALSE);
+    }
+    for (j = 0; j < spec->num_nets; j++) {
+        n += spec->ok[j] ? 1 : 0;
+    }
+    fprintf(fp, "# Figure %d: %s\n", fig->number, fig->title);
+    fprintf(fp, "# Network: %s; Damage: %s%s; Networks: %d; Seed: %llu\n", nt_name[spec->pars.nt], lesion_name[spec->lesion_type], spec->nested ? " (nested)" : "", n, (unsigned long long) spec->seed);
+    fprintf(fp, "%s", lesion_axis[spec->lesion_type]);
+    for (k = 0; k < fig->series; k++) {
+        fprintf(fp, "\t%s\tSE", fig->label[k]);
+    }
+    fprintf(fp, "\n");
+    for (i = 0; i < MAX_POINTS; i++) {
+        fprintf(fp, "%5.3f", spec->level[i]);
+        for (k = 0; k < fig->series; k++) {
+            running_stats_reset(&rs);
+            for (j = 0; j < spec->num_nets; j++) {
+                if (spec->ok[j]) {
+                    running_stats_add(&rs, spec->result[j][i][fig->measure[k]]);
+                }
+            }
+            fprintf(fp, "\t%7.5f\t%7.5f", running_stats_mean(&rs), running_stats_se(&rs));
+        }
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+    return(TRUE);
+}
+
+/******************************************************************************/
+
+static void print_usage(FILE *fp)
+{
+    fprintf(fp, "Usage: tyler_lesion [-d zero|noise|ablate|scale] [-N] [-r] [-n networks] [-e epochs]\n");
+    fprintf(fp, "                    [-j threads] [-s seed] [-p patterns] [-o directory] [weight_file ...]\n");
+}
+
+int main(int argc, char **argv)
+{
+    LesionSpec spec;
+    pthread_t thread[MAX_THREADS];
+    char filename[256];
+    char *directory = "FIGURES";
+    int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int epochs = -1;
+    int i, k;
+#ifdef CLAMPED
+    char *nt_prefix[NT_MAX] = {"ffn", "ranc"};
+#else
+    char *nt_prefix[NT_MAX] = {"ffn", "ranu"};
+#endif
+
+    memset(&spec, 0, sizeof(LesionSpec));
+    spec.pars = pars_ff;
+    spec.num_nets = 300;
+    spec.seed = (uint64_t) time(NULL);
+    spec.pattern_file = TRAINING_PATTERNS;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-d") == 0) && (i+1 < argc)) {
+            i++;
+            for (k = 0; (k < 4) && (strcmp(argv[i], lesion_name[k]) != 0); k++);
+            if (k == 4) {
+                fprintf(stderr, "ERROR: Unknown damage type %s\n", argv[i]);
+                exit(1);
+            }
+            spec.lesion_type = k;
+        }
+        else if (strcmp(argv[i], "-N") == 0) {
+            spec.nested = TRUE;
+        }
+        else if (strcmp(argv[i], "-r") == 0) {
+            spec.pars = pars_recurrent;
+        }
+        else if ((strcmp(argv[i], "-n") == 0) && (i+1 < argc)) {
+            spec.num_nets = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-e") == 0) && (i+1 < argc)) {
+            epochs = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-j") == 0) && (i+1 < argc)) {
+            threads = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-s") == 0) && (i+1 < argc)) {
+            spec.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if ((strcmp(argv[i], "-p") == 0) && (i+1 < argc)) {
+            spec.pattern_file = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-o") == 0) && (i+1 < argc)) {
+            directory = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-h") == 0) || (argv[i][0] == '-')) {
+            print_usage(stderr);
+            exit(1);
+        }
+        else if (spec.num_files < MAX_NETWORKS) {
+            spec.file[spec.num_files++] = argv[i];
+        }
+    }
+
+    if (epochs >= 0) {
+        spec.pars.epochs = epochs;
+    }
+    if (spec.nested && (spec.lesion_type != 0)) {
+        fprintf(stderr, "WARNING: Nested damage (-N) applies only to severed connections; ignored\n");
+        spec.nested = FALSE;
+    }
+    if (spec.num_files > 0) {
+        // Loaded networks carry their own type:
+        Network *net;
+        int error;
+
+        spec.num_nets = spec.num_files;
+        if ((net = network_read_weights(spec.file[0], &error)) != NULL) {
+            spec.pars.nt = net->nt;
+            network_destroy(net);
+        }
+    }
+    spec.num_nets = MAX(1, MIN(spec.num_nets, MAX_NETWORKS));
+    threads = MAX(1, MIN(threads, MIN(spec.num_nets, MAX_THREADS)));
+    for (i = 0; i < MAX_POINTS; i++) {
+        spec.level[i] = lesion_level(spec.lesion_type, i);
+    }
+
+    spec.result = malloc(spec.num_nets * sizeof(*spec.result));
+    spec.ok = (Boolean *)calloc(spec.num_nets, sizeof(Boolean));
+    if ((spec.result == NULL) || (spec.ok == NULL)) {
+        fprintf(stderr, "ERROR: Cannot allocate results for %d networks\n", spec.num_nets);
+        exit(1);
+    }
+
+    fprintf(stdout, "%s %d %s network%s on %d thread(s); damage: %s%s; seed: %llu\n", (spec.num_files > 0) ? "Testing" : "Training and testing", spec.num_nets, nt_name[spec.pars.nt], (spec.num_nets == 1) ? "" : "s", threads, lesion_name[spec.lesion_type], spec.nested ? " (nested)" : "", (unsigned long long) spec.seed);
+
+    for (k = 0; k < threads; k++) {
+        if (pthread_create(&thread[k], NULL, lesion_worker, &spec) != 0) {
+            break;
+        }
+    }
+    // Networks are taken by the workers as they finish the last, so those
+    // that did start can run them all; if none did, run them here:
+    if (k < threads) {
+        fprintf(stderr, "WARNING: Started %d of %d threads\n", k, threads);
+        threads = k;
+    }
+    if (threads == 0) {
+        lesion_worker(&spec);
+    }
+    for (k = 0; k < threads; k++) {
+        pthread_join(thread[k], NULL);
+    }
+
+    for (k = 0; k < 6; k++) {
+        g_snprintf(filename, 256, "%s/figure_%02d_%s_%s.dat", directory, figure[k].number, nt_prefix[spec.pars.nt], lesion_name[spec.lesion_type]);
+        if (write_figure(filename, &spec, &figure[k])) {
+            fprintf(stdout, "Figure %d data written to %s\n", figure[k].number, filename);
+        }
+    }
+
+    free(spec.result);
+    free(spec.ok);
+    exit(0);
+}
+
+/******************************************************************************/
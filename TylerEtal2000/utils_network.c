@@ -9,6 +9,10 @@ typedef enum boolean {
 #include <ctype.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <glib.h>
 
 #define DEBUG FALSE
@@ -110,14 +114,11 @@ void network_tell_randomise_hidden(Network *n)
     }
 }
 
+static void perturb_vector(double *v, int n, double sd);
+
 void network_inject_noise(Network *n, double variance)
 {
-    double sd = sqrt(variance);
-    int i;
-
-    for (i = 0; i < n->hidden_width; i++) {
-        n->units_hidden[i] += random_normal(0, sd);
-    }
+    perturb_vector(n->units_hidden, n->hidden_width, sqrt(variance));
 }
 
 void network_print_state(Network *n, FILE *fp, char *message)
@@ -145,66 +146,45 @@ void network_print_state(Network *n, FILE *fp, char *message)
 
 /******************************************************************************/
 
-void network_lesion_weights_ih(Network *n, double severity)
+static void lesion_vector(double *w, int n, double severity)
 {
-    int i, j;
+    // Zero each of the n weights in w with probability severity, jumping
+    // straight from one lesioned weight to the next:
+
+    int k;
+
+    for (k = random_bernoulli_next(-1, n, severity); k < n; k = random_bernoulli_next(k, n, severity)) {
+        w[k] = 0.0;
+    }
+}
 
+void network_lesion_weights_ih(Network *n, double severity)
+{
     if (n->weights_ih != NULL) {
-// fprintf(stdout, "Lesion IH weights at %f severity\n", severity);
-        for (i = 0; i < n->in_width; i++) { // Don't lesion the bias!
-            for (j = 0; j < n->hidden_width; j++) {
-                if (random_uniform(0.0, 1.0) < severity) {
-                    n->weights_ih[i * n->hidden_width + j] = 0.0;
-                }
-            }
-        }
 #ifdef BIAS_LESION
-	i = n->in_width;
-        for (j = 0; j < n->hidden_width; j++) {
-            if (random_uniform(0.0, 1.0) < severity) {
-                n->weights_ih[i * n->hidden_width + j] = 0.0;
-            }
-        }
+        lesion_vector(n->weights_ih, (n->in_width+1) * n->hidden_width, severity);
+#else
+        // Don't lesion the bias (the last row):
+        lesion_vector(n->weights_ih, n->in_width * n->hidden_width, severity);
 #endif
     }
 }
 
 void network_lesion_weights_hh(Network *n, double severity)
 {
-    int i, j;
-
-    if (n->weights_hh != NULL) { // For RAN only
-// fprintf(stdout, "Lesion HH weights at %f severity\n", severity);
-        for (i = 0; i < n->hidden_width; i++) { // No hidden to hidden bias to worry about
-            for (j = 0; j < n->hidden_width; j++) {
-                if (random_uniform(0.0, 1.0) < severity) {
-                    n->weights_hh[i * n->hidden_width + j] = 0.0;
-                }
-            }
-        }
+    if (n->weights_hh != NULL) { // For RAN only; no hidden to hidden bias
+        lesion_vector(n->weights_hh, n->hidden_width * n->hidden_width, severity);
     }
 }
 
 void network_lesion_weights_ho(Network *n, double severity)
 {
-    int i, j;
-
     if (n->weights_ho != NULL) {
-// fprintf(stdout, "Lesion HO weights at %f severity\n", severity);
-        for (i = 0; i < n->hidden_width; i++) { // Don't lesion the bias!
-            for (j = 0; j < n->out_width; j++) {
-                if (random_uniform(0.0, 1.0) < severity) {
-                    n->weights_ho[i * n->out_width + j] = 0.0;
-                }
-            }
-        }
 #ifdef BIAS_LESION
-	i = n->hidden_width;
-        for (j = 0; j < n->out_width; j++) {
-            if (random_uniform(0.0, 1.0) < severity) {
-                n->weights_ho[i * n->out_width + j] = 0.0;
-            }
-        }
+        lesion_vector(n->weights_ho, (n->hidden_width+1) * n->out_width, severity);
+#else
+        // Don't lesion the bias (the last row):
+        lesion_vector(n->weights_ho, n->hidden_width * n->out_width, severity);
 #endif
     }
 }
@@ -219,59 +199,53 @@ void network_lesion_weights(Network *net, double severity)
 
 /******************************************************************************/
 
-static double perturb(double w0, double sd)
+#define PERTURB_BLOCK 256
+
+static void perturb_vector(double *v, int n, double sd)
 {
-    return(random_normal(w0, sd));
-    // return(w0 + random_uniform(-sd, sd));
+    // Add normally distributed noise to each of the n values in v. The noise
+    // is generated PERTURB_BLOCK values at a time:
+
+    double noise[PERTURB_BLOCK];
+    int i, k, m;
+
+    for (i = 0; i < n; i += m) {
+        m = (n - i < PERTURB_BLOCK) ? n - i : PERTURB_BLOCK;
+        random_fill_normal(noise, m, 0.0, sd);
+        // random_fill_uniform(noise, m, -sd, sd);
+        for (k = 0; k < m; k++) {
+            v[i+k] += noise[k];
+        }
+    }
 }
 
 void network_perturb_weights_ih(Network *n, double noise_sd)
 {
-    int i, j;
-
     if (n->weights_ih != NULL) {
-        for (i = 0; i < n->in_width; i++) { // Don't lesion the bias!
-            for (j = 0; j < n->hidden_width; j++) {
-                n->weights_ih[i * n->hidden_width + j] = perturb(n->weights_ih[i * n->hidden_width + j], noise_sd);
-            }
-        }
 #ifdef BIAS_LESION
-	i = n->in_width;
-        for (j = 0; j < n->hidden_width; j++) {
-            n->weights_ih[i * n->hidden_width + j] = perturb(n->weights_ih[i * n->hidden_width + j], noise_sd);
-        }
+        perturb_vector(n->weights_ih, (n->in_width+1) * n->hidden_width, noise_sd);
+#else
+        // Don't lesion the bias (the last row):
+        perturb_vector(n->weights_ih, n->in_width * n->hidden_width, noise_sd);
 #endif
     }
 }
 
 void network_perturb_weights_hh(Network *n, double noise_sd)
 {
-    int i, j;
-
-    if (n->weights_hh != NULL) { // For RAN only
-        for (i = 0; i < n->hidden_width; i++) { // No hidden to hidden bias to worry about
-            for (j = 0; j < n->hidden_width; j++) {
-                n->weights_hh[i * n->hidden_width + j] = perturb(n->weights_hh[i * n->hidden_width + j], noise_sd);
-            }
-        }
+    if (n->weights_hh != NULL) { // For RAN only; no hidden to hidden bias
+        perturb_vector(n->weights_hh, n->hidden_width * n->hidden_width, noise_sd);
     }
 }
 
 void network_perturb_weights_ho(Network *n, double noise_sd)
 {
-    int i, j;
-
     if (n->weights_ho != NULL) {
-        for (i = 0; i < n->hidden_width; i++) { // Don't lesion the bias!
-            for (j = 0; j < n->out_width; j++) {
-                n->weights_ho[i * n->out_width + j] = perturb(n->weights_ho[i * n->out_width + j], noise_sd);
-            }
-        }
 #ifdef BIAS_LESION
-	i = n->hidden_width;
-        for (j = 0; j < n->out_width; j++) {
-            n->weights_ho[i * n->out_width + j] = perturb(n->weights_ho[i * n->out_width + j], noise_sd);
-        }
+        perturb_vector(n->weights_ho, (n->hidden_width+1) * n->out_width, noise_sd);
+#else
+        // Don't lesion the bias (the last row):
+        perturb_vector(n->weights_ho, n->hidden_width * n->out_width, noise_sd);
 #endif
     }
 }
@@ -378,6 +352,230 @@ void network_scale_weights(Network *net, double scale)
     network_scale_weights_ho(net, scale);
 }
 
+/******************************************************************************/
+/* Damage overlays: Each function below draws random numbers in the same     */
+/* order as the corresponding network_ function above, so an overlay on the  */
+/* pristine weights behaves exactly as the same damage applied to a copy.    */
+
+#define DAMAGE_BIT_TEST(mask, k) ((mask)[(k) >> 5] & (1u << ((k) & 31)))
+#define DAMAGE_BIT_SET(mask, k) ((mask)[(k) >> 5] |= (1u << ((k) & 31)))
+
+static int damage_mask_words(int n)
+{
+    return((n + 31) / 32);
+}
+
+static int damage_rows(int width)
+{
+    // Rows of a weight matrix subject to damage: the bias row is last
+#ifdef BIAS_LESION
+    return(width+1);
+#else
+    return(width);
+#endif
+}
+
+void damage_overlay_destroy(DamageOverlay *d)
+{
+    if (d != NULL) {
+        free(d->severed_ih);
+        free(d->severed_hh);
+        free(d->severed_ho);
+        free(d->noise_ih);
+        free(d->noise_hh);
+        free(d->noise_ho);
+        free(d->ablated_hh);
+        free(d->ablated_ho);
+        free(d->rank_ih.order);
+        free(d->rank_ih.key);
+        free(d->rank_hh.order);
+        free(d->rank_hh.key);
+        free(d->rank_ho.order);
+        free(d->rank_ho.key);
+        free(d);
+    }
+}
+
+DamageOverlay *damage_overlay_create(Network *net)
+{
+    int nih = (net->in_width+1) * net->hidden_width;
+    int nhh = net->hidden_width * net->hidden_width;
+    int nho = (net->hidden_width+1) * net->out_width;
+    DamageOverlay *d;
+
+    if ((d = (DamageOverlay *)calloc(1, sizeof(DamageOverlay))) != NULL) {
+        d->recurrent = (net->weights_hh != NULL);
+        d->in_width = net->in_width;
+        d->hidden_width = net->hidden_width;
+        d->out_width = net->out_width;
+        d->severed_ih = (unsigned int *)calloc(damage_mask_words(nih), sizeof(unsigned int));
+        d->severed_hh = (unsigned int *)calloc(damage_mask_words(nhh), sizeof(unsigned int));
+        d->severed_ho = (unsigned int *)calloc(damage_mask_words(nho), sizeof(unsigned int));
+        d->noise_ih = (double *)calloc(nih, sizeof(double));
+        d->noise_hh = (double *)calloc(nhh, sizeof(double));
+        d->noise_ho = (double *)calloc(nho, sizeof(double));
+        d->ablated_hh = (Boolean *)calloc(net->hidden_width, sizeof(Boolean));
+        d->ablated_ho = (Boolean *)calloc(net->hidden_width+1, sizeof(Boolean));
+        d->scale = 1.0;
+        d->rank_ih.n = damage_rows(net->in_width) * net->hidden_width;
+        d->rank_hh.n = d->recurrent ? nhh : 0;
+        d->rank_ho.n = damage_rows(net->hidden_width) * net->out_width;
+        d->rank_ih.order = (int *)malloc(nih * sizeof(int));
+        d->rank_ih.key = (double *)malloc(nih * sizeof(double));
+        d->rank_hh.order = (int *)malloc(nhh * sizeof(int));
+        d->rank_hh.key = (double *)malloc(nhh * sizeof(double));
+        d->rank_ho.order = (int *)malloc(nho * sizeof(int));
+        d->rank_ho.key = (double *)malloc(nho * sizeof(double));
+
+        if ((d->severed_ih == NULL) || (d->severed_hh == NULL) || (d->severed_ho == NULL) || (d->noise_ih == NULL) || (d->noise_hh == NULL) || (d->noise_ho == NULL) || (d->ablated_hh == NULL) || (d->ablated_ho == NULL) || (d->rank_ih.order == NULL) || (d->rank_ih.key == NULL) || (d->rank_hh.order == NULL) || (d->rank_hh.key == NULL) || (d->rank_ho.order == NULL) || (d->rank_ho.key == NULL)) {
+            damage_overlay_destroy(d);
+            return(NULL);
+        }
+    }
+    return(d);
+}
+
+void damage_overlay_clear(DamageOverlay *d)
+{
+    int nih = (d->in_width+1) * d->hidden_width;
+    int nhh = d->hidden_width * d->hidden_width;
+    int nho = (d->hidden_width+1) * d->out_width;
+
+    if (d->any_severed) {
+        memset(d->severed_ih, 0, damage_mask_words(nih) * sizeof(unsigned int));
+        memset(d->severed_hh, 0, damage_mask_words(nhh) * sizeof(unsigned int));
+        memset(d->severed_ho, 0, damage_mask_words(nho) * sizeof(unsigned int));
+    }
+    if (d->any_noise) {
+        memset(d->noise_ih, 0, nih * sizeof(double));
+        memset(d->noise_hh, 0, nhh * sizeof(double));
+        memset(d->noise_ho, 0, nho * sizeof(double));
+    }
+    if (d->any_ablated) {
+        memset(d->ablated_hh, 0, d->hidden_width * sizeof(Boolean));
+        memset(d->ablated_ho, 0, (d->hidden_width+1) * sizeof(Boolean));
+    }
+    d->scale = 1.0;
+    d->any_severed = FALSE;
+    d->any_noise = FALSE;
+    d->any_ablated = FALSE;
+    d->rank_ih.severed = 0;
+    d->rank_hh.severed = 0;
+    d->rank_ho.severed = 0;
+}
+
+static void damage_overlay_sever(unsigned int *mask, int n, double severity, Boolean *any)
+{
+    int k;
+
+    for (k = random_bernoulli_next(-1, n, severity); k < n; k = random_bernoulli_next(k, n, severity)) {
+        DAMAGE_BIT_SET(mask, k);
+        *any = TRUE;
+    }
+}
+
+void damage_overlay_lesion_weights(DamageOverlay *d, double severity)
+{
+    damage_overlay_sever(d->severed_ih, damage_rows(d->in_width) * d->hidden_width, severity, &d->any_severed);
+    if (d->recurrent) {
+        damage_overlay_sever(d->severed_hh, d->hidden_width * d->hidden_width, severity, &d->any_severed);
+    }
+    damage_overlay_sever(d->severed_ho, damage_rows(d->hidden_width) * d->out_width, severity, &d->any_severed);
+}
+
+void damage_overlay_rank_weights(DamageOverlay *d)
+{
+    // Draw a new ranking of the connections for nested lesions (connections
+    // already severed stay severed until the overlay is cleared):
+
+    random_ranking(d->rank_ih.n, d->rank_ih.order, d->rank_ih.key);
+    random_ranking(d->rank_hh.n, d->rank_hh.order, d->rank_hh.key);
+    random_ranking(d->rank_ho.n, d->rank_ho.order, d->rank_ho.key);
+    d->rank_ih.severed = 0;
+    d->rank_hh.severed = 0;
+    d->rank_ho.severed = 0;
+    d->ranked = TRUE;
+}
+
+static void damage_overlay_sever_ranked(LesionRanking *rank, unsigned int *mask, double severity, Boolean *any)
+{
+    // Carry on from the connections severed at the last severity:
+
+    while ((rank->severed < rank->n) && (rank->key[rank->severed] < severity)) {
+        DAMAGE_BIT_SET(mask, rank->order[rank->severed]);
+        rank->severed++;
+        *any = TRUE;
+    }
+}
+
+void damage_overlay_lesion_nested(DamageOverlay *d, double severity)
+{
+    // As damage_overlay_lesion_weights(), but severing connections in the
+    // order they were ranked. Stepping through increasing severities without
+    // clearing the overlay severs each connection just once:
+
+    if (!d->ranked) {
+        damage_overlay_rank_weights(d);
+    }
+    damage_overlay_sever_ranked(&d->rank_ih, d->severed_ih, severity, &d->any_severed);
+    damage_overlay_sever_ranked(&d->rank_hh, d->severed_hh, severity, &d->any_severed);
+    damage_overlay_sever_ranked(&d->rank_ho, d->severed_ho, severity, &d->any_severed);
+}
+
+void damage_overlay_perturb_weights(DamageOverlay *d, double noise_sd)
+{
+    perturb_vector(d->noise_ih, damage_rows(d->in_width) * d->hidden_width, noise_sd);
+    if (d->recurrent) {
+        perturb_vector(d->noise_hh, d->hidden_width * d->hidden_width, noise_sd);
+    }
+    perturb_vector(d->noise_ho, damage_rows(d->hidden_width) * d->out_width, noise_sd);
+    d->any_noise = TRUE;
+}
+
+void damage_overlay_ablate_units(DamageOverlay *d, double severity)
+{
+    int i;
+
+    if (d->recurrent) {
+        for (i = 0; i < d->hidden_width; i++) {
+            if (random_uniform(0.0, 1.0) < severity) {
+                d->ablated_hh[i] = TRUE;
+                d->any_ablated = TRUE;
+            }
+        }
+    }
+    for (i = 0; i < damage_rows(d->hidden_width); i++) {
+        if (random_uniform(0.0, 1.0) < severity) {
+            d->ablated_ho[i] = TRUE;
+            d->any_ablated = TRUE;
+        }
+    }
+}
+
+void damage_overlay_scale_weights(DamageOverlay *d, double scale)
+{
+    d->scale *= scale;
+}
+
+void network_tell_damage(Network *n, DamageOverlay *d)
+{
+    // Propagate through the weights as damaged by d (NULL to undamage):
+    n->damage = d;
+}
+
+static double damage_weight(DamageOverlay *d, double w, unsigned int *severed, double *noise, int k, int row, int rows)
+{
+    // The effective value of weight k, in the given row of its matrix:
+
+    if (d->any_severed && DAMAGE_BIT_TEST(severed, k)) {
+        return(0.0);
+    }
+    if (d->any_noise) {
+        w += noise[k];
+    }
+    return((row < rows) ? w * d->scale : w);
+}
+
 /******************************************************************************/
 
 static double vector_compare(ErrorFunction ef, int width, double *v1, double *v2)
@@ -520,7 +718,13 @@ void network_destroy(Network *n)
         if (n->tmp_hh_deltas != NULL) { free(n->tmp_hh_deltas); }
         if (n->tmp_ho_deltas != NULL) { free(n->tmp_ho_deltas); }
         if (n->previous_ih_deltas != NULL) { free(n->previous_ih_deltas); }
+        if (n->previous_hh_deltas != NULL) { free(n->previous_hh_deltas); }
         if (n->previous_ho_deltas != NULL) { free(n->previous_ho_deltas); }
+        if (n->work_hidden != NULL) { free(n->work_hidden); }
+        if (n->work_error != NULL) { free(n->work_error); }
+        if (n->work_out != NULL) { free(n->work_out); }
+        if (n->work_delta != NULL) { free(n->work_delta); }
+        if (n->work_epsilon != NULL) { free(n->work_epsilon); }
         free(n);
     }
 }
@@ -583,6 +787,30 @@ void network_initialise_weights(Network *net, double weight_noise)
 
 }
 
+static void network_allocate_workspace(Network *n)
+{
+    /* Space for the history of a full settling sequence (plus the two extra */
+    /* cycles of lag) for BPTT, or just the output deltas for a FF network:  */
+
+    int cycles = RAN_SETTLING_CYCLES;
+    int units = n->hidden_width + n->out_width;
+
+    if (n->nt == NT_RECURRENT) {
+        n->work_hidden = (double *)malloc((cycles+2) * n->hidden_width * sizeof(double));
+        n->work_error = (double *)malloc((cycles+2) * n->out_width * sizeof(double));
+        n->work_out = (double *)malloc((cycles+2) * n->out_width * sizeof(double));
+        n->work_delta = (double *)malloc((cycles+2) * units * sizeof(double));
+        n->work_epsilon = (double *)malloc((cycles+2) * units * sizeof(double));
+    }
+    else {
+        n->work_hidden = NULL;
+        n->work_error = NULL;
+        n->work_out = NULL;
+        n->work_delta = (double *)malloc(n->out_width * sizeof(double));
+        n->work_epsilon = NULL;
+    }
+}
+
 Network *network_initialise(NetworkType nt, int iw, int hw, int ow)
 {
     /* Generalised version (for both FF and RAN) */
@@ -600,6 +828,8 @@ Network *network_initialise(NetworkType nt, int iw, int hw, int ow)
         n->nt = nt;
         n->settled = FALSE;
         n->cycles = 0;
+        n->damage = NULL;
+        n->input_net = NULL;
 
         /* 1. Weights: */
 
@@ -664,6 +894,8 @@ Network *network_initialise(NetworkType nt, int iw, int hw, int ow)
         }
         n->previous_ho_deltas = (double *)malloc((n->hidden_width+1) * n->out_width * sizeof(double));
 
+        network_allocate_workspace(n);
+
         /* Initialise the previous_*_deltas, for momentum calculations: */
         for (i = 0; i < (n->in_width+1); i++) {
             for (j = 0; j < n->hidden_width; j++) {
@@ -705,6 +937,8 @@ Network *network_copy(Network *n)
         r->nt = n->nt;
         r->settled = n->settled;
         r->cycles = n->cycles;
+        r->damage = NULL;
+        r->input_net = NULL;
 
         if ((r->weights_ih = (double *)malloc((r->in_width+1) * r->hidden_width * sizeof(double))) != NULL) {
             for (i = 0; i < (r->in_width+1); i++) {
@@ -782,6 +1016,8 @@ Network *network_copy(Network *n)
         }
         r->previous_ho_deltas = (double *)malloc((r->hidden_width+1) * r->out_width * sizeof(double));
 
+        network_allocate_workspace(r);
+
         /* Initialise the previous_*_deltas, for momentum calculations: */
         for (i = 0; i < (r->in_width+1); i++) {
             for (j = 0; j < r->hidden_width; j++) {
@@ -816,6 +1052,7 @@ void network_zero_input(Network *n)
             n->units_in[i] = 0.0;
         }
     }
+    n->input_net = NULL;
 }
 
 void network_tell_input(Network *n, double *vector)
@@ -828,52 +1065,172 @@ void network_tell_input(Network *n, double *vector)
             n->units_in[i] = vector[i];
         }
     }
+    n->input_net = NULL;
     /* Initialise the cycle count (only relevant for recurrent networks) */
     n->cycles = 0;
 }
 
 /*----------------------------------------------------------------------------*/
 
-void network_tell_propagate(Network *n)
+/* When inputs are presented one after another and each differs from the    */
+/* last in few units (e.g. in Gray code order), the input layer's part of    */
+/* the hidden units' net input can be updated, one row of weights per       */
+/* changed unit, rather than recomputed. The caller keeps the net input up   */
+/* to date and passes it with the input; it is used for as long as that     */
+/* input is clamped, and must be recomputed if the weights or damage change. */
+
+static double network_input_weight(Network *n, int i, int j)
 {
-    /* Generalised version (FF or RAN) */
+    // The effective weight from input unit i (or the bias, i == in_width)
+    // to hidden unit j:
+
+    int k = i * n->hidden_width + j;
+
+    if (n->damage != NULL) {
+        DamageOverlay *d = n->damage;
+        return(damage_weight(d, n->weights_ih[k], d->severed_ih, d->noise_ih, k, i, damage_rows(n->in_width)));
+    }
+    else {
+        return(n->weights_ih[k]);
+    }
+}
+
+void network_ask_input_net(Network *n, double *vector, double *net)
+{
+    // Set net[0 .. hidden_width-1] to the net input to each hidden unit from
+    // the input layer (and bias) when vector is presented. The sums are
+    // formed in the same order as by network_tell_propagate:
 
     int i, j;
 
-    if (n->nt == NT_RECURRENT) {
-        if ((INPUT_CLAMP_DURATION > 0) && (n->cycles >= INPUT_CLAMP_DURATION)) {
-            network_zero_input(n);
+    for (j = 0; j < n->hidden_width; j++) {
+        net[j] = 0.0;
+        for (i = 0; i < n->in_width; i++) {
+            net[j] += vector[i] * network_input_weight(n, i, j);
         }
+        net[j] += network_input_weight(n, n->in_width, j);
+    }
+}
+
+void network_adjust_input_net(Network *n, double *net, int i, double delta)
+{
+    // Update net for a change of delta in the activation of input unit i:
+
+    int j;
+
+    for (j = 0; j < n->hidden_width; j++) {
+        net[j] += delta * network_input_weight(n, i, j);
     }
+}
+
+void network_tell_input_with_net(Network *n, double *vector, double *net)
+{
+    // As network_tell_input, where net is the input net from vector (as set
+    // by network_ask_input_net or kept up to date by network_adjust_input_net):
+
+    network_tell_input(n, vector);
+    n->input_net = net;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void network_damaged_propagate_units(Network *n, DamageOverlay *d)
+{
+    // As network_tell_propagate, but through the damaged weights. The sums
+    // are formed in the same order, so results match a damaged copy exactly.
+
+    int ih_rows = damage_rows(n->in_width);
+    int ho_rows = damage_rows(n->hidden_width);
+    int i, j, k;
 
-    /* Propagate from input to hidden: */
     if (n->units_hidden != NULL) {
         for (j = 0; j < n->hidden_width; j++) {
-            n->units_hidden[j] = 0.0;
-            for (i = 0; i < (n->in_width+1); i++) {
-                n->units_hidden[j] += n->units_in[i] * n->weights_ih[i * n->hidden_width + j];
+            if (n->input_net != NULL) {
+                n->units_hidden[j] = n->input_net[j];
+            }
+            else {
+                n->units_hidden[j] = 0.0;
+                for (i = 0; i < (n->in_width+1); i++) {
+                    k = i * n->hidden_width + j;
+                    n->units_hidden[j] += n->units_in[i] * damage_weight(d, n->weights_ih[k], d->severed_ih, d->noise_ih, k, i, ih_rows);
+                }
             }
-            /* If recurrent, then add in recurrent input: */
             if (n->nt == NT_RECURRENT) {
                 for (i = 0; i < n->hidden_width; i++) {
-                    n->units_hidden[j] += n->units_hidden_prev[i] * n->weights_hh[i * n->hidden_width + j];
+                    k = i * n->hidden_width + j;
+                    if (!d->ablated_hh[i]) {
+                        n->units_hidden[j] += n->units_hidden_prev[i] * damage_weight(d, n->weights_hh[k], d->severed_hh, d->noise_hh, k, i, n->hidden_width);
+                    }
                 }
             }
-            /* And calculate the post-synaptic value: */
             n->units_hidden[j] = sigmoid(n->units_hidden[j]);
         }
     }
 
-    /* Propagate from hidden to output: */
     if (n->units_out != NULL) {
         for (j = 0; j < n->out_width; j++) {
             n->units_out[j] = 0.0;
             for (i = 0; i < (n->hidden_width+1); i++) {
-                n->units_out[j] += n->units_hidden[i] * n->weights_ho[i * n->out_width + j];
+                k = i * n->out_width + j;
+                if (!d->ablated_ho[i]) {
+                    n->units_out[j] += n->units_hidden[i] * damage_weight(d, n->weights_ho[k], d->severed_ho, d->noise_ho, k, i, ho_rows);
+                }
             }
             n->units_out[j] = sigmoid(n->units_out[j]);
         }
     }
+}
+
+void network_tell_propagate(Network *n)
+{
+    /* Generalised version (FF or RAN) */
+
+    int i, j;
+
+    if (n->nt == NT_RECURRENT) {
+        if ((INPUT_CLAMP_DURATION > 0) && (n->cycles >= INPUT_CLAMP_DURATION)) {
+            network_zero_input(n);
+        }
+    }
+
+    if (n->damage != NULL) {
+        network_damaged_propagate_units(n, n->damage);
+    }
+    else {
+        /* Propagate from input to hidden: */
+        if (n->units_hidden != NULL) {
+            for (j = 0; j < n->hidden_width; j++) {
+                if (n->input_net != NULL) {
+                    n->units_hidden[j] = n->input_net[j];
+                }
+                else {
+                    n->units_hidden[j] = 0.0;
+                    for (i = 0; i < (n->in_width+1); i++) {
+                        n->units_hidden[j] += n->units_in[i] * n->weights_ih[i * n->hidden_width + j];
+                    }
+                }
+                /* If recurrent, then add in recurrent input: */
+                if (n->nt == NT_RECURRENT) {
+                    for (i = 0; i < n->hidden_width; i++) {
+                        n->units_hidden[j] += n->units_hidden_prev[i] * n->weights_hh[i * n->hidden_width + j];
+                    }
+                }
+                /* And calculate the post-synaptic value: */
+                n->units_hidden[j] = sigmoid(n->units_hidden[j]);
+            }
+        }
+
+        /* Propagate from hidden to output: */
+        if (n->units_out != NULL) {
+            for (j = 0; j < n->out_width; j++) {
+                n->units_out[j] = 0.0;
+                for (i = 0; i < (n->hidden_width+1); i++) {
+                    n->units_out[j] += n->units_hidden[i] * n->weights_ho[i * n->out_width + j];
+                }
+                n->units_out[j] = sigmoid(n->units_out[j]);
+            }
+        }
+    }
 
     if (n->nt == NT_RECURRENT) {
 
@@ -1011,10 +1368,10 @@ static void network_accumulate_weight_changes_ff(Network *n, double *test_in, do
 {
     /* FF Version: From Hertz et al., 1991, pp 116-117. */
 
-    double *delta_ho;
+    double *delta_ho = n->work_delta;
     int i, j, k;
 
-    if ((delta_ho = (double *)malloc(n->out_width * sizeof(double))) == NULL) {
+    if (delta_ho == NULL) {
         fprintf(stderr, "ERROR: Allocation failure in %s at %d\n", __FILE__, __LINE__);
         return;
     }
@@ -1056,9 +1413,42 @@ static void network_accumulate_weight_changes_ff(Network *n, double *test_in, do
         n->tmp_ih_deltas[n->in_width * n->hidden_width + j] = 0;
     }
 #endif
+}
+
+/*----------------------------------------------------------------------------*/
 
-    /* Deallocate temporary space: */
-    free(delta_ho);
+/* The dot product of two contiguous vectors, added to sum. By default this  */
+/* accumulates strictly in order, so results are identical to the original   */
+/* unit-by-unit BPTT loop. Compiling with -DBPTT_SIMD instead uses four      */
+/* partial sums, which the compiler can vectorise; with GCC on x86-64 AVX2   */
+/* and AVX-512 versions are also built and the best is selected at run time. */
+
+#if defined(BPTT_SIMD) && defined(__GNUC__) && defined(__x86_64__)
+__attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+static double vector_dot_add(double sum, int n, const double *a, const double *b)
+{
+    int i;
+#ifdef BPTT_SIMD
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+    for (i = 0; i + 3 < n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i+1] * b[i+1];
+        s2 += a[i+2] * b[i+2];
+        s3 += a[i+3] * b[i+3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i] * b[i];
+    }
+    return(sum + ((s0 + s1) + (s2 + s3)));
+#else
+
+    for (i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return(sum);
+#endif
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1069,16 +1459,21 @@ static void network_accumulate_weight_changes_srn(Network *n, double *test_in, d
 
     int cycles = RAN_SETTLING_CYCLES; 
     int units = n->hidden_width + n->out_width;
-    double *history_hidden = (double *)malloc((cycles+2) * n->hidden_width * sizeof(double));
-    double *history_error = (double *)malloc((cycles+2) * n->out_width * sizeof(double));
-    double *history_out = (double *)malloc((cycles+2) * n->out_width * sizeof(double));
-    double *delta = (double *)malloc((cycles+2) * units * sizeof(double));
-    double *epsilon = (double *)malloc((cycles+2) * units * sizeof(double));
-    double y, weight_lk, df;
-    int i, j, k, l, t;
+    double *history_hidden = n->work_hidden;
+    double *history_error = n->work_error;
+    double *history_out = n->work_out;
+    double *delta = n->work_delta;
+    double *epsilon = n->work_epsilon;
+    double y, df;
+    int i, j, k, t;
 
     Boolean penalty = FALSE;
 
+    if ((history_hidden == NULL) || (history_error == NULL) || (history_out == NULL) || (delta == NULL) || (epsilon == NULL)) {
+        fprintf(stderr, "ERROR: Allocation failure in %s at %d\n", __FILE__, __LINE__);
+        return;
+    }
+
     /* 1: Run the network over the entire sequence and collect its state: */
 
     network_tell_randomise_hidden(n);
@@ -1094,33 +1489,29 @@ static void network_accumulate_weight_changes_srn(Network *n, double *test_in, d
 
     }
 
-    /* 2: Calculate epsilon and delta for each non-input unit (equations 17-19): */
+    /* 2: Calculate epsilon and delta for each non-input unit (equations 17-19). */
+    /* Only hidden units have outgoing weights, so only they receive error from */
+    /* the next time step: the dot product of each hidden unit's outgoing rows  */
+    /* of weights_hh and weights_ho with the next step's hidden/output deltas:  */
 
     for (t = cycles+1; t > 0; t--) {
+        double *delta_next = &delta[(t+1) * units];
+
         for (k = 0; k < units; k++) {
             /* Calculate the external error for each node: */
             epsilon[t * units + k] = (k < n->hidden_width ? 0.0 : history_error[t * n->out_width + (k - n->hidden_width)]);
+        }
+        if (t < (cycles+1)) {
+            /* Add in the sum of delta terms to epsilon for hidden units: */
+            for (k = 0; k < n->hidden_width; k++) {
+                double e = epsilon[t * units + k];
 
-            /* Add in the sum of delta terms to epsilon if appropriate: */
-            if (t < (cycles+1)) {
-                for (l = 0; l < units; l++) {
-                    if (k < n->hidden_width) {
-                        if (l < n->hidden_width) {
-                            /* Weight from hidden unit k to hidden unit l: */
-                            weight_lk  = n->weights_hh[k*n->hidden_width+l];
-                        }
-                        else {
-                            /* Weight from hidden unit k to output unit (l-hidden_width): */
-                            weight_lk  = n->weights_ho[k*n->out_width+(l-n->hidden_width)];
-                        }
-                    }
-                    else {
-                        /* Weight from output unit (k-hidden_width) to unit l: */
-                        weight_lk = 0.0;
-                    }
-                    epsilon[t * units + k] += weight_lk * delta[(t+1) * units + l];
-                }
+                e = vector_dot_add(e, n->hidden_width, &n->weights_hh[k * n->hidden_width], delta_next);
+                e = vector_dot_add(e, n->out_width, &n->weights_ho[k * n->out_width], &delta_next[n->hidden_width]);
+                epsilon[t * units + k] = e;
             }
+        }
+        for (k = 0; k < units; k++) {
             /* And calculate the deltas... */
             y = (k < n->hidden_width ? history_hidden[t * n->hidden_width + k] : history_out[t * n->out_width + (k - n->hidden_width)]);
             df = y * (1-y);
@@ -1185,13 +1576,6 @@ static void network_accumulate_weight_changes_srn(Network *n, double *test_in, d
     write_network_deltas(stdout, n);
 
 #endif
-
-    /* 4: Release all allocated space: */
-    free(history_hidden);
-    free(history_out);
-    free(history_error);
-    free(delta);
-    free(epsilon);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1214,11 +1598,21 @@ static void network_accumulate_weight_changes(Network *n, double *test_in, doubl
     }
 }
 
-Boolean network_train(Network *n, NetworkParameters *pars, PatternList *seqs)
+/* Train for one epoch. If error is not NULL it is set to the error of the  */
+/* network on seqs, scaled as by network_test, but measured on the outputs  */
+/* of the training pass itself rather than on a separate test pass. With    */
+/* updates by epoch, the weights are fixed until the end of the pass, so    */
+/* this is the error before the epoch's update (for RAN networks, after the */
+/* fixed number of training cycles rather than settling). With updates by   */
+/* item, each pattern is measured before its own update.                    */
+
+Boolean network_train_with_error(Network *n, NetworkParameters *pars, PatternList *seqs, ErrorFunction ef, double *error)
 {
     /* FF Version: */
 
     double (*net_error_function)() = NULL;
+    double e = 0.0;
+    int l = 0;
 
     switch (pars->ef) {
         case SUM_SQUARE_ERROR: {
@@ -1244,6 +1638,10 @@ Boolean network_train(Network *n, NetworkParameters *pars, PatternList *seqs)
         /* Run the training data, accumulating weight changes over all sequences: */
         while (seqs != NULL) {
             network_accumulate_weight_changes(n, seqs->vector_in, seqs->vector_out, net_error_function);
+            if (error != NULL) {
+                e += vector_compare(ef, n->out_width, seqs->vector_out, n->units_out);
+                l++;
+            }
             seqs = seqs->next;
         }
 
@@ -1267,6 +1665,10 @@ Boolean network_train(Network *n, NetworkParameters *pars, PatternList *seqs)
 
             /* Run the training data, over the current pattern: */
             network_accumulate_weight_changes(n, seqs->vector_in, seqs->vector_out, net_error_function);
+            if (error != NULL) {
+                e += vector_compare(ef, n->out_width, seqs->vector_out, n->units_out);
+                l++;
+            }
 
             /* Now update the weights: */
             network_train_update_weights(n, pars->lr, wd, pars->momentum);
@@ -1276,18 +1678,44 @@ Boolean network_train(Network *n, NetworkParameters *pars, PatternList *seqs)
         }
     }
 
+    if (error != NULL) {
+        *error = (l > 0) ? e / (double) (l * n->out_width) : 0.0;
+    }
     return(TRUE);
 }
 
+Boolean network_train(Network *n, NetworkParameters *pars, PatternList *seqs)
+{
+    return(network_train_with_error(n, pars, seqs, pars->ef, NULL));
+}
+
 void network_train_to_criterion(Network *n, NetworkParameters *pars, PatternList *seqs)
 {
+    /* The error is tested every test_interval epochs. When it is taken from */
+    /* the training pass (which is only valid when updating by epoch) it is  */
+    /* that of the weights before the epoch's update, so training may run   */
+    /* one epoch beyond the point at which a separate test would stop it.    */
+
+    Boolean fused = pars->test_in_training && (pars->wut == UPDATE_BY_EPOCH);
+    int k = MAX(pars->test_interval, 1);
+    double error;
     int i;
 
     for (i = 0; i < pars->epochs; i++) {
-        network_train(n, pars, seqs);
-
-        if (network_test(n, seqs, pars->ef) < pars->criterion) {
-            return;
+        if (((i+1) % k) != 0) {
+            network_train(n, pars, seqs);
+        }
+        else if (fused) {
+            network_train_with_error(n, pars, seqs, pars->ef, &error);
+            if (error < pars->criterion) {
+                return;
+            }
+        }
+        else {
+            network_train(n, pars, seqs);
+            if (network_test(n, seqs, pars->ef) < pars->criterion) {
+                return;
+            }
         }
     }
 }
@@ -1505,6 +1933,180 @@ Network *network_read_weights_from_file(FILE *fp, int *error)
     return(n);
 }
 
+/*----------------------------------------------------------------------------*/
+/* Binary weights (native byte order). The header gives the network type and */
+/* layer sizes, and an FNV-1a checksum of the header and the weights, which  */
+/* follow in the order IH, HH (recurrent networks only), HO:                 */
+
+#define WGT_BIN_MAGIC "TYLWGT\0\0"
+#define WGT_BIN_VERSION 1
+#define WGT_BIN_BYTE_ORDER 0x01020304
+
+typedef struct wgt_bin_header {
+    char     magic[8];
+    int32_t  version;
+    int32_t  byte_order;
+    int32_t  nt;
+    int32_t  in_width, hidden_width, out_width;
+    int32_t  reserved[4];
+    uint64_t checksum;
+} WgtBinHeader;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t bytes)
+{
+    const unsigned char *byte = (const unsigned char *)data;
+    size_t k;
+
+    for (k = 0; k < bytes; k++) {
+        hash = (hash ^ byte[k]) * 0x100000001b3ULL;
+    }
+    return(hash);
+}
+
+static uint64_t network_weight_checksum(WgtBinHeader *header, Network *n)
+{
+    WgtBinHeader h0 = *header;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    int h = n->hidden_width;
+
+    h0.checksum = 0;
+    hash = fnv1a(hash, &h0, sizeof(WgtBinHeader));
+    hash = fnv1a(hash, n->weights_ih, (n->in_width+1) * h * sizeof(double));
+    if (n->weights_hh != NULL) {
+        hash = fnv1a(hash, n->weights_hh, h * h * sizeof(double));
+    }
+    hash = fnv1a(hash, n->weights_ho, (h+1) * n->out_width * sizeof(double));
+    return(hash);
+}
+
+Boolean network_write_weights_binary(Network *n, char *filename)
+{
+    int i = n->in_width, h = n->hidden_width, o = n->out_width;
+    char tmpname[1024];
+    WgtBinHeader header;
+    Boolean ok;
+    FILE *fp;
+
+    memset(&header, 0, sizeof(WgtBinHeader));
+    memcpy(header.magic, WGT_BIN_MAGIC, 8);
+    header.version = WGT_BIN_VERSION;
+    header.byte_order = WGT_BIN_BYTE_ORDER;
+    header.nt = (n->weights_hh != NULL) ? NT_RECURRENT : NT_FEEDFORWARD;
+    header.in_width = i;
+    header.hidden_width = h;
+    header.out_width = o;
+    header.checksum = network_weight_checksum(&header, n);
+
+    // Written under a per-process temporary name and renamed into place:
+    g_snprintf(tmpname, 1024, "%s.%d.tmp", filename, (int) getpid());
+    if ((fp = fopen(tmpname, "wb")) == NULL) {
+        return(FALSE);
+    }
+    ok = (fwrite(&header, sizeof(WgtBinHeader), 1, fp) == 1);
+    ok = ok && (fwrite(n->weights_ih, sizeof(double), (i+1) * h, fp) == (i+1) * h);
+    if (n->weights_hh != NULL) {
+        ok = ok && (fwrite(n->weights_hh, sizeof(double), h * h, fp) == h * h);
+    }
+    ok = ok && (fwrite(n->weights_ho, sizeof(double), (h+1) * o, fp) == (h+1) * o);
+    ok = (fclose(fp) == 0) && ok;
+
+    if (!ok || (rename(tmpname, filename) != 0)) {
+        remove(tmpname);
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+static Network *network_read_weights_binary(FILE *fp, int *error)
+{
+    WgtBinHeader header;
+    Network *n;
+    int i, h, o;
+
+    if ((fread(&header, sizeof(WgtBinHeader), 1, fp) != 1) || (memcmp(header.magic, WGT_BIN_MAGIC, 8) != 0)) {
+        *error = ERROR_RW_HEADER1;
+        return(NULL);
+    }
+    else if ((header.version != WGT_BIN_VERSION) || (header.byte_order != WGT_BIN_BYTE_ORDER)) {
+        *error = ERROR_RW_VERSION;
+        return(NULL);
+    }
+    else if ((header.nt < 0) || (header.nt >= NT_MAX) || (header.in_width < 1) || (header.hidden_width < 1) || (header.out_width < 1)) {
+        *error = ERROR_RW_HEADER1;
+        return(NULL);
+    }
+
+    i = header.in_width;
+    h = header.hidden_width;
+    o = header.out_width;
+
+    if ((n = network_initialise((NetworkType) header.nt, i, h, o)) == NULL) {
+        *error = ERROR_RW_ALLOC1;
+        return(NULL);
+    }
+    else if ((fread(n->weights_ih, sizeof(double), (i+1) * h, fp) != (i+1) * h) ||
+             ((n->weights_hh != NULL) && (fread(n->weights_hh, sizeof(double), h * h, fp) != h * h)) ||
+             (fread(n->weights_ho, sizeof(double), (h+1) * o, fp) != (h+1) * o) ||
+             (fgetc(fp) != EOF)) {
+        network_destroy(n);
+        *error = ERROR_RW_READ1;
+        return(NULL);
+    }
+    else if (network_weight_checksum(&header, n) != header.checksum) {
+        network_destroy(n);
+        *error = ERROR_RW_CHECKSUM;
+        return(NULL);
+    }
+    return(n);
+}
+
+static Boolean file_is_newer(char *file1, char *file2)
+{
+    struct stat st1, st2;
+
+    return((stat(file1, &st1) == 0) && (stat(file2, &st2) == 0) && (st1.st_mtime >= st2.st_mtime));
+}
+
+Network *network_read_weights(char *filename, int *error)
+{
+    /* Read weights from filename, which may be text or binary. For text    */
+    /* files, an up to date binary copy in filename.bin is used if present, */
+    /* and written if not. On failure *error is ERROR_RW_OPEN if the file   */
+    /* could not be opened, or the format error:                            */
+
+    char binfile[1024];
+    char magic[8];
+    Network *n;
+    FILE *fp;
+
+    g_snprintf(binfile, 1024, "%s.bin", filename);
+    if (file_is_newer(binfile, filename) && ((fp = fopen(binfile, "rb")) != NULL)) {
+        n = network_read_weights_binary(fp, error);
+        fclose(fp);
+        if (n != NULL) {
+            return(n);
+        }
+        fprintf(stderr, "WARNING: %s is corrupt or out of date (error %d) ... reading %s\n", binfile, *error, filename);
+    }
+
+    if ((fp = fopen(filename, "rb")) == NULL) {
+        *error = ERROR_RW_OPEN;
+        return(NULL);
+    }
+    if ((fread(magic, 1, 8, fp) == 8) && (memcmp(magic, WGT_BIN_MAGIC, 8) == 0)) {
+        rewind(fp);
+        n = network_read_weights_binary(fp, error);
+    }
+    else {
+        rewind(fp);
+        if ((n = network_read_weights_from_file(fp, error)) != NULL) {
+            network_write_weights_binary(n, binfile);
+        }
+    }
+    fclose(fp);
+    return(n);
+}
+
 /******************************************************************************/
 /* SECTION XX */
 /******************************************************************************/
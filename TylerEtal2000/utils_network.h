@@ -14,9 +14,38 @@ typedef enum {UPDATE_BY_ITEM, UPDATE_BY_EPOCH} WeightUpdateTime;
 typedef enum {ERROR_NONE, 
     ERROR_RW_HEADER1, ERROR_RW_ALLOC1, ERROR_RW_READ1,
     ERROR_RW_HEADER2, ERROR_RW_ALLOC2, ERROR_RW_READ2,
-    ERROR_RW_HEADER3, ERROR_RW_ALLOC3, ERROR_RW_READ3} ErrorType;
+    ERROR_RW_HEADER3, ERROR_RW_ALLOC3, ERROR_RW_READ3,
+    ERROR_RW_VERSION, ERROR_RW_CHECKSUM, ERROR_RW_OPEN} ErrorType;
 typedef enum {NT_FEEDFORWARD, NT_RECURRENT, NT_MAX} NetworkType;
 
+// Damage applied without touching a network's weights. The propagate
+// routines read each weight as (w + noise) * scale, or as zero if the
+// connection is severed or comes from an ablated hidden unit. Bias weights
+// are left unscaled unless BIAS_LESION is defined (see utils_network.c).
+
+// For nested lesions each connection is given a key in (0, 1) once, and a
+// lesion of severity s severs the connections with key below s, so lesions
+// of increasing severity each contain the last:
+
+typedef struct lesion_ranking {
+    int n;                 // Connections ranked
+    int *order;            // The connections, in the order they are severed
+    double *key;           // The severity at which each is severed
+    int severed;           // order[0 ... severed-1] are severed
+} LesionRanking;
+
+typedef struct damage_overlay {
+    Boolean recurrent;
+    int in_width, hidden_width, out_width;
+    unsigned int *severed_ih, *severed_hh, *severed_ho; // One bit per weight
+    double *noise_ih, *noise_hh, *noise_ho;
+    Boolean *ablated_hh, *ablated_ho;     // Outgoing weights of hidden units
+    double scale;
+    Boolean any_severed, any_noise, any_ablated;
+    Boolean ranked;                       // The rankings below have been drawn
+    LesionRanking rank_ih, rank_hh, rank_ho;
+} DamageOverlay;
+
 // We treat the network as an object, which we ask and tell things.
 
 typedef struct network {
@@ -28,6 +57,12 @@ typedef struct network {
     double *units_in, *units_hidden, *units_hidden_prev, *units_out;
     double *tmp_ih_deltas, *tmp_hh_deltas, *tmp_ho_deltas;
     double *previous_ih_deltas, *previous_hh_deltas, *previous_ho_deltas;
+    // Training workspace, allocated with the network and reused by every
+    // call to network_train (only work_delta is used by FF networks):
+    double *work_hidden, *work_error, *work_out, *work_delta, *work_epsilon;
+    DamageOverlay *damage;     // Not owned by the network; NULL if undamaged
+    double *input_net;         // Not owned: the input layer's contribution to
+                               // the hidden net input, if known (else NULL)
 } Network;
 
 typedef struct network_parameters {
@@ -40,6 +75,8 @@ typedef struct network_parameters {
     WeightUpdateTime wut;      // Update by item or by epoch
     int epochs;                // Maximum number of epochs to train
     double criterion;          // Criterion error when training should terminate
+    int test_interval;         // Epochs between criterion tests (0 is every epoch)
+    Boolean test_in_training;  // Take the criterion error from the training pass
 } NetworkParameters;
 
 // Compile for clamped or unclamped version of RAN:
@@ -70,6 +107,9 @@ extern Network *network_initialise(NetworkType nt, int iw, int hw, int ow);
 extern void network_initialise_weights(Network *net, double weight_noise);
 extern Network *network_copy(Network *net);
 extern void network_tell_input(Network *n, double *vector);
+extern void network_ask_input_net(Network *n, double *vector, double *net);
+extern void network_adjust_input_net(Network *n, double *net, int i, double delta);
+extern void network_tell_input_with_net(Network *n, double *vector, double *net);
 extern void network_tell_randomise_hidden(Network *n);
 extern void network_tell_propagate(Network *n);
 extern void network_tell_propagate_full(Network *n);
@@ -87,8 +127,19 @@ extern void network_perturb_weights_ho(Network *net, double noise_sd);
 extern void network_perturb_weights(Network *net, double noise_sd);
 extern void network_ablate_units(Network *net, double severity);
 extern void network_scale_weights(Network *net, double scale);
+extern DamageOverlay *damage_overlay_create(Network *net);
+extern void damage_overlay_destroy(DamageOverlay *d);
+extern void damage_overlay_clear(DamageOverlay *d);
+extern void damage_overlay_lesion_weights(DamageOverlay *d, double severity);
+extern void damage_overlay_rank_weights(DamageOverlay *d);
+extern void damage_overlay_lesion_nested(DamageOverlay *d, double severity);
+extern void damage_overlay_perturb_weights(DamageOverlay *d, double noise_sd);
+extern void damage_overlay_ablate_units(DamageOverlay *d, double severity);
+extern void damage_overlay_scale_weights(DamageOverlay *d, double scale);
+extern void network_tell_damage(Network *n, DamageOverlay *d);
 extern double network_test(Network *n, PatternList *test_patterns, ErrorFunction ef);
 extern Boolean network_train(Network *n, NetworkParameters *pars, PatternList *test_patterns);
+extern Boolean network_train_with_error(Network *n, NetworkParameters *pars, PatternList *seqs, ErrorFunction ef, double *error);
 extern void network_train_to_criterion(Network *n, NetworkParameters *pars, PatternList *seqs);
 extern void network_train_to_epochs(Network *n, NetworkParameters *pars, PatternList *seqs);
 extern void training_set_free(PatternList *patterns);
@@ -98,6 +149,8 @@ extern PatternList *training_set_next(PatternList *patterns);
 extern double *training_set_input_vector(PatternList *patterns);
 extern Boolean network_dump_weights(Network *n, FILE *fp);
 extern Network *network_read_weights_from_file(FILE *fp, int *error);
+extern Network *network_read_weights(char *filename, int *error);
+extern Boolean network_write_weights_binary(Network *n, char *filename);
 extern double net_conflict(Network *n);
 extern void network_inject_noise(Network *n, double sv_noise);
 
@@ -123,3 +123,81 @@ double response_error(PatternList *input, double *result, FeatureType ft)
     return(e / 8.0);
 }
 
+/******************************************************************************/
+
+void lesion_measure(Network *net, PatternList *training_set, double *measure)
+{
+    // Present each pattern in turn and set measure[0 .. LM_MAX-1]. Within
+    // (w) and between (b) errors are errors within and between the categories
+    // of a domain. There is a third type of error - between domain - which
+    // is not counted.
+
+    double r[IO_WIDTH];
+    PatternList *p;
+    int animal_t = 0, artifact_t = 0;
+    int ft, k;
+
+    for (k = 0; k < LM_MAX; k++) {
+        measure[k] = 0.0;
+    }
+
+    for (p = training_set; p != NULL; p = p->next) {
+        Boolean animal = pattern_is_animal(p);
+
+        network_tell_input(net, p->vector_in);
+        network_tell_propagate_full(net);
+        network_ask_output(net, r);
+
+        for (ft = F_DISTINCTIVE; ft <= F_FUNCTIONAL; ft++) {
+            measure[LM_FEATURE_ERROR(ft, !animal)] += response_error(p, r, (FeatureType) ft);
+        }
+        if (animal) {
+            animal_t++;
+            if (response_is_correct(training_set, p, r)) {
+                measure[LM_ANIMAL_CORRECT] += 1.0;
+            }
+            if (pattern_is_animal1(p) && response_is_animal2(training_set, r)) {
+                measure[LM_ANIMAL_BETWEEN] += 1.0;
+            }
+            else if (pattern_is_animal2(p) && response_is_animal1(training_set, r)) {
+                measure[LM_ANIMAL_BETWEEN] += 1.0;
+            }
+            else if (!response_is_correct(training_set, p, r)) {
+                if (response_is_animal1(training_set, r) || response_is_animal2(training_set, r)) {
+                    measure[LM_ANIMAL_WITHIN] += 1.0;
+                }
+            }
+        }
+        else {
+            artifact_t++;
+            if (response_is_correct(training_set, p, r)) {
+                measure[LM_ARTIFACT_CORRECT] += 1.0;
+            }
+            if (pattern_is_artifact1(p) && response_is_artifact2(training_set, r)) {
+                measure[LM_ARTIFACT_BETWEEN] += 1.0;
+            }
+            else if (pattern_is_artifact2(p) && response_is_artifact1(training_set, r)) {
+                measure[LM_ARTIFACT_BETWEEN] += 1.0;
+            }
+            else if (!response_is_correct(training_set, p, r)) {
+                if (response_is_artifact1(training_set, r) || response_is_artifact2(training_set, r)) {
+                    measure[LM_ARTIFACT_WITHIN] += 1.0;
+                }
+            }
+        }
+    }
+
+    // Convert the sums to means and the counts to percentages:
+    for (ft = F_DISTINCTIVE; ft <= F_FUNCTIONAL; ft++) {
+        measure[LM_FEATURE_ERROR(ft, FALSE)] /= (double) animal_t;
+        measure[LM_FEATURE_ERROR(ft, TRUE)] /= (double) artifact_t;
+    }
+    measure[LM_ANIMAL_CORRECT] *= 100.0 / (double) animal_t;
+    measure[LM_ANIMAL_BETWEEN] *= 100.0 / (double) animal_t;
+    measure[LM_ANIMAL_WITHIN] *= 100.0 / (double) animal_t;
+    measure[LM_ARTIFACT_CORRECT] *= 100.0 / (double) artifact_t;
+    measure[LM_ARTIFACT_BETWEEN] *= 100.0 / (double) artifact_t;
+    measure[LM_ARTIFACT_WITHIN] *= 100.0 / (double) artifact_t;
+}
+
+/******************************************************************************/
@@ -1,20 +1,24 @@
 
 #include "xframe.h"
 #include "lib_string.h"
+#include "lib_maths.h"
 #include "lib_cairoxg_2_2.h"
 
 #define MAX_NETWORKS 300
 #define MAX_POINTS    21
-static float animal_within[MAX_NETWORKS][MAX_POINTS];
-static float animal_between[MAX_NETWORKS][MAX_POINTS];
-static float animal_correct[MAX_NETWORKS][MAX_POINTS];
-static float animal_error_s[MAX_NETWORKS][MAX_POINTS];
-static float animal_error_d[MAX_NETWORKS][MAX_POINTS];
-static float animal_error[MAX_NETWORKS][MAX_POINTS];
-static float artifact_within[MAX_NETWORKS][MAX_POINTS];
-static float artifact_between[MAX_NETWORKS][MAX_POINTS];
-static float artifact_correct[MAX_NETWORKS][MAX_POINTS];
-static float artifact_error[MAX_NETWORKS][MAX_POINTS];
+
+// Statistics over the networks tested so far, at each point on the graph
+// (only those for the current graph are used):
+static RunningStats animal_within[MAX_POINTS];
+static RunningStats animal_between[MAX_POINTS];
+static RunningStats animal_correct[MAX_POINTS];
+static RunningStats animal_error_s[MAX_POINTS];
+static RunningStats animal_error_d[MAX_POINTS];
+static RunningStats animal_error[MAX_POINTS];
+static RunningStats artifact_within[MAX_POINTS];
+static RunningStats artifact_between[MAX_POINTS];
+static RunningStats artifact_correct[MAX_POINTS];
+static RunningStats artifact_error[MAX_POINTS];
 
 // Tyler et al used 0.80
 #define MAX_DAMAGE 1.00
@@ -36,6 +40,12 @@ static GraphStruct *gd = NULL;
 
 static Boolean paused;
 
+// While data is generated the graph is redrawn from a timer, at most every
+// REDRAW_INTERVAL ms, rather than after every network:
+#define REDRAW_INTERVAL 100
+static Boolean redraw_pending = FALSE;
+static guint redraw_timer = 0;
+
 static char *dump_file_prefix[4] = {"zero",
                                     "noise",
                                     "ablate",
@@ -128,296 +138,134 @@ static Boolean lesion_viewer_repaint_callback(GtkWidget *widget, GdkEventConfigu
     return(lesion_viewer_repaint(xg));
 }
 
-/******************************************************************************/
-
-void test_features(Network *net, PatternList *training_set, int j, int i, double ll, FeatureType ft)
+static gboolean lesion_viewer_redraw_timeout(gpointer data)
 {
-    double *r = (double *)malloc(IO_WIDTH * sizeof(double));
-    PatternList *p;
-    double animal_f;
-    double artifact_f;
-    int animal_t;
-    int artifact_t;
-    double sum_animal_e;
-    double sum_artifact_e;
-    double ssq_animal_e;
-    double ssq_artifact_e;
-    int k;
-
-    gd->dataset[0].x[i] = ll;
-    gd->dataset[1].x[i] = ll;
+    if (redraw_pending) {
+        redraw_pending = FALSE;
+        lesion_viewer_repaint((XGlobals *)data);
+        return(TRUE);
+    }
+    else {
+        redraw_timer = 0;
+        return(FALSE);
+    }
+}
 
-    animal_f = 0;
-    artifact_f = 0;
-    animal_t = 0;
-    artifact_t = 0;
+static void lesion_viewer_request_redraw(XGlobals *xg)
+{
+    redraw_pending = TRUE;
+    if (redraw_timer == 0) {
+        redraw_timer = g_timeout_add(REDRAW_INTERVAL, lesion_viewer_redraw_timeout, xg);
+    }
+}
 
-    for (p = training_set; p != NULL; p = p->next) {
-        network_tell_input(net, p->vector_in);
-        network_tell_propagate_full(net);
-        network_ask_output(net, r);
+/******************************************************************************/
 
-        if (pattern_is_animal(p)) {
-            animal_t++;
-            animal_f += response_error(p, r, ft);
-        }
-        else {
-            artifact_t++;
-            artifact_f += response_error(p, r, ft);
-        }
-    }
-    animal_error[j][i] = animal_f / (double) animal_t;
-    artifact_error[j][i] = artifact_f / (double) artifact_t;
-
-    sum_animal_e = 0;
-    sum_artifact_e = 0;
-    ssq_animal_e = 0;
-    ssq_artifact_e = 0;
-
-    for (k = 0; k <= j; k++) {
-        sum_animal_e += animal_error[k][i];
-        ssq_animal_e += (animal_error[k][i] * animal_error[k][i]);
-        sum_artifact_e += artifact_error[k][i];
-        ssq_artifact_e += (artifact_error[k][i] * artifact_error[k][i]);
+static void lesion_stats_reset()
+{
+    int i;
+
+    for (i = 0; i < MAX_POINTS; i++) {
+        running_stats_reset(&animal_within[i]);
+        running_stats_reset(&animal_between[i]);
+        running_stats_reset(&animal_correct[i]);
+        running_stats_reset(&animal_error_s[i]);
+        running_stats_reset(&animal_error_d[i]);
+        running_stats_reset(&animal_error[i]);
+        running_stats_reset(&artifact_within[i]);
+        running_stats_reset(&artifact_between[i]);
+        running_stats_reset(&artifact_correct[i]);
+        running_stats_reset(&artifact_error[i]);
     }
+}
 
-    // Set line data to means of [j][i] for k = 0 < j
-    gd->dataset[0].y[i] = (j+1 > 0) ? sum_animal_e / (double) (j+1) : 0.0;
-    gd->dataset[0].se[i] = sqrt((ssq_animal_e - (sum_animal_e*sum_animal_e / (double) (j+1)))/((double) j)) / sqrt(j+1);
-    gd->dataset[1].y[i] = (j+1 > 0) ? sum_artifact_e / (double) (j+1) : 0.0;
-    gd->dataset[1].se[i] = sqrt((ssq_artifact_e - (sum_artifact_e*sum_artifact_e / (double) (j+1)))/((double) j)) / sqrt(j+1);
+static void lesion_stats_plot(int d, int i, RunningStats *rs)
+{
+    // Set line data to the mean over the networks so far:
+    gd->dataset[d].y[i] = running_stats_mean(rs);
+    gd->dataset[d].se[i] = running_stats_se(rs);
 }
 
-void test_animal_features(Network *net, PatternList *training_set, int j, int i, double ll)
+/*----------------------------------------------------------------------------*/
+
+// Each test presents every pattern once (see lesion_measure in world.c) and
+// adds the measures for its graph to the statistics at point i:
+
+void test_features(Network *net, PatternList *training_set, int i, double ll, FeatureType ft)
 {
-    double *r = (double *)malloc(IO_WIDTH * sizeof(double));
-    PatternList *p;
-    double animal_s;
-    double animal_d;
-    int animal_t;
-    double sum_animal_s;
-    double sum_animal_d;
-    double ssq_animal_s;
-    double ssq_animal_d;
-    int k;
+    double m[LM_MAX];
 
     gd->dataset[0].x[i] = ll;
     gd->dataset[1].x[i] = ll;
 
-    animal_s = 0;
-    animal_d = 0;
-    animal_t = 0;
+    lesion_measure(net, training_set, m);
+    running_stats_add(&animal_error[i], m[LM_FEATURE_ERROR(ft, FALSE)]);
+    running_stats_add(&artifact_error[i], m[LM_FEATURE_ERROR(ft, TRUE)]);
 
-    for (p = training_set; p != NULL; p = p->next) {
-        if (pattern_is_animal(p)) {
-            network_tell_input(net, p->vector_in);
-            network_tell_propagate_full(net);
-            network_ask_output(net, r);
-
-            animal_t++;
-            animal_s += response_error(p, r, F_SHARED);
-            animal_d += response_error(p, r, F_DISTINCTIVE);
-        }
-    }
-    animal_error_s[j][i] = animal_s / (double) animal_t;
-    animal_error_d[j][i] = animal_d / (double) animal_t;
-
-    sum_animal_s = 0;
-    sum_animal_d = 0;
-    ssq_animal_s = 0;
-    ssq_animal_d = 0;
-
-    for (k = 0; k <= j; k++) {
-        sum_animal_s += animal_error_s[k][i];
-        ssq_animal_s += (animal_error_s[k][i] * animal_error_s[k][i]);
-        sum_animal_d += animal_error_d[k][i];
-        ssq_animal_d += (animal_error_d[k][i] * animal_error_d[k][i]);
-    }
-
-    // Set line data to means of [j][i] for k = 0 < j
-    gd->dataset[0].y[i] = (j+1 > 0) ? sum_animal_s / (double) (j+1) : 0.0;
-    gd->dataset[0].se[i] = sqrt((ssq_animal_s - (sum_animal_s*sum_animal_s / (double) (j+1)))/((double) j)) / sqrt(j+1);
-    gd->dataset[1].y[i] = (j+1 > 0) ? sum_animal_d / (double) (j+1) : 0.0;
-    gd->dataset[1].se[i] = sqrt((ssq_animal_d - (sum_animal_d*sum_animal_d / (double) (j+1)))/((double) j)) / sqrt(j+1);
+    lesion_stats_plot(0, i, &animal_error[i]);
+    lesion_stats_plot(1, i, &artifact_error[i]);
 }
 
-void test_patterns_correct(Network *net, PatternList *training_set, int j, int i, double ll)
+void test_animal_features(Network *net, PatternList *training_set, int i, double ll)
 {
-    double *r = (double *)malloc(IO_WIDTH * sizeof(double));
-    PatternList *p;
-    int animal_t;
-    int animal_c;
-    int artifact_t;
-    int artifact_c;
-    double sum_animal_c;
-    double sum_artifact_c;
-    double ssq_animal_c;
-    double ssq_artifact_c;
-    int k;
+    double m[LM_MAX];
 
     gd->dataset[0].x[i] = ll;
     gd->dataset[1].x[i] = ll;
 
-    animal_t = 0;
-    animal_c = 0;
-    artifact_t = 0;
-    artifact_c = 0;
+    lesion_measure(net, training_set, m);
+    running_stats_add(&animal_error_s[i], m[LM_ANIMAL_SHARED]);
+    running_stats_add(&animal_error_d[i], m[LM_ANIMAL_DISTINCTIVE]);
 
-    for (p = training_set; p != NULL; p = p->next) {
+    lesion_stats_plot(0, i, &animal_error_s[i]);
+    lesion_stats_plot(1, i, &animal_error_d[i]);
+}
 
-        network_tell_input(net, p->vector_in);
-        network_tell_propagate_full(net);
-        network_ask_output(net, r);
+void test_patterns_correct(Network *net, PatternList *training_set, int i, double ll)
+{
+    double m[LM_MAX];
 
-        if (pattern_is_animal(p)) {
-            animal_t++;
-            if (response_is_correct(training_set, p, r)) {
-                animal_c++;
-            }
-        }
-        else {
-            artifact_t++;
-            if (response_is_correct(training_set, p, r)) {
-                artifact_c++;
-            }
-        }
-    }
-    animal_correct[j][i] = animal_c * 100.0 / (double) animal_t;
-    artifact_correct[j][i] = artifact_c * 100.0 / (double) artifact_t;
-
-    sum_animal_c = 0;
-    sum_artifact_c = 0;
-    ssq_animal_c = 0;
-    ssq_artifact_c = 0;
-
-    for (k = 0; k <= j; k++) {
-        sum_animal_c += animal_correct[k][i];
-        ssq_animal_c += (animal_correct[k][i] * animal_correct[k][i]);
-        sum_artifact_c += artifact_correct[k][i];
-        ssq_artifact_c += (artifact_correct[k][i] * artifact_correct[k][i]);
-    }
+    gd->dataset[0].x[i] = ll;
+    gd->dataset[1].x[i] = ll;
+
+    lesion_measure(net, training_set, m);
+    running_stats_add(&animal_correct[i], m[LM_ANIMAL_CORRECT]);
+    running_stats_add(&artifact_correct[i], m[LM_ARTIFACT_CORRECT]);
 
-    // Set line data to means of [j][i] for k = 0 < j
-    gd->dataset[0].y[i] = (j+1 > 0) ? sum_animal_c / (double) (j+1) : 0.0;
-    gd->dataset[0].se[i] = sqrt((ssq_animal_c - (sum_animal_c*sum_animal_c / (double) (j+1)))/((double) j)) / sqrt(j+1);
-    gd->dataset[1].y[i] = (j+1 > 0) ? sum_artifact_c / (double) (j+1) : 0.0;
-    gd->dataset[1].se[i] = sqrt((ssq_artifact_c - (sum_artifact_c*sum_artifact_c / (double) (j+1)))/((double) j)) / sqrt(j+1);
+    lesion_stats_plot(0, i, &animal_correct[i]);
+    lesion_stats_plot(1, i, &artifact_correct[i]);
 }
 
-void test_patterns_error_breakdown(Network *net, PatternList *training_set, int j, int i, double ll)
+void test_patterns_error_breakdown(Network *net, PatternList *training_set, int i, double ll)
 {
-    double *r = (double *)malloc(IO_WIDTH * sizeof(double));
-    PatternList *p;
-    int animal_t;
-    int animal_w;
-    int animal_b;
-    int artifact_t;
-    int artifact_w;
-    int artifact_b;
-    double sum_animal_w;
-    double sum_artifact_w;
-    double ssq_animal_w;
-    double ssq_artifact_w;
-    double sum_animal_b;
-    double sum_artifact_b;
-    double ssq_animal_b;
-    double ssq_artifact_b;
-    int k;
+    double m[LM_MAX];
 
     gd->dataset[0].x[i] = ll;
     gd->dataset[1].x[i] = ll;
     gd->dataset[2].x[i] = ll;
     gd->dataset[3].x[i] = ll;
 
-    animal_t = 0;
-    animal_w = 0;
-    animal_b = 0;
-    artifact_t = 0;
-    artifact_w = 0;
-    artifact_b = 0;
-
-    for (p = training_set; p != NULL; p = p->next) {
-
-        network_tell_input(net, p->vector_in);
-        network_tell_propagate_full(net);
-        network_ask_output(net, r);
-
-	// DOMAIN_w means a "within category" error for that domain
-	// DOMAIN_b means a "between category" error for that domain
-	// There is another type of error - betweeen domain.
-	// We don't count the latter.
-
-        if (pattern_is_animal(p)) {
-            animal_t++;
-	    if (pattern_is_animal1(p) && response_is_animal2(training_set, r)) {
-                animal_b++;
-	    }
-            else if (pattern_is_animal2(p) && response_is_animal1(training_set, r)) {
-                animal_b++;
-            }
-            else if (!response_is_correct(training_set, p, r)) {
-	      if (response_is_animal1(training_set, r) || response_is_animal2(training_set, r)) {
-                animal_w++;
-	      }
-	    }
-        }
-        else {
-            artifact_t++;
-	    if (pattern_is_artifact1(p) && response_is_artifact2(training_set, r)) {
-                artifact_b++;
-	    }
-            else if (pattern_is_artifact2(p) && response_is_artifact1(training_set, r)) {
-                artifact_b++;
-            }
-            else if (!response_is_correct(training_set, p, r)) {
-	      if (response_is_artifact1(training_set, r) || response_is_artifact2(training_set, r)) {
-                artifact_w++;
-	      }
-	    }
-        }
-    }
-    animal_within[j][i] = animal_w * 100.0 / (double) animal_t;
-    animal_between[j][i] = animal_b * 100.0 / (double) animal_t;
-    artifact_within[j][i] = artifact_w * 100.0 / (double) artifact_t;
-    artifact_between[j][i] = artifact_b * 100.0 / (double) artifact_t;
-
-    sum_animal_w = 0;
-    sum_animal_b = 0;
-    sum_artifact_w = 0;
-    sum_artifact_b = 0;
-    ssq_animal_w = 0;
-    ssq_animal_b = 0;
-    ssq_artifact_w = 0;
-    ssq_artifact_b = 0;
-
-    for (k = 0; k <= j; k++) {
-        sum_animal_w += animal_within[k][i];
-        sum_animal_b += animal_between[k][i];
-        sum_artifact_w += artifact_within[k][i];
-        sum_artifact_b += artifact_between[k][i];
-        ssq_animal_w += (animal_within[k][i] * animal_within[k][i]);
-        ssq_animal_b += (animal_between[k][i] * animal_between[k][i]);
-        ssq_artifact_w += (artifact_within[k][i] * artifact_within[k][i]);
-        ssq_artifact_b += (artifact_between[k][i] * artifact_between[k][i]);
-    }
+    lesion_measure(net, training_set, m);
+    running_stats_add(&animal_within[i], m[LM_ANIMAL_WITHIN]);
+    running_stats_add(&animal_between[i], m[LM_ANIMAL_BETWEEN]);
+    running_stats_add(&artifact_within[i], m[LM_ARTIFACT_WITHIN]);
+    running_stats_add(&artifact_between[i], m[LM_ARTIFACT_BETWEEN]);
 
-    // Set line data to means of [j][i] for k = 0 < j
-    gd->dataset[0].y[i] = (j+1 > 0) ? sum_animal_b / (double) (j+1) : 0.0;
-    gd->dataset[0].se[i] = sqrt((ssq_animal_b - (sum_animal_b*sum_animal_b / (double) (j+1)))/((double) j)) / sqrt(j+1);
-    gd->dataset[1].y[i] = (j+1 > 0) ? sum_animal_w / (double) (j+1) : 0.0;
-    gd->dataset[1].se[i] = sqrt((ssq_animal_w - (sum_animal_w*sum_animal_w / (double) (j+1)))/((double) j)) / sqrt(j+1);
-    gd->dataset[2].y[i] = (j+1 > 0) ? sum_artifact_b / (double) (j+1) : 0.0;
-    gd->dataset[2].se[i] = sqrt((ssq_artifact_b - (sum_artifact_b*sum_artifact_b / (double) (j+1)))/((double) j)) / sqrt(j+1);
-    gd->dataset[3].y[i] = (j+1 > 0) ? sum_artifact_w / (double) (j+1) : 0.0;
-    gd->dataset[3].se[i] = sqrt((ssq_artifact_w - (sum_artifact_w*sum_artifact_w / (double) (j+1)))/((double) j)) / sqrt(j+1);
+    lesion_stats_plot(0, i, &animal_between[i]);
+    lesion_stats_plot(1, i, &animal_within[i]);
+    lesion_stats_plot(2, i, &artifact_between[i]);
+    lesion_stats_plot(3, i, &artifact_within[i]);
 }
 
 static void generate_lesion_data(XGlobals *xg)
 {
-    Network *tmp, *my_net;
+    Network *my_net;
+    DamageOverlay *damage = NULL;
+    double *hidden_prev = NULL;
     int i, j;
 
     paused = FALSE;
+    lesion_stats_reset();
 
     for (j = 0; j < MAX_NETWORKS; j++) {
         xg->reps = j+1;
@@ -433,30 +281,58 @@ static void generate_lesion_data(XGlobals *xg)
         fprintf(stdout, " Weight range: [%7.5f - %7.5f];",         network_weight_minimum(my_net), network_weight_maximum(my_net)); 
         fprintf(stdout, " Error: %7.5f\n", sqrt(network_test(my_net, xg->training_set, SUM_SQUARE_ERROR))); fflush(stdout);
 
+        // Damage is applied through an overlay on my_net's own weights. Each
+        // level starts from the same context state, as a fresh copy would:
+        if (damage == NULL) {
+            damage = damage_overlay_create(my_net);
+            hidden_prev = (double *)malloc(my_net->hidden_width * sizeof(double));
+        }
+        if (my_net->units_hidden_prev != NULL) {
+            memcpy(hidden_prev, my_net->units_hidden_prev, my_net->hidden_width * sizeof(double));
+        }
+        if (xg->nested) {
+            // Nested lesions: one ranking of the connections serves every
+            // level, each level severing the next connections in rank order:
+            damage_overlay_clear(damage);
+            damage_overlay_rank_weights(damage);
+        }
+
         for (i = 0; i < MAX_POINTS; i++) {
             double ll = 0.0;
-            tmp = network_copy(my_net);
+
+            if (my_net->units_hidden_prev != NULL) {
+                memcpy(my_net->units_hidden_prev, hidden_prev, my_net->hidden_width * sizeof(double));
+            }
+            if (!xg->nested || (xg->lesion_type != 0)) {
+                damage_overlay_clear(damage);
+            }
+            network_tell_damage(my_net, damage);
 
             if (xg->lesion_type == 0) {
                 ll = 100 * i * MAX_DAMAGE / (double) (MAX_POINTS - 1);
-                network_lesion_weights(tmp, ll / 100.0);
+                if (xg->nested) {
+                    damage_overlay_lesion_nested(damage, ll / 100.0);
+                }
+                else {
+                    damage_overlay_lesion_weights(damage, ll / 100.0);
+                }
             }
             else if (xg->lesion_type == 1) {
                 ll = i * MAX_NOISE / (double) (MAX_POINTS - 1);
-                network_perturb_weights(tmp, ll);
+                damage_overlay_perturb_weights(damage, ll);
             }
             else if (xg->lesion_type == 2) {
                 ll = 100.0 * i * MAX_ABLATE / (double) (MAX_POINTS - 1);
-                network_ablate_units(tmp, ll);
+                damage_overlay_ablate_units(damage, ll / 100.0);
             }
             else if (xg->lesion_type == 3) {
                 ll = 1.0 - (i * MAX_SCALE / (double) (MAX_POINTS - 1));
-                network_scale_weights(tmp, ll);
+                damage_overlay_scale_weights(damage, ll);
             }
 
             switch (graph_id) {
                 case 0: { // Fig 3: Animals versus Artefacts / Distinctive
-                    test_features(tmp, xg->training_set, j, i, ll, F_DISTINCTIVE);
+                    test_features(my_net, xg->training_set, i, ll, F_DISTINCTIVE);
                     gd->dataset[0].points = MAX_POINTS;
                     gd->dataset[1].points = MAX_POINTS;
                     gd->dataset[2].points = 0;
@@ -464,7 +340,7 @@ static void generate_lesion_data(XGlobals *xg)
                     break;
                 }
                 case 1: { // Fig 4: Shared versus Distinctive / Perceptual
-                    test_animal_features(tmp, xg->training_set, j, i, ll);
+                    test_animal_features(my_net, xg->training_set, i, ll);
                     gd->dataset[0].points = MAX_POINTS;
                     gd->dataset[1].points = MAX_POINTS;
                     gd->dataset[2].points = 0;
@@ -472,7 +348,7 @@ static void generate_lesion_data(XGlobals *xg)
                     break;
                 }
                 case 2: { // Fig 5: Animal versus Artefacts / Shared
-                    test_features(tmp, xg->training_set, j, i, ll, F_SHARED);
+                    test_features(my_net, xg->training_set, i, ll, F_SHARED);
                     gd->dataset[0].points = MAX_POINTS;
                     gd->dataset[1].points = MAX_POINTS;
                     gd->dataset[2].points = 0;
@@ -480,7 +356,7 @@ static void generate_lesion_data(XGlobals *xg)
                     break;
                 }
                 case 3: { // Fig 6: Animal versus Artefacts / Functional
-                    test_features(tmp, xg->training_set, j, i, ll, F_FUNCTIONAL);
+                    test_features(my_net, xg->training_set, i, ll, F_FUNCTIONAL);
                     gd->dataset[0].points = MAX_POINTS;
                     gd->dataset[1].points = MAX_POINTS;
                     gd->dataset[2].points = 0;
@@ -488,7 +364,7 @@ static void generate_lesion_data(XGlobals *xg)
                     break;
                 }
                 case 4: { // Fig 7: Identity: Animals versus Artefacts
-                    test_patterns_correct(tmp, xg->training_set, j, i, ll);
+                    test_patterns_correct(my_net, xg->training_set, i, ll);
                     gd->dataset[0].points = MAX_POINTS;
                     gd->dataset[1].points = MAX_POINTS;
                     gd->dataset[2].points = 0;
@@ -496,7 +372,7 @@ static void generate_lesion_data(XGlobals *xg)
                     break;
                 }
                 case 5: { // Fig 8: Error breakdown
-                    test_patterns_error_breakdown(tmp, xg->training_set, j, i, ll);
+                    test_patterns_error_breakdown(my_net, xg->training_set, i, ll);
                     gd->dataset[0].points = MAX_POINTS;
                     gd->dataset[1].points = MAX_POINTS;
                     gd->dataset[2].points = MAX_POINTS;
@@ -507,10 +383,10 @@ static void generate_lesion_data(XGlobals *xg)
                     fprintf(stderr, "Invalid graph selection\n");
                 }
             }
-            network_destroy(tmp);
+            network_tell_damage(my_net, NULL);
         }
         network_destroy(my_net);
-        lesion_viewer_repaint(xg);
+        lesion_viewer_request_redraw(xg);
         gtkx_flush_events();
 
 	if (paused) {
@@ -518,6 +394,8 @@ static void generate_lesion_data(XGlobals *xg)
 	}
 
     }
+    damage_overlay_destroy(damage);
+    free(hidden_prev);
 }
 
 static void configure_lesion_graph(GraphStruct *gd, int graph_num)
@@ -652,6 +530,12 @@ static void callback_toggle_generate(GtkWidget *button, XGlobals *xg)
     lesion_viewer_repaint(xg);
 }
 
+static void callback_toggle_nested(GtkWidget *button, XGlobals *xg)
+{
+    xg->nested = (Boolean) (GTK_TOGGLE_BUTTON(button)->active);
+    lesion_viewer_repaint(xg);
+}
+
 static void callback_select_lesion_type(GtkWidget *combobox, XGlobals *xg)
 {
     xg->lesion_type = gtk_combo_box_get_active(GTK_COMBO_BOX(combobox));
@@ -680,6 +564,10 @@ static void lesion_viewer_destroy(GtkWidget *viewer1, XGlobals xg)
 {
     // Destroying viewer ...
     viewer = NULL;
+    if (redraw_timer != 0) {
+        g_source_remove(redraw_timer);
+        redraw_timer = 0;
+    }
 }
 
 void lesion_viewer_create_widgets(GtkWidget *vbox, XGlobals *xg)
@@ -746,6 +634,16 @@ void lesion_viewer_create_widgets(GtkWidget *vbox, XGlobals *xg)
     g_signal_connect(G_OBJECT(tmp), "toggled", GTK_SIGNAL_FUNC(callback_toggle_generate), xg);
     gtk_widget_show(tmp);
 
+    /* Widgets for setting whether disconnection lesions are nested: */
+    tmp = gtk_label_new("Nested:");
+    gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 5);
+    gtk_widget_show(tmp);
+    tmp = gtk_check_button_new();
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(tmp), xg->nested);
+    gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 5);
+    g_signal_connect(G_OBJECT(tmp), "toggled", GTK_SIGNAL_FUNC(callback_toggle_nested), xg);
+    gtk_widget_show(tmp);
+
     /* Widgets for setting colour/greyscale: */
     tmp = gtk_label_new("Colour:");
     gtk_box_pack_start(GTK_BOX(hbox), tmp, FALSE, FALSE, 5);
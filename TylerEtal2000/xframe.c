@@ -131,28 +131,24 @@ static void select_rc_weight_file(GtkWidget *w, GtkWidget *chooser)
     char *filename = (char *)gtk_file_selection_get_filename(GTK_FILE_SELECTION(chooser));
     XGlobals *xg = g_object_get_data(G_OBJECT(chooser), "globals");
     char buffer[128];
-    FILE *fp;
     int j;
 
     network_destroy(xg->net);
     xg->net = NULL;
 
-    if ((fp = fopen(filename, "r")) == NULL) {
-        g_snprintf(buffer, 128, "ERROR: Cannot read file ... weights not restored");
-    }
-    else if ((xg->net = network_read_weights_from_file(fp, &j)) == NULL) {
-        g_snprintf(buffer, 128, "ERROR: Weight file format error %d ... weights not restored", j);
-        fclose(fp);
-    }
-    else {
+    if ((xg->net = network_read_weights(filename, &j)) != NULL) {
         gtk_label_set_text(GTK_LABEL(xg->weight_history_label), filename);
         g_snprintf(buffer, 128, "Weights successfully restored from\n%s", filename);
 
         /* Initialise the graph and various viewers: */
         xgraph_set_error_scores(xg);
         initialise_widgets(xg);
-
-        fclose(fp);
+    }
+    else if (j == ERROR_RW_OPEN) {
+        g_snprintf(buffer, 128, "ERROR: Cannot read file ... weights not restored");
+    }
+    else {
+        g_snprintf(buffer, 128, "ERROR: Weight file format error %d ... weights not restored", j);
     }
     gtkx_warn(chooser, buffer);
     gtk_widget_destroy(chooser);
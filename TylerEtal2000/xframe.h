@@ -25,6 +25,7 @@ typedef struct x_globals {
     Boolean           colour;
     Boolean           ddd;
     Boolean           generate;
+    Boolean           nested;      // Nested lesions in the lesion viewer
     int               lesion_type;
     PatternList      *training_set;
     int               pattern_num;
@@ -25,6 +25,8 @@ XGlobals xg =  {
                 TRUE,
 //    Boolean           generate;
                 TRUE,
+//    Boolean           nested;
+                FALSE,
 //    int               lesion_type;
                 0,
 //    PatternList      *training_set;